@@ -0,0 +1,312 @@
+// LPAF - lightweight and performant application framework
+// Copyright (C) 2024 ToneXum (Toni Stein)
+//
+// This program is free software: you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation, either version 3 of
+// the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program. If
+// not, see <https://www.gnu.org/licenses/>.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "internal.h"
+
+#define BNCH_DATAGRAM_SIZE  1400
+#define BNCH_DATAGRAM_BATCH 32
+#define BNCH_FILE_NAME      "lpafBench.bin"
+#define BNCH_FILE_SIZE      67108864 // 64 MiB
+#define BNCH_LOG_MESSAGES   5000
+#define BNCH_STARTUPS       20
+
+void bnchLogFrameworkFail(const fwError error, const char* location, const int32_t line) {
+    printf("Call in %s failed with %d at line %d\n", location, error, line);
+}
+
+struct bnchLoopback {
+    fwSocket first;
+    fwSocket second;
+    char buffer[BNCH_DATAGRAM_SIZE * BNCH_DATAGRAM_BATCH];
+    fwSocketDatagram datagrams[BNCH_DATAGRAM_BATCH];
+};
+
+static fwError bnchRoundTrip(void* user_p) {
+    struct bnchLoopback* loopback_p = user_p;
+    fwError ret = fwSocketSend(loopback_p->first, loopback_p->buffer, 64, nullptr);
+    if (ret == fwErrorSuccess) {
+        ret = fwSocketReceive(loopback_p->second, loopback_p->buffer, 64, nullptr);
+    }
+    if (ret == fwErrorSuccess) {
+        ret = fwSocketSend(loopback_p->second, loopback_p->buffer, 64, nullptr);
+    }
+    if (ret == fwErrorSuccess) {
+        ret = fwSocketReceive(loopback_p->first, loopback_p->buffer, 64, nullptr);
+    }
+    return ret;
+}
+
+static fwError bnchBatchThroughput(void* user_p) {
+    struct bnchLoopback* loopback_p = user_p;
+    uint32_t count = 0;
+    fwError ret = fwSocketSendBatch(loopback_p->first, loopback_p->datagrams, BNCH_DATAGRAM_BATCH,
+                                    &count);
+
+    // Receiving blocks until at least one datagram is there, loopback does not drop any
+    for (uint32_t received = 0; ret == fwErrorSuccess && received < BNCH_DATAGRAM_BATCH;
+         received += count) {
+        ret = fwSocketReceiveBatch(loopback_p->second, loopback_p->datagrams + received,
+                                   BNCH_DATAGRAM_BATCH - received, &count);
+    }
+    return ret;
+}
+
+void bnchSocketLoopback(void) {
+    struct bnchLoopback* loopback_p = calloc(1, sizeof(struct bnchLoopback));
+    if (loopback_p == nullptr) {
+        bnchLogFrameworkFail(fwErrorOutOfMemory, __func__, __LINE__);
+        return;
+    }
+    for (uint32_t i = 0; i < BNCH_DATAGRAM_BATCH; i++) {
+        loopback_p->datagrams[i].buffer.data_p = loopback_p->buffer + i * BNCH_DATAGRAM_SIZE;
+        loopback_p->datagrams[i].buffer.size = BNCH_DATAGRAM_SIZE;
+    }
+
+    struct fwSocketAddress firstAddress = {};
+    firstAddress.target_p = "127.0.0.1";
+    firstAddress.port_p = "49170";
+    struct fwSocketAddress secondAddress = {};
+    secondAddress.target_p = "127.0.0.1";
+    secondAddress.port_p = "49171";
+
+    BNCH(fwSocketCreate(&loopback_p->first, fwSocketAddressFamilyIPv4, fwSocketProtocolDatagram));
+    BNCH(fwSocketCreate(&loopback_p->second, fwSocketAddressFamilyIPv4, fwSocketProtocolDatagram));
+    BNCH(fwSocketBind(loopback_p->first, &firstAddress));
+    BNCH(fwSocketBind(loopback_p->second, &secondAddress));
+    BNCH(fwSocketConnect(loopback_p->first, &secondAddress));
+    BNCH(fwSocketConnect(loopback_p->second, &firstAddress));
+
+    const struct fwBenchConfiguration latencyConfiguration = {
+        .name_p = "UDP loopback round trip, 64 bytes",
+        .warmup = 1000,
+        .repetitions = 20000
+    };
+    fwBench bench = 0;
+    BNCH(fwBenchCreate(&latencyConfiguration, &bench));
+    BNCH(fwBenchRun(bench, bnchRoundTrip, loopback_p));
+    BNCH(fwBenchReport(bench, nullptr));
+    BNCH(fwBenchDestroy(bench));
+
+    const struct fwBenchConfiguration throughputConfiguration = {
+        .name_p = "UDP loopback batch of 32 datagrams, 1400 bytes each",
+        .warmup = 100,
+        .repetitions = 2000,
+        .bytes = BNCH_DATAGRAM_SIZE * BNCH_DATAGRAM_BATCH
+    };
+    BNCH(fwBenchCreate(&throughputConfiguration, &bench));
+    BNCH(fwBenchRun(bench, bnchBatchThroughput, loopback_p));
+    BNCH(fwBenchReport(bench, nullptr));
+    BNCH(fwBenchDestroy(bench));
+
+    BNCH(fwSocketClose(loopback_p->first));
+    BNCH(fwSocketClose(loopback_p->second));
+    free(loopback_p);
+}
+
+static uint64_t bnchSum(const void* data_p, const size_t size) {
+    // Touching every cache line is enough to fault in every page and pull it through the caches
+    const uint8_t* bytes_p = data_p;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < size; i += 64) {
+        sum += bytes_p[i];
+    }
+    return sum;
+}
+
+static volatile uint64_t bnchSink_s = 0;
+
+static fwError bnchLoadToMemory([[maybe_unused]] void* user_p) {
+    void* buffer_p = nullptr;
+    uint64_t size = 0;
+    const fwError ret = fwLoadFileToMem(BNCH_FILE_NAME, &buffer_p, &size);
+    if (ret != fwErrorSuccess) {
+        return ret;
+    }
+
+    bnchSink_s += bnchSum(buffer_p, size);
+    free(buffer_p);
+    return fwErrorSuccess;
+}
+
+static fwError bnchMapped([[maybe_unused]] void* user_p) {
+    const void* view_p = nullptr;
+    uint64_t size = 0;
+    const fwError ret = fwMapFile(BNCH_FILE_NAME, fwFileMapHintSequential, &view_p, &size);
+    if (ret != fwErrorSuccess) {
+        return ret;
+    }
+
+    bnchSink_s += bnchSum(view_p, size);
+    return fwUnmapFile(view_p, size);
+}
+
+static fwError bnchStreamed([[maybe_unused]] void* user_p) {
+    fwFileReader reader = 0;
+    fwError ret = fwFileReaderOpen(BNCH_FILE_NAME, 1048576, &reader);
+    if (ret != fwErrorSuccess) {
+        return ret;
+    }
+
+    const void* chunk_p = nullptr;
+    size_t chunkSize = 0;
+    while ((ret = fwFileReaderNext(reader, &chunk_p, &chunkSize)) == fwErrorSuccess
+           && chunkSize != 0) {
+        bnchSink_s += bnchSum(chunk_p, chunkSize);
+    }
+
+    fwFileReaderClose(reader);
+    return ret;
+}
+
+void bnchFileReads(void) {
+    FILE* file_p = fopen(BNCH_FILE_NAME, "wb");
+    if (file_p == nullptr) {
+        bnchLogFrameworkFail(fwErrorFileUnableToOpen, __func__, __LINE__);
+        return;
+    }
+    char block[65536];
+    memset(block, 'l', sizeof(block));
+    for (uint32_t i = 0; i < BNCH_FILE_SIZE / sizeof(block); i++) {
+        fwrite(block, 1, sizeof(block), file_p);
+    }
+    fclose(file_p);
+
+    // The first warmup run pulls the file into the page cache, all variants read it from there
+    const struct {
+        const char* name_p;
+        fwBenchFunction function;
+    } variants[] = {
+        { "fwLoadFileToMem, 64 MiB", bnchLoadToMemory },
+        { "fwMapFile, 64 MiB", bnchMapped },
+        { "fwFileReader, 64 MiB in 1 MiB chunks", bnchStreamed }
+    };
+
+    for (uint32_t i = 0; i < sizeof(variants) / sizeof(variants[0]); i++) {
+        const struct fwBenchConfiguration configuration = {
+            .name_p = variants[i].name_p,
+            .warmup = 2,
+            .repetitions = 20,
+            .bytes = BNCH_FILE_SIZE
+        };
+        fwBench bench = 0;
+        BNCH(fwBenchCreate(&configuration, &bench));
+        BNCH(fwBenchRun(bench, variants[i].function, nullptr));
+        BNCH(fwBenchReport(bench, nullptr));
+        BNCH(fwBenchDestroy(bench));
+    }
+
+    remove(BNCH_FILE_NAME);
+}
+
+static void* bnchLogThread(void* bench_p) {
+    const fwBench bench = *(fwBench*)bench_p;
+    for (uint32_t i = 0; i < BNCH_LOG_MESSAGES; i++) {
+        fwBenchBegin(bench);
+        FWI_LOG_INFO("Benchmark message %u with some payload %s", i, "attached");
+        fwBenchEnd(bench);
+    }
+    return nullptr;
+}
+
+void bnchLoggerContention(void) {
+    static const char* const names[] = {
+        "Logger, 1 thread",
+        "Logger, 2 threads",
+        "Logger, 4 threads",
+        "Logger, 8 threads"
+    };
+
+    for (uint32_t round = 0; round < 4; round++) {
+        const uint32_t threadCount = 1u << round;
+        const struct fwBenchConfiguration configuration = {
+            .name_p = names[round],
+            .warmup = 100,
+            .repetitions = BNCH_LOG_MESSAGES
+        };
+
+        fwBench total = 0;
+        fwBench benches[8] = {};
+        pthread_t threads[8] = {};
+        BNCH(fwBenchCreate(&configuration, &total));
+        for (uint32_t i = 0; i < threadCount; i++) {
+            BNCH(fwBenchCreate(&configuration, &benches[i]));
+            pthread_create(&threads[i], nullptr, bnchLogThread, &benches[i]);
+        }
+        for (uint32_t i = 0; i < threadCount; i++) {
+            pthread_join(threads[i], nullptr);
+            BNCH(fwBenchMerge(total, benches[i]));
+            BNCH(fwBenchDestroy(benches[i]));
+        }
+
+        BNCH(fwBenchReport(total, nullptr));
+        BNCH(fwBenchDestroy(total));
+    }
+}
+
+void bnchModuleStartup(void) {
+    // The network module stays up for the other benchmarks, a failing window module on a machine
+    // without a display only shows up as a short sample
+    const uint8_t modules = fwModuleWindow | fwModuleRender | fwModuleMultimedia | fwModuleJob;
+    static const char* const names[FW_MODULE_COUNT + 1] = {
+        "Startup, window module",
+        "Startup, render module",
+        "Startup, network module",
+        "Startup, multimedia module",
+        "Startup, job module",
+        "Startup, fwStartModules total"
+    };
+
+    // The last bench takes the totals, it counts as measured like the started modules
+    const uint32_t measured = modules | 1u << FW_MODULE_COUNT;
+    fwBench benches[FW_MODULE_COUNT + 1] = {};
+    for (uint32_t i = 0; i <= FW_MODULE_COUNT; i++) {
+        const struct fwBenchConfiguration configuration = {
+            .name_p = names[i],
+            .warmup = 1,
+            .repetitions = BNCH_STARTUPS
+        };
+        if (measured & 1u << i) {
+            BNCH(fwBenchCreate(&configuration, &benches[i]));
+        }
+    }
+
+    for (uint32_t round = 0; round <= BNCH_STARTUPS; round++) {
+        struct fwModuleStartStats stats = {};
+        fwStartModules(modules, 0, nullptr, 0, &stats);
+        for (uint32_t i = 0; i < FW_MODULE_COUNT; i++) {
+            if (measured & 1u << i) {
+                BNCH(fwBenchRecord(benches[i], stats.modules[i]));
+            }
+        }
+        BNCH(fwBenchRecord(benches[FW_MODULE_COUNT], stats.total));
+
+        BNCH(fwStopModule(fwModuleRender));
+        BNCH(fwStopModule(fwModuleWindow));
+        BNCH(fwStopModule(fwModuleMultimedia));
+        BNCH(fwStopModule(fwModuleJob));
+    }
+
+    for (uint32_t i = 0; i <= FW_MODULE_COUNT; i++) {
+        if (measured & 1u << i) {
+            BNCH(fwBenchReport(benches[i], nullptr));
+            BNCH(fwBenchDestroy(benches[i]));
+        }
+    }
+}
@@ -0,0 +1,43 @@
+// LPAF - lightweight and performant application framework
+// Copyright (C) 2024 ToneXum (Toni Stein)
+//
+// This program is free software: you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation, either version 3 of
+// the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program. If
+// not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LPAF_BENCH_H
+#define LPAF_BENCH_H
+
+#include "framework.h"
+
+#define BNCH(f) { fwError e = 0; if ((e = f) != 0) { bnchLogFrameworkFail(e, __func__, __LINE__); } }
+
+void bnchLogFrameworkFail(
+    fwError error,
+    const char* location,
+    int32_t line);
+
+void bnchSocketLoopback(
+    void
+    );
+
+void bnchFileReads(
+    void
+    );
+
+void bnchLoggerContention(
+    void
+    );
+
+void bnchModuleStartup(
+    void
+    );
+
+#endif //LPAF_BENCH_H
@@ -16,342 +16,7061 @@
 
 #ifdef PLATFORM_LINUX
 
+#define _GNU_SOURCE // sendmmsg, recvmmsg, pthread_setaffinity_np, memfd_create
+
 #include "internal.h"
 #include "linux.h"
 
+#include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
 #include <errno.h>
+#include <fcntl.h>
 #include <netdb.h>
+#include <poll.h>
+#include <sched.h>
 #include <arpa/inet.h>
+#include <linux/errqueue.h>
+#include <linux/filter.h>
+#include <linux/io_uring.h>
+#include <linux/mempolicy.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
 #include <sys/un.h>
+#include <alsa/asoundlib.h>
+#include <wayland-client.h>
+
+#include "xdg-shell-client-protocol.h"
+
+// Large enough for the textual form of any address family and the path of a local socket
+#define FWI_SOCKET_TARGET_ADDRESS_SIZE 108
+
+// Datagrams passed to the kernel with one sendmmsg / recvmmsg
+#define FWI_SOCKET_BATCH 64
+
+// Largest piece handed to one sendfile call, keeps a huge file from starving other sockets of the
+// same thread for too long between the calls
+#define FWI_SOCKET_SENDFILE_CHUNK 1048576 // 1 MiB
+
+// Connections a listener keeps waiting for their fast open cookie check
+#define FWI_SOCKET_FASTOPEN_QUEUE 256
+
+// Sends below this size are copied even with zero-copy enabled, the kernel documentation puts the
+// break-even point at around 10 KiB
+#define FWI_SOCKET_ZEROCOPY_THRESHOLD 16384
+
+// Delay between starting the attempts of fwSocketConnectParallel, RFC 8305 recommends 250 ms
+#define FWI_SOCKET_CONNECT_DELAY 250
+
+// Local channels: default and limits of the ring size per direction, the shared header takes the
+// first page so the rings start page aligned
+#define FWI_LOCAL_CHANNEL_CAPACITY 1048576
+#define FWI_LOCAL_CHANNEL_MIN_CAPACITY 4096
+#define FWI_LOCAL_CHANNEL_MAX_CAPACITY 1073741824
+#define FWI_LOCAL_CHANNEL_HEADER 4096
+#define FWI_LOCAL_CHANNEL_MAGIC 0x4C4E48434641504Cull // "LPAFCHNL"
+#define FWI_LOCAL_CHANNEL_VERSION 1
+
+// Resolver cache: slots, slots a name may hash to, addresses kept per name and default lifetimes
+// of positive and negative entries in milliseconds
+#define FWI_RESOLVER_ENTRIES 256
+#define FWI_RESOLVER_PROBES 8
+#define FWI_RESOLVER_ADDRESSES 16
+#define FWI_RESOLVER_HOST_SIZE 256
+#define FWI_RESOLVER_PORT_SIZE 32
+#define FWI_RESOLVER_DEFAULT_TTL 60000
+#define FWI_RESOLVER_DEFAULT_NEGATIVE_TTL 5000
+
+// Connection pool: hash buckets per shard, idle connections kept per target and shard, idle time
+// in milliseconds and the upper limit of shards
+#define FWI_POOL_BUCKETS 16
+#define FWI_POOL_DEFAULT_MAX_IDLE 8
+#define FWI_POOL_DEFAULT_IDLE_TIME 30000
+#define FWI_POOL_MAX_SHARDS 64
+
+// Jobs a worker can hold before further submissions go to the shared injection queue
+#define FWI_JOB_DEQUE_SIZE 4096
+
+// Rounds without finding work before fwJobWait blocks instead of yielding
+#define FWI_JOB_WAIT_SPINS 64
+
+// Fibers: default usable stack size, stacks of finished fibers kept for reuse and readiness events
+// collected per wait of the thread that resumes waiting fibers
+#define FWI_FIBER_STACK_SIZE 65536
+#define FWI_FIBER_POOLED_STACKS 1024
+#define FWI_FIBER_REACTOR_BATCH 64
+
+// Software renderer: buffers per surface, largest extent of a surface, operations covering fewer
+// pixels stay on the calling thread and bands handed to the job system are at least this many rows
+#define FWI_RENDER_BUFFERS 3
+#define FWI_RENDER_MAX_EXTENT 16384
+#define FWI_RENDER_PARALLEL_PIXELS 262144
+#define FWI_RENDER_BAND_ROWS 32
+#define FWI_RENDER_BANDS_MAX 64
+
+// Audio: defaults of a stream, at 48 kHz two periods of 128 frames are 5.3 ms of device latency,
+// and the SCHED_FIFO priority of its thread, below the interrupt threads of the kernel
+#define FWI_AUDIO_SAMPLE_RATE 48000
+#define FWI_AUDIO_CHANNELS 2
+#define FWI_AUDIO_PERIOD_FRAMES 128
+#define FWI_AUDIO_PERIODS 2
+#define FWI_AUDIO_RING_PERIODS 4
+#define FWI_AUDIO_MAX_RING_FRAMES 1048576
+#define FWI_AUDIO_PRIORITY 70
+
+// File cache: default budget, buckets of a new cache, they double whenever the entries outnumber
+// them, and the changes that make a watched file stale
+#define FWI_FILE_CACHE_BUDGET 67108864 // 64 MiB
+#define FWI_FILE_CACHE_BUCKETS 64
+#define FWI_FILE_CACHE_WATCH_MASK (IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVE_SELF | \
+                                   IN_DELETE_SELF)
+
+// fwSocketBuffer arrays are handed to the kernel as they are
+static_assert(sizeof(fwSocketBuffer) == sizeof(struct iovec) &&
+              offsetof(fwSocketBuffer, data_p) == offsetof(struct iovec, iov_base) &&
+              offsetof(fwSocketBuffer, size) == offsetof(struct iovec, iov_len),
+              "fwSocketBuffer must be layout compatible with struct iovec");
+
+// Upper limit of the socket table, the file descriptor limit of the process usually is lower
+#define FWI_SOCKET_TABLE_LIMIT 1048576
+
+static_assert(sizeof(fwSocket) == sizeof(uint64_t), "fwSocket must hold index and generation");
+
+// Only every n-th call of a socket is timed, the two clock reads cost more than all the counters
+#define FWI_SOCKET_LATENCY_SAMPLING 16
+
+/**
+ * @brief Counters of a socket, mirrors fwSocketStats so both can be walked as arrays of counters
+ */
+struct fwiSocketStatistics {
+    _Atomic uint64_t bytesSent;
+    _Atomic uint64_t bytesReceived;
+    _Atomic uint64_t syscalls;
+    _Atomic uint64_t shortWrites;
+    _Atomic uint64_t shortReads;
+    _Atomic uint64_t wouldBlock;
+    _Atomic uint64_t errors;
+    _Atomic uint64_t sendLatency[FW_SOCKET_LATENCY_BUCKETS];
+    _Atomic uint64_t receiveLatency[FW_SOCKET_LATENCY_BUCKETS];
+};
+
+static_assert(sizeof(struct fwiSocketStatistics) == sizeof(fwSocketStats),
+              "fwiSocketStatistics must mirror fwSocketStats");
+
+#define FWI_SOCKET_COUNTERS (sizeof(fwSocketStats) / sizeof(uint64_t))
 
 struct fwiNativeSocketState {
-    char* targetAddress;
+    fwSocket handle; // 0 while the slot is free
+    int32_t fileDescriptor;
     int32_t addressFamily;
     int32_t protocol;
+    uint32_t generation; // survives reuse of the slot, invalidates identifiers of closed sockets
+    uint32_t nextFree;
+    bool connected, bound, listening, nonBlocking;
+    bool connecting; // a non-blocking connect is in flight
+    bool quickAck; // TCP_QUICKACK is reset by the kernel, so it is renewed after every receive
+    struct fwiSocketStatistics statistics;
+    struct fwiEventSource eventSource;
+    fwEventCallback eventCallback;
+    void* eventUser_p;
+    uint8_t eventInterest;
+    struct fwSocketTimeouts timeouts;
+    struct fwiTimer deadlineTimer; // due at the earliest deadline, only while registered
+    int64_t readDeadline, writeDeadline, idleDeadline; // milliseconds of CLOCK_MONOTONIC
+    fwSocketZeroCopyCallback zeroCopyCallback; // nullptr while zero-copy sends are disabled
+    void* zeroCopyUser_p;
+    size_t zeroCopyThreshold;
+    uint32_t zeroCopyNext; // the kernel numbers zero-copy sends per socket, starting at 0
+    struct fwiPooledConnection* pooled_p; // nullptr unless the socket came from a connection pool
+    struct fwSocketOptions options; // replayed on descriptors that replace the current one
+    bool configured; // fwSocketConfigure was called, options is valid
+    char targetAddress[FWI_SOCKET_TARGET_ADDRESS_SIZE]; // cold, kept at the end
+};
+
+/**
+ * @brief Slab of all socket states. A socket identifier is the slot index plus one in the lower
+ *        and the generation of the slot in the upper 32 bit, so 0 is never a valid socket.
+ * @note The slab is reserved for the full capacity up front but only slots up to the high water
+ *       mark have ever been touched, physical memory grows with the peak number of sockets.
+ */
+struct fwiSocketTable {
+    struct fwiNativeSocketState* slots_p;
+    size_t mappingSize;
+    _Atomic uint64_t freeHead; // ABA tag in the upper, slot index in the lower 32 bit
+    atomic_uint highWater;
+    uint32_t capacity;
+    uint32_t generationBase; // above every generation of the previous table, see Destroy
+    struct fwiSocketStatistics retired; // counters of every socket that was closed
+};
+
+static struct fwiSocketTable socketTable_s = {};
+
+typedef enum fwiIoOperationKind : uint8_t {
+    fwiIoOperationSend,
+    fwiIoOperationReceive,
+    fwiIoOperationAccept,
+    fwiIoOperationRead
+} fwiIoOperationKind;
+
+/**
+ * @brief Bookkeeping for an operation in flight, the index is used as io_uring user data
+ */
+struct fwiIoOperation {
+    uint64_t tag;
+    fwSocket socket; // checked at completion, the socket may have been closed in the meantime
+    uint32_t length;
+    uint32_t nextFree;
+    fwiIoOperationKind kind;
+};
+
+struct fwiNativeIoQueue {
+    struct io_uring_sqe* sqes_p;
+    const struct io_uring_cqe* cqes_p;
+    const uint32_t* sqHead_p;
+    uint32_t* sqTail_p;
+    uint32_t* sqArray_p;
+    uint32_t* cqHead_p;
+    const uint32_t* cqTail_p;
+    struct fwiIoOperation* operations_p;
+    void* sqRing_p;
+    void* cqRing_p;
+    size_t sqRingSize, cqRingSize, sqesSize;
+    uint32_t sqMask, cqMask, sqEntries, operationCount;
+    uint32_t unsubmitted;
+    uint32_t freeOperation; // head of the operation free list, UINT32_MAX when exhausted
     int32_t fileDescriptor;
-    bool connected, bound;
 };
 
-fwError fwGetSystemConfiguration(fwSystemConfiguration* res_p) {
-    res_p->cores  = sysconf(_SC_NPROCESSORS_ONLN);
-    // TODO: figure out why only first memory bank is counted
-    res_p->memory = sysconf(_SC_PHYS_PAGES) * sysconf(_SC_AVPHYS_PAGES) / 1048576; // 1024^2, to MiB
-    return fwErrorSuccess;
-}
+struct fwiNativeFileReader {
+    uint8_t* buffers_p[2];
+    uint64_t readOffset; // offset of the read that is in flight, or of the next one
+    fwIoQueue queue; // 0 when reading synchronously
+    size_t chunkSize;
+    int32_t fileDescriptor;
+    uint8_t filling; // buffer that receives the next chunk
+    bool pending; // an asynchronous read is in flight
+};
 
-fwError fwLoadFileToMem(const char* filename_p, void** buffer_pp, uint64_t* fileSize_p) {
-    FILE* file = fopen(filename_p, "rb");
-    if (!(uintptr_t)file) {
-        return fwErrorFileUnableToOpen;
-    }
+static fwError fwiFileReaderIssue(struct fwiNativeFileReader* nativeReader);
 
-    const int32_t fileDescriptor = fileno(file); // should not error since file stream must be valid
+fwError fwiSocketTableCreate(void) {
+    struct rlimit limit = {};
+    getrlimit(RLIMIT_NOFILE, &limit);
 
-    struct stat fileStats;
-    if (fstat(fileDescriptor, &fileStats)) { // -1 on error
-        return fwErrorFileStats;
-    }
+    // A socket needs a descriptor, there can never be more of them than the process may open
+    socketTable_s.capacity = limit.rlim_cur < FWI_SOCKET_TABLE_LIMIT ?
+                             (uint32_t)limit.rlim_cur : FWI_SOCKET_TABLE_LIMIT;
+    socketTable_s.mappingSize = socketTable_s.capacity * sizeof(struct fwiNativeSocketState);
 
-    *fileSize_p = fileStats.st_size;
-    *buffer_pp = malloc(*fileSize_p);
-    if (!(uintptr_t)*buffer_pp) {
+    void* slots_p = mmap(nullptr, socketTable_s.mappingSize, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (slots_p == MAP_FAILED) {
+        FWI_LOG_ERRNO;
         return fwErrorOutOfMemory;
     }
 
-    fread(*buffer_pp, 1, *fileSize_p, file);
+    socketTable_s.slots_p = slots_p;
+    memset(&socketTable_s.retired, 0, sizeof(socketTable_s.retired));
+    atomic_store(&socketTable_s.freeHead, UINT32_MAX);
+    atomic_store(&socketTable_s.highWater, 0);
+
+    FWI_LOG_INFO("Socket table for %d sockets was created", socketTable_s.capacity);
     return fwErrorSuccess;
 }
 
-fwError fwSocketCreate(const fwSocketAddressFamily addressFamily, const fwSocketProtocol protocol,
-                       fwSocket* sfdop_p) {
-    int32_t realAddressFamily, realProtocol, targetAddressSize;
-
-    switch (addressFamily) {
-        case fwSocketAddressFamilyLocal: {
-            realAddressFamily = AF_LOCAL;
-            targetAddressSize = 108;
-            break;
-        }
-        case fwSocketAddressFamilyIPv4: {
-            realAddressFamily = AF_INET;
-            targetAddressSize = INET_ADDRSTRLEN;
-            break;
-        }
-        case fwSocketAddressFamilyIPv6: {
-            realAddressFamily = AF_INET6;
-            targetAddressSize = INET6_ADDRSTRLEN;
-            break;
-        }
-        default: {
-            return fwErrorInvalidParameter;
-        }
+void fwiSocketTableDestroy(void) {
+    if (socketTable_s.slots_p == nullptr) {
+        return;
     }
 
-    switch (protocol) {
-        case fwSocketProtocolStream: {
-            realProtocol = SOCK_STREAM;
-            break;
-        }
-        case fwSocketProtocolDatagram: {
-            realProtocol = SOCK_DGRAM;
-            break;
-        }
-        case fwSocketProtocolRaw: {
-            realProtocol = SOCK_RAW;
-            break;
+    // Identifiers from before a restart must not match the sockets of the next table, so its
+    // slots start counting above the highest generation this one handed out
+    uint32_t generationMax = socketTable_s.generationBase;
+    const uint32_t highWater = atomic_load(&socketTable_s.highWater);
+    for (uint32_t i = 0; i < highWater; i++) {
+        struct fwiNativeSocketState* state_p = &socketTable_s.slots_p[i];
+        if (state_p->generation > generationMax) {
+            generationMax = state_p->generation;
         }
-        default: {
-            return fwErrorInvalidParameter;
+        if (state_p->handle != 0) {
+            FWI_LOG_WARNING("Socket (ID: %lX) was still open", state_p->handle);
+            if (state_p->eventSource.loop_p != nullptr) {
+                fwiTimerWheelCancel(&state_p->eventSource.loop_p->timerWheel,
+                                    &state_p->deadlineTimer);
+                fwiEventLoopRemoveSource(&state_p->eventSource);
+            }
+            free(state_p->pooled_p);
+            close(state_p->fileDescriptor);
         }
     }
 
-    struct fwiNativeSocketState* nativeSocket;
+    munmap(socketTable_s.slots_p, socketTable_s.mappingSize);
+    socketTable_s.slots_p = nullptr;
+    socketTable_s.generationBase = generationMax + 1;
+    atomic_store(&socketTable_s.freeHead, UINT32_MAX);
+    atomic_store(&socketTable_s.highWater, 0);
+}
 
-    // This memory is not leaked, is it put into the hands of the user in the form of an unsigned
-    // long, which is then reinterpreted. Freed in fwSocketClose
-    if ((nativeSocket = malloc(sizeof(struct fwiNativeSocketState) + targetAddressSize)) == nullptr) {
-        return fwErrorOutOfMemory;
+/**
+ * @brief Takes a zeroed slot from the table
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorModule The network module is not running
+ * @return @c fwErrorOutOfMemory Every slot is in use
+ */
+static fwError fwiSocketAllocate(struct fwiNativeSocketState** state_pp) {
+    if (socketTable_s.slots_p == nullptr) {
+        return fwErrorModule;
     }
-    // Can you spot the difference which cost me a whole week to debug?
-    //if ((nativeSocket = malloc(sizeof(struct fwiNativeSocketState)) + targetAddressSize) == nullptr) {
 
-    memset(nativeSocket, 0, sizeof(struct fwiNativeSocketState) + targetAddressSize);
-    nativeSocket->targetAddress = (char*)&nativeSocket->targetAddress +
-                                     sizeof(struct fwiNativeSocketState);
+    uint32_t index = UINT32_MAX;
 
-    nativeSocket->protocol       = realProtocol;
-    nativeSocket->addressFamily  = realAddressFamily;
-    if ((nativeSocket->fileDescriptor = socket(realAddressFamily, realProtocol, 0)) == -1) {
-        FWI_LOG_ERRNO;
+    uint64_t head = atomic_load_explicit(&socketTable_s.freeHead, memory_order_acquire);
+    while ((uint32_t)head != UINT32_MAX) {
+        const uint64_t next = ((head >> 32) + 1) << 32 |
+                              socketTable_s.slots_p[(uint32_t)head].nextFree;
+        if (atomic_compare_exchange_weak_explicit(&socketTable_s.freeHead, &head, next,
+                                                  memory_order_acq_rel, memory_order_acquire)) {
+            index = (uint32_t)head;
+            break;
+        }
+    }
+
+    const bool fresh = index == UINT32_MAX;
+    if (fresh) { // nothing was recycled, take a slot that was never used before
+        uint32_t highWater = atomic_load_explicit(&socketTable_s.highWater, memory_order_relaxed);
+        do {
+            if (highWater >= socketTable_s.capacity) {
+                return fwErrorOutOfMemory;
+            }
+        } while (!atomic_compare_exchange_weak_explicit(&socketTable_s.highWater, &highWater,
+                                                        highWater + 1, memory_order_relaxed,
+                                                        memory_order_relaxed));
+        index = highWater;
     }
 
-    *sfdop_p = (uintptr_t)nativeSocket;
+    struct fwiNativeSocketState* state_p = &socketTable_s.slots_p[index];
+    const uint32_t generation = fresh ? socketTable_s.generationBase : state_p->generation;
+    memset(state_p, 0, sizeof(struct fwiNativeSocketState));
+    state_p->generation = generation;
+    state_p->handle     = (uint64_t)generation << 32 | (index + 1);
 
-    fwiLogA(fwiLogLevelInfo, "New socket (ID: %X) was created", nativeSocket);
+    *state_pp = state_p;
     return fwErrorSuccess;
 }
 
-fwError fwSocketConnect(const fwSocket sfdop, const fwSocketAddress* connectInfo_p) {
-    struct fwiNativeSocketState* nativeSocket = {(struct fwiNativeSocketState*)sfdop};
+static void fwiSocketRelease(struct fwiNativeSocketState* state_p) {
+    const uint32_t index = state_p - socketTable_s.slots_p;
 
-    struct addrinfo hint      = {};
-    struct addrinfo* res      = {};
+    state_p->handle = 0;
+    state_p->generation++;
 
-    hint.ai_family            = nativeSocket->addressFamily;
-    hint.ai_socktype          = nativeSocket->protocol;
+    uint64_t head = atomic_load_explicit(&socketTable_s.freeHead, memory_order_relaxed);
+    uint64_t next;
+    do {
+        state_p->nextFree = (uint32_t)head;
+        next = ((head >> 32) + 1) << 32 | index;
+    } while (!atomic_compare_exchange_weak_explicit(&socketTable_s.freeHead, &head, next,
+                                                    memory_order_release, memory_order_relaxed));
+}
 
-    if (getaddrinfo(connectInfo_p->target_p, connectInfo_p->port_p, &hint, &res)) {
-        freeaddrinfo(res);
-        return fwErrorSocketTargetName;
+/**
+ * @brief Resolves a socket identifier, nullptr if it is malformed or the socket was closed
+ */
+static struct fwiNativeSocketState* fwiSocketLookup(const fwSocket sfdop) {
+    const uint32_t index = (uint32_t)sfdop - 1;
+    if (socketTable_s.slots_p == nullptr ||
+        index >= atomic_load_explicit(&socketTable_s.highWater, memory_order_relaxed)) {
+        return nullptr; // the network module is not running
     }
 
-    const struct addrinfo *it = res;
-    do {
-        if (connect(nativeSocket->fileDescriptor, it->ai_addr, sizeof(struct sockaddr_in)) == -1) {
-            FWI_LOG_ERRNO;
-            close(sfdop);
-            it = it->ai_next;
-            continue;
-        }
-        break;
-    } while (it != nullptr);
+    struct fwiNativeSocketState* state_p = &socketTable_s.slots_p[index];
+    if (state_p->handle != sfdop) {
+        return nullptr;
+    }
+    return state_p;
+}
 
-    if (it == nullptr) {
-        freeaddrinfo(res);
-        return fwErrorSocketConnection;
+static void fwiStatsAdd(_Atomic uint64_t* counter_p, const uint64_t value) {
+    atomic_fetch_add_explicit(counter_p, value, memory_order_relaxed);
+}
+
+/**
+ * @brief Counts a syscall and returns its start time, or 0 if this call is not sampled
+ */
+static uint64_t fwiStatsBegin(struct fwiSocketStatistics* stats_p) {
+    const uint64_t calls = atomic_fetch_add_explicit(&stats_p->syscalls, 1, memory_order_relaxed);
+    if (calls % FWI_SOCKET_LATENCY_SAMPLING != 0) {
+        return 0;
     }
 
-    nativeSocket->connected = true;
-    nativeSocket->bound = true;
-    strncpy(nativeSocket->targetAddress, connectInfo_p->target_p, 108);
+    uint64_t now = 0;
+    fwBenchNow(&now);
+    return now;
+}
 
-    fwiLogA(fwiLogLevelInfo, "Socket (ID: %X) connected to %s", nativeSocket, connectInfo_p->target_p);
-    return fwErrorSuccess;
+/**
+ * @brief Accounts for a finished transfer
+ * @param transferred[in] Bytes that were transferred or the negated errno of a failed call, the
+ *                       way io_uring reports it
+ * @param isShort[in] Less than requested was transferred
+ */
+static void fwiStatsEnd(struct fwiSocketStatistics* stats_p, const uint64_t start,
+                        const bool sending, const int64_t transferred, const bool isShort) {
+    if (start != 0) {
+        uint64_t now = 0;
+        fwBenchNow(&now);
+        const uint64_t elapsed = now - start;
+        uint32_t bucket = elapsed > 1 ? 63 - __builtin_clzll(elapsed) : 0;
+        bucket = bucket < FW_SOCKET_LATENCY_BUCKETS ? bucket : FW_SOCKET_LATENCY_BUCKETS - 1;
+        fwiStatsAdd(sending ? &stats_p->sendLatency[bucket] : &stats_p->receiveLatency[bucket], 1);
+    }
+
+    if (transferred < 0) {
+        fwiStatsAdd(-transferred == EAGAIN || -transferred == EWOULDBLOCK ? &stats_p->wouldBlock
+                                                                          : &stats_p->errors, 1);
+        return;
+    }
+
+    fwiStatsAdd(sending ? &stats_p->bytesSent : &stats_p->bytesReceived, (uint64_t)transferred);
+    if (isShort) {
+        fwiStatsAdd(sending ? &stats_p->shortWrites : &stats_p->shortReads, 1);
+    }
 }
 
-fwError fwSocketBind(const fwSocket sfdop, const struct fwSocketAddress* localAddress) {
-    struct fwiNativeSocketState* nativeSocket = {(struct fwiNativeSocketState*)sfdop};
+static void fwiStatsAccumulate(uint64_t* out_p, struct fwiSocketStatistics* stats_p) {
+    _Atomic uint64_t* counters_p = (_Atomic uint64_t*)stats_p;
+    for (size_t i = 0; i < FWI_SOCKET_COUNTERS; i++) {
+        out_p[i] += atomic_load_explicit(&counters_p[i], memory_order_relaxed);
+    }
+}
 
-    switch (nativeSocket->addressFamily) {
-        case AF_INET6:
-        case AF_INET: {
-            struct sockaddr_in address = {};
-            address.sin_family = nativeSocket->addressFamily;
-            address.sin_port = htons(atoi(localAddress->port_p));
+/**
+ * @brief Error for EAGAIN, blocking sockets only see it once SO_RCVTIMEO or SO_SNDTIMEO ran out
+ */
+static fwError fwiSocketWouldBlock(const struct fwiNativeSocketState* nativeSocket) {
+    return nativeSocket->nonBlocking ? fwErrorSocketWouldBlock : fwErrorSocketTimeout;
+}
 
-            if (strcmp(localAddress->target_p, FW_SOCKET_ADDRESS_ANY)) {
-                address.sin_addr.s_addr = INADDR_ANY;
-            } else {
-                inet_pton(nativeSocket->addressFamily, localAddress->target_p, &address.sin_addr);
-            }
+static void fwiSocketRenewQuickAck(const struct fwiNativeSocketState* nativeSocket) {
+    const int32_t enable = 1;
+    setsockopt(nativeSocket->fileDescriptor, IPPROTO_TCP, TCP_QUICKACK, &enable, sizeof(enable));
+}
 
-            if (bind(nativeSocket->fileDescriptor, (struct sockaddr*)&address,
-                sizeof(address)) == -1) {
-                FWI_LOG_ERRNO;
-                return fwErrorSocketBind;
-            }
+static fwError fwiReadFileQueued(fwIoQueue queue, int32_t fileDescriptor, uint8_t* buffer_p,
+                                 uint64_t size);
 
-            break;
-        }
-        case AF_LOCAL: {
-            struct sockaddr_un address = {};
-            address.sun_family = AF_LOCAL;
-            strncpy(address.sun_path, localAddress->target_p, sizeof(address.sun_path) - 1);
+static fwError fwiSocketApplyOptions(const struct fwiNativeSocketState* nativeSocket,
+                                     int32_t fileDescriptor, bool fastOpen);
 
-            if (bind(nativeSocket->fileDescriptor, (struct sockaddr*)&address,
-                sizeof(address)) == -1) {
-                FWI_LOG_ERRNO;
-                return fwErrorSocketBind;
-            }
+// Reads a small sysfs or procfs file into buffer_p, returns false if it does not exist
+static bool fwiReadSystemFile(const char* path_p, char* buffer_p, const size_t size) {
+    const int32_t fd = open(path_p, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
 
-            break;
-        }
-        default: {
-            return fwErrorGoodJob;
-        }
+    const ssize_t length = read(fd, buffer_p, size - 1);
+    close(fd);
+    if (length <= 0) {
+        return false;
     }
 
-    nativeSocket->bound = true;
-    fwiLogA(fwiLogLevelInfo, "Socket (ID: %X) was bound to %s", nativeSocket, localAddress->target_p);
-    return fwErrorSuccess;
+    buffer_p[length] = '\0';
+    return true;
 }
 
-fwError fwSocketAccept(const fwSocket sfdop, fwSocket* newSocket, char* foreignAddress) {
-    const struct fwiNativeSocketState* nativeSocket = {(struct fwiNativeSocketState*)sfdop};
+// Sysfs values like "32K" or "8192K" to bytes
+static uint64_t fwiReadSystemSize(const char* path_p) {
+    char buffer[64];
+    if (!fwiReadSystemFile(path_p, buffer, sizeof(buffer))) {
+        return 0;
+    }
 
-    if (nativeSocket->bound == false) {
-        return fwErrorSocketNotBound;
+    char* end_p = nullptr;
+    uint64_t value = strtoull(buffer, &end_p, 10);
+    switch (*end_p) {
+        case 'K': value *= 1024u; break;
+        case 'M': value *= 1024u * 1024u; break;
+        case 'G': value *= 1024u * 1024u * 1024u; break;
+        default: break;
     }
+    return value;
+}
 
-    if (listen(nativeSocket->fileDescriptor, 128) == -1) {
-        FWI_LOG_ERRNO;
-        return fwErrorSocketListen;
+// CPU lists like "0-3,8-11" to a bitmask, returns the number of CPUs in it
+static uint16_t fwiParseCpuList(const char* list_p, uint64_t mask[FW_SYSTEM_CPUS_MAX / 64]) {
+    uint16_t count = 0;
+    while (*list_p >= '0' && *list_p <= '9') {
+        char* end_p = nullptr;
+        const uint64_t first = strtoull(list_p, &end_p, 10);
+        uint64_t last = first;
+        if (*end_p == '-') {
+            last = strtoull(end_p + 1, &end_p, 10);
+        }
+
+        for (uint64_t cpu = first; cpu <= last && cpu < FW_SYSTEM_CPUS_MAX; cpu++) {
+            mask[cpu / 64] |= 1ull << (cpu % 64);
+            count++;
+        }
+
+        list_p = *end_p == ',' ? end_p + 1 : end_p;
     }
+    return count;
+}
 
-    // ReSharper disable once CppDFAMemoryLeak
-    struct fwiNativeSocketState* newNativeSocket = malloc(sizeof(struct fwiNativeSocketState));
-    if (newNativeSocket == nullptr) {
-        return fwErrorOutOfMemory;
+// Looks up a "Name: value kB" line of a meminfo file, returns the value in KiB or 0
+static uint64_t fwiFindMemInfo(const char* memInfo_p, const char* name_p) {
+    const char* line_p = strstr(memInfo_p, name_p);
+    if (line_p == nullptr) {
+        return 0;
     }
+    return strtoull(line_p + strlen(name_p), nullptr, 10);
+}
 
-    switch (nativeSocket->addressFamily) {
-        case AF_INET: {
-            struct sockaddr_in address = {};
-            socklen_t sockSize = sizeof(address);
+fwError fwGetSystemConfiguration(fwSystemConfiguration* res_p) {
+    *res_p = (struct fwSystemConfiguration){};
 
-            newNativeSocket->connected      = true;
-            newNativeSocket->bound          = true;
-            newNativeSocket->protocol       = nativeSocket->protocol;
-            newNativeSocket->addressFamily  = nativeSocket->addressFamily;
-            newNativeSocket->fileDescriptor = accept(nativeSocket->fileDescriptor,
-                                                       (struct sockaddr*)&address, &sockSize);
-            inet_ntop(AF_INET, &address.sin_addr, nativeSocket->targetAddress, INET_ADDRSTRLEN);
+    const uint64_t pageSize = sysconf(_SC_PAGESIZE);
+    res_p->pageSize        = pageSize;
+    res_p->cores           = sysconf(_SC_NPROCESSORS_ONLN);
+    res_p->memory          = sysconf(_SC_PHYS_PAGES) * pageSize / 1048576; // 1024^2, to MiB
+    res_p->memoryAvailable = sysconf(_SC_AVPHYS_PAGES) * pageSize / 1048576;
 
-            if (foreignAddress != nullptr) {
-                strncpy(foreignAddress, newNativeSocket->targetAddress, INET_ADDRSTRLEN);
-            }
+    char buffer[4096];
+    if (fwiReadSystemFile("/proc/meminfo", buffer, sizeof(buffer))) {
+        // Unlike free pages this includes page cache that the kernel would give up
+        const uint64_t available = fwiFindMemInfo(buffer, "MemAvailable:");
+        if (available != 0) {
+            res_p->memoryAvailable = available / 1024u;
+        }
+        res_p->hugePageSize  = fwiFindMemInfo(buffer, "Hugepagesize:") * 1024u;
+        res_p->hugePagesFree = fwiFindMemInfo(buffer, "HugePages_Free:");
+    }
+    if (fwiReadSystemFile("/sys/kernel/mm/transparent_hugepage/enabled", buffer, sizeof(buffer))) {
+        res_p->transparentHugePages = strstr(buffer, "[never]") == nullptr;
+    }
 
-            break;
+    // Topology of the online CPUs, a core is identified by its package and its id in there
+    uint64_t online[FW_SYSTEM_CPUS_MAX / 64] = {};
+    if (!fwiReadSystemFile("/sys/devices/system/cpu/online", buffer, sizeof(buffer)) ||
+        fwiParseCpuList(buffer, online) == 0) {
+        online[0] = 1; // at least the CPU this runs on
+    }
+
+    uint32_t packages[FW_SYSTEM_CPUS_MAX];
+    uint32_t coreKeys[FW_SYSTEM_CPUS_MAX];
+    uint16_t packageCount = 0;
+    uint16_t coreCount = 0;
+    char path[128];
+    for (uint32_t cpu = 0; cpu < FW_SYSTEM_CPUS_MAX; cpu++) {
+        if (!(online[cpu / 64] & (1ull << (cpu % 64)))) {
+            continue;
         }
-        case AF_INET6: {
-            struct sockaddr_in6 address = {};
-            socklen_t sockSize = sizeof(address);
 
-            newNativeSocket->connected      = true;
-            newNativeSocket->bound          = true;
-            newNativeSocket->protocol       = nativeSocket->protocol;
-            newNativeSocket->addressFamily  = nativeSocket->addressFamily;
-            newNativeSocket->fileDescriptor = accept(nativeSocket->fileDescriptor,
-                                                       (struct sockaddr*)&address, &sockSize);
-            inet_ntop(AF_INET6, &address.sin6_addr, nativeSocket->targetAddress, INET6_ADDRSTRLEN);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/physical_package_id",
+                 cpu);
+        const uint32_t package = fwiReadSystemFile(path, buffer, sizeof(buffer)) ?
+                                 strtoul(buffer, nullptr, 10) : 0;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/core_id", cpu);
+        const uint32_t core = fwiReadSystemFile(path, buffer, sizeof(buffer)) ?
+                              strtoul(buffer, nullptr, 10) : cpu;
 
-            if (foreignAddress != nullptr) {
-                strncpy(foreignAddress, newNativeSocket->targetAddress, INET6_ADDRSTRLEN);
-            }
+        bool known = false;
+        for (uint16_t i = 0; i < packageCount && !known; i++) {
+            known = packages[i] == package;
+        }
+        if (!known) {
+            packages[packageCount++] = package;
+        }
 
-            break;
+        const uint32_t key = package << 16 | (core & 0xFFFF);
+        known = false;
+        for (uint16_t i = 0; i < coreCount && !known; i++) {
+            known = coreKeys[i] == key;
         }
-        case AF_LOCAL: {
-            struct sockaddr_un address = {};
-            socklen_t sockSize = sizeof(address);
+        if (!known) {
+            coreKeys[coreCount++] = key;
+        }
+    }
+    res_p->sockets        = packageCount;
+    res_p->physicalCores  = coreCount;
+    res_p->threadsPerCore = coreCount != 0 ? (res_p->cores + coreCount - 1) / coreCount : 1;
 
-            newNativeSocket->connected      = true;
-            newNativeSocket->bound          = true;
-            newNativeSocket->protocol       = nativeSocket->protocol;
-            newNativeSocket->addressFamily  = nativeSocket->addressFamily;
-            newNativeSocket->fileDescriptor = accept(nativeSocket->fileDescriptor,
-                                                       (struct sockaddr*)&address, &sockSize);
-            inet_ntop(AF_INET, &address.sun_path, nativeSocket->targetAddress, 108);
+    // Caches as seen by the first CPU, the other cores on x86 and arm64 have the same layout
+    for (uint32_t index = 0; index < 8; index++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/level", index);
+        if (!fwiReadSystemFile(path, buffer, sizeof(buffer))) {
+            break;
+        }
+        const uint32_t level = strtoul(buffer, nullptr, 10);
 
-            if (foreignAddress != nullptr) {
-                strncpy(foreignAddress, newNativeSocket->targetAddress, 108);
-            }
+        char type[32] = {};
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/type", index);
+        fwiReadSystemFile(path, type, sizeof(type));
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/size", index);
+        const uint32_t size = fwiReadSystemSize(path);
 
-            break;
+        if (level == 1 && strncmp(type, "Instruction", 11) == 0) {
+            res_p->l1InstructionCache = size;
         }
-        default: {
-            return fwErrorGoodJob;
+        else if (level == 1) {
+            res_p->l1DataCache = size;
+            snprintf(path, sizeof(path),
+                     "/sys/devices/system/cpu/cpu0/cache/index%u/coherency_line_size", index);
+            res_p->cacheLine = fwiReadSystemSize(path);
+        }
+        else if (level == 2) {
+            res_p->l2Cache = size;
+        }
+        else if (level == 3) {
+            res_p->l3Cache = size;
         }
     }
+    if (res_p->cacheLine == 0) {
+        const int64_t line = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+        res_p->cacheLine = line > 0 ? line : 64;
+    }
 
-    if (newNativeSocket->fileDescriptor == -1) {
-        FWI_LOG_ERRNO;
-        free(newNativeSocket);
-        return fwErrorSocketAccept;
+    // NUMA nodes, numbering may have holes so the online list is walked instead of counting up
+    uint64_t nodes[FW_SYSTEM_CPUS_MAX / 64] = {};
+    if (fwiReadSystemFile("/sys/devices/system/node/online", buffer, sizeof(buffer))) {
+        fwiParseCpuList(buffer, nodes);
     }
+    for (uint32_t node = 0; node < FW_SYSTEM_CPUS_MAX; node++) {
+        if (!(nodes[node / 64] & (1ull << (node % 64))) ||
+            res_p->numaNodeCount == FW_SYSTEM_NUMA_NODES_MAX) {
+            continue;
+        }
 
-    *newSocket = (uintptr_t)newNativeSocket;
+        struct fwSystemNumaNode* numaNode_p = &res_p->numaNodes[res_p->numaNodeCount++];
+        numaNode_p->id = node;
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+        if (fwiReadSystemFile(path, buffer, sizeof(buffer))) {
+            numaNode_p->cpuCount = fwiParseCpuList(buffer, numaNode_p->cpus);
+        }
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/meminfo", node);
+        if (fwiReadSystemFile(path, buffer, sizeof(buffer))) {
+            numaNode_p->memory = fwiFindMemInfo(buffer, "MemTotal:") / 1024u;
+        }
+    }
+    if (res_p->numaNodeCount == 0) { // kernel without NUMA support
+        res_p->numaNodeCount = 1;
+        res_p->numaNodes[0].memory = res_p->memory;
+        for (uint32_t i = 0; i < FW_SYSTEM_CPUS_MAX / 64; i++) {
+            res_p->numaNodes[0].cpus[i] = online[i];
+            res_p->numaNodes[0].cpuCount += __builtin_popcountll(online[i]);
+        }
+    }
 
     return fwErrorSuccess;
 }
 
-fwError fwSocketSend(const fwSocket sfdop, const void* data, const size_t ammount) {
-    struct fwiNativeSocketState* nativeSocket = {(struct fwiNativeSocketState*)sfdop};
+/**
+ * @brief The parts of the system configuration every mapping needs. Reading them walks sysfs, so
+ *        it happens once, on the first mapping.
+ */
+struct fwiMemoryTopology {
+    pthread_once_t once;
+    uint64_t pageSize;
+    uint64_t hugePageSize; // 0 without huge page support
+    uint64_t nodeMask; // bit n is set when NUMA node n exists
+    uint8_t nodeCount;
+};
 
-    const size_t written = write(nativeSocket->fileDescriptor, data, ammount);
-    if (written == -1) {
-        FWI_LOG_ERRNO;
-        return fwErrorSocketSend;
+static struct fwiMemoryTopology memoryTopology_s = {.once = PTHREAD_ONCE_INIT};
+
+static void fwiMemoryTopologyRead(void) {
+    struct fwSystemConfiguration configuration;
+    fwGetSystemConfiguration(&configuration);
+
+    memoryTopology_s.pageSize     = configuration.pageSize;
+    memoryTopology_s.hugePageSize = configuration.hugePageSize;
+    memoryTopology_s.nodeCount    = configuration.numaNodeCount;
+    for (uint8_t i = 0; i < configuration.numaNodeCount; i++) {
+        if (configuration.numaNodes[i].id < 64) {
+            memoryTopology_s.nodeMask |= 1ull << configuration.numaNodes[i].id;
+        }
     }
-    fwiLogA(fwiLogLevelDebug, "Socket (ID: %X) sent %d bytes", nativeSocket, written);
-    return fwErrorSuccess;
 }
 
-fwError fwSocketReceive(const fwSocket sfdop, void* buffer, const size_t ammount) {
-    struct fwiNativeSocketState* nativeSocket = {(struct fwiNativeSocketState*)sfdop};
+fwError fwiMapMemory(const uint64_t size, const int16_t numaNode, const uint8_t flags,
+                     void** memory_pp, uint64_t* mappedSize_p) {
+    pthread_once(&memoryTopology_s.once, fwiMemoryTopologyRead);
+    const struct fwiMemoryTopology* topology_p = &memoryTopology_s;
 
-    const size_t readden = read(nativeSocket->fileDescriptor, buffer, ammount); // grammar 100
-    if (readden == -1) {
-        FWI_LOG_ERRNO;
-        return fwErrorSocketReceive;
+    if (numaNode != FW_MEMORY_ANY_NODE &&
+        (numaNode < 0 || numaNode >= 64 || !(topology_p->nodeMask & (1ull << numaNode)))) {
+        return fwErrorInvalidParameter;
+    }
+
+    const uint64_t pageSize = topology_p->pageSize;
+    const uint64_t hugePageSize = topology_p->hugePageSize != 0 ? topology_p->hugePageSize
+                                                                : pageSize;
+    uint64_t mappedSize = (size + pageSize - 1) & ~(pageSize - 1);
+    void* memory_p = MAP_FAILED;
+
+    if ((flags & fwMemoryFlagHugePages) && topology_p->hugePageSize != 0) {
+        const uint64_t hugeSize = (size + hugePageSize - 1) & ~(hugePageSize - 1);
+        memory_p = mmap(nullptr, hugeSize, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory_p != MAP_FAILED) {
+            mappedSize = hugeSize;
+        }
+        else {
+            FWI_LOG_DEBUG("No huge pages for %lu bytes left, using regular pages", size);
+        }
+    }
+
+    if (memory_p == MAP_FAILED && (flags & fwMemoryFlagTransparentHugePages)) {
+        // The kernel only collapses aligned huge page ranges, so the region is cut out of a
+        // larger mapping at a huge page boundary
+        mappedSize = (size + hugePageSize - 1) & ~(hugePageSize - 1);
+        uint8_t* raw_p = mmap(nullptr, mappedSize + hugePageSize, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (raw_p == MAP_FAILED) {
+            FWI_LOG_ERRNO;
+            return fwErrorOutOfMemory;
+        }
+
+        uint8_t* aligned_p = (uint8_t*)(((uintptr_t)raw_p + hugePageSize - 1) &
+                                        ~(uintptr_t)(hugePageSize - 1));
+        if (aligned_p != raw_p) {
+            munmap(raw_p, aligned_p - raw_p);
+        }
+        munmap(aligned_p + mappedSize, raw_p + hugePageSize - aligned_p);
+        madvise(aligned_p, mappedSize, MADV_HUGEPAGE);
+        memory_p = aligned_p;
+    }
+
+    if (memory_p == MAP_FAILED) {
+        memory_p = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (memory_p == MAP_FAILED) {
+            FWI_LOG_ERRNO;
+            return fwErrorOutOfMemory;
+        }
+    }
+
+    // Has to happen before the first touch, pages are placed when they are faulted in
+    if (numaNode != FW_MEMORY_ANY_NODE && topology_p->nodeCount > 1) {
+        const unsigned long nodeMask = 1ul << numaNode;
+        // The kernel reads one bit less than maxnode
+        if (syscall(SYS_mbind, memory_p, mappedSize, MPOL_PREFERRED, &nodeMask,
+                    sizeof(nodeMask) * 8 + 1, 0) != 0) {
+            FWI_LOG_WARNING("Could not place memory on NUMA node %d", numaNode);
+        }
+    }
+
+    if (flags & fwMemoryFlagPrefault) {
+        for (uint64_t offset = 0; offset < mappedSize; offset += pageSize) {
+            ((volatile uint8_t*)memory_p)[offset] = 0;
+        }
     }
-    fwiLogA(fwiLogLevelDebug, "Socket (ID: %X) received %d bytes", nativeSocket, readden);
+
+    *memory_pp = memory_p;
+    *mappedSize_p = mappedSize;
     return fwErrorSuccess;
 }
 
-fwError fwSocketClose(const fwSocket sfdop) {
-    struct fwiNativeSocketState* nativeSocket = {(struct fwiNativeSocketState*)sfdop};
+void fwiUnmapMemory(void* memory_p, const uint64_t mappedSize) {
+    munmap(memory_p, mappedSize);
+}
 
-    if (close(nativeSocket->fileDescriptor) == -1) {
-        return fwErrorInvalidParameter;
+fwError fwBenchNow(uint64_t* nanoseconds_p) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    *nanoseconds_p = (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+    return fwErrorSuccess;
+}
+
+fwError fwLoadFileToMem(const char* filename_p, void** buffer_pp, uint64_t* fileSize_p) {
+    FILE* file = fopen(filename_p, "rb");
+    if (!(uintptr_t)file) {
+        return fwErrorFileUnableToOpen;
     }
 
-    free(nativeSocket);
+    const int32_t fileDescriptor = fileno(file); // should not error since file stream must be valid
+
+    struct stat fileStats;
+    if (fstat(fileDescriptor, &fileStats)) { // -1 on error
+        fclose(file);
+        return fwErrorFileStats;
+    }
+
+    *fileSize_p = fileStats.st_size;
+    *buffer_pp = malloc(*fileSize_p);
+    if (!(uintptr_t)*buffer_pp) {
+        fclose(file);
+        return fwErrorOutOfMemory;
+    }
+
+    // With the io_uring engine large files are read as many chunks in parallel
+    fwError error = fwErrorSuccess;
+    struct fwiNativeState* nativeState = fwiGetNativeState();
+    if (nativeState->fileIoQueue != 0 && *fileSize_p >= FWI_IO_QUEUE_FILE_CHUNK) {
+        pthread_mutex_lock(&nativeState->fileIoQueueMutex);
+        error = fwiReadFileQueued(nativeState->fileIoQueue, fileDescriptor, *buffer_pp,
+                                  *fileSize_p);
+        pthread_mutex_unlock(&nativeState->fileIoQueueMutex);
+    }
+    else if (fread(*buffer_pp, 1, *fileSize_p, file) != *fileSize_p) {
+        error = fwErrorFileStats;
+    }
+
+    // No queued read is in flight anymore, this is the only place the buffer is released
+    fclose(file);
+    if (error != fwErrorSuccess) {
+        free(*buffer_pp);
+        *buffer_pp = nullptr;
+    }
+    return error;
+}
+
+fwError fwMapFile(const char* filename_p, const uint8_t hints, const void** view_pp,
+                  uint64_t* fileSize_p) {
+    const int32_t fileDescriptor = open(filename_p, O_RDONLY | O_CLOEXEC);
+    if (fileDescriptor == -1) {
+        return fwErrorFileUnableToOpen;
+    }
+
+    struct stat fileStats;
+    if (fstat(fileDescriptor, &fileStats)) {
+        close(fileDescriptor);
+        return fwErrorFileStats;
+    }
+
+    *fileSize_p = fileStats.st_size;
+    if (*fileSize_p == 0) { // mmap refuses empty mappings
+        close(fileDescriptor);
+        *view_pp = nullptr;
+        return fwErrorSuccess;
+    }
+
+    void* view_p = mmap(nullptr, *fileSize_p, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    close(fileDescriptor); // the mapping keeps its own reference to the file
+    if (view_p == MAP_FAILED) {
+        FWI_LOG_ERRNO;
+        return fwErrorFileMap;
+    }
+
+    // Hints are only advisory, a kernel that does not know one must not fail the mapping
+    if (hints & fwFileMapHintSequential) {
+        madvise(view_p, *fileSize_p, MADV_SEQUENTIAL);
+    }
+    if (hints & fwFileMapHintRandom) {
+        madvise(view_p, *fileSize_p, MADV_RANDOM);
+    }
+    if (hints & fwFileMapHintHugePage) {
+        madvise(view_p, *fileSize_p, MADV_HUGEPAGE);
+    }
+    if (hints & fwFileMapHintWillNeed) {
+        madvise(view_p, *fileSize_p, MADV_WILLNEED);
+    }
+
+    *view_pp = view_p;
+    return fwErrorSuccess;
+}
+
+fwError fwUnmapFile(const void* view_p, const uint64_t fileSize) {
+    if (view_p == nullptr) {
+        return fwErrorSuccess;
+    }
+
+    if (munmap((void*)view_p, fileSize) == -1) {
+        return fwErrorInvalidParameter;
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwSocketCreate(fwSocket* sfdop_p, const fwSocketAddressFamily addressFamily,
+                       const fwSocketProtocol protocol) {
+    int32_t realAddressFamily, realProtocol;
+
+    switch (addressFamily) {
+        case fwSocketAddressFamilyLocal: {
+            realAddressFamily = AF_LOCAL;
+            break;
+        }
+        case fwSocketAddressFamilyIPv4: {
+            realAddressFamily = AF_INET;
+            break;
+        }
+        case fwSocketAddressFamilyIPv6: {
+            realAddressFamily = AF_INET6;
+            break;
+        }
+        default: {
+            return fwErrorInvalidParameter;
+        }
+    }
+
+    switch (protocol) {
+        case fwSocketProtocolStream: {
+            realProtocol = SOCK_STREAM;
+            break;
+        }
+        case fwSocketProtocolDatagram: {
+            realProtocol = SOCK_DGRAM;
+            break;
+        }
+        case fwSocketProtocolRaw: {
+            realProtocol = SOCK_RAW;
+            break;
+        }
+        default: {
+            return fwErrorInvalidParameter;
+        }
+    }
+
+    // The state lives in the socket table, it is handed back in fwSocketClose
+    struct fwiNativeSocketState* nativeSocket = nullptr;
+    const fwError error = fwiSocketAllocate(&nativeSocket);
+    if (error != fwErrorSuccess) {
+        return error;
+    }
+
+    nativeSocket->protocol       = realProtocol;
+    nativeSocket->addressFamily  = realAddressFamily;
+    if ((nativeSocket->fileDescriptor = socket(realAddressFamily, realProtocol, 0)) == -1) {
+        const int32_t err = errno; // the logger may change it
+        FWI_LOG_ERRNO;
+        fwiSocketRelease(nativeSocket);
+        if (err == EACCES || err == EPERM) { // raw sockets need CAP_NET_RAW, policies may deny more
+            return fwErrorPermission;
+        }
+        return err == EMFILE || err == ENFILE || err == ENOBUFS ? fwErrorOutOfMemory
+                                                                : fwErrorInvalidParameter;
+    }
+
+    *sfdop_p = nativeSocket->handle;
+
+    FWI_LOG_INFO("New socket (ID: %lX) was created", nativeSocket->handle);
+    return fwErrorSuccess;
+}
+
+/**
+ * @brief One address of a resolver cache entry, big enough for both internet families
+ */
+struct fwiResolvedAddress {
+    union {
+        struct sockaddr address;
+        struct sockaddr_in v4;
+        struct sockaddr_in6 v6;
+    };
+    socklen_t length;
+    int32_t family;
+};
+
+typedef enum fwiResolverState : uint8_t {
+    fwiResolverStateEmpty,
+    fwiResolverStateResolving /*! getaddrinfo is running, lookups for the name wait for it */,
+    fwiResolverStateReady
+} fwiResolverState;
+
+struct fwiResolverEntry {
+    uint64_t hash;
+    int64_t expires; // monotonic milliseconds
+    int64_t lastUse;
+    fwError error; // cached as well, for negative entries
+    fwiResolverState state;
+    uint8_t addressCount;
+    struct fwiResolvedAddress addresses[FWI_RESOLVER_ADDRESSES];
+    char host[FWI_RESOLVER_HOST_SIZE];
+    char port[FWI_RESOLVER_PORT_SIZE];
+};
+
+/**
+ * @brief Cache of name lookups, shared by every socket. getaddrinfo does not report the TTL of
+ *        the records, so entries live for a configured time instead.
+ */
+struct fwiResolver {
+    pthread_mutex_t mutex;
+    pthread_cond_t resolved; // broadcast whenever any lookup finishes
+    uint32_t ttl;
+    uint32_t negativeTtl;
+    struct fwiResolverEntry entries[FWI_RESOLVER_ENTRIES];
+};
+
+static struct fwiResolver resolver_s = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .resolved = PTHREAD_COND_INITIALIZER,
+    .ttl = FWI_RESOLVER_DEFAULT_TTL,
+    .negativeTtl = FWI_RESOLVER_DEFAULT_NEGATIVE_TTL
+};
+
+static int64_t fwiMonotonicMilliseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Hands the read and write timeouts of a socket to the kernel, blocking calls obey them
+ */
+static bool fwiSocketApplyTimeouts(const int32_t fileDescriptor,
+                                   const struct fwSocketTimeouts* timeouts_p) {
+    const struct timeval receive = {
+        .tv_sec = timeouts_p->read / 1000, .tv_usec = timeouts_p->read % 1000 * 1000
+    };
+    const struct timeval send = {
+        .tv_sec = timeouts_p->write / 1000, .tv_usec = timeouts_p->write % 1000 * 1000
+    };
+    return setsockopt(fileDescriptor, SOL_SOCKET, SO_RCVTIMEO, &receive, sizeof(receive)) == 0 &&
+           setsockopt(fileDescriptor, SOL_SOCKET, SO_SNDTIMEO, &send, sizeof(send)) == 0;
+}
+
+// Connecting to AF_UNSPEC dissolves a pending handshake, the socket is unconnected again afterwards
+static void fwiSocketAbortConnect(const int32_t fileDescriptor) {
+    const struct sockaddr unspecified = {.sa_family = AF_UNSPEC};
+    connect(fileDescriptor, &unspecified, sizeof(unspecified));
+}
+
+static uint64_t fwiResolverHash(const char* host_p, const char* port_p) {
+    uint64_t hash = 14695981039346656037ull; // FNV-1a
+    for (; *host_p != '\0'; host_p++) {
+        hash = (hash ^ (uint8_t)*host_p) * 1099511628211ull;
+    }
+    hash = (hash ^ ':') * 1099511628211ull;
+    for (; *port_p != '\0'; port_p++) {
+        hash = (hash ^ (uint8_t)*port_p) * 1099511628211ull;
+    }
+    return hash;
+}
+
+/**
+ * @brief Finds the entry of a name or claims a slot for it, has to be called with the lock held
+ * @return @c nullptr if every slot the name may use is busy resolving
+ */
+static struct fwiResolverEntry* fwiResolverClaim(const char* host_p, const char* port_p,
+                                                 const uint64_t hash, const int64_t now) {
+    struct fwiResolverEntry* victim_p = nullptr;
+    for (uint32_t i = 0; i < FWI_RESOLVER_PROBES; i++) {
+        struct fwiResolverEntry* entry_p = &resolver_s.entries[(hash + i) % FWI_RESOLVER_ENTRIES];
+        if (entry_p->state != fwiResolverStateEmpty && entry_p->hash == hash &&
+            strcmp(entry_p->host, host_p) == 0 && strcmp(entry_p->port, port_p) == 0) {
+            return entry_p;
+        }
+
+        // Empty before expired before least recently used, resolving entries are never taken
+        if (entry_p->state == fwiResolverStateResolving) {
+            continue;
+        }
+        if (victim_p == nullptr || entry_p->state == fwiResolverStateEmpty ||
+            (victim_p->state != fwiResolverStateEmpty && (entry_p->expires <= now ||
+             (victim_p->expires > now && entry_p->lastUse < victim_p->lastUse)))) {
+            victim_p = entry_p;
+        }
+    }
+
+    if (victim_p != nullptr) {
+        victim_p->state = fwiResolverStateEmpty;
+        victim_p->hash = hash;
+        strcpy(victim_p->host, host_p);
+        strcpy(victim_p->port, port_p);
+    }
+    return victim_p;
+}
+
+/**
+ * @brief Runs getaddrinfo for an entry that was set to resolving, the lock must not be held
+ */
+static void fwiResolverFill(struct fwiResolverEntry* entry_p) {
+    struct addrinfo hint   = {};
+    struct addrinfo* res_p = nullptr;
+    hint.ai_family         = AF_UNSPEC;
+    hint.ai_socktype       = SOCK_STREAM; // numeric ports resolve the same for every protocol
+
+    struct fwiResolvedAddress addresses[FWI_RESOLVER_ADDRESSES];
+    uint8_t count = 0;
+    const int32_t failed = getaddrinfo(entry_p->host, entry_p->port, &hint, &res_p);
+    if (!failed) {
+        for (const struct addrinfo* it = res_p; it != nullptr && count < FWI_RESOLVER_ADDRESSES;
+             it = it->ai_next) {
+            if ((it->ai_family == AF_INET || it->ai_family == AF_INET6) &&
+                it->ai_addrlen <= sizeof(struct sockaddr_in6)) {
+                memcpy(&addresses[count].address, it->ai_addr, it->ai_addrlen);
+                addresses[count].length = it->ai_addrlen;
+                addresses[count].family = it->ai_family;
+                count++;
+            }
+        }
+        freeaddrinfo(res_p);
+    }
+    else {
+        FWI_LOG_DEBUG("Could not resolve %s: %s", entry_p->host, gai_strerror(failed));
+    }
+
+    pthread_mutex_lock(&resolver_s.mutex);
+    const int64_t now = fwiMonotonicMilliseconds();
+    entry_p->error        = count != 0 ? fwErrorSuccess : fwErrorSocketTargetName;
+    entry_p->expires      = now + (count != 0 ? resolver_s.ttl : resolver_s.negativeTtl);
+    entry_p->addressCount = count;
+    memcpy(entry_p->addresses, addresses, count * sizeof(struct fwiResolvedAddress));
+    entry_p->state        = fwiResolverStateReady;
+    pthread_cond_broadcast(&resolver_s.resolved);
+    pthread_mutex_unlock(&resolver_s.mutex);
+}
+
+/**
+ * @brief Looks a name up through the cache, concurrent lookups of the same name share one query
+ * @param addresses_p[out] Receives up to FWI_RESOLVER_ADDRESSES addresses in preference order
+ * @param count_p[out] Number of addresses
+ */
+static fwError fwiResolve(const char* host_p, const char* port_p,
+                          struct fwiResolvedAddress* addresses_p, uint32_t* count_p) {
+    if (strlen(host_p) >= FWI_RESOLVER_HOST_SIZE || strlen(port_p) >= FWI_RESOLVER_PORT_SIZE) {
+        return fwErrorSocketTargetName;
+    }
+    const uint64_t hash = fwiResolverHash(host_p, port_p);
+
+    pthread_mutex_lock(&resolver_s.mutex);
+    struct fwiResolverEntry* entry_p = nullptr;
+    for (;;) {
+        const int64_t now = fwiMonotonicMilliseconds();
+        entry_p = fwiResolverClaim(host_p, port_p, hash, now);
+        if (entry_p == nullptr || entry_p->state == fwiResolverStateResolving) {
+            pthread_cond_wait(&resolver_s.resolved, &resolver_s.mutex);
+            continue; // the entry may have been evicted and reused in the meantime
+        }
+        if (entry_p->state == fwiResolverStateReady && entry_p->expires > now) {
+            break;
+        }
+
+        entry_p->state = fwiResolverStateResolving;
+        pthread_mutex_unlock(&resolver_s.mutex);
+        fwiResolverFill(entry_p);
+        pthread_mutex_lock(&resolver_s.mutex);
+        if (entry_p->state == fwiResolverStateReady &&
+            strcmp(entry_p->host, host_p) == 0 && strcmp(entry_p->port, port_p) == 0) {
+            break; // used even if it expired already, the query was just made
+        }
+    }
+
+    entry_p->lastUse = fwiMonotonicMilliseconds();
+    const fwError error = entry_p->error;
+    *count_p = entry_p->addressCount;
+    memcpy(addresses_p, entry_p->addresses, entry_p->addressCount * sizeof(*addresses_p));
+    pthread_mutex_unlock(&resolver_s.mutex);
+    return error;
+}
+
+static void fwiResolverPrefetchJob(void* entry_p) {
+    fwiResolverFill(entry_p);
+}
+
+// Claims slots for names that are neither cached nor being resolved, fills entries_pp with them
+static uint32_t fwiResolverClaimMissing(const struct fwSocketAddress* addresses_p,
+                                        const uint32_t count,
+                                        struct fwiResolverEntry** entries_pp) {
+    uint32_t claimed = 0;
+    pthread_mutex_lock(&resolver_s.mutex);
+    const int64_t now = fwiMonotonicMilliseconds();
+    for (uint32_t i = 0; i < count; i++) {
+        const char* host_p = addresses_p[i].target_p;
+        const char* port_p = addresses_p[i].port_p;
+        if (strlen(host_p) >= FWI_RESOLVER_HOST_SIZE || strlen(port_p) >= FWI_RESOLVER_PORT_SIZE) {
+            continue;
+        }
+
+        struct fwiResolverEntry* entry_p = fwiResolverClaim(host_p, port_p,
+                                                            fwiResolverHash(host_p, port_p), now);
+        if (entry_p == nullptr || entry_p->state == fwiResolverStateResolving ||
+            (entry_p->state == fwiResolverStateReady && entry_p->expires > now)) {
+            continue;
+        }
+        entry_p->state = fwiResolverStateResolving;
+        entries_pp[claimed++] = entry_p;
+    }
+    pthread_mutex_unlock(&resolver_s.mutex);
+    return claimed;
+}
+
+fwError fwResolverConfigure(const struct fwResolverConfiguration* configuration_p) {
+    if (configuration_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    pthread_mutex_lock(&resolver_s.mutex);
+    resolver_s.ttl         = configuration_p->ttl != 0 ? configuration_p->ttl
+                                                       : FWI_RESOLVER_DEFAULT_TTL;
+    resolver_s.negativeTtl = configuration_p->negativeTtl;
+    pthread_mutex_unlock(&resolver_s.mutex);
+    return fwErrorSuccess;
+}
+
+fwError fwResolverPrefetch(const struct fwSocketAddress* addresses_p, const uint32_t count) {
+    uint32_t workers = 0;
+    if (fwJobGetWorkerCount(&workers) != fwErrorSuccess) {
+        return fwErrorModule;
+    }
+    if (addresses_p == nullptr && count != 0) {
+        return fwErrorInvalidParameter;
+    }
+
+    for (uint32_t first = 0; first < count; first += FWI_RESOLVER_ENTRIES) {
+        const uint32_t chunk = count - first < FWI_RESOLVER_ENTRIES ? count - first
+                                                                    : FWI_RESOLVER_ENTRIES;
+        struct fwiResolverEntry* entries[FWI_RESOLVER_ENTRIES];
+        fwJob jobs[FWI_RESOLVER_ENTRIES];
+        const uint32_t claimed = fwiResolverClaimMissing(&addresses_p[first], chunk, entries);
+        for (uint32_t i = 0; i < claimed; i++) {
+            jobs[i] = (fwJob){.function = fwiResolverPrefetchJob, .user_p = entries[i]};
+        }
+
+        const fwError error = fwJobSubmit(jobs, claimed, 0);
+        if (error != fwErrorSuccess) {
+            // Releases the claims, the names get resolved on first use instead
+            pthread_mutex_lock(&resolver_s.mutex);
+            for (uint32_t i = 0; i < claimed; i++) {
+                entries[i]->state = fwiResolverStateEmpty;
+            }
+            pthread_cond_broadcast(&resolver_s.resolved);
+            pthread_mutex_unlock(&resolver_s.mutex);
+            return error;
+        }
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwResolverWarmup(const struct fwSocketAddress* addresses_p, const uint32_t count) {
+    if (addresses_p == nullptr && count != 0) {
+        return fwErrorInvalidParameter;
+    }
+
+    // Fanned out over the job system when it runs, the lookups below then only collect results
+    fwResolverPrefetch(addresses_p, count);
+
+    fwError ret = fwErrorSuccess;
+    for (uint32_t i = 0; i < count; i++) {
+        struct fwiResolvedAddress resolved[FWI_RESOLVER_ADDRESSES];
+        uint32_t resolvedCount = 0;
+        if (fwiResolve(addresses_p[i].target_p, addresses_p[i].port_p, resolved,
+                       &resolvedCount) != fwErrorSuccess) {
+            ret = fwErrorSocketTargetName;
+        }
+    }
+    return ret;
+}
+
+fwError fwResolverFlush(void) {
+    pthread_mutex_lock(&resolver_s.mutex);
+    for (uint32_t i = 0; i < FWI_RESOLVER_ENTRIES; i++) {
+        if (resolver_s.entries[i].state == fwiResolverStateReady) {
+            resolver_s.entries[i].state = fwiResolverStateEmpty;
+        }
+    }
+    pthread_mutex_unlock(&resolver_s.mutex);
+    return fwErrorSuccess;
+}
+
+/**
+ * @brief Connects a local socket to the path the peer was bound to, there is nothing to resolve
+ */
+static fwError fwiSocketConnectLocal(struct fwiNativeSocketState* nativeSocket,
+                                     const fwSocketAddress* connectInfo_p) {
+    struct sockaddr_un address = {};
+    address.sun_family = AF_LOCAL;
+    if (strlen(connectInfo_p->target_p) >= sizeof(address.sun_path)) {
+        return fwErrorSocketTargetName;
+    }
+    strcpy(address.sun_path, connectInfo_p->target_p);
+
+    int32_t connected;
+    do {
+        connected = connect(nativeSocket->fileDescriptor, (struct sockaddr*)&address,
+                            sizeof(address));
+    } while (connected == -1 && errno == EINTR);
+    if (connected == -1) {
+        FWI_LOG_ERRNO;
+        return fwErrorSocketConnection;
+    }
+
+    nativeSocket->connected = true;
+    nativeSocket->bound = true;
+    strncpy(nativeSocket->targetAddress, connectInfo_p->target_p,
+            FWI_SOCKET_TARGET_ADDRESS_SIZE - 1);
+
+    FWI_LOG_INFO("Socket (ID: %lX) connected to %s", nativeSocket->handle, connectInfo_p->target_p);
+    return fwErrorSuccess;
+}
+
+/**
+ * @brief Learns how a non-blocking connect ended, the socket stays connecting while it is in flight
+ */
+static fwError fwiSocketFinishConnect(struct fwiNativeSocketState* nativeSocket) {
+    int32_t pending = 0;
+    socklen_t length = sizeof(pending);
+    getsockopt(nativeSocket->fileDescriptor, SOL_SOCKET, SO_ERROR, &pending, &length);
+    if (pending != 0) {
+        nativeSocket->connecting = false;
+        errno = pending;
+        FWI_LOG_ERRNO;
+        return fwErrorSocketConnection;
+    }
+
+    struct sockaddr_storage peer;
+    socklen_t peerLength = sizeof(peer);
+    if (getpeername(nativeSocket->fileDescriptor, (struct sockaddr*)&peer, &peerLength) == -1) {
+        return fwErrorSocketWouldBlock; // not connected yet, the handshake is still running
+    }
+
+    nativeSocket->connecting = false;
+    nativeSocket->connected = true;
+    nativeSocket->bound = true;
+    FWI_LOG_INFO("Socket (ID: %lX) connected to %s", nativeSocket->handle,
+                 nativeSocket->targetAddress);
+    return fwErrorSuccess;
+}
+
+fwError fwSocketConnect(const fwSocket sfdop, const fwSocketAddress* connectInfo_p) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+    if (nativeSocket->addressFamily == AF_LOCAL) {
+        return fwiSocketConnectLocal(nativeSocket, connectInfo_p);
+    }
+    if (nativeSocket->connecting) {
+        return fwiSocketFinishConnect(nativeSocket);
+    }
+
+    struct fwiResolvedAddress addresses[FWI_RESOLVER_ADDRESSES];
+    uint32_t count = 0;
+    const fwError error = fwiResolve(connectInfo_p->target_p, connectInfo_p->port_p, addresses,
+                                     &count);
+    if (error != fwErrorSuccess) {
+        return error;
+    }
+
+    // A refused connect leaves a Linux socket unconnected, so the same descriptor can try again
+    uint32_t i = 0;
+    for (; i < count; i++) {
+        if (addresses[i].family != nativeSocket->addressFamily) {
+            continue;
+        }
+        if (connect(nativeSocket->fileDescriptor, &addresses[i].address,
+                    addresses[i].length) == 0) {
+            break;
+        }
+        if (errno == EINPROGRESS && !nativeSocket->nonBlocking) { // SO_SNDTIMEO ran out
+            fwiSocketAbortConnect(nativeSocket->fileDescriptor);
+            return fwErrorSocketTimeout;
+        }
+        if (errno == EINPROGRESS) { // finishes in the background, fwEventWrite reports the end
+            nativeSocket->connecting = true;
+            strncpy(nativeSocket->targetAddress, connectInfo_p->target_p,
+                    FWI_SOCKET_TARGET_ADDRESS_SIZE - 1);
+            return fwErrorSocketWouldBlock;
+        }
+        FWI_LOG_ERRNO;
+    }
+
+    if (i == count) {
+        return fwErrorSocketConnection;
+    }
+
+    nativeSocket->connected = true;
+    nativeSocket->bound = true;
+    strncpy(nativeSocket->targetAddress, connectInfo_p->target_p,
+            FWI_SOCKET_TARGET_ADDRESS_SIZE - 1);
+
+    FWI_LOG_INFO("Socket (ID: %lX) connected to %s", nativeSocket->handle, connectInfo_p->target_p);
+    return fwErrorSuccess;
+}
+
+/**
+ * @brief Orders resolved addresses the way RFC 8305 section 4 asks for, alternating between the
+ *        families and starting with the family of the first, most preferred, address
+ */
+static uint32_t fwiSortAttempts(const struct fwiResolvedAddress* addresses_p, const uint32_t count,
+                                const struct fwiResolvedAddress** attempts_pp) {
+    const struct fwiResolvedAddress* primary[FWI_RESOLVER_ADDRESSES];
+    const struct fwiResolvedAddress* secondary[FWI_RESOLVER_ADDRESSES];
+    uint32_t primaryCount = 0, secondaryCount = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (addresses_p[i].family == addresses_p[0].family) {
+            primary[primaryCount++] = &addresses_p[i];
+        }
+        else {
+            secondary[secondaryCount++] = &addresses_p[i];
+        }
+    }
+
+    uint32_t sorted = 0;
+    for (uint32_t i = 0; i < primaryCount || i < secondaryCount; i++) {
+        if (i < primaryCount) {
+            attempts_pp[sorted++] = primary[i];
+        }
+        if (i < secondaryCount) {
+            attempts_pp[sorted++] = secondary[i];
+        }
+    }
+    return sorted;
+}
+
+fwError fwSocketConnectParallel(const fwSocket sfdop, const fwSocketAddress* connectInfo_p,
+                                const uint32_t timeout) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr || connectInfo_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+    // Datagram connects never wait and local sockets only have one address
+    if (nativeSocket->protocol != SOCK_STREAM || nativeSocket->addressFamily == AF_LOCAL) {
+        return fwSocketConnect(sfdop, connectInfo_p);
+    }
+    // Epoll watches the descriptor that is about to be replaced
+    if (nativeSocket->eventSource.loop_p != nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    // Both families race, whatever the socket was created with
+    struct fwiResolvedAddress addresses[FWI_RESOLVER_ADDRESSES];
+    uint32_t count = 0;
+    const fwError error = fwiResolve(connectInfo_p->target_p, connectInfo_p->port_p, addresses,
+                                     &count);
+    if (error != fwErrorSuccess) {
+        return error;
+    }
+
+    const struct fwiResolvedAddress* attempts[FWI_RESOLVER_ADDRESSES];
+    const uint32_t attemptCount = fwiSortAttempts(addresses, count, attempts);
+
+    struct pollfd pending[FWI_RESOLVER_ADDRESSES];
+    int32_t pendingFamilies[FWI_RESOLVER_ADDRESSES];
+    uint32_t pendingCount = 0;
+    uint32_t next = 0;
+    int32_t winner = -1;
+    int32_t winnerFamily = 0;
+
+    const int64_t deadline = timeout != 0 ? fwiMonotonicMilliseconds() + timeout : INT64_MAX;
+    int64_t nextAttempt = fwiMonotonicMilliseconds();
+
+    while (winner == -1 && (next < attemptCount || pendingCount != 0)) {
+        const int64_t now = fwiMonotonicMilliseconds();
+        if (now >= deadline) {
+            break;
+        }
+
+        // Starts the next attempt once the delay ran out or nothing is in flight anymore
+        if (next < attemptCount && (now >= nextAttempt || pendingCount == 0)) {
+            const struct fwiResolvedAddress* address_p = attempts[next++];
+            const int32_t fileDescriptor = socket(address_p->family,
+                                                  SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fileDescriptor == -1) {
+                FWI_LOG_ERRNO;
+                continue;
+            }
+            // Before the handshake, the buffer sizes decide the window scale it negotiates. Fast
+            // open is left out, its connect returns before the address proved to be reachable.
+            if (nativeSocket->configured) {
+                fwiSocketApplyOptions(nativeSocket, fileDescriptor, false);
+            }
+
+            if (connect(fileDescriptor, &address_p->address, address_p->length) == 0) {
+                winner = fileDescriptor; // loopback can complete right away
+                winnerFamily = address_p->family;
+                break;
+            }
+            if (errno != EINPROGRESS) {
+                close(fileDescriptor);
+                continue; // failed immediately, the next one goes without waiting
+            }
+
+            pending[pendingCount] = (struct pollfd){.fd = fileDescriptor, .events = POLLOUT};
+            pendingFamilies[pendingCount++] = address_p->family;
+            nextAttempt = now + FWI_SOCKET_CONNECT_DELAY;
+        }
+
+        int64_t wait = deadline - now;
+        if (next < attemptCount && nextAttempt - now < wait) {
+            wait = nextAttempt - now > 0 ? nextAttempt - now : 0;
+        }
+        const int32_t ready = poll(pending, pendingCount, wait > INT32_MAX ? -1 : (int32_t)wait);
+        if (ready <= 0) {
+            continue; // delay or deadline reached, EINTR just goes around once more
+        }
+
+        for (uint32_t i = 0; i < pendingCount && winner == -1;) {
+            if (pending[i].revents == 0) {
+                i++;
+                continue;
+            }
+
+            int32_t error = 0;
+            socklen_t length = sizeof(error);
+            getsockopt(pending[i].fd, SOL_SOCKET, SO_ERROR, &error, &length);
+            if (error == 0) {
+                winner = pending[i].fd;
+                winnerFamily = pendingFamilies[i];
+            }
+            else {
+                close(pending[i].fd);
+                nextAttempt = 0; // a failed attempt lets the next one start at once
+            }
+
+            pending[i] = pending[--pendingCount];
+            pendingFamilies[i] = pendingFamilies[pendingCount];
+        }
+    }
+
+    for (uint32_t i = 0; i < pendingCount; i++) {
+        close(pending[i].fd);
+    }
+
+    if (winner == -1) {
+        FWI_LOG_ERROR("Socket (ID: %lX) could not connect to %s", nativeSocket->handle,
+                      connectInfo_p->target_p);
+        return fwErrorSocketConnection;
+    }
+
+    // The winner takes over the socket and keeps the blocking mode and timeouts of the caller
+    if (!nativeSocket->nonBlocking) {
+        fcntl(winner, F_SETFL, fcntl(winner, F_GETFL) & ~O_NONBLOCK);
+    }
+    if (nativeSocket->timeouts.read != 0 || nativeSocket->timeouts.write != 0) {
+        fwiSocketApplyTimeouts(winner, &nativeSocket->timeouts);
+    }
+    // Notifications of the old descriptor are gone with it, the kernel counts from 0 again
+    if (nativeSocket->zeroCopyCallback != nullptr) {
+        const int32_t enable = 1;
+        if (setsockopt(winner, SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable)) == -1) {
+            FWI_LOG_WARNING("Socket (ID: %lX) sends with copies again: %s", nativeSocket->handle,
+                            strerror(errno));
+            nativeSocket->zeroCopyCallback = nullptr;
+        }
+        nativeSocket->zeroCopyNext = 0;
+    }
+    close(nativeSocket->fileDescriptor);
+    nativeSocket->fileDescriptor = winner;
+    nativeSocket->addressFamily  = winnerFamily;
+    nativeSocket->connected      = true;
+    nativeSocket->bound          = true;
+    strncpy(nativeSocket->targetAddress, connectInfo_p->target_p,
+            FWI_SOCKET_TARGET_ADDRESS_SIZE - 1);
+
+    FWI_LOG_INFO("Socket (ID: %lX) connected to %s over %s", nativeSocket->handle,
+                 connectInfo_p->target_p, winnerFamily == AF_INET6 ? "IPv6" : "IPv4");
+    return fwErrorSuccess;
+}
+
+fwError fwSocketConnectTimeout(const fwSocket sfdop, const fwSocketAddress* connectInfo_p,
+                               const uint32_t timeout) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr || connectInfo_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+    // Neither datagram nor local connects wait for a handshake
+    if (nativeSocket->protocol != SOCK_STREAM || nativeSocket->addressFamily == AF_LOCAL) {
+        return fwSocketConnect(sfdop, connectInfo_p);
+    }
+
+    const int64_t deadline = timeout != 0 ? fwiMonotonicMilliseconds() + timeout : INT64_MAX;
+
+    struct fwiResolvedAddress addresses[FWI_RESOLVER_ADDRESSES];
+    uint32_t count = 0;
+    const fwError error = fwiResolve(connectInfo_p->target_p, connectInfo_p->port_p, addresses,
+                                     &count);
+    if (error != fwErrorSuccess) {
+        return error;
+    }
+
+    // The handshake is waited for with poll, the socket only looks non-blocking for this call
+    const int32_t flags = fcntl(nativeSocket->fileDescriptor, F_GETFL);
+    if (!nativeSocket->nonBlocking) {
+        fcntl(nativeSocket->fileDescriptor, F_SETFL, flags | O_NONBLOCK);
+    }
+
+    fwError ret = fwErrorSocketConnection;
+    for (uint32_t i = 0; i < count && ret == fwErrorSocketConnection; i++) {
+        if (addresses[i].family != nativeSocket->addressFamily) {
+            continue;
+        }
+        if (connect(nativeSocket->fileDescriptor, &addresses[i].address,
+                    addresses[i].length) == 0) {
+            ret = fwErrorSuccess;
+            break;
+        }
+        if (errno != EINPROGRESS) {
+            FWI_LOG_ERRNO;
+            continue; // refused right away, a Linux socket can try the next address
+        }
+
+        struct pollfd pending = {.fd = nativeSocket->fileDescriptor, .events = POLLOUT};
+        int32_t ready;
+        do {
+            const int64_t left = deadline - fwiMonotonicMilliseconds();
+            ready = left <= 0 ? 0 : poll(&pending, 1, left > INT32_MAX ? -1 : (int32_t)left);
+        } while (ready == -1 && errno == EINTR);
+
+        if (ready <= 0) {
+            fwiSocketAbortConnect(nativeSocket->fileDescriptor);
+            ret = fwErrorSocketTimeout;
+            break;
+        }
+
+        int32_t result = 0;
+        socklen_t length = sizeof(result);
+        getsockopt(nativeSocket->fileDescriptor, SOL_SOCKET, SO_ERROR, &result, &length);
+        if (result == 0) {
+            ret = fwErrorSuccess;
+            break;
+        }
+        errno = result;
+        FWI_LOG_ERRNO;
+    }
+
+    if (!nativeSocket->nonBlocking) {
+        fcntl(nativeSocket->fileDescriptor, F_SETFL, flags);
+    }
+
+    if (ret != fwErrorSuccess) {
+        FWI_LOG_ERROR("Socket (ID: %lX) could not connect to %s in time", nativeSocket->handle,
+                      connectInfo_p->target_p);
+        return ret;
+    }
+
+    nativeSocket->connected = true;
+    nativeSocket->bound = true;
+    strncpy(nativeSocket->targetAddress, connectInfo_p->target_p,
+            FWI_SOCKET_TARGET_ADDRESS_SIZE - 1);
+
+    FWI_LOG_INFO("Socket (ID: %lX) connected to %s", nativeSocket->handle, connectInfo_p->target_p);
+    return fwErrorSuccess;
+}
+
+/**
+ * @brief A connection of a pool, it travels with its socket while checked out and is linked into
+ *        a bucket of a shard while idle
+ */
+struct fwiPooledConnection {
+    struct fwiPooledConnection* next_p;
+    fwSocket socket;
+    uint64_t hash;
+    int64_t created; // monotonic milliseconds
+    int64_t idleSince;
+    char host[FWI_RESOLVER_HOST_SIZE];
+    char port[FWI_RESOLVER_PORT_SIZE];
+};
+
+struct fwiConnectionPoolShard {
+    alignas(64) pthread_mutex_t mutex;
+    struct fwiPooledConnection* buckets[FWI_POOL_BUCKETS];
+};
+
+struct fwiConnectionPool {
+    struct fwConnectionPoolConfiguration configuration;
+    uint32_t shardCount;
+    struct fwiConnectionPoolShard* shards_p;
+};
+
+static atomic_uint poolThreadCount_s = 0;
+static thread_local uint32_t poolThread_s = UINT32_MAX;
+
+// Threads are numbered on first use, so that consecutive threads land on different shards
+static uint32_t fwiPoolThreadIndex(void) {
+    if (poolThread_s == UINT32_MAX) {
+        poolThread_s = atomic_fetch_add_explicit(&poolThreadCount_s, 1, memory_order_relaxed);
+    }
+    return poolThread_s;
+}
+
+static bool fwiPoolExpired(const struct fwiConnectionPool* nativePool,
+                           const struct fwiPooledConnection* connection_p, const int64_t now) {
+    const uint32_t maxAge = nativePool->configuration.maxAge;
+    return (maxAge != 0 && now - connection_p->created >= maxAge) ||
+           now - connection_p->idleSince >= nativePool->configuration.maxIdleTime;
+}
+
+/**
+ * @brief An idle connection is only usable if the peer neither closed it nor sent anything, a
+ *        pending socket error is reported by the peek as well
+ */
+static bool fwiPoolHealthy(const struct fwiPooledConnection* connection_p) {
+    const struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(connection_p->socket);
+    if (nativeSocket == nullptr) {
+        return false;
+    }
+
+    uint8_t byte = 0;
+    const ssize_t peeked = recv(nativeSocket->fileDescriptor, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+    return peeked == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+static void fwiPoolDiscard(struct fwiPooledConnection* connection_p) {
+    while (connection_p != nullptr) {
+        struct fwiPooledConnection* next_p = connection_p->next_p;
+        // Closing frees the connection along with the socket, unless the socket is already gone
+        if (fwSocketClose(connection_p->socket) != fwErrorSuccess) {
+            free(connection_p);
+        }
+        connection_p = next_p;
+    }
+}
+
+/**
+ * @brief Unlinks the newest healthy idle connection to a target from a locked shard, the stale
+ *        ones that are found on the way are moved onto the discard list
+ */
+static struct fwiPooledConnection* fwiPoolTake(const struct fwiConnectionPool* nativePool,
+                                               struct fwiConnectionPoolShard* shard_p,
+                                               const char* host_p, const char* port_p,
+                                               const uint64_t hash, const int64_t now,
+                                               struct fwiPooledConnection** discard_pp) {
+    struct fwiPooledConnection** link_pp = &shard_p->buckets[hash % FWI_POOL_BUCKETS];
+    while (*link_pp != nullptr) {
+        struct fwiPooledConnection* connection_p = *link_pp;
+        if (connection_p->hash != hash || strcmp(connection_p->host, host_p) != 0 ||
+            strcmp(connection_p->port, port_p) != 0) {
+            link_pp = &connection_p->next_p;
+            continue;
+        }
+
+        *link_pp = connection_p->next_p;
+        if (!fwiPoolExpired(nativePool, connection_p, now) && fwiPoolHealthy(connection_p)) {
+            return connection_p;
+        }
+        connection_p->next_p = *discard_pp;
+        *discard_pp = connection_p;
+    }
+    return nullptr;
+}
+
+fwError fwConnectionPoolCreate(const struct fwConnectionPoolConfiguration* configuration_p,
+                               fwConnectionPool* pool_p) {
+    if (configuration_p == nullptr || pool_p == nullptr ||
+        configuration_p->addressFamily > fwSocketAddressFamilyLocal) {
+        return fwErrorInvalidParameter;
+    }
+
+    struct fwiConnectionPool* nativePool = calloc(1, sizeof(struct fwiConnectionPool));
+    if (nativePool == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+
+    nativePool->configuration = *configuration_p;
+    if (nativePool->configuration.maxIdle == 0) {
+        nativePool->configuration.maxIdle = FWI_POOL_DEFAULT_MAX_IDLE;
+    }
+    if (nativePool->configuration.maxIdleTime == 0) {
+        nativePool->configuration.maxIdleTime = FWI_POOL_DEFAULT_IDLE_TIME;
+    }
+
+    uint32_t shardCount = configuration_p->shards;
+    if (shardCount == 0) {
+        const long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        shardCount = processors > 0 ? (uint32_t)processors : 1;
+    }
+    nativePool->shardCount = shardCount < FWI_POOL_MAX_SHARDS ? shardCount : FWI_POOL_MAX_SHARDS;
+
+    // Every shard sits on its own cache lines, the mutexes of neighbouring threads never share one
+    nativePool->shards_p = aligned_alloc(64, nativePool->shardCount *
+                                             sizeof(struct fwiConnectionPoolShard));
+    if (nativePool->shards_p == nullptr) {
+        free(nativePool);
+        return fwErrorOutOfMemory;
+    }
+    for (uint32_t i = 0; i < nativePool->shardCount; i++) {
+        memset(&nativePool->shards_p[i], 0, sizeof(struct fwiConnectionPoolShard));
+        pthread_mutex_init(&nativePool->shards_p[i].mutex, nullptr);
+    }
+
+    *pool_p = (uintptr_t)nativePool;
+    return fwErrorSuccess;
+}
+
+fwError fwConnectionPoolDestroy(const fwConnectionPool pool) {
+    struct fwiConnectionPool* nativePool = {(struct fwiConnectionPool*)pool};
+    for (uint32_t i = 0; i < nativePool->shardCount; i++) {
+        struct fwiConnectionPoolShard* shard_p = &nativePool->shards_p[i];
+        for (uint32_t j = 0; j < FWI_POOL_BUCKETS; j++) {
+            fwiPoolDiscard(shard_p->buckets[j]);
+        }
+        pthread_mutex_destroy(&shard_p->mutex);
+    }
+
+    free(nativePool->shards_p);
+    free(nativePool);
+    return fwErrorSuccess;
+}
+
+fwError fwConnectionPoolAcquire(const fwConnectionPool pool,
+                                const struct fwSocketAddress* address_p, fwSocket* socket_p,
+                                bool* reused_p) {
+    struct fwiConnectionPool* nativePool = {(struct fwiConnectionPool*)pool};
+    if (address_p == nullptr || address_p->target_p == nullptr || address_p->port_p == nullptr ||
+        socket_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+    const char* host_p = address_p->target_p;
+    const char* port_p = address_p->port_p;
+    if (strlen(host_p) >= FWI_RESOLVER_HOST_SIZE || strlen(port_p) >= FWI_RESOLVER_PORT_SIZE) {
+        return fwErrorSocketTargetName;
+    }
+
+    const uint64_t hash = fwiResolverHash(host_p, port_p);
+    const int64_t now = fwiMonotonicMilliseconds();
+    const uint32_t own = fwiPoolThreadIndex() % nativePool->shardCount;
+    struct fwiPooledConnection* discard_p = nullptr;
+    struct fwiPooledConnection* connection_p = nullptr;
+
+    // Other shards are only worth a look while nobody holds them, waiting would cost more
+    for (uint32_t i = 0; i < nativePool->shardCount && connection_p == nullptr; i++) {
+        struct fwiConnectionPoolShard* shard_p =
+            &nativePool->shards_p[(own + i) % nativePool->shardCount];
+        if (i == 0) {
+            pthread_mutex_lock(&shard_p->mutex);
+        } else if (pthread_mutex_trylock(&shard_p->mutex) != 0) {
+            continue;
+        }
+        connection_p = fwiPoolTake(nativePool, shard_p, host_p, port_p, hash, now, &discard_p);
+        pthread_mutex_unlock(&shard_p->mutex);
+    }
+    fwiPoolDiscard(discard_p);
+
+    if (connection_p != nullptr) {
+        FWI_LOG_DEBUG("Socket (ID: %lX) was reused for %s", connection_p->socket, host_p);
+        *socket_p = connection_p->socket;
+        if (reused_p != nullptr) {
+            *reused_p = true;
+        }
+        return fwErrorSuccess;
+    }
+
+    connection_p = calloc(1, sizeof(struct fwiPooledConnection));
+    if (connection_p == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+    fwSocket socket = 0;
+    fwError ret = fwSocketCreate(&socket, nativePool->configuration.addressFamily,
+                                 fwSocketProtocolStream);
+    if (ret != fwErrorSuccess) {
+        free(connection_p);
+        return ret;
+    }
+    ret = fwSocketConnectParallel(socket, address_p, nativePool->configuration.connectTimeout);
+    if (ret != fwErrorSuccess) {
+        free(connection_p);
+        fwSocketClose(socket);
+        return ret;
+    }
+
+    connection_p->socket  = socket;
+    connection_p->hash    = hash;
+    connection_p->created = fwiMonotonicMilliseconds();
+    strcpy(connection_p->host, host_p);
+    strcpy(connection_p->port, port_p);
+    fwiSocketLookup(socket)->pooled_p = connection_p;
+
+    *socket_p = socket;
+    if (reused_p != nullptr) {
+        *reused_p = false;
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwConnectionPoolRelease(const fwConnectionPool pool, const fwSocket socket,
+                                const bool reusable) {
+    struct fwiConnectionPool* nativePool = {(struct fwiConnectionPool*)pool};
+    const struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(socket);
+    if (nativeSocket == nullptr || nativeSocket->pooled_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    struct fwiPooledConnection* connection_p = nativeSocket->pooled_p;
+    const int64_t now = fwiMonotonicMilliseconds();
+    connection_p->idleSince = now;
+    if (!reusable || fwiPoolExpired(nativePool, connection_p, now)) {
+        return fwSocketClose(socket);
+    }
+
+    struct fwiConnectionPoolShard* shard_p =
+        &nativePool->shards_p[fwiPoolThreadIndex() % nativePool->shardCount];
+    struct fwiPooledConnection** bucket_pp = &shard_p->buckets[connection_p->hash %
+                                                               FWI_POOL_BUCKETS];
+    pthread_mutex_lock(&shard_p->mutex);
+    uint32_t idle = 0;
+    for (const struct fwiPooledConnection* other_p = *bucket_pp; other_p != nullptr;
+         other_p = other_p->next_p) {
+        if (other_p->hash == connection_p->hash && strcmp(other_p->host, connection_p->host) == 0 &&
+            strcmp(other_p->port, connection_p->port) == 0) {
+            idle++;
+        }
+    }
+    // Newest first, so checkouts get the connection with the warmest congestion window
+    const bool kept = idle < nativePool->configuration.maxIdle;
+    if (kept) {
+        connection_p->next_p = *bucket_pp;
+        *bucket_pp = connection_p;
+    }
+    pthread_mutex_unlock(&shard_p->mutex);
+
+    return kept ? fwErrorSuccess : fwSocketClose(socket);
+}
+
+fwError fwConnectionPoolPrune(const fwConnectionPool pool, uint32_t* closed_p) {
+    struct fwiConnectionPool* nativePool = {(struct fwiConnectionPool*)pool};
+    const int64_t now = fwiMonotonicMilliseconds();
+    struct fwiPooledConnection* discard_p = nullptr;
+    uint32_t closed = 0;
+
+    for (uint32_t i = 0; i < nativePool->shardCount; i++) {
+        struct fwiConnectionPoolShard* shard_p = &nativePool->shards_p[i];
+        pthread_mutex_lock(&shard_p->mutex);
+        for (uint32_t j = 0; j < FWI_POOL_BUCKETS; j++) {
+            struct fwiPooledConnection** link_pp = &shard_p->buckets[j];
+            while (*link_pp != nullptr) {
+                struct fwiPooledConnection* connection_p = *link_pp;
+                if (!fwiPoolExpired(nativePool, connection_p, now)) {
+                    link_pp = &connection_p->next_p;
+                    continue;
+                }
+                *link_pp = connection_p->next_p;
+                connection_p->next_p = discard_p;
+                discard_p = connection_p;
+                closed++;
+            }
+        }
+        pthread_mutex_unlock(&shard_p->mutex);
+    }
+    fwiPoolDiscard(discard_p);
+
+    if (closed_p != nullptr) {
+        *closed_p = closed;
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwSocketBind(const fwSocket sfdop, const struct fwSocketAddress* localAddress) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    switch (nativeSocket->addressFamily) {
+        case AF_INET6:
+        case AF_INET: {
+            struct sockaddr_storage address = {};
+            socklen_t addressSize;
+            const bool any = strcmp(localAddress->target_p, FW_SOCKET_ADDRESS_ANY) == 0;
+            int32_t parsed = 1;
+            if (nativeSocket->addressFamily == AF_INET) {
+                struct sockaddr_in* address_p = (struct sockaddr_in*)&address;
+                address_p->sin_family = AF_INET;
+                address_p->sin_port   = htons(atoi(localAddress->port_p));
+                if (any) {
+                    address_p->sin_addr.s_addr = htonl(INADDR_ANY);
+                } else {
+                    parsed = inet_pton(AF_INET, localAddress->target_p, &address_p->sin_addr);
+                }
+                addressSize = sizeof(struct sockaddr_in);
+            } else {
+                struct sockaddr_in6* address_p = (struct sockaddr_in6*)&address;
+                address_p->sin6_family = AF_INET6;
+                address_p->sin6_port   = htons(atoi(localAddress->port_p));
+                if (any) {
+                    address_p->sin6_addr = in6addr_any;
+                } else {
+                    parsed = inet_pton(AF_INET6, localAddress->target_p, &address_p->sin6_addr);
+                }
+                addressSize = sizeof(struct sockaddr_in6);
+            }
+            if (parsed != 1) {
+                FWI_LOG_ERROR("Socket (ID: %lX) cannot bind to %s, it is no address of its family",
+                              nativeSocket->handle, localAddress->target_p);
+                return fwErrorInvalidParameter;
+            }
+
+            if (bind(nativeSocket->fileDescriptor, (struct sockaddr*)&address, addressSize) == -1) {
+                FWI_LOG_ERRNO;
+                return fwErrorSocketBind;
+            }
+
+            break;
+        }
+        case AF_LOCAL: {
+            struct sockaddr_un address = {};
+            address.sun_family = AF_LOCAL;
+            strncpy(address.sun_path, localAddress->target_p, sizeof(address.sun_path) - 1);
+
+            if (bind(nativeSocket->fileDescriptor, (struct sockaddr*)&address,
+                sizeof(address)) == -1) {
+                FWI_LOG_ERRNO;
+                return fwErrorSocketBind;
+            }
+
+            break;
+        }
+        default: {
+            return fwErrorGoodJob;
+        }
+    }
+
+    nativeSocket->bound = true;
+    FWI_LOG_INFO("Socket (ID: %lX) was bound to %s", nativeSocket->handle, localAddress->target_p);
+    return fwErrorSuccess;
+}
+
+/**
+ * @brief Wraps a descriptor that was accepted on @c listener_p into a new socket
+ *
+ * @c address_p is the peer as @c accept4 reported it, with @c nullptr it is looked up.
+ */
+static fwError fwiSocketAdopt(const struct fwiNativeSocketState* listener_p,
+                              const int32_t fileDescriptor, const bool nonBlocking,
+                              const struct sockaddr_storage* address_p, socklen_t addressSize,
+                              fwSocket* socket_p) {
+    struct fwiNativeSocketState* nativeSocket = nullptr;
+    const fwError error = fwiSocketAllocate(&nativeSocket);
+    if (error != fwErrorSuccess) {
+        close(fileDescriptor);
+        return error;
+    }
+    nativeSocket->connected      = true;
+    nativeSocket->bound          = true;
+    nativeSocket->protocol       = listener_p->protocol;
+    nativeSocket->addressFamily  = listener_p->addressFamily;
+    nativeSocket->fileDescriptor = fileDescriptor;
+    nativeSocket->nonBlocking    = nonBlocking;
+    nativeSocket->timeouts       = listener_p->timeouts; // the kernel copies them as well
+
+    // Callers that did not get the peer from accept pay for the lookup here
+    struct sockaddr_storage peer = {};
+    socklen_t peerSize = sizeof(peer);
+    if (address_p == nullptr) {
+        if (getpeername(fileDescriptor, (struct sockaddr*)&peer, &peerSize) == -1) {
+            peerSize = 0;
+        }
+        address_p = &peer;
+        addressSize = peerSize;
+    }
+    if (addressSize != 0) {
+        if (address_p->ss_family == AF_INET) {
+            inet_ntop(AF_INET, &((const struct sockaddr_in*)address_p)->sin_addr,
+                      nativeSocket->targetAddress, INET_ADDRSTRLEN);
+        } else if (address_p->ss_family == AF_INET6) {
+            inet_ntop(AF_INET6, &((const struct sockaddr_in6*)address_p)->sin6_addr,
+                      nativeSocket->targetAddress, INET6_ADDRSTRLEN);
+        } else if (address_p->ss_family == AF_LOCAL &&
+                   addressSize > offsetof(struct sockaddr_un, sun_path)) {
+            strncpy(nativeSocket->targetAddress, ((const struct sockaddr_un*)address_p)->sun_path,
+                    FWI_SOCKET_TARGET_ADDRESS_SIZE - 1);
+        }
+    }
+
+    *socket_p = nativeSocket->handle;
+    return fwErrorSuccess;
+}
+
+// Puts a bound socket into the listening state unless it already is
+static fwError fwiSocketEnsureListening(struct fwiNativeSocketState* nativeSocket,
+                                        const int32_t backlog) {
+    if (nativeSocket->bound == false) {
+        return fwErrorSocketNotBound;
+    }
+    if (nativeSocket->listening) {
+        return fwErrorSuccess;
+    }
+
+    if (listen(nativeSocket->fileDescriptor, backlog > 0 ? backlog : SOMAXCONN) == -1) {
+        FWI_LOG_ERRNO;
+        return fwErrorSocketListen;
+    }
+    nativeSocket->listening = true;
+    return fwErrorSuccess;
+}
+
+fwError fwSocketListen(const fwSocket sfdop, const int32_t backlog) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    // Listening again is allowed and only changes the backlog
+    nativeSocket->listening = false;
+    const fwError error = fwiSocketEnsureListening(nativeSocket, backlog);
+    if (error != fwErrorSuccess) {
+        return error;
+    }
+
+    FWI_LOG_INFO("Socket (ID: %lX) is listening", nativeSocket->handle);
+    return fwErrorSuccess;
+}
+
+fwError fwSocketListenSharded(const enum fwSocketAddressFamily addressFamily,
+                              const struct fwSocketAddress* localAddress, const uint32_t shards,
+                              const int32_t backlog, fwSocket* sockets_p) {
+    if (shards == 0 || localAddress == nullptr || sockets_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    fwError error = fwErrorSuccess;
+    uint32_t created = 0;
+    for (; created < shards; created++) {
+        if ((error = fwSocketCreate(&sockets_p[created], addressFamily,
+                                    fwSocketProtocolStream)) != fwErrorSuccess) {
+            break;
+        }
+
+        // Has to be set on every socket of the group before it is bound
+        struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sockets_p[created]);
+        const int32_t enable = 1;
+        if (setsockopt(nativeSocket->fileDescriptor, SOL_SOCKET, SO_REUSEPORT, &enable,
+                       sizeof(enable)) == -1) {
+            FWI_LOG_ERRNO;
+            error = fwErrorSocketBind;
+            created++;
+            break;
+        }
+
+        if ((error = fwSocketBind(sockets_p[created], localAddress)) != fwErrorSuccess ||
+            (error = fwSocketListen(sockets_p[created], backlog)) != fwErrorSuccess ||
+            (error = fwSocketSetNonBlocking(sockets_p[created], true)) != fwErrorSuccess) {
+            created++;
+            break;
+        }
+    }
+
+    if (error != fwErrorSuccess) {
+        for (uint32_t i = 0; i < created; i++) {
+            fwSocketClose(sockets_p[i]);
+        }
+        return error;
+    }
+
+    // Without a program the kernel spreads connections by hash, with it a connection lands on the
+    // shard of the CPU that received it, which keeps it on the core that already has it in cache
+    struct sock_filter code[] = {
+        {BPF_LD | BPF_W | BPF_ABS, 0, 0, (uint32_t)(SKF_AD_OFF + SKF_AD_CPU)},
+        {BPF_ALU | BPF_MOD | BPF_K, 0, 0, shards},
+        {BPF_RET | BPF_A, 0, 0, 0}
+    };
+    const struct sock_fprog program = {.len = sizeof(code) / sizeof(code[0]), .filter = code};
+    const struct fwiNativeSocketState* first_p = fwiSocketLookup(sockets_p[0]);
+    if (shards > 1 && setsockopt(first_p->fileDescriptor, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+                                 &program, sizeof(program)) == -1) {
+        FWI_LOG_DEBUG("Connections are spread by hash, CPU steering is not available");
+    }
+
+    return fwErrorSuccess;
+}
+
+fwError fwSocketAccept(const fwSocket sfdop, fwSocket* newSocket, char* foreignAddress) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    // Sockets that were never put into the listening state get the default backlog
+    const fwError error = fwiSocketEnsureListening(nativeSocket, 0);
+    if (error != fwErrorSuccess) {
+        return error;
+    }
+
+    int32_t fileDescriptor;
+    struct sockaddr_storage peer;
+    socklen_t peerSize;
+    do {
+        peerSize = sizeof(peer);
+        fileDescriptor = accept4(nativeSocket->fileDescriptor, (struct sockaddr*)&peer, &peerSize,
+                                 SOCK_CLOEXEC);
+    } while (fileDescriptor == -1 && errno == EINTR);
+
+    if (fileDescriptor == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return fwiSocketWouldBlock(nativeSocket);
+        }
+        FWI_LOG_ERRNO;
+        return fwErrorSocketAccept;
+    }
+
+    const fwError adopted = fwiSocketAdopt(nativeSocket, fileDescriptor, false, &peer, peerSize,
+                                           newSocket);
+    if (adopted != fwErrorSuccess) {
+        return adopted;
+    }
+
+    if (foreignAddress != nullptr) {
+        const struct fwiNativeSocketState* newNativeSocket = fwiSocketLookup(*newSocket);
+        strcpy(foreignAddress, newNativeSocket->targetAddress);
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwSocketAcceptTimeout(const fwSocket sfdop, fwSocket* newSocket, char* foreignAddress,
+                              const uint32_t timeout) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    const fwError error = fwiSocketEnsureListening(nativeSocket, 0);
+    if (error != fwErrorSuccess) {
+        return error;
+    }
+
+    const int64_t deadline = timeout != 0 ? fwiMonotonicMilliseconds() + timeout : INT64_MAX;
+    for (;;) {
+        struct pollfd listener = {.fd = nativeSocket->fileDescriptor, .events = POLLIN};
+        const int64_t left = deadline - fwiMonotonicMilliseconds();
+        const int32_t ready = left <= 0 ? 0 :
+                              poll(&listener, 1, left > INT32_MAX ? -1 : (int32_t)left);
+        if (ready == 0) {
+            return fwErrorSocketTimeout;
+        }
+        if (ready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            FWI_LOG_ERRNO;
+            return fwErrorSocketAccept;
+        }
+
+        // A non-blocking listener that lost the connection to another thread waits once more
+        const fwError ret = fwSocketAccept(sfdop, newSocket, foreignAddress);
+        if (ret != fwErrorSocketWouldBlock) {
+            return ret;
+        }
+    }
+}
+
+fwError fwSocketAcceptBatch(const fwSocket sfdop, fwSocket* sockets_p, const uint32_t count,
+                            uint32_t* accepted_p) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr || sockets_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    const fwError error = fwiSocketEnsureListening(nativeSocket, 0);
+    if (error != fwErrorSuccess) {
+        return error;
+    }
+
+    // Drains the accept queue without waiting, even if the listener itself is blocking
+    uint32_t accepted = 0;
+    fwError ret = fwErrorSuccess;
+    while (accepted < count) {
+        struct sockaddr_storage peer;
+        socklen_t peerSize = sizeof(peer);
+        const int32_t fileDescriptor = accept4(nativeSocket->fileDescriptor,
+                                               (struct sockaddr*)&peer, &peerSize,
+                                               SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (fileDescriptor == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                ret = fwErrorSocketWouldBlock;
+            }
+            else {
+                FWI_LOG_ERRNO;
+                ret = fwErrorSocketAccept;
+            }
+            break;
+        }
+
+        if ((ret = fwiSocketAdopt(nativeSocket, fileDescriptor, true, &peer, peerSize,
+                                  &sockets_p[accepted])) != fwErrorSuccess) {
+            break;
+        }
+        accepted++;
+    }
+
+    if (accepted_p != nullptr) {
+        *accepted_p = accepted;
+    }
+    if (accepted != 0) {
+        FWI_LOG_DEBUG("Socket (ID: %lX) accepted %u connections", nativeSocket->handle, accepted);
+        return fwErrorSuccess;
+    }
+    return ret;
+}
+
+fwError fwSocketSend(const fwSocket sfdop, const void* data, const size_t ammount,
+                     size_t* sent_p) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    const uint64_t start = fwiStatsBegin(&nativeSocket->statistics);
+    const ssize_t written = write(nativeSocket->fileDescriptor, data, ammount);
+    fwiStatsEnd(&nativeSocket->statistics, start, true, written < 0 ? -errno : written,
+                (size_t)written < ammount);
+    if (written == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return fwiSocketWouldBlock(nativeSocket);
+        }
+        FWI_LOG_ERRNO;
+        return fwErrorSocketSend;
+    }
+    if (sent_p != nullptr) {
+        *sent_p = written;
+    }
+    FWI_LOG_DEBUG("Socket (ID: %lX) sent %zd bytes", nativeSocket->handle, written);
+    return fwErrorSuccess;
+}
+
+/**
+ * @brief Moves file data through a pipe into the socket, for files that sendfile refuses
+ */
+static ssize_t fwiSpliceFile(const int32_t socketDescriptor, const int32_t fileDescriptor,
+                             off_t* offset_p, const size_t length) {
+    int32_t pipeDescriptors[2];
+    if (pipe2(pipeDescriptors, O_CLOEXEC) == -1) {
+        return -1;
+    }
+
+    ssize_t moved = splice(fileDescriptor, offset_p, pipeDescriptors[1], nullptr, length,
+                           SPLICE_F_MOVE);
+    if (moved > 0) {
+        // Whatever is left in the pipe when the socket stops taking data is lost, the offset was
+        // already advanced, so the file offset is moved back by that much
+        ssize_t drained = 0;
+        while (drained < moved) {
+            const ssize_t sent = splice(pipeDescriptors[0], nullptr, socketDescriptor, nullptr,
+                                        moved - drained, SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (sent <= 0) {
+                break;
+            }
+            drained += sent;
+        }
+        *offset_p -= moved - drained;
+        moved = drained != 0 ? drained : -1;
+    }
+
+    const int32_t err = errno;
+    close(pipeDescriptors[0]);
+    close(pipeDescriptors[1]);
+    errno = err;
+    return moved;
+}
+
+fwError fwSocketSendFileHandle(const fwSocket sfdop, const intptr_t fileHandle,
+                               const uint64_t offset, uint64_t length, uint64_t* sent_p) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr || fileHandle < 0) {
+        return fwErrorInvalidParameter;
+    }
+
+    const int32_t fileDescriptor = (int32_t)fileHandle;
+    if (length == 0) {
+        struct stat fileStats;
+        if (fstat(fileDescriptor, &fileStats) == -1) {
+            FWI_LOG_ERRNO;
+            return fwErrorFileStats;
+        }
+        length = (uint64_t)fileStats.st_size > offset ? fileStats.st_size - offset : 0;
+    }
+
+    // The kernel copies from the page cache into the socket, the data never enters user space
+    off_t position = (off_t)offset;
+    uint64_t sent = 0;
+    bool useSplice = false;
+    fwError ret = fwErrorSuccess;
+    while (sent < length) {
+        const size_t chunk = length - sent < FWI_SOCKET_SENDFILE_CHUNK ? length - sent
+                                                                       : FWI_SOCKET_SENDFILE_CHUNK;
+        const uint64_t start = fwiStatsBegin(&nativeSocket->statistics);
+        ssize_t written = useSplice
+            ? fwiSpliceFile(nativeSocket->fileDescriptor, fileDescriptor, &position, chunk)
+            : sendfile(nativeSocket->fileDescriptor, fileDescriptor, &position, chunk);
+        if (written == -1 && !useSplice && (errno == EINVAL || errno == ENOSYS) && sent == 0) {
+            useSplice = true; // the file cannot be mapped, try again through a pipe
+            fwiStatsEnd(&nativeSocket->statistics, start, true, 0, false);
+            continue;
+        }
+        fwiStatsEnd(&nativeSocket->statistics, start, true, written < 0 ? -errno : written,
+                    written >= 0 && (size_t)written < chunk);
+
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                ret = sent == 0 ? fwiSocketWouldBlock(nativeSocket) : fwErrorSuccess;
+                break;
+            }
+            FWI_LOG_ERRNO;
+            ret = errno == ESPIPE ? fwErrorInvalidParameter : fwErrorSocketSend;
+            break;
+        }
+        if (written == 0) {
+            break; // the file is shorter than requested
+        }
+        sent += written;
+    }
+
+    if (sent_p != nullptr) {
+        *sent_p = sent;
+    }
+    FWI_LOG_DEBUG("Socket (ID: %lX) sent %lu bytes from a file", nativeSocket->handle, sent);
+    return ret;
+}
+
+fwError fwSocketSendFile(const fwSocket sfdop, const char* filename_p, const uint64_t offset,
+                         const uint64_t length, uint64_t* sent_p) {
+    if (filename_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    const int32_t fileDescriptor = open(filename_p, O_RDONLY | O_CLOEXEC);
+    if (fileDescriptor == -1) {
+        return fwErrorFileUnableToOpen;
+    }
+
+    const fwError error = fwSocketSendFileHandle(sfdop, fileDescriptor, offset, length, sent_p);
+    close(fileDescriptor);
+    return error;
+}
+
+fwError fwSocketEnableZeroCopy(const fwSocket sfdop, const size_t threshold,
+                               const fwSocketZeroCopyCallback callback, void* user_p) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr || callback == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    const int32_t enable = 1;
+    if (setsockopt(nativeSocket->fileDescriptor, SOL_SOCKET, SO_ZEROCOPY, &enable,
+                   sizeof(enable)) == -1) {
+        const int32_t err = errno; // the logger may change it
+        FWI_LOG_ERRNO;
+        return err == ENOPROTOOPT || err == EOPNOTSUPP ? fwErrorUnimplemented
+                                                       : fwErrorInvalidParameter;
+    }
+
+    nativeSocket->zeroCopyCallback  = callback;
+    nativeSocket->zeroCopyUser_p    = user_p;
+    nativeSocket->zeroCopyThreshold = threshold != 0 ? threshold : FWI_SOCKET_ZEROCOPY_THRESHOLD;
+    return fwErrorSuccess;
+}
+
+fwError fwSocketSendZeroCopy(const fwSocket sfdop, const void* data, const size_t ammount,
+                             size_t* sent_p, uint32_t* id_p) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr || id_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    // Pinning pages and the notification cost more than copying a small buffer
+    const bool zeroCopy = nativeSocket->zeroCopyCallback != nullptr &&
+                          ammount >= nativeSocket->zeroCopyThreshold;
+
+    const uint64_t start = fwiStatsBegin(&nativeSocket->statistics);
+    const ssize_t written = send(nativeSocket->fileDescriptor, data, ammount,
+                                 MSG_NOSIGNAL | (zeroCopy ? MSG_ZEROCOPY : 0));
+    const int32_t err = errno; // the logger may change it
+    fwiStatsEnd(&nativeSocket->statistics, start, true, written < 0 ? -err : written,
+                (size_t)written < ammount);
+    if (written == -1) {
+        if (err == EAGAIN || err == EWOULDBLOCK) {
+            return fwiSocketWouldBlock(nativeSocket);
+        }
+        // ENOBUFS means the socket exceeded its locked memory limit, the caller can reap and retry
+        FWI_LOG_ERRNO;
+        return err == ENOBUFS ? fwErrorSocketWouldBlock : fwErrorSocketSend;
+    }
+
+    *id_p = zeroCopy ? nativeSocket->zeroCopyNext++ : FW_SOCKET_ZEROCOPY_NONE;
+    if (sent_p != nullptr) {
+        *sent_p = written;
+    }
+    FWI_LOG_DEBUG("Socket (ID: %lX) sent %zd bytes%s", nativeSocket->handle, written,
+                  zeroCopy ? " without copying" : "");
+    return fwErrorSuccess;
+}
+
+static uint32_t fwiReapZeroCopy(struct fwiNativeSocketState* nativeSocket) {
+    const fwSocket handle = nativeSocket->handle;
+    uint32_t reaped = 0;
+
+    for (;;) {
+        alignas(struct cmsghdr) char control[128];
+        struct msghdr message = {.msg_control = control, .msg_controllen = sizeof(control)};
+        if (recvmsg(nativeSocket->fileDescriptor, &message, MSG_ERRQUEUE | MSG_DONTWAIT) == -1) {
+            break; // EAGAIN once the error queue is empty
+        }
+
+        for (struct cmsghdr* cmsg_p = CMSG_FIRSTHDR(&message); cmsg_p != nullptr;
+             cmsg_p = CMSG_NXTHDR(&message, cmsg_p)) {
+            if (!(cmsg_p->cmsg_level == SOL_IP && cmsg_p->cmsg_type == IP_RECVERR) &&
+                !(cmsg_p->cmsg_level == SOL_IPV6 && cmsg_p->cmsg_type == IPV6_RECVERR)) {
+                continue;
+            }
+
+            const struct sock_extended_err* error_p = (struct sock_extended_err*)CMSG_DATA(cmsg_p);
+            if (error_p->ee_errno != 0 || error_p->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+
+            // One notification covers a range of sends, the kernel merges consecutive ones
+            reaped++;
+            nativeSocket->zeroCopyCallback(handle, error_p->ee_info, error_p->ee_data,
+                                           error_p->ee_code & SO_EE_CODE_ZEROCOPY_COPIED,
+                                           nativeSocket->zeroCopyUser_p);
+            if (fwiSocketLookup(handle) == nullptr) {
+                return reaped; // closed from within the callback
+            }
+        }
+    }
+    return reaped;
+}
+
+fwError fwSocketReapZeroCopy(const fwSocket sfdop, uint32_t* reaped_p) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr || nativeSocket->zeroCopyCallback == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    const uint32_t reaped = fwiReapZeroCopy(nativeSocket);
+    if (reaped_p != nullptr) {
+        *reaped_p = reaped;
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwSocketReceive(const fwSocket sfdop, void* buffer, const size_t ammount,
+                        size_t* received_p) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    const uint64_t start = fwiStatsBegin(&nativeSocket->statistics);
+    const ssize_t readden = read(nativeSocket->fileDescriptor, buffer, ammount); // grammar 100
+    if (nativeSocket->quickAck && readden > 0) { // leaves errno of a failed read alone
+        fwiSocketRenewQuickAck(nativeSocket);
+    }
+    fwiStatsEnd(&nativeSocket->statistics, start, false, readden < 0 ? -errno : readden,
+                (size_t)readden < ammount);
+    if (readden == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return fwiSocketWouldBlock(nativeSocket);
+        }
+        FWI_LOG_ERRNO;
+        return fwErrorSocketReceive;
+    }
+    if (received_p != nullptr) {
+        *received_p = readden;
+    }
+    FWI_LOG_DEBUG("Socket (ID: %lX) received %zd bytes", nativeSocket->handle, readden);
+    return fwErrorSuccess;
+}
+
+fwError fwSocketSendv(const fwSocket sfdop, const fwSocketBuffer* buffers_p, const uint32_t count,
+                      size_t* sent_p) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    size_t requested = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        requested += buffers_p[i].size;
+    }
+
+    const uint64_t start = fwiStatsBegin(&nativeSocket->statistics);
+    const ssize_t written = writev(nativeSocket->fileDescriptor, (const struct iovec*)buffers_p,
+                                   (int32_t)count);
+    fwiStatsEnd(&nativeSocket->statistics, start, true, written < 0 ? -errno : written,
+                (size_t)written < requested);
+    if (written == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return fwiSocketWouldBlock(nativeSocket);
+        }
+        FWI_LOG_ERRNO;
+        return fwErrorSocketSend;
+    }
+    if (sent_p != nullptr) {
+        *sent_p = written;
+    }
+    FWI_LOG_DEBUG("Socket (ID: %lX) sent %zd bytes from %d buffers", nativeSocket->handle,
+            written, count);
+    return fwErrorSuccess;
+}
+
+fwError fwSocketReceivev(const fwSocket sfdop, const fwSocketBuffer* buffers_p,
+                         const uint32_t count, size_t* received_p) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    size_t requested = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        requested += buffers_p[i].size;
+    }
+
+    const uint64_t start = fwiStatsBegin(&nativeSocket->statistics);
+    const ssize_t readden = readv(nativeSocket->fileDescriptor, (const struct iovec*)buffers_p,
+                                  (int32_t)count);
+    if (nativeSocket->quickAck && readden > 0) { // leaves errno of a failed read alone
+        fwiSocketRenewQuickAck(nativeSocket);
+    }
+    fwiStatsEnd(&nativeSocket->statistics, start, false, readden < 0 ? -errno : readden,
+                (size_t)readden < requested);
+    if (readden == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return fwiSocketWouldBlock(nativeSocket);
+        }
+        FWI_LOG_ERRNO;
+        return fwErrorSocketReceive;
+    }
+    if (received_p != nullptr) {
+        *received_p = readden;
+    }
+    FWI_LOG_DEBUG("Socket (ID: %lX) received %zd bytes into %d buffers", nativeSocket->handle,
+            readden, count);
+    return fwErrorSuccess;
+}
+
+fwError fwSocketSendBatch(const fwSocket sfdop, fwSocketDatagram* datagrams_p,
+                          const uint32_t count, uint32_t* sent_p) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    if (nativeSocket->protocol != SOCK_DGRAM) {
+        return fwErrorInvalidParameter;
+    }
+
+    struct mmsghdr messages[FWI_SOCKET_BATCH];
+    uint32_t sent = 0;
+    while (sent < count) {
+        const uint32_t batch = count - sent < FWI_SOCKET_BATCH ? count - sent : FWI_SOCKET_BATCH;
+        memset(messages, 0, batch * sizeof(struct mmsghdr));
+        for (uint32_t i = 0; i < batch; i++) {
+            messages[i].msg_hdr.msg_iov    = (struct iovec*)&datagrams_p[sent + i].buffer;
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        const uint64_t start = fwiStatsBegin(&nativeSocket->statistics);
+        const int32_t done = sendmmsg(nativeSocket->fileDescriptor, messages, batch, 0);
+        int64_t bytes = done == -1 ? -errno : 0;
+        for (int32_t i = 0; i < done; i++) {
+            bytes += messages[i].msg_len;
+        }
+        fwiStatsEnd(&nativeSocket->statistics, start, true, bytes, (uint32_t)done < batch);
+        if (done == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (sent > 0) {
+                    break;
+                }
+                return fwiSocketWouldBlock(nativeSocket);
+            }
+            FWI_LOG_ERRNO;
+            return fwErrorSocketSend;
+        }
+
+        for (int32_t i = 0; i < done; i++) {
+            datagrams_p[sent + i].transferred = messages[i].msg_len;
+        }
+        sent += done;
+        if ((uint32_t)done < batch) { // the send buffer is full
+            break;
+        }
+    }
+
+    if (sent_p != nullptr) {
+        *sent_p = sent;
+    }
+    FWI_LOG_DEBUG("Socket (ID: %lX) sent %d datagrams", nativeSocket->handle, sent);
+    return fwErrorSuccess;
+}
+
+fwError fwSocketReceiveBatch(const fwSocket sfdop, fwSocketDatagram* datagrams_p,
+                             const uint32_t count, uint32_t* received_p) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    if (nativeSocket->protocol != SOCK_DGRAM) {
+        return fwErrorInvalidParameter;
+    }
+
+    struct mmsghdr messages[FWI_SOCKET_BATCH];
+    uint32_t received = 0;
+    while (received < count) {
+        const uint32_t batch = count - received < FWI_SOCKET_BATCH ?
+                               count - received : FWI_SOCKET_BATCH;
+        memset(messages, 0, batch * sizeof(struct mmsghdr));
+        for (uint32_t i = 0; i < batch; i++) {
+            messages[i].msg_hdr.msg_iov    = (struct iovec*)&datagrams_p[received + i].buffer;
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        // Only the very first datagram is waited for, everything after that is what is queued
+        const int32_t flags = received == 0 ? MSG_WAITFORONE : MSG_DONTWAIT;
+        const uint64_t start = fwiStatsBegin(&nativeSocket->statistics);
+        const int32_t done = recvmmsg(nativeSocket->fileDescriptor, messages, batch, flags,
+                                      nullptr);
+        int64_t bytes = done == -1 ? -errno : 0;
+        for (int32_t i = 0; i < done; i++) {
+            bytes += messages[i].msg_len;
+        }
+        fwiStatsEnd(&nativeSocket->statistics, start, false, bytes, (uint32_t)done < batch);
+        if (done == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (received > 0) {
+                    break;
+                }
+                return fwiSocketWouldBlock(nativeSocket);
+            }
+            FWI_LOG_ERRNO;
+            return fwErrorSocketReceive;
+        }
+
+        for (int32_t i = 0; i < done; i++) {
+            datagrams_p[received + i].transferred = messages[i].msg_len;
+        }
+        received += done;
+        if ((uint32_t)done < batch) { // the receive queue is drained
+            break;
+        }
+    }
+
+    if (received_p != nullptr) {
+        *received_p = received;
+    }
+    FWI_LOG_DEBUG("Socket (ID: %lX) received %d datagrams", nativeSocket->handle, received);
+    return fwErrorSuccess;
+}
+
+fwError fwSocketSetNonBlocking(const fwSocket sfdop, const bool nonBlocking) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    const int32_t flags = fcntl(nativeSocket->fileDescriptor, F_GETFL);
+    if (flags == -1) {
+        return fwErrorInvalidParameter;
+    }
+    if (fcntl(nativeSocket->fileDescriptor, F_SETFL,
+              nonBlocking ? flags | O_NONBLOCK : flags & ~O_NONBLOCK) == -1) {
+        FWI_LOG_ERRNO;
+        return fwErrorInvalidParameter;
+    }
+
+    nativeSocket->nonBlocking = nonBlocking;
+    return fwErrorSuccess;
+}
+
+/**
+ * @brief Option values of every preset, indexed by fwSocketPreset. A negative buffer size or busy
+ *        poll time leaves the system default in place.
+ */
+static const struct fwSocketOptions socketPresets_s[] = {
+    [fwSocketPresetDefault] = {
+        .sendBuffer = -1, .receiveBuffer = -1, .busyPoll = -1
+    },
+    // Every segment goes out at once and is acknowledged at once, small buffers keep queues short
+    [fwSocketPresetLowLatency] = {
+        .noDelay = true, .quickAck = true, .sendBuffer = 65536, .receiveBuffer = 65536,
+        .busyPoll = 50
+    },
+    // Full segments only, big windows and data in the SYN of repeated connections
+    [fwSocketPresetThroughput] = {
+        .cork = true, .fastOpen = true, .sendBuffer = 4194304, .receiveBuffer = 4194304,
+        .busyPoll = -1
+    }
+};
+
+// Applies one option, failures are logged but do not stop the others from being applied
+static bool fwiSocketSetOption(const int32_t fileDescriptor, const int32_t level,
+                               const int32_t name, const int32_t value, const char* name_p) {
+    if (setsockopt(fileDescriptor, level, name, &value, sizeof(value)) == -1) {
+        FWI_LOG_WARNING("Could not set %s to %d: %s", name_p, value, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Applies the options fwSocketConfigure stored for a socket to one of its descriptors
+ * @param fastOpen Whether TCP_FASTOPEN is set as well, only possible before the handshake
+ * @return @c fwErrorPermission An explicitly requested busy poll time needs CAP_NET_ADMIN
+ * @return @c fwErrorUnimplemented Another option was refused
+ */
+static fwError fwiSocketApplyOptions(const struct fwiNativeSocketState* nativeSocket,
+                                     const int32_t fileDescriptor, const bool fastOpen) {
+    const struct fwSocketOptions* options_p = &nativeSocket->options;
+    const int32_t fd = fileDescriptor;
+    bool applied = true;
+    if (options_p->sendBuffer >= 0) {
+        applied &= fwiSocketSetOption(fd, SOL_SOCKET, SO_SNDBUF, options_p->sendBuffer,
+                                      "SO_SNDBUF");
+    }
+    if (options_p->receiveBuffer >= 0) {
+        applied &= fwiSocketSetOption(fd, SOL_SOCKET, SO_RCVBUF, options_p->receiveBuffer,
+                                      "SO_RCVBUF");
+    }
+    // Raising the busy poll time above the sysctl default needs CAP_NET_ADMIN, which ordinary
+    // users lack, so only an explicit override has to succeed
+    bool permitted = true;
+    if (options_p->busyPoll >= 0 && setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &options_p->busyPoll,
+                                               sizeof(options_p->busyPoll)) == -1) {
+        if (errno != EPERM) {
+            FWI_LOG_WARNING("Could not set SO_BUSY_POLL to %d: %s", options_p->busyPoll,
+                            strerror(errno));
+            applied = false;
+        } else if (options_p->overrides & fwSocketOptionBusyPoll) {
+            FWI_LOG_WARNING("SO_BUSY_POLL of %d us needs CAP_NET_ADMIN", options_p->busyPoll);
+            permitted = false;
+        } else {
+            FWI_LOG_INFO("SO_BUSY_POLL of the preset needs CAP_NET_ADMIN, it stays at the "
+                         "system default");
+        }
+    }
+
+    // The rest only exists for TCP, on other protocols the preset stops at the generic options
+    if (nativeSocket->protocol == SOCK_STREAM && nativeSocket->addressFamily != AF_LOCAL) {
+        applied &= fwiSocketSetOption(fd, IPPROTO_TCP, TCP_NODELAY, options_p->noDelay,
+                                      "TCP_NODELAY");
+        applied &= fwiSocketSetOption(fd, IPPROTO_TCP, TCP_CORK, options_p->cork, "TCP_CORK");
+        applied &= fwiSocketSetOption(fd, IPPROTO_TCP, TCP_QUICKACK, options_p->quickAck,
+                                      "TCP_QUICKACK");
+        // The queue length for listeners and the SYN data for connects, whichever this becomes,
+        // established connections are past the handshake and refuse it
+        if (fastOpen) {
+            applied &= fwiSocketSetOption(fd, IPPROTO_TCP, TCP_FASTOPEN,
+                                          options_p->fastOpen ? FWI_SOCKET_FASTOPEN_QUEUE : 0,
+                                          "TCP_FASTOPEN");
+            if (!nativeSocket->listening) {
+                applied &= fwiSocketSetOption(fd, IPPROTO_TCP, TCP_FASTOPEN_CONNECT,
+                                              options_p->fastOpen, "TCP_FASTOPEN_CONNECT");
+            }
+        }
+    }
+    return !permitted ? fwErrorPermission : applied ? fwErrorSuccess : fwErrorUnimplemented;
+}
+
+fwError fwSocketConfigure(const fwSocket sfdop, const struct fwSocketOptions* options_p) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr || options_p == nullptr ||
+        options_p->preset > fwSocketPresetThroughput) {
+        return fwErrorInvalidParameter;
+    }
+
+    struct fwSocketOptions effective = socketPresets_s[options_p->preset];
+    const uint32_t overrides = options_p->overrides;
+    if (overrides & fwSocketOptionNoDelay) {
+        effective.noDelay = options_p->noDelay;
+    }
+    if (overrides & fwSocketOptionQuickAck) {
+        effective.quickAck = options_p->quickAck;
+    }
+    if (overrides & fwSocketOptionCork) {
+        effective.cork = options_p->cork;
+    }
+    if (overrides & fwSocketOptionFastOpen) {
+        effective.fastOpen = options_p->fastOpen;
+    }
+    if (overrides & fwSocketOptionSendBuffer) {
+        effective.sendBuffer = options_p->sendBuffer;
+    }
+    if (overrides & fwSocketOptionReceiveBuffer) {
+        effective.receiveBuffer = options_p->receiveBuffer;
+    }
+    if (overrides & fwSocketOptionBusyPoll) {
+        effective.busyPoll = options_p->busyPoll;
+    }
+
+    effective.overrides      = overrides;
+    nativeSocket->options    = effective;
+    nativeSocket->configured = true;
+    const fwError error = fwiSocketApplyOptions(nativeSocket, nativeSocket->fileDescriptor,
+                                                (effective.fastOpen ||
+                                                 (overrides & fwSocketOptionFastOpen)) &&
+                                                !nativeSocket->connected);
+    if (nativeSocket->protocol == SOCK_STREAM && nativeSocket->addressFamily != AF_LOCAL) {
+        nativeSocket->quickAck = effective.quickAck;
+    }
+
+    FWI_LOG_DEBUG("Socket (ID: %lX) was configured with preset %d", nativeSocket->handle,
+                  options_p->preset);
+    return error;
+}
+
+fwError fwSocketFlush(const fwSocket sfdop) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    // Only a corked socket holds data back, pulling the cork pushes out the partial segment
+    int32_t corked = 0;
+    socklen_t length = sizeof(corked);
+    if (nativeSocket->protocol != SOCK_STREAM ||
+        getsockopt(nativeSocket->fileDescriptor, IPPROTO_TCP, TCP_CORK, &corked, &length) == -1 ||
+        !corked) {
+        return fwErrorSuccess;
+    }
+
+    const int32_t off = 0;
+    const int32_t on = 1;
+    setsockopt(nativeSocket->fileDescriptor, IPPROTO_TCP, TCP_CORK, &off, sizeof(off));
+    setsockopt(nativeSocket->fileDescriptor, IPPROTO_TCP, TCP_CORK, &on, sizeof(on));
+    return fwErrorSuccess;
+}
+
+fwError fwSocketGetStats(const fwSocket sfdop, struct fwSocketStats* stats_p) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    memset(stats_p, 0, sizeof(struct fwSocketStats));
+    fwiStatsAccumulate((uint64_t*)stats_p, &nativeSocket->statistics);
+    return fwErrorSuccess;
+}
+
+fwError fwSocketGetGlobalStats(struct fwSocketStats* stats_p) {
+    if (socketTable_s.slots_p == nullptr) {
+        return fwErrorModule;
+    }
+
+    memset(stats_p, 0, sizeof(struct fwSocketStats));
+    fwiStatsAccumulate((uint64_t*)stats_p, &socketTable_s.retired);
+
+    // A socket that is closed during the walk can be counted twice, fine for a monitoring figure
+    const uint32_t highWater = atomic_load_explicit(&socketTable_s.highWater, memory_order_acquire);
+    for (uint32_t i = 0; i < highWater; i++) {
+        if (socketTable_s.slots_p[i].handle != 0) {
+            fwiStatsAccumulate((uint64_t*)stats_p, &socketTable_s.slots_p[i].statistics);
+        }
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwSocketClose(const fwSocket sfdop) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    if (nativeSocket->eventSource.loop_p != nullptr) {
+        fwiTimerWheelCancel(&nativeSocket->eventSource.loop_p->timerWheel,
+                            &nativeSocket->deadlineTimer);
+        fwiEventLoopRemoveSource(&nativeSocket->eventSource);
+    }
+
+    uint64_t counters[FWI_SOCKET_COUNTERS] = {};
+    fwiStatsAccumulate(counters, &nativeSocket->statistics);
+    _Atomic uint64_t* retired_p = (_Atomic uint64_t*)&socketTable_s.retired;
+    for (size_t i = 0; i < FWI_SOCKET_COUNTERS; i++) {
+        fwiStatsAdd(&retired_p[i], counters[i]);
+    }
+
+    free(nativeSocket->pooled_p);
+    const int32_t closed = close(nativeSocket->fileDescriptor);
+    fwiSocketRelease(nativeSocket); // the descriptor is gone either way
+    if (closed == -1) {
+        FWI_LOG_ERRNO;
+    }
+
+    FWI_LOG_INFO("Socket (ID: %lX) was closed", sfdop);
+    return fwErrorSuccess;
+}
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Local channels need lock-free 64 bit atomics");
+
+/**
+ * @brief Single producer single consumer ring inside of the shared memory of a local channel, the
+ *        positions count every byte that ever went through and wrap by masking
+ */
+struct fwiLocalRing {
+    alignas(64) _Atomic uint64_t head; // only stored by the producer
+    atomic_uint producerWaiting;
+    alignas(64) _Atomic uint64_t tail; // only stored by the consumer
+    atomic_uint consumerWaiting;
+};
+
+/**
+ * @brief Start of the shared memory of a local channel, the data of both rings follows after
+ *        FWI_LOCAL_CHANNEL_HEADER bytes. Side 0 is the one that connected.
+ */
+struct fwiLocalChannelShared {
+    atomic_uint closed[2]; // indexed by side
+    struct fwiLocalRing rings[2]; // indexed by the side that produces into it
+};
+
+static_assert(sizeof(struct fwiLocalChannelShared) <= FWI_LOCAL_CHANNEL_HEADER,
+              "The shared header of a local channel must fit into its first page");
+
+/**
+ * @brief Payload of the message that hands a local channel to the peer, the memfd and both
+ *        eventfds travel along as SCM_RIGHTS
+ */
+struct fwiLocalChannelOffer {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t capacity;
+};
+
+/**
+ * @brief Backing state of an @c fwLocalChannel, private to one side
+ */
+struct fwiLocalChannel {
+    struct fwiLocalChannelShared* shared_p;
+    struct fwiLocalRing* send_p;
+    struct fwiLocalRing* receive_p;
+    uint8_t* sendData_p;
+    uint8_t* receiveData_p;
+    uint64_t sendTail; // last tail of the peer that was seen, reloaded once the ring looks full
+    uint64_t receiveHead; // last head of the peer that was seen, likewise once it looks empty
+    size_t mappingSize;
+    uint32_t capacity;
+    uint32_t spins;
+    int32_t ownEvent, peerEvent;
+    int32_t socketDescriptor; // duplicate of the handshake socket, hangs up with the peer
+    uint8_t side;
+    bool nonBlocking;
+    bool peerGone;
+};
+
+static void fwiLocalRingWrite(uint8_t* data_p, const uint32_t capacity, const uint64_t position,
+                              const void* source_p, const size_t size) {
+    const size_t offset = position & (capacity - 1);
+    const size_t first  = size < capacity - offset ? size : capacity - offset;
+    memcpy(data_p + offset, source_p, first);
+    memcpy(data_p, (const uint8_t*)source_p + first, size - first);
+}
+
+static void fwiLocalRingRead(const uint8_t* data_p, const uint32_t capacity,
+                             const uint64_t position, void* destination_p, const size_t size) {
+    const size_t offset = position & (capacity - 1);
+    const size_t first  = size < capacity - offset ? size : capacity - offset;
+    memcpy(destination_p, data_p + offset, first);
+    memcpy((uint8_t*)destination_p + first, data_p, size - first);
+}
+
+/**
+ * @brief Wakes the peer if it sleeps on the given flag, costs no syscall while it does not
+ */
+static void fwiLocalChannelNotify(const struct fwiLocalChannel* nativeChannel,
+                                  atomic_uint* waiting_p) {
+    // Pairs with the flag being raised in fwiLocalChannelWait, either the peer sees the new
+    // position or this side sees the flag
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(waiting_p, memory_order_relaxed) != 0) {
+        const uint64_t one = 1;
+        write(nativeChannel->peerEvent, &one, sizeof(one));
+    }
+}
+
+static bool fwiLocalChannelPeerClosed(const struct fwiLocalChannel* nativeChannel) {
+    return nativeChannel->peerGone ||
+           atomic_load_explicit(&nativeChannel->shared_p->closed[nativeChannel->side ^ 1],
+                                memory_order_acquire) != 0;
+}
+
+/**
+ * @brief Waits until the peer moved a position of a ring away from what was seen, closed the
+ *        channel or went away. Spins first if the channel was configured to.
+ */
+static void fwiLocalChannelWait(struct fwiLocalChannel* nativeChannel, atomic_uint* waiting_p,
+                                const _Atomic uint64_t* position_p, const uint64_t seen) {
+    for (uint32_t i = 0; i < nativeChannel->spins; i++) {
+        if (atomic_load_explicit(position_p, memory_order_acquire) != seen) {
+            return;
+        }
+        sched_yield();
+    }
+
+    atomic_store_explicit(waiting_p, 1, memory_order_seq_cst);
+    if (atomic_load_explicit(position_p, memory_order_seq_cst) == seen &&
+        !fwiLocalChannelPeerClosed(nativeChannel)) {
+        struct pollfd descriptors[2] = {
+            {.fd = nativeChannel->ownEvent, .events = POLLIN},
+            {.fd = nativeChannel->socketDescriptor, .events = POLLRDHUP}
+        };
+        if (poll(descriptors, 2, -1) > 0) {
+            if (descriptors[0].revents & POLLIN) {
+                uint64_t counter;
+                read(nativeChannel->ownEvent, &counter, sizeof(counter)); // only resets it
+            }
+            if (descriptors[1].revents & (POLLRDHUP | POLLHUP | POLLERR)) {
+                nativeChannel->peerGone = true; // died without closing the channel
+            }
+        }
+    }
+    atomic_store_explicit(waiting_p, 0, memory_order_relaxed);
+}
+
+/**
+ * @brief Maps the shared memory of a channel and sets up the state of one side
+ * @note Takes over the eventfds on success, the memfd can be closed once this returned.
+ */
+static fwError fwiLocalChannelOpen(const struct fwiNativeSocketState* nativeSocket,
+                                   const struct fwLocalChannelConfiguration* configuration_p,
+                                   const int32_t memory, const uint32_t capacity,
+                                   const uint8_t side, const int32_t events[2],
+                                   fwLocalChannel* channel_p) {
+    struct fwiLocalChannel* nativeChannel = calloc(1, sizeof(struct fwiLocalChannel));
+    if (nativeChannel == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+
+    nativeChannel->mappingSize = FWI_LOCAL_CHANNEL_HEADER + 2 * (size_t)capacity;
+    void* mapping_p = mmap(nullptr, nativeChannel->mappingSize, PROT_READ | PROT_WRITE,
+                           MAP_SHARED, memory, 0);
+    if (mapping_p == MAP_FAILED) {
+        FWI_LOG_ERRNO;
+        free(nativeChannel);
+        return fwErrorOutOfMemory;
+    }
+    if ((nativeChannel->socketDescriptor = fcntl(nativeSocket->fileDescriptor, F_DUPFD_CLOEXEC,
+                                                 0)) == -1) {
+        FWI_LOG_ERRNO;
+        munmap(mapping_p, nativeChannel->mappingSize);
+        free(nativeChannel);
+        return fwErrorOutOfMemory;
+    }
+
+    uint8_t* data_p = (uint8_t*)mapping_p + FWI_LOCAL_CHANNEL_HEADER;
+    nativeChannel->shared_p      = mapping_p;
+    nativeChannel->send_p        = &nativeChannel->shared_p->rings[side];
+    nativeChannel->receive_p     = &nativeChannel->shared_p->rings[side ^ 1];
+    nativeChannel->sendData_p    = data_p + (size_t)side * capacity;
+    nativeChannel->receiveData_p = data_p + (size_t)(side ^ 1) * capacity;
+    nativeChannel->capacity      = capacity;
+    nativeChannel->ownEvent      = events[side];
+    nativeChannel->peerEvent     = events[side ^ 1];
+    nativeChannel->side          = side;
+    if (configuration_p != nullptr) {
+        nativeChannel->spins       = configuration_p->spins;
+        nativeChannel->nonBlocking = configuration_p->nonBlocking;
+    }
+
+    *channel_p = (uintptr_t)nativeChannel;
+    FWI_LOG_INFO("Local channel (ID: %lX) with %u byte rings was set up over socket (ID: %lX)",
+                 *channel_p, capacity, nativeSocket->handle);
+    return fwErrorSuccess;
+}
+
+static struct fwiNativeSocketState* fwiLocalChannelSocket(const fwSocket sfdop) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr || nativeSocket->addressFamily != AF_LOCAL ||
+        nativeSocket->protocol != SOCK_STREAM || !nativeSocket->connected) {
+        return nullptr;
+    }
+    return nativeSocket;
+}
+
+fwError fwLocalChannelConnect(const fwSocket sfdop,
+                              const struct fwLocalChannelConfiguration* configuration_p,
+                              fwLocalChannel* channel_p) {
+    const struct fwiNativeSocketState* nativeSocket = fwiLocalChannelSocket(sfdop);
+    if (nativeSocket == nullptr || channel_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    uint32_t capacity = FWI_LOCAL_CHANNEL_CAPACITY;
+    if (configuration_p != nullptr && configuration_p->capacity != 0) {
+        if (configuration_p->capacity > FWI_LOCAL_CHANNEL_MAX_CAPACITY) {
+            return fwErrorInvalidParameter;
+        }
+        capacity = FWI_LOCAL_CHANNEL_MIN_CAPACITY;
+        while (capacity < configuration_p->capacity) {
+            capacity <<= 1;
+        }
+    }
+
+    // Sealing the size keeps the peer from truncating the memory underneath this side's mapping,
+    // which would turn every access into SIGBUS
+    const int32_t memory = memfd_create("lpaf-channel", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    int32_t events[2] = {
+        eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)
+    };
+    if (memory == -1 || events[0] == -1 || events[1] == -1 ||
+        ftruncate(memory, FWI_LOCAL_CHANNEL_HEADER + 2 * (off_t)capacity) == -1 ||
+        fcntl(memory, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == -1) {
+        FWI_LOG_ERRNO;
+        const int32_t descriptors[] = {memory, events[0], events[1]};
+        for (uint32_t i = 0; i < 3; i++) {
+            if (descriptors[i] != -1) {
+                close(descriptors[i]);
+            }
+        }
+        return fwErrorOutOfMemory;
+    }
+
+    // The fresh memfd reads as zeros, which already is an open channel with empty rings
+    fwError error = fwiLocalChannelOpen(nativeSocket, configuration_p, memory, capacity, 0, events,
+                                        channel_p);
+    if (error != fwErrorSuccess) {
+        close(memory);
+        close(events[0]);
+        close(events[1]);
+        return error;
+    }
+
+    const struct fwiLocalChannelOffer offer = {
+        .magic = FWI_LOCAL_CHANNEL_MAGIC, .version = FWI_LOCAL_CHANNEL_VERSION,
+        .capacity = capacity
+    };
+    struct iovec payload = {.iov_base = (void*)&offer, .iov_len = sizeof(offer)};
+    union {
+        struct cmsghdr header;
+        uint8_t buffer[CMSG_SPACE(3 * sizeof(int32_t))];
+    } control = {};
+    struct msghdr message = {};
+    message.msg_iov        = &payload;
+    message.msg_iovlen     = 1;
+    message.msg_control    = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+    struct cmsghdr* header_p = CMSG_FIRSTHDR(&message);
+    header_p->cmsg_level = SOL_SOCKET;
+    header_p->cmsg_type  = SCM_RIGHTS;
+    header_p->cmsg_len   = CMSG_LEN(3 * sizeof(int32_t));
+    const int32_t descriptors[] = {memory, events[0], events[1]};
+    memcpy(CMSG_DATA(header_p), descriptors, sizeof(descriptors));
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(nativeSocket->fileDescriptor, &message, MSG_NOSIGNAL);
+    } while (sent == -1 && errno == EINTR);
+    close(memory);
+
+    if (sent != sizeof(offer)) {
+        FWI_LOG_ERRNO;
+        fwLocalChannelClose(*channel_p);
+        return fwErrorSocketSend;
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwLocalChannelAccept(const fwSocket sfdop,
+                             const struct fwLocalChannelConfiguration* configuration_p,
+                             fwLocalChannel* channel_p) {
+    const struct fwiNativeSocketState* nativeSocket = fwiLocalChannelSocket(sfdop);
+    if (nativeSocket == nullptr || channel_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    struct fwiLocalChannelOffer offer = {};
+    struct iovec payload = {.iov_base = &offer, .iov_len = sizeof(offer)};
+    union {
+        struct cmsghdr header;
+        uint8_t buffer[CMSG_SPACE(3 * sizeof(int32_t))];
+    } control = {};
+    struct msghdr message = {};
+    message.msg_iov        = &payload;
+    message.msg_iovlen     = 1;
+    message.msg_control    = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+
+    ssize_t received;
+    do {
+        received = recvmsg(nativeSocket->fileDescriptor, &message, MSG_CMSG_CLOEXEC);
+    } while (received == -1 && errno == EINTR);
+    if (received == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return fwiSocketWouldBlock(nativeSocket);
+        }
+        FWI_LOG_ERRNO;
+        return fwErrorSocketReceive;
+    }
+    if (received == 0) {
+        return fwErrorSocketClosed;
+    }
+
+    // Whatever descriptors arrived are owned by this process now, also when they are unusable
+    int32_t descriptors[3] = {-1, -1, -1};
+    uint32_t descriptorCount = 0;
+    for (struct cmsghdr* header_p = CMSG_FIRSTHDR(&message); header_p != nullptr;
+         header_p = CMSG_NXTHDR(&message, header_p)) {
+        if (header_p->cmsg_level != SOL_SOCKET || header_p->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+        const uint32_t count = (header_p->cmsg_len - CMSG_LEN(0)) / sizeof(int32_t);
+        for (uint32_t i = 0; i < count; i++) {
+            int32_t descriptor;
+            memcpy(&descriptor, CMSG_DATA(header_p) + i * sizeof(int32_t), sizeof(descriptor));
+            if (descriptorCount < 3) {
+                descriptors[descriptorCount++] = descriptor;
+            }
+            else {
+                close(descriptor);
+            }
+        }
+    }
+
+    const uint64_t size = FWI_LOCAL_CHANNEL_HEADER + 2 * (uint64_t)offer.capacity;
+    struct stat memoryStat = {};
+    // Anything but a memfd fails F_GET_SEALS, an unsealed file could still be truncated
+    const int32_t seals = descriptorCount == 3 ? fcntl(descriptors[0], F_GET_SEALS) : -1;
+    const bool valid = received == sizeof(offer) && !(message.msg_flags & MSG_CTRUNC) &&
+                       descriptorCount == 3 && offer.magic == FWI_LOCAL_CHANNEL_MAGIC &&
+                       offer.version == FWI_LOCAL_CHANNEL_VERSION &&
+                       offer.capacity >= FWI_LOCAL_CHANNEL_MIN_CAPACITY &&
+                       offer.capacity <= FWI_LOCAL_CHANNEL_MAX_CAPACITY &&
+                       (offer.capacity & (offer.capacity - 1)) == 0 &&
+                       fstat(descriptors[0], &memoryStat) == 0 &&
+                       (uint64_t)memoryStat.st_size >= size &&
+                       seals != -1 &&
+                       (seals & (F_SEAL_SHRINK | F_SEAL_GROW)) == (F_SEAL_SHRINK | F_SEAL_GROW);
+
+    fwError error = fwErrorSocketReceive;
+    if (valid) {
+        error = fwiLocalChannelOpen(nativeSocket, configuration_p, descriptors[0], offer.capacity,
+                                    1, &descriptors[1], channel_p);
+    }
+    else {
+        FWI_LOG_ERROR("Socket (ID: %lX) received no valid local channel", nativeSocket->handle);
+    }
+
+    close(descriptors[0]);
+    if (error != fwErrorSuccess) {
+        for (uint32_t i = 1; i < descriptorCount; i++) {
+            close(descriptors[i]);
+        }
+    }
+    return error;
+}
+
+fwError fwLocalChannelSend(const fwLocalChannel channel, const void* data, const size_t ammount,
+                           size_t* sent_p) {
+    struct fwiLocalChannel* nativeChannel = {(struct fwiLocalChannel*)channel};
+    struct fwiLocalRing* ring_p = nativeChannel->send_p;
+
+    size_t sent = 0;
+    fwError ret = fwErrorSuccess;
+    while (sent < ammount) {
+        if (fwiLocalChannelPeerClosed(nativeChannel)) {
+            ret = fwErrorSocketClosed;
+            break;
+        }
+
+        const uint64_t head = atomic_load_explicit(&ring_p->head, memory_order_relaxed);
+        if (head - nativeChannel->sendTail >= nativeChannel->capacity) {
+            nativeChannel->sendTail = atomic_load_explicit(&ring_p->tail, memory_order_acquire);
+            if (head - nativeChannel->sendTail > nativeChannel->capacity) {
+                FWI_LOG_ERROR("Local channel (ID: %lX) was corrupted by its peer", channel);
+                ret = fwErrorSocketSend;
+                break;
+            }
+            if (head - nativeChannel->sendTail == nativeChannel->capacity) {
+                if (nativeChannel->nonBlocking) {
+                    ret = sent == 0 ? fwErrorSocketWouldBlock : fwErrorSuccess;
+                    break;
+                }
+                fwiLocalChannelWait(nativeChannel, &ring_p->producerWaiting, &ring_p->tail,
+                                    nativeChannel->sendTail);
+                continue;
+            }
+        }
+
+        const uint64_t room = nativeChannel->capacity - (head - nativeChannel->sendTail);
+        const size_t chunk = ammount - sent < room ? ammount - sent : room;
+        fwiLocalRingWrite(nativeChannel->sendData_p, nativeChannel->capacity, head,
+                          (const uint8_t*)data + sent, chunk);
+        atomic_store_explicit(&ring_p->head, head + chunk, memory_order_release);
+        fwiLocalChannelNotify(nativeChannel, &ring_p->consumerWaiting);
+        sent += chunk;
+    }
+
+    if (sent_p != nullptr) {
+        *sent_p = sent;
+    }
+    return ret;
+}
+
+fwError fwLocalChannelReceive(const fwLocalChannel channel, void* buffer, const size_t ammount,
+                              size_t* received_p) {
+    struct fwiLocalChannel* nativeChannel = {(struct fwiLocalChannel*)channel};
+    struct fwiLocalRing* ring_p = nativeChannel->receive_p;
+
+    size_t received = 0;
+    fwError ret = fwErrorSuccess;
+    while (ammount != 0) {
+        const uint64_t tail = atomic_load_explicit(&ring_p->tail, memory_order_relaxed);
+        if (nativeChannel->receiveHead == tail) {
+            nativeChannel->receiveHead = atomic_load_explicit(&ring_p->head, memory_order_acquire);
+        }
+
+        const uint64_t available = nativeChannel->receiveHead - tail;
+        if (available > nativeChannel->capacity) {
+            FWI_LOG_ERROR("Local channel (ID: %lX) was corrupted by its peer", channel);
+            ret = fwErrorSocketReceive;
+            break;
+        }
+        if (available != 0) {
+            received = available < ammount ? available : ammount;
+            fwiLocalRingRead(nativeChannel->receiveData_p, nativeChannel->capacity, tail, buffer,
+                             received);
+            atomic_store_explicit(&ring_p->tail, tail + received, memory_order_release);
+            fwiLocalChannelNotify(nativeChannel, &ring_p->producerWaiting);
+            break;
+        }
+
+        // The peer publishes everything before it closes, one more look and the ring is drained
+        if (fwiLocalChannelPeerClosed(nativeChannel)) {
+            if (atomic_load_explicit(&ring_p->head, memory_order_acquire) == tail) {
+                break;
+            }
+            continue;
+        }
+        if (nativeChannel->nonBlocking) {
+            ret = fwErrorSocketWouldBlock;
+            break;
+        }
+        fwiLocalChannelWait(nativeChannel, &ring_p->consumerWaiting, &ring_p->head, tail);
+    }
+
+    if (received_p != nullptr) {
+        *received_p = received;
+    }
+    return ret;
+}
+
+fwError fwLocalChannelClose(const fwLocalChannel channel) {
+    struct fwiLocalChannel* nativeChannel = {(struct fwiLocalChannel*)channel};
+
+    // Released after the last head, a peer that sees the flag also sees everything that was sent
+    atomic_store_explicit(&nativeChannel->shared_p->closed[nativeChannel->side], 1,
+                          memory_order_release);
+    const uint64_t one = 1;
+    write(nativeChannel->peerEvent, &one, sizeof(one)); // a sleeping peer has to look again
+
+    munmap(nativeChannel->shared_p, nativeChannel->mappingSize);
+    close(nativeChannel->ownEvent);
+    close(nativeChannel->peerEvent);
+    close(nativeChannel->socketDescriptor);
+    free(nativeChannel);
+
+    FWI_LOG_INFO("Local channel (ID: %lX) was closed", channel);
+    return fwErrorSuccess;
+}
+
+static uint32_t fwiEventInterestToEpoll(const uint8_t interest) {
+    uint32_t events = EPOLLRDHUP;
+    if (interest & fwEventRead) {
+        events |= EPOLLIN;
+    }
+    if (interest & fwEventWrite) {
+        events |= EPOLLOUT;
+    }
+    return events;
+}
+
+static uint8_t fwiEventEpollToReady(const uint32_t events) {
+    uint8_t ready = 0;
+    if (events & EPOLLIN) {
+        ready |= fwEventRead;
+    }
+    if (events & EPOLLOUT) {
+        ready |= fwEventWrite;
+    }
+    if (events & (EPOLLHUP | EPOLLRDHUP)) {
+        ready |= fwEventHangup;
+    }
+    if (events & EPOLLERR) {
+        ready |= fwEventError;
+    }
+    return ready;
+}
+
+/**
+ * @brief Sets the timerfd of a loop to the next tick its wheel has work at, unless it is set to an
+ *        earlier one already. Waking up too early finds nothing to do and sets it again.
+ */
+static void fwiEventLoopScheduleTimer(struct fwiNativeEventLoop* nativeLoop) {
+    const uint64_t next = fwiTimerWheelNext(&nativeLoop->timerWheel);
+    if (next >= nativeLoop->timerProgrammed) {
+        return;
+    }
+
+    const struct itimerspec expiry = {
+        .it_value = {.tv_sec = (time_t)(next / 1000), .tv_nsec = (long)(next % 1000 * 1000000)}
+    };
+    if (timerfd_settime(nativeLoop->timerSource.fileDescriptor, TFD_TIMER_ABSTIME, &expiry,
+                        nullptr) == -1) {
+        FWI_LOG_ERRNO;
+        return;
+    }
+    nativeLoop->timerProgrammed = next;
+}
+
+static void fwiEventLoopArmTimer(struct fwiNativeEventLoop* nativeLoop, struct fwiTimer* timer_p,
+                                 const int64_t expiry) {
+    // An empty wheel stood still, it has no timers that could be skipped by moving it forward
+    if (nativeLoop->timerWheel.count == 0) {
+        const uint64_t now = fwiMonotonicMilliseconds();
+        if (nativeLoop->timerWheel.now < now) {
+            nativeLoop->timerWheel.now = now;
+        }
+    }
+
+    fwiTimerWheelArm(&nativeLoop->timerWheel, timer_p, expiry);
+    fwiEventLoopScheduleTimer(nativeLoop);
+}
+
+static void fwiDispatchTimerEvent(struct fwiEventSource* source_p, const uint32_t events) {
+    (void)events;
+    struct fwiNativeEventLoop* nativeLoop = source_p->context_p;
+
+    uint64_t expirations;
+    read(source_p->fileDescriptor, &expirations, sizeof(expirations)); // only resets the timerfd
+    nativeLoop->timerProgrammed = UINT64_MAX;
+
+    fwiTimerWheelAdvance(&nativeLoop->timerWheel, nativeLoop->now);
+    fwiEventLoopScheduleTimer(nativeLoop);
+}
+
+/**
+ * @brief Earliest deadline of a registered socket that applies to its interest, INT64_MAX if none
+ */
+static int64_t fwiSocketNextDeadline(const struct fwiNativeSocketState* nativeSocket) {
+    int64_t next = INT64_MAX;
+    if (nativeSocket->timeouts.read != 0 && (nativeSocket->eventInterest & fwEventRead) &&
+        nativeSocket->readDeadline < next) {
+        next = nativeSocket->readDeadline;
+    }
+    if (nativeSocket->timeouts.write != 0 && (nativeSocket->eventInterest & fwEventWrite) &&
+        nativeSocket->writeDeadline < next) {
+        next = nativeSocket->writeDeadline;
+    }
+    if (nativeSocket->timeouts.idle != 0 && nativeSocket->idleDeadline < next) {
+        next = nativeSocket->idleDeadline;
+    }
+    return next;
+}
+
+/**
+ * @brief Moves the deadline timer of a registered socket forward to its earliest deadline
+ * @note Events push deadlines back without touching the timer, it expires early and is moved then.
+ */
+static void fwiSocketScheduleDeadlines(struct fwiNativeSocketState* nativeSocket) {
+    struct fwiNativeEventLoop* nativeLoop = nativeSocket->eventSource.loop_p;
+    const int64_t next = fwiSocketNextDeadline(nativeSocket);
+    if (next == INT64_MAX) {
+        fwiTimerWheelCancel(&nativeLoop->timerWheel, &nativeSocket->deadlineTimer);
+        return;
+    }
+
+    if (nativeSocket->deadlineTimer.previous_pp == nullptr ||
+        nativeSocket->deadlineTimer.expiry > (uint64_t)next) {
+        fwiEventLoopArmTimer(nativeLoop, &nativeSocket->deadlineTimer, next);
+    }
+}
+
+/**
+ * @brief Starts the selected deadlines of a registered socket over
+ * @param restart[in] Mask of fwEventReadTimeout, fwEventWriteTimeout and fwEventIdleTimeout
+ */
+static void fwiSocketRestartDeadlines(struct fwiNativeSocketState* nativeSocket,
+                                      const uint8_t restart) {
+    const int64_t now = fwiMonotonicMilliseconds();
+    if (restart & fwEventReadTimeout) {
+        nativeSocket->readDeadline = now + nativeSocket->timeouts.read;
+    }
+    if (restart & fwEventWriteTimeout) {
+        nativeSocket->writeDeadline = now + nativeSocket->timeouts.write;
+    }
+    if (restart & fwEventIdleTimeout) {
+        nativeSocket->idleDeadline = now + nativeSocket->timeouts.idle;
+    }
+    fwiSocketScheduleDeadlines(nativeSocket);
+}
+
+static void fwiDispatchSocketDeadline(struct fwiTimer* timer_p) {
+    struct fwiNativeSocketState* nativeSocket = timer_p->context_p;
+    const int64_t now = nativeSocket->eventSource.loop_p->now;
+
+    // A deadline that ran out starts over, a stall is reported once per timeout
+    uint8_t expired = 0;
+    if (nativeSocket->timeouts.read != 0 && (nativeSocket->eventInterest & fwEventRead) &&
+        nativeSocket->readDeadline <= now) {
+        expired |= fwEventReadTimeout;
+        nativeSocket->readDeadline = now + nativeSocket->timeouts.read;
+    }
+    if (nativeSocket->timeouts.write != 0 && (nativeSocket->eventInterest & fwEventWrite) &&
+        nativeSocket->writeDeadline <= now) {
+        expired |= fwEventWriteTimeout;
+        nativeSocket->writeDeadline = now + nativeSocket->timeouts.write;
+    }
+    if (nativeSocket->timeouts.idle != 0 && nativeSocket->idleDeadline <= now) {
+        expired |= fwEventIdleTimeout;
+        nativeSocket->idleDeadline = now + nativeSocket->timeouts.idle;
+    }
+
+    fwiSocketScheduleDeadlines(nativeSocket); // before the callback, which may close the socket
+    if (expired != 0) {
+        nativeSocket->eventCallback(nativeSocket->handle, expired, nativeSocket->eventUser_p);
+    }
+}
+
+static void fwiDispatchSocketEvent(struct fwiEventSource* source_p, uint32_t events) {
+    struct fwiNativeSocketState* nativeSocket = source_p->context_p;
+
+    // Zero-copy completions arrive on the error queue and raise EPOLLERR, a real socket error
+    // stays pending and raises it again on the next wait once the queue is drained
+    if ((events & EPOLLERR) && nativeSocket->zeroCopyCallback != nullptr) {
+        const fwSocket handle = nativeSocket->handle;
+        if (fwiReapZeroCopy(nativeSocket) != 0) {
+            if (fwiSocketLookup(handle) == nullptr) {
+                return;
+            }
+            events &= ~EPOLLERR;
+        }
+    }
+
+    const uint8_t ready = fwiEventEpollToReady(events);
+    if (ready == 0) {
+        return;
+    }
+    // A failed connect is left pending, so that the callback can learn it from fwSocketConnect
+    if (nativeSocket->connecting && (ready & fwEventWrite) && !(ready & fwEventError)) {
+        fwiSocketFinishConnect(nativeSocket);
+    }
+
+    if (nativeSocket->deadlineTimer.previous_pp != nullptr) {
+        const int64_t now = source_p->loop_p->now;
+        if (ready & fwEventRead) {
+            nativeSocket->readDeadline = now + nativeSocket->timeouts.read;
+        }
+        if (ready & fwEventWrite) {
+            nativeSocket->writeDeadline = now + nativeSocket->timeouts.write;
+        }
+        nativeSocket->idleDeadline = now + nativeSocket->timeouts.idle;
+    }
+    nativeSocket->eventCallback(nativeSocket->handle, ready, nativeSocket->eventUser_p);
+}
+
+static void fwiDispatchWakeEvent(struct fwiEventSource* source_p, const uint32_t events) {
+    (void)events;
+    uint64_t counter;
+    read(source_p->fileDescriptor, &counter, sizeof(counter)); // only resets the eventfd
+}
+
+fwError fwEventLoopCreate(fwEventLoop* loop_p) {
+    struct fwiNativeEventLoop* nativeLoop = calloc(1, sizeof(struct fwiNativeEventLoop));
+    if (nativeLoop == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+
+    if ((nativeLoop->epollFileDescriptor = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+        FWI_LOG_ERRNO;
+        free(nativeLoop);
+        return fwErrorEventLoop;
+    }
+
+    nativeLoop->wakeSource.handler    = fwiDispatchWakeEvent;
+    nativeLoop->wakeSource.context_p  = nativeLoop;
+    nativeLoop->timerSource.handler   = fwiDispatchTimerEvent;
+    nativeLoop->timerSource.context_p = nativeLoop;
+    nativeLoop->wakeSource.fileDescriptor  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    nativeLoop->timerSource.fileDescriptor = timerfd_create(CLOCK_MONOTONIC,
+                                                            TFD_NONBLOCK | TFD_CLOEXEC);
+    if (nativeLoop->wakeSource.fileDescriptor == -1 ||
+        nativeLoop->timerSource.fileDescriptor == -1 ||
+        fwiEventLoopAddSource(nativeLoop, &nativeLoop->wakeSource, EPOLLIN) != fwErrorSuccess ||
+        fwiEventLoopAddSource(nativeLoop, &nativeLoop->timerSource, EPOLLIN) != fwErrorSuccess) {
+        FWI_LOG_ERRNO;
+        if (nativeLoop->wakeSource.fileDescriptor != -1) {
+            close(nativeLoop->wakeSource.fileDescriptor);
+        }
+        if (nativeLoop->timerSource.fileDescriptor != -1) {
+            close(nativeLoop->timerSource.fileDescriptor);
+        }
+        close(nativeLoop->epollFileDescriptor);
+        free(nativeLoop);
+        return fwErrorEventLoop;
+    }
+
+    nativeLoop->now = fwiMonotonicMilliseconds();
+    nativeLoop->timerProgrammed = UINT64_MAX;
+    fwiTimerWheelInit(&nativeLoop->timerWheel, nativeLoop->now);
+
+    *loop_p = (uintptr_t)nativeLoop;
+
+    FWI_LOG_INFO("New event loop (ID: %lX) was created", *loop_p);
+    return fwErrorSuccess;
+}
+
+fwError fwEventLoopDestroy(const fwEventLoop loop) {
+    struct fwiNativeEventLoop* nativeLoop = {(struct fwiNativeEventLoop*)loop};
+    if (nativeLoop->timerCount != 0) {
+        FWI_LOG_ERROR("Event loop (ID: %lX) still has %u timers", loop, nativeLoop->timerCount);
+        return fwErrorInvalidParameter;
+    }
+
+    if (nativeLoop->windowSource_p != nullptr) {
+        fwiWindowDetach();
+    }
+    if (nativeLoop->sourceCount > 2) { // the wake and timer sources do not count
+        FWI_LOG_WARNING("Event loop (ID: %lX) destroyed with %d sources registered",
+                loop, nativeLoop->sourceCount - 2);
+    }
+
+    // Sockets keep a pointer to their loop, they are unregistered so that closing them later does
+    // not reach into the freed loop. Their deadline timers leave the wheel with them.
+    const uint32_t highWater = atomic_load_explicit(&socketTable_s.highWater, memory_order_acquire);
+    for (uint32_t i = 0; socketTable_s.slots_p != nullptr && i < highWater; i++) {
+        struct fwiNativeSocketState* state_p = &socketTable_s.slots_p[i];
+        if (state_p->handle != 0 && state_p->eventSource.loop_p == nativeLoop) {
+            fwiTimerWheelCancel(&nativeLoop->timerWheel, &state_p->deadlineTimer);
+            fwiEventLoopRemoveSource(&state_p->eventSource);
+        }
+    }
+
+    close(nativeLoop->timerSource.fileDescriptor);
+    close(nativeLoop->wakeSource.fileDescriptor);
+    close(nativeLoop->epollFileDescriptor);
+    free(nativeLoop);
+
+    FWI_LOG_INFO("Event loop (ID: %lX) was destroyed", loop);
+    return fwErrorSuccess;
+}
+
+fwError fwEventLoopGetDefault(fwEventLoop* loop_p) {
+    if (fwiGetNativeState()->defaultEventLoop == 0) {
+        return fwErrorModule;
+    }
+
+    *loop_p = fwiGetNativeState()->defaultEventLoop;
+    return fwErrorSuccess;
+}
+
+fwError fwEventLoopRegister(const fwEventLoop loop, const fwSocket sfdop, const uint8_t interest,
+                            const fwEventCallback callback, void* user_p) {
+    struct fwiNativeEventLoop* nativeLoop     = {(struct fwiNativeEventLoop*)loop};
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    if (callback == nullptr || nativeSocket->eventSource.loop_p != nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    if (!nativeSocket->nonBlocking) {
+        const fwError error = fwSocketSetNonBlocking(sfdop, true);
+        if (error != fwErrorSuccess) {
+            return error;
+        }
+    }
+
+    nativeSocket->eventCallback              = callback;
+    nativeSocket->eventUser_p                = user_p;
+    nativeSocket->eventInterest              = interest;
+    nativeSocket->eventSource.handler        = fwiDispatchSocketEvent;
+    nativeSocket->eventSource.context_p      = nativeSocket;
+    nativeSocket->eventSource.fileDescriptor = nativeSocket->fileDescriptor;
+    nativeSocket->deadlineTimer.handler      = fwiDispatchSocketDeadline;
+    nativeSocket->deadlineTimer.context_p    = nativeSocket;
+
+    const fwError error = fwiEventLoopAddSource(nativeLoop, &nativeSocket->eventSource,
+                                                fwiEventInterestToEpoll(interest));
+    if (error != fwErrorSuccess) {
+        return error;
+    }
+
+    fwiSocketRestartDeadlines(nativeSocket,
+                              fwEventReadTimeout | fwEventWriteTimeout | fwEventIdleTimeout);
+    return fwErrorSuccess;
+}
+
+fwError fwEventLoopModify(const fwSocket sfdop, const uint8_t interest) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    if (nativeSocket->eventSource.loop_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    const fwError error = fwiEventLoopModifySource(&nativeSocket->eventSource,
+                                                   fwiEventInterestToEpoll(interest));
+    if (error != fwErrorSuccess) {
+        return error;
+    }
+
+    // Waiting for an event that was not of interest before starts its deadline
+    const uint8_t added = interest & ~nativeSocket->eventInterest;
+    nativeSocket->eventInterest = interest;
+    fwiSocketRestartDeadlines(nativeSocket, (added & fwEventRead ? fwEventReadTimeout : 0) |
+                                            (added & fwEventWrite ? fwEventWriteTimeout : 0));
+    return fwErrorSuccess;
+}
+
+fwError fwEventLoopUnregister(const fwSocket sfdop) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    if (nativeSocket->eventSource.loop_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    fwiTimerWheelCancel(&nativeSocket->eventSource.loop_p->timerWheel,
+                        &nativeSocket->deadlineTimer);
+    return fwiEventLoopRemoveSource(&nativeSocket->eventSource);
+}
+
+fwError fwEventLoopRegisterWindow(const fwEventLoop loop) {
+    struct fwiNativeEventLoop* nativeLoop = {(struct fwiNativeEventLoop*)loop};
+
+    const fwError error = fwiWindowAttach(nativeLoop);
+    if (error == fwErrorSuccess) {
+        FWI_LOG_INFO("Wayland display was registered with event loop (ID: %lX)", loop);
+    }
+    return error;
+}
+
+fwError fwEventLoopUnregisterWindow(void) {
+    return fwiWindowDetach();
+}
+
+fwError fwEventLoopPoll(const fwEventLoop loop, const int32_t timeoutMs, uint32_t* dispatched_p) {
+    struct fwiNativeEventLoop* nativeLoop = {(struct fwiNativeEventLoop*)loop};
+
+    // Displays are read by the thread that waits on them, no other thread dispatches window events
+    if (nativeLoop->windowSource_p != nullptr) {
+        fwiWindowPrepareRead();
+    }
+
+    struct epoll_event events[FWI_EVENT_LOOP_BATCH];
+    const int32_t count = epoll_wait(nativeLoop->epollFileDescriptor, events, FWI_EVENT_LOOP_BATCH,
+                                     timeoutMs);
+    const int32_t err = errno; // finishing the display read may change it
+    if (nativeLoop->windowSource_p != nullptr) {
+        bool readable = false;
+        for (int32_t i = 0; i < count; i++) {
+            if (events[i].data.ptr == nativeLoop->windowSource_p) {
+                readable = (events[i].events & EPOLLIN) != 0;
+                break;
+            }
+        }
+        fwiWindowFinishRead(readable);
+    }
+    if (count == -1) {
+        if (err == EINTR) {
+            if (dispatched_p != nullptr) {
+                *dispatched_p = 0;
+            }
+            return fwErrorSuccess;
+        }
+        errno = err;
+        FWI_LOG_ERRNO;
+        return fwErrorEventLoop;
+    }
+
+    nativeLoop->now = fwiMonotonicMilliseconds(); // one clock read for every deadline in the batch
+    uint32_t dispatched         = 0;
+    nativeLoop->dispatching_p   = events;
+    nativeLoop->dispatchCount   = count;
+    for (nativeLoop->dispatchIndex = 0; nativeLoop->dispatchIndex < count;
+         nativeLoop->dispatchIndex++) {
+        struct fwiEventSource* source_p = events[nativeLoop->dispatchIndex].data.ptr;
+        if (source_p == nullptr) { // removed by a callback earlier in this batch
+            continue;
+        }
+        source_p->handler(source_p, events[nativeLoop->dispatchIndex].events);
+        dispatched++;
+    }
+    nativeLoop->dispatching_p = nullptr;
+
+    if (dispatched_p != nullptr) {
+        *dispatched_p = dispatched;
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwEventLoopRun(const fwEventLoop loop) {
+    struct fwiNativeEventLoop* nativeLoop = {(struct fwiNativeEventLoop*)loop};
+
+    atomic_store(&nativeLoop->running, true);
+    while (atomic_load(&nativeLoop->running)) {
+        const fwError error = fwEventLoopPoll(loop, -1, nullptr);
+        if (error != fwErrorSuccess) {
+            atomic_store(&nativeLoop->running, false);
+            return error;
+        }
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwEventLoopStop(const fwEventLoop loop) {
+    struct fwiNativeEventLoop* nativeLoop = {(struct fwiNativeEventLoop*)loop};
+
+    atomic_store(&nativeLoop->running, false);
+    const uint64_t one = 1;
+    write(nativeLoop->wakeSource.fileDescriptor, &one, sizeof(one));
+    return fwErrorSuccess;
+}
+
+/**
+ * @brief Backing state of an @c fwTimer
+ */
+struct fwiNativeTimer {
+    struct fwiTimer timer;
+    struct fwiNativeEventLoop* loop_p;
+    fwTimerCallback callback;
+    void* user_p;
+    uint32_t interval;
+};
+
+static void fwiDispatchTimer(struct fwiTimer* timer_p) {
+    struct fwiNativeTimer* nativeTimer = timer_p->context_p;
+
+    // Re-armed before the callback, which may destroy the timer. Missed expiries are skipped
+    // instead of fired all at once, the phase stays the same.
+    if (nativeTimer->interval != 0) {
+        const uint64_t now = nativeTimer->loop_p->now;
+        uint64_t expiry = timer_p->expiry + nativeTimer->interval;
+        if (expiry <= now) {
+            expiry += ((now - expiry) / nativeTimer->interval + 1) * nativeTimer->interval;
+        }
+        fwiTimerWheelArm(&nativeTimer->loop_p->timerWheel, timer_p, expiry);
+    }
+    nativeTimer->callback((fwTimer)nativeTimer, nativeTimer->user_p);
+}
+
+fwError fwTimerCreate(const fwEventLoop loop, const fwTimerCallback callback, void* user_p,
+                      fwTimer* timer_p) {
+    if (loop == 0 || callback == nullptr || timer_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    struct fwiNativeTimer* nativeTimer = calloc(1, sizeof(struct fwiNativeTimer));
+    if (nativeTimer == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+    nativeTimer->timer.handler   = fwiDispatchTimer;
+    nativeTimer->timer.context_p = nativeTimer;
+    nativeTimer->loop_p          = (struct fwiNativeEventLoop*)loop;
+    nativeTimer->callback        = callback;
+    nativeTimer->user_p          = user_p;
+    nativeTimer->loop_p->timerCount++;
+
+    *timer_p = (uintptr_t)nativeTimer;
+    return fwErrorSuccess;
+}
+
+fwError fwTimerDestroy(const fwTimer timer) {
+    struct fwiNativeTimer* nativeTimer = {(struct fwiNativeTimer*)timer};
+
+    fwiTimerWheelCancel(&nativeTimer->loop_p->timerWheel, &nativeTimer->timer);
+    nativeTimer->loop_p->timerCount--;
+    free(nativeTimer);
+    return fwErrorSuccess;
+}
+
+fwError fwTimerArm(const fwTimer timer, const uint32_t timeout, const uint32_t interval) {
+    struct fwiNativeTimer* nativeTimer = {(struct fwiNativeTimer*)timer};
+
+    nativeTimer->interval = interval;
+    fwiEventLoopArmTimer(nativeTimer->loop_p, &nativeTimer->timer,
+                         fwiMonotonicMilliseconds() + timeout);
+    return fwErrorSuccess;
+}
+
+fwError fwTimerCancel(const fwTimer timer) {
+    struct fwiNativeTimer* nativeTimer = {(struct fwiNativeTimer*)timer};
+
+    fwiTimerWheelCancel(&nativeTimer->loop_p->timerWheel, &nativeTimer->timer);
+    return fwErrorSuccess;
+}
+
+fwError fwSocketSetTimeouts(const fwSocket sfdop, const struct fwSocketTimeouts* timeouts_p) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr || timeouts_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    if (!fwiSocketApplyTimeouts(nativeSocket->fileDescriptor, timeouts_p)) {
+        FWI_LOG_ERRNO;
+        return fwErrorInvalidParameter;
+    }
+    nativeSocket->timeouts = *timeouts_p;
+
+    if (nativeSocket->eventSource.loop_p != nullptr) {
+        fwiSocketRestartDeadlines(nativeSocket,
+                                  fwEventReadTimeout | fwEventWriteTimeout | fwEventIdleTimeout);
+    }
+    return fwErrorSuccess;
+}
+
+static void fwiIoQueueRelease(struct fwiNativeIoQueue* nativeQueue) {
+    if (nativeQueue->sqes_p != nullptr) {
+        munmap(nativeQueue->sqes_p, nativeQueue->sqesSize);
+    }
+    if (nativeQueue->cqRing_p != nullptr && nativeQueue->cqRing_p != nativeQueue->sqRing_p) {
+        munmap(nativeQueue->cqRing_p, nativeQueue->cqRingSize);
+    }
+    if (nativeQueue->sqRing_p != nullptr) {
+        munmap(nativeQueue->sqRing_p, nativeQueue->sqRingSize);
+    }
+    close(nativeQueue->fileDescriptor);
+    free(nativeQueue->operations_p);
+    free(nativeQueue);
+}
+
+/**
+ * @brief Reserves the next submission entry and its bookkeeping, nullptr if the queue is full.
+ *        The entry only becomes visible to the kernel with @c fwiIoQueueCommit .
+ */
+static struct io_uring_sqe* fwiIoQueuePrepare(struct fwiNativeIoQueue* nativeQueue,
+                                              const fwiIoOperationKind kind, const uint64_t tag,
+                                              const struct fwiNativeSocketState* socket_p) {
+    const uint32_t tail = *nativeQueue->sqTail_p; // only ever written by this side
+    if (tail - __atomic_load_n(nativeQueue->sqHead_p, __ATOMIC_ACQUIRE) >= nativeQueue->sqEntries ||
+        nativeQueue->freeOperation == UINT32_MAX) {
+        return nullptr;
+    }
+
+    const uint32_t operation          = nativeQueue->freeOperation;
+    struct fwiIoOperation* operation_p = &nativeQueue->operations_p[operation];
+    nativeQueue->freeOperation        = operation_p->nextFree;
+    operation_p->tag                  = tag;
+    operation_p->socket               = socket_p != nullptr ? socket_p->handle : 0;
+    operation_p->kind                 = kind;
+
+    const uint32_t index = tail & nativeQueue->sqMask;
+    struct io_uring_sqe* sqe_p = &nativeQueue->sqes_p[index];
+    memset(sqe_p, 0, sizeof(struct io_uring_sqe));
+    sqe_p->user_data = operation;
+    nativeQueue->sqArray_p[index] = index;
+    return sqe_p;
+}
+
+static void fwiIoQueueCommit(struct fwiNativeIoQueue* nativeQueue) {
+    // The entry is complete now, remember how much was asked for to spot short transfers
+    const struct io_uring_sqe* sqe_p = &nativeQueue->sqes_p[*nativeQueue->sqTail_p &
+                                                            nativeQueue->sqMask];
+    nativeQueue->operations_p[sqe_p->user_data].length = sqe_p->len;
+
+    __atomic_store_n(nativeQueue->sqTail_p, *nativeQueue->sqTail_p + 1, __ATOMIC_RELEASE);
+    nativeQueue->unsubmitted++;
+}
+
+static fwError fwiIoQueueError(const fwiIoOperationKind kind, const int32_t err) {
+    if (err == EAGAIN || err == EWOULDBLOCK) {
+        return fwErrorSocketWouldBlock;
+    }
+    switch (kind) {
+        case fwiIoOperationSend: {
+            return fwErrorSocketSend;
+        }
+        case fwiIoOperationReceive: {
+            return fwErrorSocketReceive;
+        }
+        case fwiIoOperationAccept: {
+            return fwErrorSocketAccept;
+        }
+        case fwiIoOperationRead: {
+            return fwErrorFileStats;
+        }
+        default: {
+            return fwErrorGoodJob;
+        }
+    }
+}
+
+fwError fwIoQueueCreate(const uint32_t entries, fwIoQueue* queue_p) {
+    struct fwiNativeIoQueue* nativeQueue = calloc(1, sizeof(struct fwiNativeIoQueue));
+    if (nativeQueue == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+
+    struct io_uring_params params = {};
+    if ((nativeQueue->fileDescriptor = (int32_t)syscall(SYS_io_uring_setup, entries, &params)) ==
+        -1) {
+        FWI_LOG_ERRNO;
+        free(nativeQueue);
+        return fwErrorIoQueue;
+    }
+
+    nativeQueue->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    nativeQueue->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    nativeQueue->sqesSize   = params.sq_entries * sizeof(struct io_uring_sqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) { // both rings share one mapping since 5.4
+        if (nativeQueue->cqRingSize > nativeQueue->sqRingSize) {
+            nativeQueue->sqRingSize = nativeQueue->cqRingSize;
+        }
+        nativeQueue->cqRingSize = nativeQueue->sqRingSize;
+    }
+
+    void* mapping = mmap(nullptr, nativeQueue->sqRingSize, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, nativeQueue->fileDescriptor,
+                         IORING_OFF_SQ_RING);
+    nativeQueue->sqRing_p = mapping == MAP_FAILED ? nullptr : mapping;
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        nativeQueue->cqRing_p = nativeQueue->sqRing_p;
+    } else {
+        mapping = mmap(nullptr, nativeQueue->cqRingSize, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, nativeQueue->fileDescriptor, IORING_OFF_CQ_RING);
+        nativeQueue->cqRing_p = mapping == MAP_FAILED ? nullptr : mapping;
+    }
+
+    mapping = mmap(nullptr, nativeQueue->sqesSize, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, nativeQueue->fileDescriptor, IORING_OFF_SQES);
+    nativeQueue->sqes_p = mapping == MAP_FAILED ? nullptr : mapping;
+
+    if (nativeQueue->sqRing_p == nullptr || nativeQueue->cqRing_p == nullptr ||
+        nativeQueue->sqes_p == nullptr) {
+        FWI_LOG_ERRNO;
+        fwiIoQueueRelease(nativeQueue);
+        return fwErrorIoQueue;
+    }
+
+    uint8_t* sqRing = nativeQueue->sqRing_p;
+    uint8_t* cqRing = nativeQueue->cqRing_p;
+    nativeQueue->sqHead_p   = (uint32_t*)(sqRing + params.sq_off.head);
+    nativeQueue->sqTail_p   = (uint32_t*)(sqRing + params.sq_off.tail);
+    nativeQueue->sqArray_p  = (uint32_t*)(sqRing + params.sq_off.array);
+    nativeQueue->sqMask     = *(uint32_t*)(sqRing + params.sq_off.ring_mask);
+    nativeQueue->sqEntries  = params.sq_entries;
+    nativeQueue->cqHead_p   = (uint32_t*)(cqRing + params.cq_off.head);
+    nativeQueue->cqTail_p   = (uint32_t*)(cqRing + params.cq_off.tail);
+    nativeQueue->cqMask     = *(uint32_t*)(cqRing + params.cq_off.ring_mask);
+    nativeQueue->cqes_p     = (struct io_uring_cqe*)(cqRing + params.cq_off.cqes);
+
+    // Never more operations in flight than completions fit, so the completion ring cannot overflow
+    nativeQueue->operationCount = params.cq_entries;
+    nativeQueue->operations_p   = malloc(params.cq_entries * sizeof(struct fwiIoOperation));
+    if (nativeQueue->operations_p == nullptr) {
+        fwiIoQueueRelease(nativeQueue);
+        return fwErrorOutOfMemory;
+    }
+    for (uint32_t i = 0; i < params.cq_entries; i++) {
+        nativeQueue->operations_p[i].nextFree = i + 1 < params.cq_entries ? i + 1 : UINT32_MAX;
+    }
+
+    *queue_p = (uintptr_t)nativeQueue;
+
+    FWI_LOG_INFO("New I/O queue (ID: %lX) with %u entries was created", *queue_p,
+            params.sq_entries);
+    return fwErrorSuccess;
+}
+
+fwError fwIoQueueDestroy(const fwIoQueue queue) {
+    fwiIoQueueRelease((struct fwiNativeIoQueue*)queue);
+
+    FWI_LOG_INFO("I/O queue (ID: %lX) was destroyed", queue);
+    return fwErrorSuccess;
+}
+
+fwError fwIoQueueGetDefault(fwIoQueue* queue_p) {
+    if (fwiGetNativeState()->defaultIoQueue == 0) {
+        return fwErrorModule;
+    }
+
+    *queue_p = fwiGetNativeState()->defaultIoQueue;
+    return fwErrorSuccess;
+}
+
+fwError fwIoQueueSend(const fwIoQueue queue, const fwSocket sfdop, const void* data,
+                      const size_t ammount, const uint64_t tag) {
+    struct fwiNativeIoQueue* nativeQueue            = {(struct fwiNativeIoQueue*)queue};
+    const struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr || ammount > UINT32_MAX) { // the entry only holds 32 bits
+        return fwErrorInvalidParameter;
+    }
+
+    struct io_uring_sqe* sqe_p = fwiIoQueuePrepare(nativeQueue, fwiIoOperationSend, tag,
+                                                   nativeSocket);
+    if (sqe_p == nullptr) {
+        return fwErrorIoQueueFull;
+    }
+    sqe_p->opcode = IORING_OP_SEND;
+    sqe_p->fd     = nativeSocket->fileDescriptor;
+    sqe_p->addr   = (uintptr_t)data;
+    sqe_p->len    = ammount;
+    fwiIoQueueCommit(nativeQueue);
+    return fwErrorSuccess;
+}
+
+fwError fwIoQueueReceive(const fwIoQueue queue, const fwSocket sfdop, void* buffer,
+                         const size_t ammount, const uint64_t tag) {
+    struct fwiNativeIoQueue* nativeQueue            = {(struct fwiNativeIoQueue*)queue};
+    const struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr || ammount > UINT32_MAX) { // the entry only holds 32 bits
+        return fwErrorInvalidParameter;
+    }
+
+    struct io_uring_sqe* sqe_p = fwiIoQueuePrepare(nativeQueue, fwiIoOperationReceive, tag,
+                                                   nativeSocket);
+    if (sqe_p == nullptr) {
+        return fwErrorIoQueueFull;
+    }
+    sqe_p->opcode = IORING_OP_RECV;
+    sqe_p->fd     = nativeSocket->fileDescriptor;
+    sqe_p->addr   = (uintptr_t)buffer;
+    sqe_p->len    = ammount;
+    fwiIoQueueCommit(nativeQueue);
+    return fwErrorSuccess;
+}
+
+fwError fwIoQueueAccept(const fwIoQueue queue, const fwSocket sfdop, const uint64_t tag) {
+    struct fwiNativeIoQueue* nativeQueue      = {(struct fwiNativeIoQueue*)queue};
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    const fwError error = fwiSocketEnsureListening(nativeSocket, 0);
+    if (error != fwErrorSuccess) {
+        return error;
+    }
+
+    struct io_uring_sqe* sqe_p = fwiIoQueuePrepare(nativeQueue, fwiIoOperationAccept, tag,
+                                                   nativeSocket);
+    if (sqe_p == nullptr) {
+        return fwErrorIoQueueFull;
+    }
+    sqe_p->opcode       = IORING_OP_ACCEPT;
+    sqe_p->fd           = nativeSocket->fileDescriptor;
+    sqe_p->accept_flags = SOCK_CLOEXEC;
+    fwiIoQueueCommit(nativeQueue);
+    return fwErrorSuccess;
+}
+
+fwError fwIoQueueSubmit(const fwIoQueue queue, const uint32_t waitFor) {
+    struct fwiNativeIoQueue* nativeQueue = {(struct fwiNativeIoQueue*)queue};
+
+    const uint32_t flags = waitFor > 0 ? IORING_ENTER_GETEVENTS : 0;
+    while (true) {
+        const int32_t submitted = (int32_t)syscall(SYS_io_uring_enter, nativeQueue->fileDescriptor,
+                                                   nativeQueue->unsubmitted, waitFor, flags,
+                                                   nullptr, 0);
+        if (submitted == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            FWI_LOG_ERRNO;
+            return fwErrorIoQueue;
+        }
+        nativeQueue->unsubmitted -= submitted;
+        return fwErrorSuccess;
+    }
+}
+
+fwError fwIoQueueReap(const fwIoQueue queue, fwIoCompletion* completions_p,
+                      const uint32_t capacity, uint32_t* reaped_p) {
+    struct fwiNativeIoQueue* nativeQueue = {(struct fwiNativeIoQueue*)queue};
+
+    uint32_t head       = *nativeQueue->cqHead_p; // only ever written by this side
+    const uint32_t tail = __atomic_load_n(nativeQueue->cqTail_p, __ATOMIC_ACQUIRE);
+    uint32_t reaped     = 0;
+
+    while (head != tail && reaped < capacity) {
+        const struct io_uring_cqe* cqe_p   = &nativeQueue->cqes_p[head & nativeQueue->cqMask];
+        struct fwiIoOperation* operation_p = &nativeQueue->operations_p[cqe_p->user_data];
+        fwIoCompletion* completion_p       = &completions_p[reaped];
+
+        completion_p->tag         = operation_p->tag;
+        completion_p->transferred = 0;
+        completion_p->socket      = 0;
+        completion_p->error       = fwErrorSuccess;
+
+        struct fwiNativeSocketState* socket_p = operation_p->kind != fwiIoOperationRead ?
+                                                fwiSocketLookup(operation_p->socket) : nullptr;
+        if (socket_p != nullptr && operation_p->kind != fwiIoOperationAccept) {
+            fwiStatsEnd(&socket_p->statistics, 0, operation_p->kind == fwiIoOperationSend,
+                        cqe_p->res, (uint32_t)cqe_p->res < operation_p->length);
+        }
+
+        // The listener was closed while the accept was in flight, nobody is left to hand it to
+        const bool orphaned = operation_p->kind == fwiIoOperationAccept && socket_p == nullptr;
+        if (orphaned) {
+            if (cqe_p->res >= 0) {
+                close(cqe_p->res);
+            }
+        } else if (cqe_p->res < 0) {
+            completion_p->error = fwiIoQueueError(operation_p->kind, -cqe_p->res);
+        } else if (operation_p->kind == fwiIoOperationAccept) {
+            completion_p->error = fwiSocketAdopt(socket_p, cqe_p->res, false, nullptr, 0,
+                                                 &completion_p->socket);
+        } else {
+            completion_p->transferred = cqe_p->res;
+        }
+
+        operation_p->nextFree      = nativeQueue->freeOperation;
+        nativeQueue->freeOperation = cqe_p->user_data;
+        head++;
+        reaped += orphaned ? 0 : 1;
+    }
+
+    __atomic_store_n(nativeQueue->cqHead_p, head, __ATOMIC_RELEASE);
+    *reaped_p = reaped;
+    return fwErrorSuccess;
+}
+
+/**
+ * @brief Waits until none of the reads of @c fwiReadFileQueued is in flight anymore. Entries the
+ *        kernel has not picked up yet are taken back, the others are waited for and dropped.
+ */
+static void fwiIoQueueDrainReads(struct fwiNativeIoQueue* nativeQueue, uint32_t outstanding) {
+    // Without SQPOLL the kernel only consumes entries inside io_uring_enter, a failed call left
+    // everything between head and tail untouched
+    const uint32_t head = __atomic_load_n(nativeQueue->sqHead_p, __ATOMIC_ACQUIRE);
+    while (*nativeQueue->sqTail_p != head) {
+        const uint32_t tail      = *nativeQueue->sqTail_p - 1;
+        const uint32_t operation = nativeQueue->sqes_p[tail & nativeQueue->sqMask].user_data;
+        nativeQueue->operations_p[operation].nextFree = nativeQueue->freeOperation;
+        nativeQueue->freeOperation                    = operation;
+        __atomic_store_n(nativeQueue->sqTail_p, tail, __ATOMIC_RELEASE);
+        outstanding--;
+    }
+    nativeQueue->unsubmitted = 0;
+
+    fwIoCompletion completions[FWI_IO_QUEUE_FILE_ENTRIES];
+    while (outstanding > 0) {
+        if (fwIoQueueSubmit((fwIoQueue)nativeQueue, 1) != fwErrorSuccess) {
+            sched_yield(); // completions are still posted, just not waited for
+        }
+        uint32_t reaped = 0;
+        fwIoQueueReap((fwIoQueue)nativeQueue, completions, FWI_IO_QUEUE_FILE_ENTRIES, &reaped);
+        outstanding -= reaped;
+    }
+}
+
+/**
+ * @brief Reads a whole file through the queue in parallel chunks. The buffer stays owned by the
+ *        caller and no read is in flight anymore once this returns, whatever the result.
+ */
+static fwError fwiReadFileQueued(const fwIoQueue queue, const int32_t fileDescriptor,
+                                 uint8_t* buffer_p, const uint64_t size) {
+    struct fwiNativeIoQueue* nativeQueue = {(struct fwiNativeIoQueue*)queue};
+
+    fwIoCompletion completions[FWI_IO_QUEUE_FILE_ENTRIES];
+    uint64_t queuedUpTo  = 0;
+    uint32_t outstanding = 0;
+    fwError result       = fwErrorSuccess;
+
+    while (queuedUpTo < size || outstanding > 0) {
+        while (queuedUpTo < size && result == fwErrorSuccess) {
+            struct io_uring_sqe* sqe_p = fwiIoQueuePrepare(nativeQueue, fwiIoOperationRead,
+                                                           queuedUpTo, nullptr);
+            if (sqe_p == nullptr) {
+                break;
+            }
+            const uint32_t chunk = size - queuedUpTo < FWI_IO_QUEUE_FILE_CHUNK ?
+                                   size - queuedUpTo : FWI_IO_QUEUE_FILE_CHUNK;
+            sqe_p->opcode = IORING_OP_READ;
+            sqe_p->fd     = fileDescriptor;
+            sqe_p->addr   = (uintptr_t)(buffer_p + queuedUpTo);
+            sqe_p->len    = chunk;
+            sqe_p->off    = queuedUpTo;
+            fwiIoQueueCommit(nativeQueue);
+            queuedUpTo += chunk;
+            outstanding++;
+        }
+        if (outstanding == 0) {
+            if (result == fwErrorSuccess) {
+                result = fwErrorIoQueueFull; // nothing could be prepared, so nothing will complete
+            }
+            break;
+        }
+
+        if (fwIoQueueSubmit(queue, 1) != fwErrorSuccess) {
+            // The queue is shared by every load, stale completions must not outlive this one
+            fwiIoQueueDrainReads(nativeQueue, outstanding);
+            return fwErrorFileStats;
+        }
+
+        uint32_t reaped = 0;
+        fwIoQueueReap(queue, completions, FWI_IO_QUEUE_FILE_ENTRIES, &reaped);
+        for (uint32_t i = 0; i < reaped; i++) {
+            outstanding--;
+            if (completions[i].error != fwErrorSuccess) {
+                result = completions[i].error;
+                continue;
+            }
+
+            // Short reads are rare for regular files, finish them synchronously
+            const uint64_t offset = completions[i].tag;
+            uint64_t done         = completions[i].transferred;
+            const uint64_t chunk  = size - offset < FWI_IO_QUEUE_FILE_CHUNK ?
+                                    size - offset : FWI_IO_QUEUE_FILE_CHUNK;
+            while (done < chunk && result == fwErrorSuccess) {
+                const ssize_t readden = pread(fileDescriptor, buffer_p + offset + done,
+                                              chunk - done, (off_t)(offset + done));
+                if (readden <= 0) {
+                    result = fwErrorFileStats;
+                    break;
+                }
+                done += readden;
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Starts the asynchronous read of the next chunk into the buffer which is not handed out
+ */
+static fwError fwiFileReaderIssue(struct fwiNativeFileReader* nativeReader) {
+    struct fwiNativeIoQueue* nativeQueue = {(struct fwiNativeIoQueue*)nativeReader->queue};
+
+    struct io_uring_sqe* sqe_p = fwiIoQueuePrepare(nativeQueue, fwiIoOperationRead,
+                                                   nativeReader->readOffset, nullptr);
+    if (sqe_p == nullptr) {
+        return fwErrorIoQueueFull;
+    }
+    sqe_p->opcode = IORING_OP_READ;
+    sqe_p->fd     = nativeReader->fileDescriptor;
+    sqe_p->addr   = (uintptr_t)nativeReader->buffers_p[nativeReader->filling];
+    sqe_p->len    = nativeReader->chunkSize;
+    sqe_p->off    = nativeReader->readOffset;
+    fwiIoQueueCommit(nativeQueue);
+
+    if (fwIoQueueSubmit(nativeReader->queue, 0) != fwErrorSuccess) {
+        return fwErrorFileStats;
+    }
+    nativeReader->pending = true;
+    return fwErrorSuccess;
+}
+
+fwError fwFileReaderOpen(const char* filename_p, const size_t chunkSize, fwFileReader* reader_p) {
+    if (chunkSize == 0) {
+        return fwErrorInvalidParameter;
+    }
+
+    struct fwiNativeFileReader* nativeReader = calloc(1, sizeof(struct fwiNativeFileReader));
+    if (nativeReader == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+
+    // Page aligned so the kernel can copy into the buffers in whole pages
+    const size_t alignedChunkSize = (chunkSize + 4095) & ~(size_t)4095;
+    uint8_t* buffers_p = aligned_alloc(4096, alignedChunkSize * 2);
+    if (buffers_p == nullptr) {
+        free(nativeReader);
+        return fwErrorOutOfMemory;
+    }
+    nativeReader->buffers_p[0] = buffers_p;
+    nativeReader->buffers_p[1] = buffers_p + alignedChunkSize;
+    nativeReader->chunkSize    = chunkSize;
+
+    if ((nativeReader->fileDescriptor = open(filename_p, O_RDONLY | O_CLOEXEC)) == -1) {
+        free(buffers_p);
+        free(nativeReader);
+        return fwErrorFileUnableToOpen;
+    }
+
+    // Doubles the read-ahead window of the kernel for this file
+    posix_fadvise(nativeReader->fileDescriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    // Only take the asynchronous path if the io_uring engine was asked for, a reader brings its
+    // own queue since the reads of different readers are unrelated
+    if (fwiGetNativeState()->fileIoQueue != 0 &&
+        fwIoQueueCreate(2, &nativeReader->queue) == fwErrorSuccess &&
+        fwiFileReaderIssue(nativeReader) != fwErrorSuccess) {
+        fwIoQueueDestroy(nativeReader->queue);
+        nativeReader->queue = 0;
+    }
+
+    *reader_p = (uintptr_t)nativeReader;
+    return fwErrorSuccess;
+}
+
+fwError fwFileReaderNext(const fwFileReader reader, const void** chunk_pp, size_t* chunkSize_p) {
+    struct fwiNativeFileReader* nativeReader = {(struct fwiNativeFileReader*)reader};
+
+    if (nativeReader->queue == 0) {
+        const ssize_t readden = pread(nativeReader->fileDescriptor, nativeReader->buffers_p[0],
+                                      nativeReader->chunkSize, (off_t)nativeReader->readOffset);
+        if (readden == -1) {
+            FWI_LOG_ERRNO;
+            return fwErrorFileStats;
+        }
+
+        nativeReader->readOffset += readden;
+        if (readden > 0) {
+            // The kernel fetches the next chunk while the caller is busy with this one
+            posix_fadvise(nativeReader->fileDescriptor, (off_t)nativeReader->readOffset,
+                          (off_t)nativeReader->chunkSize, POSIX_FADV_WILLNEED);
+        }
+
+        *chunk_pp    = nativeReader->buffers_p[0];
+        *chunkSize_p = readden;
+        return fwErrorSuccess;
+    }
+
+    if (!nativeReader->pending) { // the end of the file was reached before
+        *chunk_pp    = nativeReader->buffers_p[nativeReader->filling];
+        *chunkSize_p = 0;
+        return fwErrorSuccess;
+    }
+
+    fwIoCompletion completion = {};
+    uint32_t reaped = 0;
+    fwIoQueueReap(nativeReader->queue, &completion, 1, &reaped);
+    if (reaped == 0) {
+        if (fwIoQueueSubmit(nativeReader->queue, 1) != fwErrorSuccess) {
+            return fwErrorFileStats;
+        }
+        fwIoQueueReap(nativeReader->queue, &completion, 1, &reaped);
+    }
+    nativeReader->pending = false;
+    if (completion.error != fwErrorSuccess) {
+        return completion.error;
+    }
+
+    const uint8_t ready = nativeReader->filling;
+    *chunk_pp    = nativeReader->buffers_p[ready];
+    *chunkSize_p = completion.transferred;
+
+    // The buffer of the previous chunk is free again since the caller moved on
+    if (completion.transferred > 0) {
+        nativeReader->readOffset += completion.transferred;
+        nativeReader->filling     = ready ^ 1;
+        const fwError error = fwiFileReaderIssue(nativeReader);
+        if (error != fwErrorSuccess) {
+            return error;
+        }
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwFileReaderClose(const fwFileReader reader) {
+    struct fwiNativeFileReader* nativeReader = {(struct fwiNativeFileReader*)reader};
+
+    if (nativeReader->queue != 0) {
+        if (nativeReader->pending) { // the kernel must be done writing before the buffer is freed
+            fwIoCompletion completion = {};
+            uint32_t reaped = 0;
+            fwIoQueueSubmit(nativeReader->queue, 1);
+            fwIoQueueReap(nativeReader->queue, &completion, 1, &reaped);
+        }
+        fwIoQueueDestroy(nativeReader->queue);
+    }
+
+    close(nativeReader->fileDescriptor);
+    free(nativeReader->buffers_p[0]);
+    free(nativeReader);
+    return fwErrorSuccess;
+}
+
+struct fwiJobBatch;
+struct fwiJobCounter;
+
+struct fwiJob {
+    fwJobFunction function;
+    void* user_p;
+    struct fwiJobBatch* batch_p;
+    struct fwiJob* next_p; // link inside of the injection queue
+};
+
+/**
+ * @brief All jobs of one submission share one allocation, the last one to finish frees it
+ */
+struct fwiJobBatch {
+    struct fwiJobCounter* counter_p;
+    struct fwiJobBatch* nextDeferred_p;
+    atomic_uint remaining;
+    uint32_t count;
+    struct fwiJob jobs[];
+};
+
+struct fwiJobCounter {
+    _Atomic uint64_t value;
+    pthread_mutex_t mutex;
+    pthread_cond_t reachedZero;
+    struct fwiJobBatch* deferred_p; // batches submitted with this counter as their dependency
+};
+
+/**
+ * @brief Chase-Lev deque, only the owning worker pushes and pops at the bottom while every other
+ *        thread steals from the top
+ */
+struct fwiJobDeque {
+    alignas(64) _Atomic int64_t top;
+    alignas(64) _Atomic int64_t bottom;
+    alignas(64) _Atomic(struct fwiJob*) entries[FWI_JOB_DEQUE_SIZE];
+};
+
+struct fwiJobWorker {
+    struct fwiJobDeque deque;
+    pthread_t thread;
+    uint32_t index;
+    uint32_t random; // xorshift state for picking steal victims
+};
+
+struct fwiJobSystem {
+    struct fwiJobWorker* workers_p;
+    uint32_t workerCount;
+    atomic_bool running;
+
+    // Jobs from threads that are not workers and from deques that ran full
+    pthread_mutex_t injectionMutex;
+    struct fwiJob* injectionHead_p;
+    struct fwiJob* injectionTail_p;
+    atomic_uint injectionCount;
+
+    // Idle workers sleep until the generation changes
+    pthread_mutex_t sleepMutex;
+    pthread_cond_t wake;
+    _Atomic uint64_t generation;
+    atomic_uint sleepers;
+};
+
+static struct fwiJobSystem jobSystem_s = {
+    .injectionMutex = PTHREAD_MUTEX_INITIALIZER,
+    .sleepMutex = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER
+};
+
+static thread_local struct fwiJobWorker* currentWorker_s = nullptr;
+
+static bool fwiJobDequePush(struct fwiJobDeque* deque_p, struct fwiJob* job_p) {
+    const int64_t bottom = atomic_load_explicit(&deque_p->bottom, memory_order_relaxed);
+    const int64_t top    = atomic_load_explicit(&deque_p->top, memory_order_acquire);
+    if (bottom - top >= FWI_JOB_DEQUE_SIZE) {
+        return false;
+    }
+
+    atomic_store_explicit(&deque_p->entries[bottom & (FWI_JOB_DEQUE_SIZE - 1)], job_p,
+                          memory_order_relaxed);
+    atomic_store_explicit(&deque_p->bottom, bottom + 1, memory_order_release);
+    return true;
+}
+
+static struct fwiJob* fwiJobDequePop(struct fwiJobDeque* deque_p) {
+    const int64_t bottom = atomic_load_explicit(&deque_p->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque_p->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t top = atomic_load_explicit(&deque_p->top, memory_order_relaxed);
+
+    if (top > bottom) { // empty
+        atomic_store_explicit(&deque_p->bottom, bottom + 1, memory_order_relaxed);
+        return nullptr;
+    }
+
+    struct fwiJob* job_p = atomic_load_explicit(&deque_p->entries[bottom & (FWI_JOB_DEQUE_SIZE - 1)],
+                                                memory_order_relaxed);
+    if (top == bottom) { // the last entry, a thief may be going for it as well
+        if (!atomic_compare_exchange_strong_explicit(&deque_p->top, &top, top + 1,
+                                                     memory_order_seq_cst, memory_order_relaxed)) {
+            job_p = nullptr;
+        }
+        atomic_store_explicit(&deque_p->bottom, bottom + 1, memory_order_relaxed);
+    }
+    return job_p;
+}
+
+static struct fwiJob* fwiJobDequeSteal(struct fwiJobDeque* deque_p) {
+    int64_t top = atomic_load_explicit(&deque_p->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    const int64_t bottom = atomic_load_explicit(&deque_p->bottom, memory_order_acquire);
+    if (top >= bottom) {
+        return nullptr;
+    }
+
+    struct fwiJob* job_p = atomic_load_explicit(&deque_p->entries[top & (FWI_JOB_DEQUE_SIZE - 1)],
+                                                memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque_p->top, &top, top + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed)) {
+        return nullptr; // lost against the owner or another thief
+    }
+    return job_p;
+}
+
+static void fwiJobWakeWorkers(void) {
+    atomic_fetch_add_explicit(&jobSystem_s.generation, 1, memory_order_seq_cst);
+    if (atomic_load_explicit(&jobSystem_s.sleepers, memory_order_seq_cst) != 0) {
+        pthread_mutex_lock(&jobSystem_s.sleepMutex);
+        pthread_cond_broadcast(&jobSystem_s.wake);
+        pthread_mutex_unlock(&jobSystem_s.sleepMutex);
+    }
+}
+
+static void fwiJobInject(struct fwiJob* first_p, struct fwiJob* last_p, const uint32_t count) {
+    last_p->next_p = nullptr;
+
+    pthread_mutex_lock(&jobSystem_s.injectionMutex);
+    if (jobSystem_s.injectionTail_p != nullptr) {
+        jobSystem_s.injectionTail_p->next_p = first_p;
+    }
+    else {
+        jobSystem_s.injectionHead_p = first_p;
+    }
+    jobSystem_s.injectionTail_p = last_p;
+    atomic_fetch_add_explicit(&jobSystem_s.injectionCount, count, memory_order_release);
+    pthread_mutex_unlock(&jobSystem_s.injectionMutex);
+}
+
+static struct fwiJob* fwiJobTakeInjected(void) {
+    // Checked without the lock first, workers poll this whenever their own deque is empty
+    if (atomic_load_explicit(&jobSystem_s.injectionCount, memory_order_acquire) == 0) {
+        return nullptr;
+    }
+
+    pthread_mutex_lock(&jobSystem_s.injectionMutex);
+    struct fwiJob* job_p = jobSystem_s.injectionHead_p;
+    if (job_p != nullptr) {
+        jobSystem_s.injectionHead_p = job_p->next_p;
+        if (jobSystem_s.injectionHead_p == nullptr) {
+            jobSystem_s.injectionTail_p = nullptr;
+        }
+        atomic_fetch_sub_explicit(&jobSystem_s.injectionCount, 1, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&jobSystem_s.injectionMutex);
+    return job_p;
+}
+
+static void fwiJobEnqueueBatch(struct fwiJobBatch* batch_p) {
+    struct fwiJobWorker* worker_p = currentWorker_s;
+    const uint32_t count = batch_p->count; // pushed jobs may finish and free the batch at any time
+    uint32_t pushed = 0;
+
+    // Submissions from a job stay local, that is where the data they work on is cached
+    if (worker_p != nullptr) {
+        while (pushed < count && fwiJobDequePush(&worker_p->deque, &batch_p->jobs[pushed])) {
+            pushed++;
+        }
+    }
+
+    if (pushed < count) {
+        for (uint32_t i = pushed; i + 1 < count; i++) {
+            batch_p->jobs[i].next_p = &batch_p->jobs[i + 1];
+        }
+        fwiJobInject(&batch_p->jobs[pushed], &batch_p->jobs[count - 1], count - pushed);
+    }
+
+    fwiJobWakeWorkers();
+}
+
+/**
+ * @brief Queues a single job that is not part of a batch, locally if called from a worker
+ */
+static void fwiJobEnqueue(struct fwiJob* job_p) {
+    struct fwiJobWorker* worker_p = currentWorker_s;
+    if (worker_p == nullptr || !fwiJobDequePush(&worker_p->deque, job_p)) {
+        fwiJobInject(job_p, job_p, 1);
+    }
+    fwiJobWakeWorkers();
+}
+
+static struct fwiJob* fwiJobFind(struct fwiJobWorker* self_p) {
+    struct fwiJob* job_p = nullptr;
+    if (self_p != nullptr && (job_p = fwiJobDequePop(&self_p->deque)) != nullptr) {
+        return job_p;
+    }
+    if ((job_p = fwiJobTakeInjected()) != nullptr) {
+        return job_p;
+    }
+
+    // Start at a random victim so that thieves do not all pile onto the same deque
+    uint32_t random = self_p != nullptr ? self_p->random : (uint32_t)(uintptr_t)&job_p;
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    if (self_p != nullptr) {
+        self_p->random = random;
+    }
+
+    const uint32_t workerCount = jobSystem_s.workerCount;
+    for (uint32_t i = 0; i < workerCount; i++) {
+        struct fwiJobWorker* victim_p = &jobSystem_s.workers_p[(random + i) % workerCount];
+        if (victim_p != self_p && (job_p = fwiJobDequeSteal(&victim_p->deque)) != nullptr) {
+            return job_p;
+        }
+    }
+    return nullptr;
+}
+
+static void fwiJobCounterRelease(struct fwiJobCounter* counter_p, const uint64_t amount) {
+    uint64_t value = atomic_load_explicit(&counter_p->value, memory_order_relaxed);
+    while (value > amount) {
+        if (atomic_compare_exchange_weak_explicit(&counter_p->value, &value, value - amount,
+                                                  memory_order_acq_rel, memory_order_relaxed)) {
+            return;
+        }
+    }
+
+    // The step to zero happens under the lock, fwJobWait takes it before returning so the counter
+    // cannot be destroyed while this is still using it
+    pthread_mutex_lock(&counter_p->mutex);
+    if (atomic_fetch_sub_explicit(&counter_p->value, amount, memory_order_acq_rel) != amount) {
+        pthread_mutex_unlock(&counter_p->mutex);
+        return;
+    }
+
+    // Reached zero, hand out whatever was waiting for that and wake the waiters
+    struct fwiJobBatch* deferred_p = counter_p->deferred_p;
+    counter_p->deferred_p = nullptr;
+    pthread_cond_broadcast(&counter_p->reachedZero);
+    pthread_mutex_unlock(&counter_p->mutex);
+
+    while (deferred_p != nullptr) {
+        struct fwiJobBatch* next_p = deferred_p->nextDeferred_p;
+        fwiJobEnqueueBatch(deferred_p);
+        deferred_p = next_p;
+    }
+}
+
+static void fwiJobRun(struct fwiJob* job_p) {
+    // Jobs without a batch are embedded into their owner, like the one that resumes a fiber. The
+    // owner may already be queued again by the time the function returns.
+    struct fwiJobBatch* batch_p = job_p->batch_p;
+    job_p->function(job_p->user_p);
+    if (batch_p == nullptr) {
+        return;
+    }
+
+    struct fwiJobCounter* counter_p = batch_p->counter_p;
+    if (atomic_fetch_sub_explicit(&batch_p->remaining, 1, memory_order_acq_rel) == 1) {
+        free(batch_p);
+    }
+    if (counter_p != nullptr) {
+        fwiJobCounterRelease(counter_p, 1);
+    }
+}
+
+static void* fwiJobWorkerMain(void* worker_p) {
+    struct fwiJobWorker* self_p = worker_p;
+    currentWorker_s = self_p;
+
+    for (;;) {
+        const uint64_t generation = atomic_load_explicit(&jobSystem_s.generation,
+                                                         memory_order_seq_cst);
+        struct fwiJob* job_p = fwiJobFind(self_p);
+        if (job_p != nullptr) {
+            fwiJobRun(job_p);
+            continue;
+        }
+
+        // Every queue was empty, stopping only happens once nothing is left to run
+        if (!atomic_load_explicit(&jobSystem_s.running, memory_order_acquire)) {
+            break;
+        }
+
+        pthread_mutex_lock(&jobSystem_s.sleepMutex);
+        atomic_fetch_add_explicit(&jobSystem_s.sleepers, 1, memory_order_seq_cst);
+        while (atomic_load_explicit(&jobSystem_s.generation, memory_order_seq_cst) == generation &&
+               atomic_load_explicit(&jobSystem_s.running, memory_order_acquire)) {
+            pthread_cond_wait(&jobSystem_s.wake, &jobSystem_s.sleepMutex);
+        }
+        atomic_fetch_sub_explicit(&jobSystem_s.sleepers, 1, memory_order_relaxed);
+        pthread_mutex_unlock(&jobSystem_s.sleepMutex);
+    }
+
+    currentWorker_s = nullptr;
+    return nullptr;
+}
+
+fwError fwiJobSystemCreate(const uint32_t workers) {
+    struct fwiJobWorker* workers_p = aligned_alloc(64, workers * sizeof(struct fwiJobWorker));
+    if (workers_p == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+    memset(workers_p, 0, workers * sizeof(struct fwiJobWorker));
+
+    jobSystem_s.workers_p   = workers_p;
+    jobSystem_s.workerCount = workers;
+    atomic_store(&jobSystem_s.running, true);
+
+    // Workers are spread over the CPUs the process may run on, which are not always 0 to n - 1
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    int32_t allowedCount = 0;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        allowedCount = CPU_COUNT(&allowed);
+    } else {
+        FWI_LOG_ERRNO;
+    }
+    int32_t cpu = -1;
+
+    for (uint32_t i = 0; i < workers; i++) {
+        workers_p[i].index  = i;
+        workers_p[i].random = i * 2654435761u + 1; // never 0, xorshift would get stuck
+
+        if (pthread_create(&workers_p[i].thread, nullptr, fwiJobWorkerMain, &workers_p[i]) != 0) {
+            jobSystem_s.workerCount = i;
+            fwiJobSystemDestroy();
+            return fwErrorOutOfMemory;
+        }
+
+        // Pinned workers keep their deque and the data of their jobs in the caches of one core
+        if (allowedCount == 0) {
+            continue;
+        }
+        do {
+            cpu = (cpu + 1) % CPU_SETSIZE;
+        } while (!CPU_ISSET(cpu, &allowed));
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        const int32_t error = pthread_setaffinity_np(workers_p[i].thread, sizeof(cpus), &cpus);
+        if (error != 0) {
+            FWI_LOG_WARNING("Job worker %u could not be pinned to CPU %d: %s", i, cpu,
+                            strerror(error));
+        }
+    }
+
+    return fwErrorSuccess;
+}
+
+static void fwiFiberSystemDestroy(
+    void
+    );
+
+void fwiJobSystemDestroy(void) {
+    if (jobSystem_s.workers_p == nullptr) {
+        return;
+    }
+
+    pthread_mutex_lock(&jobSystem_s.sleepMutex);
+    atomic_store(&jobSystem_s.running, false);
+    pthread_cond_broadcast(&jobSystem_s.wake);
+    pthread_mutex_unlock(&jobSystem_s.sleepMutex);
+
+    for (uint32_t i = 0; i < jobSystem_s.workerCount; i++) {
+        pthread_join(jobSystem_s.workers_p[i].thread, nullptr);
+    }
+
+    free(jobSystem_s.workers_p);
+    jobSystem_s.workers_p   = nullptr;
+    jobSystem_s.workerCount = 0;
+
+    // Fibers that are still waiting on sockets can no longer be resumed
+    fwiFiberSystemDestroy();
+}
+
+fwError fwJobCounterCreate(fwJobCounter* counter_p) {
+    struct fwiJobCounter* nativeCounter = calloc(1, sizeof(struct fwiJobCounter));
+    if (nativeCounter == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+
+    pthread_mutex_init(&nativeCounter->mutex, nullptr);
+    pthread_cond_init(&nativeCounter->reachedZero, nullptr);
+
+    *counter_p = (uintptr_t)nativeCounter;
+    return fwErrorSuccess;
+}
+
+fwError fwJobCounterDestroy(const fwJobCounter counter) {
+    struct fwiJobCounter* nativeCounter = {(struct fwiJobCounter*)counter};
+
+    pthread_cond_destroy(&nativeCounter->reachedZero);
+    pthread_mutex_destroy(&nativeCounter->mutex);
+    free(nativeCounter);
+    return fwErrorSuccess;
+}
+
+static fwError fwiJobCreateBatch(const fwJob* jobs_p, const uint32_t count,
+                                 const fwJobCounter counter, struct fwiJobBatch** batch_pp) {
+    if (jobSystem_s.workers_p == nullptr) {
+        return fwErrorModule;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (jobs_p[i].function == nullptr) {
+            return fwErrorInvalidParameter;
+        }
+    }
+
+    struct fwiJobBatch* batch_p = malloc(sizeof(struct fwiJobBatch) +
+                                         count * sizeof(struct fwiJob));
+    if (batch_p == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+
+    batch_p->counter_p      = (struct fwiJobCounter*)counter;
+    batch_p->nextDeferred_p = nullptr;
+    batch_p->count          = count;
+    atomic_init(&batch_p->remaining, count);
+    for (uint32_t i = 0; i < count; i++) {
+        batch_p->jobs[i].function = jobs_p[i].function;
+        batch_p->jobs[i].user_p   = jobs_p[i].user_p;
+        batch_p->jobs[i].batch_p  = batch_p;
+        batch_p->jobs[i].next_p   = nullptr;
+    }
+
+    // Raised before any of the jobs can run, so their releases never see it drop below zero
+    if (batch_p->counter_p != nullptr) {
+        atomic_fetch_add_explicit(&batch_p->counter_p->value, count, memory_order_relaxed);
+    }
+
+    *batch_pp = batch_p;
+    return fwErrorSuccess;
+}
+
+fwError fwJobSubmit(const fwJob* jobs_p, const uint32_t count, const fwJobCounter counter) {
+    if (count == 0) {
+        return fwErrorSuccess;
+    }
+
+    struct fwiJobBatch* batch_p = nullptr;
+    const fwError ret = fwiJobCreateBatch(jobs_p, count, counter, &batch_p);
+    if (ret != fwErrorSuccess) {
+        return ret;
+    }
+
+    fwiJobEnqueueBatch(batch_p);
+    return fwErrorSuccess;
+}
+
+fwError fwJobSubmitAfter(const fwJobCounter dependency, const fwJob* jobs_p, const uint32_t count,
+                         const fwJobCounter counter) {
+    if (dependency == 0) {
+        return fwErrorInvalidParameter;
+    }
+    if (count == 0) {
+        return fwErrorSuccess;
+    }
+
+    struct fwiJobBatch* batch_p = nullptr;
+    const fwError ret = fwiJobCreateBatch(jobs_p, count, counter, &batch_p);
+    if (ret != fwErrorSuccess) {
+        return ret;
+    }
+
+    // Checked under the lock the release to zero takes, so the batch is never stranded
+    struct fwiJobCounter* nativeDependency = {(struct fwiJobCounter*)dependency};
+    pthread_mutex_lock(&nativeDependency->mutex);
+    const bool reached = atomic_load_explicit(&nativeDependency->value, memory_order_acquire) == 0;
+    if (!reached) {
+        batch_p->nextDeferred_p = nativeDependency->deferred_p;
+        nativeDependency->deferred_p = batch_p;
+    }
+    pthread_mutex_unlock(&nativeDependency->mutex);
+
+    if (reached) {
+        fwiJobEnqueueBatch(batch_p);
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwJobWait(const fwJobCounter counter) {
+    struct fwiJobCounter* nativeCounter = {(struct fwiJobCounter*)counter};
+    struct fwiJobWorker* self_p = currentWorker_s;
+    uint32_t idleRounds = 0;
+
+    while (atomic_load_explicit(&nativeCounter->value, memory_order_acquire) != 0) {
+        struct fwiJob* job_p = jobSystem_s.workers_p != nullptr ? fwiJobFind(self_p) : nullptr;
+        if (job_p != nullptr) {
+            fwiJobRun(job_p);
+            idleRounds = 0;
+            continue;
+        }
+
+        if (++idleRounds < FWI_JOB_WAIT_SPINS) {
+            sched_yield();
+            continue;
+        }
+
+        // Nothing left to help with, the remaining jobs are running on other threads
+        pthread_mutex_lock(&nativeCounter->mutex);
+        while (atomic_load_explicit(&nativeCounter->value, memory_order_acquire) != 0) {
+            pthread_cond_wait(&nativeCounter->reachedZero, &nativeCounter->mutex);
+        }
+        pthread_mutex_unlock(&nativeCounter->mutex);
+    }
+
+    // Waits for the release that reached zero to let go of the counter
+    pthread_mutex_lock(&nativeCounter->mutex);
+    pthread_mutex_unlock(&nativeCounter->mutex);
+    return fwErrorSuccess;
+}
+
+fwError fwJobGetWorkerCount(uint32_t* count_p) {
+    if (jobSystem_s.workers_p == nullptr) {
+        return fwErrorModule;
+    }
+
+    *count_p = jobSystem_s.workerCount;
+    return fwErrorSuccess;
+}
+
+/*
+ * Fibers switch stacks with a few instructions of assembly instead of swapcontext, which saves
+ * and restores the signal mask with a syscall on every switch. Only the registers the calling
+ * convention requires a callee to preserve are saved, everything else was already spilled by the
+ * compiler around the call. On x86_64 that includes the control bits of MXCSR and the x87 control
+ * word, so rounding modes and exception masks stay with their fiber. A new stack starts with a frame that "returns" into fwiFiberBoot,
+ * which passes the fiber to fwiFiberEntry.
+ */
+#if defined(__x86_64__)
+#define FWI_FIBER_SUPPORTED 1
+__asm__(
+    ".text\n"
+    ".globl fwiFiberSwitch\n"
+    ".hidden fwiFiberSwitch\n"
+    ".type fwiFiberSwitch, @function\n"
+    "fwiFiberSwitch:\n" // rdi receives the current stack pointer, rsi is the one to continue on
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    subq $8, %rsp\n"
+    "    stmxcsr (%rsp)\n"
+    "    fnstcw 4(%rsp)\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    ldmxcsr (%rsp)\n"
+    "    fldcw 4(%rsp)\n"
+    "    addq $8, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    ".size fwiFiberSwitch, .-fwiFiberSwitch\n"
+    ".globl fwiFiberBoot\n"
+    ".hidden fwiFiberBoot\n"
+    ".type fwiFiberBoot, @function\n"
+    "fwiFiberBoot:\n"
+    "    movq %r12, %rdi\n"
+    "    callq *%r13\n"
+    "    ud2\n"
+    ".size fwiFiberBoot, .-fwiFiberBoot\n"
+);
+#elif defined(__aarch64__)
+#define FWI_FIBER_SUPPORTED 1
+__asm__(
+    ".text\n"
+    ".globl fwiFiberSwitch\n"
+    ".hidden fwiFiberSwitch\n"
+    ".type fwiFiberSwitch, %function\n"
+    "fwiFiberSwitch:\n" // x0 receives the current stack pointer, x1 is the one to continue on
+    "    sub sp, sp, #176\n"
+    "    stp x19, x20, [sp, #0]\n"
+    "    stp x21, x22, [sp, #16]\n"
+    "    stp x23, x24, [sp, #32]\n"
+    "    stp x25, x26, [sp, #48]\n"
+    "    stp x27, x28, [sp, #64]\n"
+    "    stp x29, x30, [sp, #80]\n"
+    "    stp d8, d9, [sp, #96]\n"
+    "    stp d10, d11, [sp, #112]\n"
+    "    stp d12, d13, [sp, #128]\n"
+    "    stp d14, d15, [sp, #144]\n"
+    "    mov x2, sp\n"
+    "    str x2, [x0]\n"
+    "    mov sp, x1\n"
+    "    ldp x19, x20, [sp, #0]\n"
+    "    ldp x21, x22, [sp, #16]\n"
+    "    ldp x23, x24, [sp, #32]\n"
+    "    ldp x25, x26, [sp, #48]\n"
+    "    ldp x27, x28, [sp, #64]\n"
+    "    ldp x29, x30, [sp, #80]\n"
+    "    ldp d8, d9, [sp, #96]\n"
+    "    ldp d10, d11, [sp, #112]\n"
+    "    ldp d12, d13, [sp, #128]\n"
+    "    ldp d14, d15, [sp, #144]\n"
+    "    add sp, sp, #176\n"
+    "    ret\n"
+    ".size fwiFiberSwitch, .-fwiFiberSwitch\n"
+    ".globl fwiFiberBoot\n"
+    ".hidden fwiFiberBoot\n"
+    ".type fwiFiberBoot, %function\n"
+    "fwiFiberBoot:\n"
+    "    mov x0, x19\n"
+    "    blr x20\n"
+    "    brk #0\n"
+    ".size fwiFiberBoot, .-fwiFiberBoot\n"
+);
+#else
+#define FWI_FIBER_SUPPORTED 0
+#endif
+
+/**
+ * @brief Saves the callee-saved registers on the current stack, stores the stack pointer in
+ *        save_pp and continues on the stack that was saved in stack_p
+ */
+void fwiFiberSwitch(
+    void** save_pp,
+    void* stack_p
+    );
+
+void fwiFiberBoot(
+    void
+    );
+
+#if !FWI_FIBER_SUPPORTED
+// fwFiberSpawn refuses to run without a context switch, so no fiber ever exists to reach these
+void fwiFiberSwitch([[maybe_unused]] void** save_pp, [[maybe_unused]] void* stack_p) {
+}
+
+void fwiFiberBoot(void) {
+}
+#endif // !FWI_FIBER_SUPPORTED
+
+typedef enum fwiFiberAction : uint8_t {
+    fwiFiberActionYield /*! Queue the fiber again */,
+    fwiFiberActionWait /*! Arm the descriptor the fiber waits for */,
+    fwiFiberActionExit /*! The function returned, release the stack */
+} fwiFiberAction;
+
+/**
+ * @brief Lives at the top of its own stack mapping, so starting a fiber from the pool and parking
+ *        it never allocate
+ */
+struct fwiFiber {
+    void* stack_p; // saved stack pointer of the fiber while it is switched out
+    void* caller_p; // saved stack pointer of the worker that resumed it
+    struct fwiJob job; // resumes the fiber
+    fwJobFunction function;
+    void* user_p;
+    struct fwiJobCounter* counter_p;
+    uint8_t* region_p; // guard page followed by the stack
+    size_t regionSize;
+    struct fwiFiber* nextFree_p;
+    fwiFiberAction action; // what the worker does once the fiber switched back to it
+    fwError waitError;
+    int32_t waitDescriptor;
+    uint32_t waitEvents;
+    uint32_t readyEvents;
+};
+
+struct fwiFiberSystem {
+    pthread_mutex_t mutex; // guards everything but the descriptors, which only change on start
+    struct fwiFiber* free_p;
+    uint32_t freeCount;
+    uint32_t pooledStacks;
+    size_t stackSize;
+
+    // Waiting fibers are armed one shot on this epoll instance, the reactor queues them on events
+    int32_t epollFileDescriptor; // -1 until the first fiber was spawned
+    int32_t wakeFileDescriptor;
+    pthread_t reactor;
+};
+
+static struct fwiFiberSystem fiberSystem_s = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .pooledStacks = FWI_FIBER_POOLED_STACKS,
+    .stackSize = FWI_FIBER_STACK_SIZE,
+    .epollFileDescriptor = -1,
+    .wakeFileDescriptor = -1
+};
+
+static thread_local struct fwiFiber* currentFiber_s = nullptr;
+
+/**
+ * @brief Fibers migrate between threads, so the thread locals of a running function can change
+ *        under it. Reads go through a call the compiler can neither inline nor treat as pure,
+ *        otherwise it may reuse the address or value from before a switch.
+ */
+__attribute__((noinline)) static struct fwiFiber* fwiFiberCurrent(void) {
+    __asm__ volatile("");
+    return currentFiber_s;
+}
+
+static void* fwiFiberReactorMain(void* unused_p) {
+    (void)unused_p;
+    struct epoll_event events[FWI_FIBER_REACTOR_BATCH];
+
+    for (;;) {
+        const int32_t count = epoll_wait(fiberSystem_s.epollFileDescriptor, events,
+                                         FWI_FIBER_REACTOR_BATCH, -1);
+        if (count == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            FWI_LOG_ERRNO;
+            return nullptr;
+        }
+
+        // The whole batch goes into the injection queue with one lock
+        struct fwiJob* first_p = nullptr;
+        struct fwiJob* last_p  = nullptr;
+        uint32_t ready         = 0;
+        bool stop              = false;
+        for (int32_t i = 0; i < count; i++) {
+            struct fwiFiber* fiber_p = events[i].data.ptr;
+            if (fiber_p == nullptr) { // the wake descriptor
+                stop = true;
+                continue;
+            }
+            fiber_p->readyEvents = events[i].events;
+            if (last_p != nullptr) {
+                last_p->next_p = &fiber_p->job;
+            } else {
+                first_p = &fiber_p->job;
+            }
+            last_p = &fiber_p->job;
+            ready++;
+        }
+        if (ready != 0) {
+            fwiJobInject(first_p, last_p, ready);
+            fwiJobWakeWorkers();
+        }
+        if (stop) {
+            return nullptr;
+        }
+    }
+}
+
+static fwError fwiFiberStartReactor(void) {
+    pthread_mutex_lock(&fiberSystem_s.mutex);
+    if (fiberSystem_s.epollFileDescriptor != -1) {
+        pthread_mutex_unlock(&fiberSystem_s.mutex);
+        return fwErrorSuccess;
+    }
+
+    const int32_t epollFileDescriptor = epoll_create1(EPOLL_CLOEXEC);
+    const int32_t wakeFileDescriptor  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    struct epoll_event event = {};
+    event.events   = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (epollFileDescriptor == -1 || wakeFileDescriptor == -1 ||
+        epoll_ctl(epollFileDescriptor, EPOLL_CTL_ADD, wakeFileDescriptor, &event) == -1) {
+        FWI_LOG_ERRNO;
+        if (epollFileDescriptor != -1) {
+            close(epollFileDescriptor);
+        }
+        if (wakeFileDescriptor != -1) {
+            close(wakeFileDescriptor);
+        }
+        pthread_mutex_unlock(&fiberSystem_s.mutex);
+        return fwErrorEventLoop;
+    }
+
+    fiberSystem_s.epollFileDescriptor = epollFileDescriptor;
+    fiberSystem_s.wakeFileDescriptor  = wakeFileDescriptor;
+    if (pthread_create(&fiberSystem_s.reactor, nullptr, fwiFiberReactorMain, nullptr) != 0) {
+        close(epollFileDescriptor);
+        close(wakeFileDescriptor);
+        fiberSystem_s.epollFileDescriptor = -1;
+        fiberSystem_s.wakeFileDescriptor  = -1;
+        pthread_mutex_unlock(&fiberSystem_s.mutex);
+        return fwErrorOutOfMemory;
+    }
+
+    pthread_mutex_unlock(&fiberSystem_s.mutex);
+    return fwErrorSuccess;
+}
+
+// Expects the mutex to be held
+static void fwiFiberTrimPool(const uint32_t keep) {
+    while (fiberSystem_s.freeCount > keep) {
+        struct fwiFiber* fiber_p = fiberSystem_s.free_p;
+        fiberSystem_s.free_p = fiber_p->nextFree_p;
+        fiberSystem_s.freeCount--;
+        munmap(fiber_p->region_p, fiber_p->regionSize);
+    }
+}
+
+static void fwiFiberSystemDestroy(void) {
+    pthread_mutex_lock(&fiberSystem_s.mutex);
+    const bool started = fiberSystem_s.epollFileDescriptor != -1;
+    if (started) {
+        const uint64_t one = 1;
+        write(fiberSystem_s.wakeFileDescriptor, &one, sizeof(one));
+    }
+    pthread_mutex_unlock(&fiberSystem_s.mutex);
+
+    if (started) {
+        pthread_join(fiberSystem_s.reactor, nullptr);
+        close(fiberSystem_s.epollFileDescriptor);
+        close(fiberSystem_s.wakeFileDescriptor);
+    }
+
+    pthread_mutex_lock(&fiberSystem_s.mutex);
+    fiberSystem_s.epollFileDescriptor = -1;
+    fiberSystem_s.wakeFileDescriptor  = -1;
+    fwiFiberTrimPool(0);
+    pthread_mutex_unlock(&fiberSystem_s.mutex);
+}
+
+/**
+ * @brief Takes a stack from the pool or maps a new one with a guard page below it
+ */
+static struct fwiFiber* fwiFiberAllocate(void) {
+    pthread_mutex_lock(&fiberSystem_s.mutex);
+    struct fwiFiber* fiber_p = fiberSystem_s.free_p;
+    if (fiber_p != nullptr) {
+        fiberSystem_s.free_p = fiber_p->nextFree_p;
+        fiberSystem_s.freeCount--;
+        pthread_mutex_unlock(&fiberSystem_s.mutex);
+        return fiber_p;
+    }
+    const size_t stackSize = fiberSystem_s.stackSize;
+    pthread_mutex_unlock(&fiberSystem_s.mutex);
+
+    const size_t pageSize   = sysconf(_SC_PAGESIZE);
+    const size_t regionSize = (stackSize + pageSize - 1) / pageSize * pageSize + pageSize;
+    uint8_t* region_p = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK | MAP_NORESERVE, -1, 0);
+    if (region_p == MAP_FAILED) {
+        FWI_LOG_ERRNO;
+        return nullptr;
+    }
+    if (mprotect(region_p, pageSize, PROT_NONE) == -1) {
+        FWI_LOG_ERRNO;
+        munmap(region_p, regionSize);
+        return nullptr;
+    }
+
+    fiber_p = (struct fwiFiber*)((uintptr_t)(region_p + regionSize - sizeof(struct fwiFiber)) &
+                                 ~(uintptr_t)63);
+    fiber_p->region_p   = region_p;
+    fiber_p->regionSize = regionSize;
+    return fiber_p;
+}
+
+static void fwiFiberRelease(struct fwiFiber* fiber_p) {
+    pthread_mutex_lock(&fiberSystem_s.mutex);
+    fiber_p->nextFree_p  = fiberSystem_s.free_p;
+    fiberSystem_s.free_p = fiber_p;
+    fiberSystem_s.freeCount++;
+    fwiFiberTrimPool(fiberSystem_s.pooledStacks);
+    pthread_mutex_unlock(&fiberSystem_s.mutex);
+}
+
+static void fwiFiberEntry(struct fwiFiber* fiber_p) {
+    fiber_p->function(fiber_p->user_p);
+    fiber_p->action = fwiFiberActionExit;
+    fwiFiberSwitch(&fiber_p->stack_p, fiber_p->caller_p);
+}
+
+/**
+ * @brief Lays out the initial frame that fwiFiberSwitch pops when the fiber runs for the first time
+ */
+static void fwiFiberPrepare(struct fwiFiber* fiber_p) {
+    uintptr_t* frame_p = (uintptr_t*)((uintptr_t)fiber_p & ~(uintptr_t)15);
+#if defined(__x86_64__)
+    // MXCSR and the x87 control word, r15, r14, r13, r12, rbx, rbp and the return address, which
+    // ends up 8 bytes off the 16 byte alignment like after a call
+    frame_p -= 8;
+    memset(frame_p, 0, 8 * sizeof(uintptr_t));
+    frame_p[0] = 0x1F80 | (uintptr_t)0x037F << 32; // the initial state the ABI guarantees
+    frame_p[3] = (uintptr_t)fwiFiberEntry;
+    frame_p[4] = (uintptr_t)fiber_p;
+    frame_p[7] = (uintptr_t)fwiFiberBoot;
+#elif defined(__aarch64__)
+    // x19 to x28, the frame pointer, the link register and d8 to d15
+    frame_p -= 22;
+    memset(frame_p, 0, 22 * sizeof(uintptr_t));
+    frame_p[0]  = (uintptr_t)fiber_p;
+    frame_p[1]  = (uintptr_t)fwiFiberEntry;
+    frame_p[11] = (uintptr_t)fwiFiberBoot;
+#endif
+    fiber_p->stack_p = frame_p;
+}
+
+/**
+ * @brief Arms the descriptor a fiber is waiting for, from then on the reactor may resume the fiber
+ *        on any worker, so it must not be touched afterwards
+ */
+static void fwiFiberArm(struct fwiFiber* fiber_p) {
+    struct epoll_event event = {};
+    event.events   = fiber_p->waitEvents | EPOLLONESHOT;
+    event.data.ptr = fiber_p;
+
+    // The descriptor stays in the set between waits, the one shot disarms it after each event
+    const int32_t epollFileDescriptor = fiberSystem_s.epollFileDescriptor;
+    if (epoll_ctl(epollFileDescriptor, EPOLL_CTL_MOD, fiber_p->waitDescriptor, &event) == 0 ||
+        (errno == ENOENT &&
+         epoll_ctl(epollFileDescriptor, EPOLL_CTL_ADD, fiber_p->waitDescriptor, &event) == 0)) {
+        return;
+    }
+
+    FWI_LOG_ERRNO;
+    fiber_p->waitError = fwErrorEventLoop;
+    fwiJobEnqueue(&fiber_p->job);
+}
+
+/**
+ * @brief Body of the job that resumes a fiber, whatever the fiber asked for when it switched back
+ *        is done here because it was not safe to do while still running on its stack
+ */
+static void fwiFiberRun(void* user_p) {
+    struct fwiFiber* fiber_p = user_p;
+    struct fwiFiber* previous_p = currentFiber_s; // fwJobWait inside of a fiber can nest them
+    currentFiber_s = fiber_p;
+    fwiFiberSwitch(&fiber_p->caller_p, fiber_p->stack_p);
+    currentFiber_s = previous_p;
+
+    switch (fiber_p->action) {
+        case fwiFiberActionYield: {
+            // Behind everything else, the own deque would hand it right back to this worker
+            fwiJobInject(&fiber_p->job, &fiber_p->job, 1);
+            fwiJobWakeWorkers();
+            break;
+        }
+        case fwiFiberActionWait: {
+            fwiFiberArm(fiber_p);
+            break;
+        }
+        case fwiFiberActionExit: {
+            struct fwiJobCounter* counter_p = fiber_p->counter_p;
+            fwiFiberRelease(fiber_p);
+            if (counter_p != nullptr) {
+                fwiJobCounterRelease(counter_p, 1);
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Waits for epoll events on a descriptor, parks the fiber if called from one and blocks in
+ *        poll otherwise, the poll flags have the same values as the epoll ones
+ */
+static fwError fwiFiberWaitDescriptor(const int32_t fileDescriptor, const uint32_t events,
+                                      uint32_t* ready_p) {
+    struct fwiFiber* fiber_p = fwiFiberCurrent();
+    if (fiber_p == nullptr) {
+        struct pollfd pending = {};
+        pending.fd     = fileDescriptor;
+        pending.events = (int16_t)events;
+        while (poll(&pending, 1, -1) == -1) {
+            if (errno != EINTR) {
+                FWI_LOG_ERRNO;
+                return fwErrorEventLoop;
+            }
+        }
+        *ready_p = (uint16_t)pending.revents;
+        return fwErrorSuccess;
+    }
+
+    fiber_p->waitDescriptor = fileDescriptor;
+    fiber_p->waitEvents     = events;
+    fiber_p->waitError      = fwErrorSuccess;
+    fiber_p->action         = fwiFiberActionWait;
+    fwiFiberSwitch(&fiber_p->stack_p, fiber_p->caller_p);
+
+    // Possibly on a different thread now
+    *ready_p = fiber_p->readyEvents;
+    return fiber_p->waitError;
+}
+
+/**
+ * @brief Resolves a socket for the fiber calls, which need it non-blocking and to themselves
+ */
+static struct fwiNativeSocketState* fwiFiberSocket(const fwSocket sfdop) {
+    struct fwiNativeSocketState* nativeSocket = fwiSocketLookup(sfdop);
+    if (nativeSocket == nullptr || nativeSocket->eventSource.loop_p != nullptr) {
+        return nullptr;
+    }
+    if (!nativeSocket->nonBlocking && fwSocketSetNonBlocking(sfdop, true) != fwErrorSuccess) {
+        return nullptr;
+    }
+    return nativeSocket;
+}
+
+static fwError fwiFiberWaitSocket(const fwSocket sfdop, const uint32_t events, uint32_t* ready_p) {
+    const struct fwiNativeSocketState* nativeSocket = fwiFiberSocket(sfdop);
+    if (nativeSocket == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    uint32_t ready = 0;
+    const fwError ret = fwiFiberWaitDescriptor(nativeSocket->fileDescriptor, events, &ready);
+    if (ready_p != nullptr) {
+        *ready_p = ready;
+    }
+    return ret;
+}
+
+fwError fwFiberConfigure(const struct fwFiberConfiguration* configuration_p) {
+    if (configuration_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    pthread_mutex_lock(&fiberSystem_s.mutex);
+    const size_t stackSize = configuration_p->stackSize != 0 ? configuration_p->stackSize :
+                                                               FWI_FIBER_STACK_SIZE;
+    if (stackSize != fiberSystem_s.stackSize) {
+        fwiFiberTrimPool(0); // pooled stacks have the old size
+    }
+    fiberSystem_s.stackSize    = stackSize;
+    fiberSystem_s.pooledStacks = configuration_p->pooledStacks != 0 ?
+                                 configuration_p->pooledStacks : FWI_FIBER_POOLED_STACKS;
+    fwiFiberTrimPool(fiberSystem_s.pooledStacks);
+    pthread_mutex_unlock(&fiberSystem_s.mutex);
+    return fwErrorSuccess;
+}
+
+fwError fwFiberSpawn(const fwJobFunction function, void* user_p, const fwJobCounter counter) {
+    if (!FWI_FIBER_SUPPORTED) {
+        return fwErrorUnimplemented;
+    }
+    if (function == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+    if (jobSystem_s.workers_p == nullptr) {
+        return fwErrorModule;
+    }
+
+    const fwError ret = fwiFiberStartReactor();
+    if (ret != fwErrorSuccess) {
+        return ret;
+    }
+
+    struct fwiFiber* fiber_p = fwiFiberAllocate();
+    if (fiber_p == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+    fiber_p->function     = function;
+    fiber_p->user_p       = user_p;
+    fiber_p->counter_p    = (struct fwiJobCounter*)counter;
+    fiber_p->job.function = fwiFiberRun;
+    fiber_p->job.user_p   = fiber_p;
+    fiber_p->job.batch_p  = nullptr;
+    fiber_p->job.next_p   = nullptr;
+    fwiFiberPrepare(fiber_p);
+
+    if (fiber_p->counter_p != nullptr) {
+        atomic_fetch_add_explicit(&fiber_p->counter_p->value, 1, memory_order_relaxed);
+    }
+    fwiJobEnqueue(&fiber_p->job);
+    return fwErrorSuccess;
+}
+
+fwError fwFiberYield(void) {
+    struct fwiFiber* fiber_p = fwiFiberCurrent();
+    if (fiber_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    fiber_p->action = fwiFiberActionYield;
+    fwiFiberSwitch(&fiber_p->stack_p, fiber_p->caller_p);
+    return fwErrorSuccess;
+}
+
+fwError fwFiberSocketWait(const fwSocket sfdop, const uint8_t interest, uint8_t* ready_p) {
+    uint32_t ready = 0;
+    const fwError ret = fwiFiberWaitSocket(sfdop, fwiEventInterestToEpoll(interest), &ready);
+    if (ready_p != nullptr) {
+        *ready_p = fwiEventEpollToReady(ready);
+    }
+    return ret;
+}
+
+fwError fwFiberSocketSend(const fwSocket sfdop, const void* data, const size_t ammount,
+                          size_t* sent_p) {
+    if (fwiFiberSocket(sfdop) == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    size_t total = 0;
+    fwError ret  = fwErrorSuccess;
+    while (total < ammount) {
+        size_t sent = 0;
+        ret = fwSocketSend(sfdop, (const uint8_t*)data + total, ammount - total, &sent);
+        if (ret == fwErrorSocketWouldBlock) {
+            ret = fwiFiberWaitSocket(sfdop, EPOLLOUT, nullptr);
+            if (ret != fwErrorSuccess) {
+                break;
+            }
+            continue;
+        }
+        if (ret != fwErrorSuccess) {
+            break;
+        }
+        total += sent;
+    }
+
+    if (sent_p != nullptr) {
+        *sent_p = total;
+    }
+    return ret;
+}
+
+fwError fwFiberSocketReceive(const fwSocket sfdop, void* buffer, const size_t ammount,
+                             size_t* received_p) {
+    if (fwiFiberSocket(sfdop) == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    for (;;) {
+        fwError ret = fwSocketReceive(sfdop, buffer, ammount, received_p);
+        if (ret != fwErrorSocketWouldBlock) {
+            return ret;
+        }
+        if ((ret = fwiFiberWaitSocket(sfdop, EPOLLIN, nullptr)) != fwErrorSuccess) {
+            return ret;
+        }
+    }
+}
+
+fwError fwFiberSocketAccept(const fwSocket sfdop, fwSocket* newSocket_p, char* foreignAddress) {
+    if (fwiFiberSocket(sfdop) == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    for (;;) {
+        fwError ret = fwSocketAccept(sfdop, newSocket_p, foreignAddress);
+        if (ret != fwErrorSocketWouldBlock) {
+            return ret;
+        }
+        if ((ret = fwiFiberWaitSocket(sfdop, EPOLLIN, nullptr)) != fwErrorSuccess) {
+            return ret;
+        }
+    }
+}
+
+fwError fwFiberSocketConnect(const fwSocket sfdop, const struct fwSocketAddress* connectInfo_p) {
+    struct fwiNativeSocketState* nativeSocket = fwiFiberSocket(sfdop);
+    if (nativeSocket == nullptr || connectInfo_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+    // Neither datagram nor local connects wait for a handshake
+    if (nativeSocket->protocol != SOCK_STREAM || nativeSocket->addressFamily == AF_LOCAL) {
+        return fwSocketConnect(sfdop, connectInfo_p);
+    }
+
+    struct fwiResolvedAddress addresses[FWI_RESOLVER_ADDRESSES];
+    uint32_t count = 0;
+    const fwError error = fwiResolve(connectInfo_p->target_p, connectInfo_p->port_p, addresses,
+                                     &count);
+    if (error != fwErrorSuccess) {
+        return error;
+    }
+
+    uint32_t i = 0;
+    for (; i < count; i++) {
+        if (addresses[i].family != nativeSocket->addressFamily) {
+            continue;
+        }
+        if (connect(nativeSocket->fileDescriptor, &addresses[i].address,
+                    addresses[i].length) == 0) {
+            break;
+        }
+        if (errno == EINPROGRESS) {
+            uint32_t ready = 0;
+            const fwError ret = fwiFiberWaitDescriptor(nativeSocket->fileDescriptor, EPOLLOUT,
+                                                       &ready);
+            if (ret != fwErrorSuccess) {
+                return ret;
+            }
+            int32_t result = 0;
+            socklen_t length = sizeof(result);
+            getsockopt(nativeSocket->fileDescriptor, SOL_SOCKET, SO_ERROR, &result, &length);
+            if (result == 0) {
+                break;
+            }
+            errno = result;
+        }
+        FWI_LOG_ERRNO;
+    }
+
+    if (i == count) {
+        return fwErrorSocketConnection;
+    }
+
+    nativeSocket->connected = true;
+    nativeSocket->bound = true;
+    strncpy(nativeSocket->targetAddress, connectInfo_p->target_p,
+            FWI_SOCKET_TARGET_ADDRESS_SIZE - 1);
+
+    FWI_LOG_INFO("Socket (ID: %lX) connected to %s", nativeSocket->handle, connectInfo_p->target_p);
+    return fwErrorSuccess;
+}
+
+/**
+ * @brief One of the shared memory buffers of a render surface
+ */
+struct fwiRenderBuffer {
+    struct wl_buffer* buffer_p;
+    uint32_t* pixels_p;
+    struct fwRenderRect stale; // drawn into other buffers since this one was shown last
+    bool busy; // held by the compositor until it releases the buffer
+};
+
+/**
+ * @brief Backing state of an @c fwRenderSurface
+ */
+struct fwiRenderSurface {
+    struct wl_surface* surface_p;
+    struct xdg_surface* xdgSurface_p;
+    struct xdg_toplevel* toplevel_p;
+    struct wl_shm_pool* pool_p;
+    void* memory_p;
+    size_t memorySize;
+    struct fwiRenderBuffer buffers[FWI_RENDER_BUFFERS];
+    struct fwiRenderBuffer* back_p; // buffer the frame is drawn into, nullptr between frames
+    struct fwiRenderBuffer* front_p; // buffer that was presented last
+    struct fwRenderRect damage; // drawn in the current frame
+    uint32_t width, height;
+    fwJobCounter counter; // created the first time an operation is split into bands
+    bool configured;
+};
+
+typedef enum fwiRenderOperation : uint8_t {
+    fwiRenderOperationFill,
+    fwiRenderOperationCopy,
+    fwiRenderOperationBlend
+} fwiRenderOperation;
+
+/**
+ * @brief Rows of one drawing operation, whole operations are split into these for the job system
+ */
+struct fwiRenderBand {
+    const struct fwiRenderKernels* kernels_p;
+    uint32_t* destination_p;
+    const uint32_t* source_p;
+    uint32_t destinationStride, sourceStride; // in pixels
+    uint32_t width, rows;
+    uint32_t color;
+    fwiRenderOperation operation;
+};
+
+static void fwiRenderRunBand(void* user_p) {
+    const struct fwiRenderBand* band_p = user_p;
+    uint32_t* destination_p = band_p->destination_p;
+    const uint32_t* source_p = band_p->source_p;
+    for (uint32_t row = 0; row < band_p->rows; row++) {
+        switch (band_p->operation) {
+            case fwiRenderOperationFill: {
+                band_p->kernels_p->fill(destination_p, band_p->width, band_p->color);
+                break;
+            }
+            case fwiRenderOperationCopy: {
+                band_p->kernels_p->copy(destination_p, source_p, band_p->width);
+                break;
+            }
+            case fwiRenderOperationBlend: {
+                band_p->kernels_p->blend(destination_p, source_p, band_p->width);
+                break;
+            }
+        }
+        destination_p += band_p->destinationStride;
+        source_p += band_p->sourceStride;
+    }
+}
+
+// Runs an operation, large ones are spread over the job system when it is running
+static void fwiRenderRun(struct fwiRenderSurface* nativeSurface,
+                         const struct fwiRenderBand* band_p) {
+    uint32_t workers = 0;
+    uint32_t bandCount = band_p->rows / FWI_RENDER_BAND_ROWS;
+    if ((uint64_t)band_p->width * band_p->rows < FWI_RENDER_PARALLEL_PIXELS || bandCount < 2 ||
+        fwJobGetWorkerCount(&workers) != fwErrorSuccess ||
+        (nativeSurface->counter == 0 && fwJobCounterCreate(&nativeSurface->counter) !=
+                                        fwErrorSuccess)) {
+        fwiRenderRunBand((void*)band_p);
+        return;
+    }
+
+    // A few bands per worker even out rows that cost differently, like a partly opaque image
+    if (bandCount > (workers + 1) * 4) {
+        bandCount = (workers + 1) * 4;
+    }
+    if (bandCount > FWI_RENDER_BANDS_MAX) {
+        bandCount = FWI_RENDER_BANDS_MAX;
+    }
+    struct fwiRenderBand bands[FWI_RENDER_BANDS_MAX];
+    fwJob jobs[FWI_RENDER_BANDS_MAX];
+    const uint32_t rowsPerBand = (band_p->rows + bandCount - 1) / bandCount;
+    uint32_t count = 0;
+    for (uint32_t row = 0; row < band_p->rows; row += rowsPerBand, count++) {
+        bands[count] = *band_p;
+        bands[count].rows = band_p->rows - row < rowsPerBand ? band_p->rows - row : rowsPerBand;
+        bands[count].destination_p += (size_t)row * band_p->destinationStride;
+        if (band_p->source_p != nullptr) {
+            bands[count].source_p += (size_t)row * band_p->sourceStride;
+        }
+        jobs[count] = (fwJob){.function = fwiRenderRunBand, .user_p = &bands[count]};
+    }
+
+    if (fwJobSubmit(jobs, count, nativeSurface->counter) != fwErrorSuccess) {
+        fwiRenderRunBand((void*)band_p);
+        return;
+    }
+    fwJobWait(nativeSurface->counter); // the bands live on this stack
+}
+
+static bool fwiRenderRectEmpty(const struct fwRenderRect* rect_p) {
+    return rect_p->width == 0 || rect_p->height == 0;
+}
+
+static void fwiRenderRectUnite(struct fwRenderRect* rect_p, const struct fwRenderRect* other_p) {
+    if (fwiRenderRectEmpty(other_p)) {
+        return;
+    }
+    if (fwiRenderRectEmpty(rect_p)) {
+        *rect_p = *other_p;
+        return;
+    }
+
+    const int32_t left   = rect_p->x < other_p->x ? rect_p->x : other_p->x;
+    const int32_t top    = rect_p->y < other_p->y ? rect_p->y : other_p->y;
+    const int64_t right  = (int64_t)rect_p->x + rect_p->width;
+    const int64_t bottom = (int64_t)rect_p->y + rect_p->height;
+    const int64_t otherRight  = (int64_t)other_p->x + other_p->width;
+    const int64_t otherBottom = (int64_t)other_p->y + other_p->height;
+    rect_p->x      = left;
+    rect_p->y      = top;
+    rect_p->width  = (uint32_t)((right > otherRight ? right : otherRight) - left);
+    rect_p->height = (uint32_t)((bottom > otherBottom ? bottom : otherBottom) - top);
+}
+
+// Cuts a rectangle down to the surface, false if nothing of it is left
+static bool fwiRenderClip(const struct fwiRenderSurface* nativeSurface,
+                          struct fwRenderRect* rect_p) {
+    const int64_t left   = rect_p->x > 0 ? rect_p->x : 0;
+    const int64_t top    = rect_p->y > 0 ? rect_p->y : 0;
+    int64_t right  = (int64_t)rect_p->x + rect_p->width;
+    int64_t bottom = (int64_t)rect_p->y + rect_p->height;
+    right  = right < nativeSurface->width ? right : nativeSurface->width;
+    bottom = bottom < nativeSurface->height ? bottom : nativeSurface->height;
+    if (right <= left || bottom <= top) {
+        return false;
+    }
+
+    *rect_p = (struct fwRenderRect){
+        .x = (int32_t)left, .y = (int32_t)top,
+        .width = (uint32_t)(right - left), .height = (uint32_t)(bottom - top)
+    };
+    return true;
+}
+
+// Picks a buffer the compositor gave back and brings it up to date with the last frame
+static fwError fwiRenderBegin(struct fwiRenderSurface* nativeSurface) {
+    if (nativeSurface->back_p != nullptr) {
+        return fwErrorSuccess;
+    }
+
+    struct fwiRenderBuffer* back_p = nullptr;
+    for (uint32_t i = 0; i < FWI_RENDER_BUFFERS && back_p == nullptr; i++) {
+        if (!nativeSurface->buffers[i].busy) {
+            back_p = &nativeSurface->buffers[i];
+        }
+    }
+    if (back_p == nullptr) {
+        return fwErrorRenderBusy;
+    }
+
+    // Only what changed since this buffer was shown last is copied, not the whole frame
+    const struct fwRenderRect stale = back_p->stale;
+    if (!fwiRenderRectEmpty(&stale) && nativeSurface->front_p != back_p) {
+        const size_t offset = (size_t)stale.y * nativeSurface->width + stale.x;
+        const struct fwiRenderBand band = {
+            .kernels_p     = fwiGetNativeState()->renderKernels_p,
+            .destination_p = back_p->pixels_p + offset,
+            .source_p      = nativeSurface->front_p->pixels_p + offset,
+            .destinationStride = nativeSurface->width, .sourceStride = nativeSurface->width,
+            .width = stale.width, .rows = stale.height,
+            .operation = fwiRenderOperationCopy
+        };
+        fwiRenderRun(nativeSurface, &band);
+    }
+    back_p->stale = (struct fwRenderRect){};
+    nativeSurface->back_p = back_p;
+    return fwErrorSuccess;
+}
+
+static fwError fwiRenderImage(struct fwiRenderSurface* nativeSurface, const int32_t x,
+                              const int32_t y, const struct fwRenderImage* image_p,
+                              const fwiRenderOperation operation) {
+    if (image_p == nullptr || image_p->pixels_p == nullptr || image_p->stride < image_p->width) {
+        return fwErrorInvalidParameter;
+    }
+
+    struct fwRenderRect rect = {.x = x, .y = y, .width = image_p->width, .height = image_p->height};
+    if (!fwiRenderClip(nativeSurface, &rect)) {
+        return fwErrorSuccess;
+    }
+    const fwError error = fwiRenderBegin(nativeSurface);
+    if (error != fwErrorSuccess) {
+        return error;
+    }
+
+    const struct fwiRenderBand band = {
+        .kernels_p     = fwiGetNativeState()->renderKernels_p,
+        .destination_p = nativeSurface->back_p->pixels_p +
+                         (size_t)rect.y * nativeSurface->width + rect.x,
+        .source_p      = image_p->pixels_p + (size_t)(rect.y - y) * image_p->stride +
+                         (rect.x - x),
+        .destinationStride = nativeSurface->width, .sourceStride = image_p->stride,
+        .width = rect.width, .rows = rect.height,
+        .operation = operation
+    };
+    fwiRenderRun(nativeSurface, &band);
+    fwiRenderRectUnite(&nativeSurface->damage, &rect);
+    return fwErrorSuccess;
+}
+
+static void fwiRenderBufferRelease(void* data_p, [[maybe_unused]] struct wl_buffer* buffer_p) {
+    ((struct fwiRenderBuffer*)data_p)->busy = false;
+}
+
+static const struct wl_buffer_listener fwiRenderBufferListener = {
+    .release = fwiRenderBufferRelease
+};
+
+static void fwiRenderSurfaceConfigure(void* data_p, struct xdg_surface* xdgSurface_p,
+                                      const uint32_t serial) {
+    xdg_surface_ack_configure(xdgSurface_p, serial);
+    ((struct fwiRenderSurface*)data_p)->configured = true;
+}
+
+static const struct xdg_surface_listener fwiRenderSurfaceListener = {
+    .configure = fwiRenderSurfaceConfigure
+};
+
+fwError fwRenderSurfaceCreate(const struct fwRenderSurfaceConfiguration* configuration_p,
+                              fwRenderSurface* surface_p) {
+    if (fwiGetNativeState()->renderKernels_p == nullptr) {
+        return fwErrorModule;
+    }
+    if (configuration_p == nullptr || surface_p == nullptr || configuration_p->width == 0 ||
+        configuration_p->height == 0 || configuration_p->width > FWI_RENDER_MAX_EXTENT ||
+        configuration_p->height > FWI_RENDER_MAX_EXTENT) {
+        return fwErrorInvalidParameter;
+    }
+
+    struct fwiRenderSurface* nativeSurface = calloc(1, sizeof(struct fwiRenderSurface));
+    if (nativeSurface == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+    nativeSurface->width  = configuration_p->width;
+    nativeSurface->height = configuration_p->height;
+
+    const size_t bufferSize = (size_t)nativeSurface->width * nativeSurface->height *
+                              sizeof(uint32_t);
+    nativeSurface->memorySize = bufferSize * FWI_RENDER_BUFFERS;
+    if (nativeSurface->memorySize > INT32_MAX) { // wl_shm addresses the pool with int32_t
+        FWI_LOG_ERROR("Render surface of %ux%u pixels exceeds the shared memory limit",
+                      nativeSurface->width, nativeSurface->height);
+        free(nativeSurface);
+        return fwErrorInvalidParameter;
+    }
+    const int32_t memory = memfd_create("lpaf-render", MFD_CLOEXEC);
+    if (memory == -1 || ftruncate(memory, (off_t)nativeSurface->memorySize) == -1 ||
+        (nativeSurface->memory_p = mmap(nullptr, nativeSurface->memorySize,
+                                        PROT_READ | PROT_WRITE, MAP_SHARED, memory, 0)) ==
+        MAP_FAILED) {
+        FWI_LOG_ERRNO;
+        if (memory != -1) {
+            close(memory);
+        }
+        free(nativeSurface);
+        return fwErrorOutOfMemory;
+    }
+
+    // The pool keeps its own duplicate of the descriptor
+    nativeSurface->pool_p = wl_shm_create_pool(fwiWindowGetShm(), memory,
+                                               (int32_t)nativeSurface->memorySize);
+    close(memory);
+    if (nativeSurface->pool_p == nullptr) {
+        FWI_LOG_ERROR("Compositor did not create the shared memory pool");
+        fwRenderSurfaceDestroy((uintptr_t)nativeSurface);
+        return fwErrorOutOfMemory;
+    }
+    for (uint32_t i = 0; i < FWI_RENDER_BUFFERS; i++) {
+        struct fwiRenderBuffer* buffer_p = &nativeSurface->buffers[i];
+        buffer_p->pixels_p = (uint32_t*)((uint8_t*)nativeSurface->memory_p + i * bufferSize);
+        buffer_p->buffer_p = wl_shm_pool_create_buffer(nativeSurface->pool_p,
+                                                       (int32_t)(i * bufferSize),
+                                                       (int32_t)nativeSurface->width,
+                                                       (int32_t)nativeSurface->height,
+                                                       (int32_t)(nativeSurface->width *
+                                                                 sizeof(uint32_t)),
+                                                       WL_SHM_FORMAT_ARGB8888);
+        if (buffer_p->buffer_p == nullptr) {
+            FWI_LOG_ERROR("Compositor did not create render buffer %u", i);
+            fwRenderSurfaceDestroy((uintptr_t)nativeSurface);
+            return fwErrorOutOfMemory;
+        }
+        wl_buffer_add_listener(buffer_p->buffer_p, &fwiRenderBufferListener, buffer_p);
+    }
+
+    nativeSurface->surface_p    = wl_compositor_create_surface(fwiWindowGetCompositor());
+    nativeSurface->xdgSurface_p = xdg_wm_base_get_xdg_surface(fwiWindowGetWmBase(),
+                                                              nativeSurface->surface_p);
+    xdg_surface_add_listener(nativeSurface->xdgSurface_p, &fwiRenderSurfaceListener,
+                             nativeSurface);
+    nativeSurface->toplevel_p = xdg_surface_get_toplevel(nativeSurface->xdgSurface_p);
+    if (configuration_p->title_p != nullptr) {
+        xdg_toplevel_set_title(nativeSurface->toplevel_p, configuration_p->title_p);
+    }
+    wl_surface_commit(nativeSurface->surface_p);
+
+    // Nothing may be attached before the compositor configured the surface once
+    while (!nativeSurface->configured) {
+        if (wl_display_roundtrip(fwiWindowGetDisplay()) == -1) {
+            FWI_LOG_ERROR("Compositor did not configure the render surface");
+            fwRenderSurfaceDestroy((uintptr_t)nativeSurface);
+            return fwErrorWindowConnect;
+        }
+    }
+
+    fwiGetNativeState()->renderSurfaceCount++;
+    *surface_p = (uintptr_t)nativeSurface;
+    FWI_LOG_INFO("Render surface (ID: %lX) of %ux%u pixels was created", *surface_p,
+                 nativeSurface->width, nativeSurface->height);
+    return fwErrorSuccess;
+}
+
+fwError fwRenderSurfaceDestroy(const fwRenderSurface surface) {
+    struct fwiRenderSurface* nativeSurface = {(struct fwiRenderSurface*)surface};
+
+    if (nativeSurface->configured) {
+        fwiGetNativeState()->renderSurfaceCount--;
+    }
+    // A surface whose creation failed half way is destroyed through here as well
+    if (nativeSurface->toplevel_p != nullptr) {
+        xdg_toplevel_destroy(nativeSurface->toplevel_p);
+    }
+    if (nativeSurface->xdgSurface_p != nullptr) {
+        xdg_surface_destroy(nativeSurface->xdgSurface_p);
+    }
+    if (nativeSurface->surface_p != nullptr) {
+        wl_surface_destroy(nativeSurface->surface_p);
+    }
+    for (uint32_t i = 0; i < FWI_RENDER_BUFFERS; i++) {
+        if (nativeSurface->buffers[i].buffer_p != nullptr) {
+            wl_buffer_destroy(nativeSurface->buffers[i].buffer_p);
+        }
+    }
+    if (nativeSurface->pool_p != nullptr) {
+        wl_shm_pool_destroy(nativeSurface->pool_p);
+    }
+    wl_display_flush(fwiWindowGetDisplay());
+
+    munmap(nativeSurface->memory_p, nativeSurface->memorySize);
+    if (nativeSurface->counter != 0) {
+        fwJobCounterDestroy(nativeSurface->counter);
+    }
+    free(nativeSurface);
+
+    FWI_LOG_INFO("Render surface (ID: %lX) was destroyed", surface);
+    return fwErrorSuccess;
+}
+
+fwError fwRenderFill(const fwRenderSurface surface, const struct fwRenderRect* rect_p,
+                     const uint32_t color) {
+    struct fwiRenderSurface* nativeSurface = {(struct fwiRenderSurface*)surface};
+
+    struct fwRenderRect rect = {.width = nativeSurface->width, .height = nativeSurface->height};
+    if (rect_p != nullptr) {
+        rect = *rect_p;
+    }
+    if (!fwiRenderClip(nativeSurface, &rect)) {
+        return fwErrorSuccess;
+    }
+    const fwError error = fwiRenderBegin(nativeSurface);
+    if (error != fwErrorSuccess) {
+        return error;
+    }
+
+    const struct fwiRenderBand band = {
+        .kernels_p     = fwiGetNativeState()->renderKernels_p,
+        .destination_p = nativeSurface->back_p->pixels_p +
+                         (size_t)rect.y * nativeSurface->width + rect.x,
+        .destinationStride = nativeSurface->width,
+        .width = rect.width, .rows = rect.height,
+        .color = color,
+        .operation = fwiRenderOperationFill
+    };
+    fwiRenderRun(nativeSurface, &band);
+    fwiRenderRectUnite(&nativeSurface->damage, &rect);
+    return fwErrorSuccess;
+}
+
+fwError fwRenderBlit(const fwRenderSurface surface, const int32_t x, const int32_t y,
+                     const struct fwRenderImage* image_p) {
+    return fwiRenderImage((struct fwiRenderSurface*)surface, x, y, image_p,
+                          fwiRenderOperationCopy);
+}
+
+fwError fwRenderBlend(const fwRenderSurface surface, const int32_t x, const int32_t y,
+                      const struct fwRenderImage* image_p) {
+    return fwiRenderImage((struct fwiRenderSurface*)surface, x, y, image_p,
+                          fwiRenderOperationBlend);
+}
+
+fwError fwRenderPresent(const fwRenderSurface surface) {
+    struct fwiRenderSurface* nativeSurface = {(struct fwiRenderSurface*)surface};
+
+    // A frame whose operations were all clipped away keeps its buffer for the next one
+    if (nativeSurface->back_p == nullptr || fwiRenderRectEmpty(&nativeSurface->damage)) {
+        return fwErrorSuccess;
+    }
+
+    const struct fwRenderRect damage = nativeSurface->damage;
+    wl_surface_attach(nativeSurface->surface_p, nativeSurface->back_p->buffer_p, 0, 0);
+    if (wl_surface_get_version(nativeSurface->surface_p) >=
+        WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION) {
+        wl_surface_damage_buffer(nativeSurface->surface_p, damage.x, damage.y,
+                                 (int32_t)damage.width, (int32_t)damage.height);
+    }
+    else {
+        wl_surface_damage(nativeSurface->surface_p, damage.x, damage.y, (int32_t)damage.width,
+                          (int32_t)damage.height);
+    }
+    wl_surface_commit(nativeSurface->surface_p);
+    wl_display_flush(fwiWindowGetDisplay());
+
+    for (uint32_t i = 0; i < FWI_RENDER_BUFFERS; i++) {
+        if (&nativeSurface->buffers[i] != nativeSurface->back_p) {
+            fwiRenderRectUnite(&nativeSurface->buffers[i].stale, &damage);
+        }
+    }
+    nativeSurface->back_p->busy = true;
+    nativeSurface->front_p = nativeSurface->back_p;
+    nativeSurface->back_p  = nullptr;
+    nativeSurface->damage  = (struct fwRenderRect){};
+    return fwErrorSuccess;
+}
+
+/**
+ * @brief Backing state of an @c fwAudioStream. The ring is single producer single consumer, one
+ *        side is the audio thread and the other the application, positions count frames.
+ */
+struct fwiAudioStream {
+    alignas(64) _Atomic uint64_t head; // only stored by the producer
+    alignas(64) _Atomic uint64_t tail; // only stored by the consumer
+    alignas(64) _Atomic uint64_t frames;
+    _Atomic uint64_t xruns;
+    _Atomic uint64_t starved;
+    atomic_bool running;
+    atomic_bool failed;
+    atomic_bool primed; // playback: the application wrote at least once
+    int16_t* ring_p;
+    int16_t* period_p;
+    size_t ringSize, periodSize; // in bytes
+    snd_pcm_t* pcm_p;
+    pthread_t thread;
+    fwAudioCallback callback;
+    void* user_p;
+    uint32_t ringFrames; // power of two
+    uint32_t sampleRate, periodFrames, periods;
+    uint16_t channels;
+    fwAudioDirection direction;
+};
+
+// Copies frames into or out of the ring, split in two where it wraps
+static void fwiAudioRingCopy(const struct fwiAudioStream* nativeStream, const uint64_t position,
+                             int16_t* samples_p, const uint32_t frames, const bool into) {
+    const uint32_t offset = (uint32_t)(position & (nativeStream->ringFrames - 1));
+    const uint32_t first  = frames < nativeStream->ringFrames - offset ?
+                            frames : nativeStream->ringFrames - offset;
+    const size_t frameSize = nativeStream->channels * sizeof(int16_t);
+    int16_t* ring_p = nativeStream->ring_p + (size_t)offset * nativeStream->channels;
+    if (into) {
+        memcpy(ring_p, samples_p, first * frameSize);
+        memcpy(nativeStream->ring_p, samples_p + (size_t)first * nativeStream->channels,
+               (frames - first) * frameSize);
+    }
+    else {
+        memcpy(samples_p, ring_p, first * frameSize);
+        memcpy(samples_p + (size_t)first * nativeStream->channels, nativeStream->ring_p,
+               (frames - first) * frameSize);
+    }
+}
+
+// Producer side, returns the frames that fit
+static uint32_t fwiAudioRingPush(struct fwiAudioStream* nativeStream, const int16_t* samples_p,
+                                 uint32_t frames) {
+    const uint64_t head = atomic_load_explicit(&nativeStream->head, memory_order_relaxed);
+    const uint64_t tail = atomic_load_explicit(&nativeStream->tail, memory_order_acquire);
+    const uint64_t room = nativeStream->ringFrames - (head - tail);
+    frames = frames < room ? frames : (uint32_t)room;
+    fwiAudioRingCopy(nativeStream, head, (int16_t*)samples_p, frames, true);
+    atomic_store_explicit(&nativeStream->head, head + frames, memory_order_release);
+    return frames;
+}
+
+// Consumer side, returns the frames that were available
+static uint32_t fwiAudioRingPop(struct fwiAudioStream* nativeStream, int16_t* samples_p,
+                                uint32_t frames) {
+    const uint64_t tail = atomic_load_explicit(&nativeStream->tail, memory_order_relaxed);
+    const uint64_t head = atomic_load_explicit(&nativeStream->head, memory_order_acquire);
+    frames = frames < head - tail ? frames : (uint32_t)(head - tail);
+    fwiAudioRingCopy(nativeStream, tail, samples_p, frames, false);
+    atomic_store_explicit(&nativeStream->tail, tail + frames, memory_order_release);
+    return frames;
+}
+
+// Handles a failed transfer, false if the device cannot be brought back
+static bool fwiAudioRecover(struct fwiAudioStream* nativeStream, const snd_pcm_sframes_t error) {
+    if (error == -EINTR) {
+        return true;
+    }
+    // Quietly, printing from this thread would cost more than the period it is late by already
+    if (snd_pcm_recover(nativeStream->pcm_p, (int32_t)error, 1) < 0) {
+        atomic_store_explicit(&nativeStream->failed, true, memory_order_relaxed);
+        return false;
+    }
+    if (error == -EPIPE || error == -ESTRPIPE) {
+        atomic_fetch_add_explicit(&nativeStream->xruns, 1, memory_order_relaxed);
+    }
+    if (nativeStream->direction == fwAudioDirectionCapture) {
+        snd_pcm_start(nativeStream->pcm_p);
+    }
+    return true;
+}
+
+/**
+ * @brief The audio thread, moves one period at a time between the ring or the callback and the
+ *        device. Every buffer it touches was allocated and locked before it started.
+ */
+static void* fwiAudioThreadMain(void* argument_p) {
+    struct fwiAudioStream* nativeStream = argument_p;
+    const bool playback = nativeStream->direction == fwAudioDirectionPlayback;
+    const size_t frameSize = nativeStream->channels * sizeof(int16_t);
+
+    while (atomic_load_explicit(&nativeStream->running, memory_order_relaxed)) {
+        if (playback) {
+            if (nativeStream->callback != nullptr) {
+                nativeStream->callback(nativeStream->period_p, nativeStream->periodFrames,
+                                       nativeStream->user_p);
+            }
+            else {
+                const uint32_t popped = fwiAudioRingPop(nativeStream, nativeStream->period_p,
+                                                        nativeStream->periodFrames);
+                if (popped < nativeStream->periodFrames) {
+                    memset((uint8_t*)nativeStream->period_p + popped * frameSize, 0,
+                           (nativeStream->periodFrames - popped) * frameSize);
+                    if (atomic_load_explicit(&nativeStream->primed, memory_order_relaxed)) {
+                        atomic_fetch_add_explicit(&nativeStream->starved, 1,
+                                                  memory_order_relaxed);
+                    }
+                }
+            }
+        }
+
+        uint32_t done = 0;
+        while (done < nativeStream->periodFrames &&
+               atomic_load_explicit(&nativeStream->running, memory_order_relaxed)) {
+            int16_t* samples_p = nativeStream->period_p + (size_t)done * nativeStream->channels;
+            const snd_pcm_sframes_t transferred = playback ?
+                snd_pcm_writei(nativeStream->pcm_p, samples_p, nativeStream->periodFrames - done) :
+                snd_pcm_readi(nativeStream->pcm_p, samples_p, nativeStream->periodFrames - done);
+            if (transferred < 0) {
+                if (!fwiAudioRecover(nativeStream, transferred)) {
+                    return nullptr;
+                }
+                continue;
+            }
+            done += (uint32_t)transferred;
+        }
+        atomic_fetch_add_explicit(&nativeStream->frames, done, memory_order_relaxed);
+
+        if (!playback) {
+            if (nativeStream->callback != nullptr) {
+                nativeStream->callback(nativeStream->period_p, done, nativeStream->user_p);
+            }
+            else if (fwiAudioRingPush(nativeStream, nativeStream->period_p, done) < done) {
+                atomic_fetch_add_explicit(&nativeStream->starved, 1, memory_order_relaxed);
+            }
+        }
+    }
+    return nullptr;
+}
+
+// Negotiates format, rate and buffering, the device may settle on other values than requested
+static fwError fwiAudioConfigureDevice(struct fwiAudioStream* nativeStream) {
+    snd_pcm_hw_params_t* hardware_p = nullptr;
+    snd_pcm_sw_params_t* software_p = nullptr;
+    snd_pcm_hw_params_alloca(&hardware_p);
+    snd_pcm_sw_params_alloca(&software_p);
+
+    snd_pcm_uframes_t periodFrames = nativeStream->periodFrames;
+    uint32_t sampleRate = nativeStream->sampleRate;
+    uint32_t periods = nativeStream->periods;
+    int32_t direction = 0;
+    int32_t error;
+    if ((error = snd_pcm_hw_params_any(nativeStream->pcm_p, hardware_p)) < 0 ||
+        (error = snd_pcm_hw_params_set_access(nativeStream->pcm_p, hardware_p,
+                                              SND_PCM_ACCESS_RW_INTERLEAVED)) < 0 ||
+        (error = snd_pcm_hw_params_set_format(nativeStream->pcm_p, hardware_p,
+                                              SND_PCM_FORMAT_S16)) < 0 ||
+        (error = snd_pcm_hw_params_set_channels(nativeStream->pcm_p, hardware_p,
+                                                nativeStream->channels)) < 0 ||
+        (error = snd_pcm_hw_params_set_rate_near(nativeStream->pcm_p, hardware_p, &sampleRate,
+                                                 &direction)) < 0 ||
+        (error = snd_pcm_hw_params_set_period_size_near(nativeStream->pcm_p, hardware_p,
+                                                        &periodFrames, &direction)) < 0 ||
+        (error = snd_pcm_hw_params_set_periods_near(nativeStream->pcm_p, hardware_p, &periods,
+                                                    &direction)) < 0 ||
+        (error = snd_pcm_hw_params(nativeStream->pcm_p, hardware_p)) < 0) {
+        FWI_LOG_ERROR("Audio device does not support the stream: %s", snd_strerror(error));
+        return fwErrorAudioDevice;
+    }
+    snd_pcm_hw_params_get_period_size(hardware_p, &periodFrames, &direction);
+    snd_pcm_hw_params_get_periods(hardware_p, &periods, &direction);
+    snd_pcm_hw_params_get_rate(hardware_p, &sampleRate, &direction);
+
+    // Playback starts once one period is queued and the thread wakes for every period
+    if ((error = snd_pcm_sw_params_current(nativeStream->pcm_p, software_p)) < 0 ||
+        (error = snd_pcm_sw_params_set_start_threshold(nativeStream->pcm_p, software_p,
+                                                       periodFrames)) < 0 ||
+        (error = snd_pcm_sw_params_set_avail_min(nativeStream->pcm_p, software_p,
+                                                 periodFrames)) < 0 ||
+        (error = snd_pcm_sw_params(nativeStream->pcm_p, software_p)) < 0) {
+        FWI_LOG_ERROR("Audio device refused the start conditions: %s", snd_strerror(error));
+        return fwErrorAudioDevice;
+    }
+
+    nativeStream->periodFrames = (uint32_t)periodFrames;
+    nativeStream->periods      = periods;
+    nativeStream->sampleRate   = sampleRate;
+    return fwErrorSuccess;
+}
+
+static void fwiAudioStreamFree(struct fwiAudioStream* nativeStream) {
+    if (nativeStream->pcm_p != nullptr) {
+        snd_pcm_close(nativeStream->pcm_p);
+    }
+    if (nativeStream->ring_p != nullptr) {
+        munlock(nativeStream->ring_p, nativeStream->ringSize);
+        free(nativeStream->ring_p);
+    }
+    if (nativeStream->period_p != nullptr) {
+        munlock(nativeStream->period_p, nativeStream->periodSize);
+        free(nativeStream->period_p);
+    }
+    free(nativeStream);
+}
+
+fwError fwAudioStreamCreate(const struct fwAudioConfiguration* configuration_p,
+                            fwAudioStream* stream_p) {
+    if (!fwiGetNativeState()->multimediaRunning) {
+        return fwErrorModule;
+    }
+    if (configuration_p == nullptr || stream_p == nullptr ||
+        configuration_p->ringFrames > FWI_AUDIO_MAX_RING_FRAMES) {
+        return fwErrorInvalidParameter;
+    }
+
+    struct fwiAudioStream* nativeStream = aligned_alloc(64, sizeof(struct fwiAudioStream));
+    if (nativeStream == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+    memset(nativeStream, 0, sizeof(struct fwiAudioStream));
+    nativeStream->direction    = configuration_p->direction;
+    nativeStream->callback     = configuration_p->callback;
+    nativeStream->user_p       = configuration_p->user_p;
+    nativeStream->sampleRate   = configuration_p->sampleRate != 0 ? configuration_p->sampleRate :
+                                                                    FWI_AUDIO_SAMPLE_RATE;
+    nativeStream->channels     = configuration_p->channels != 0 ? configuration_p->channels :
+                                                                  FWI_AUDIO_CHANNELS;
+    nativeStream->periodFrames = configuration_p->periodFrames != 0 ?
+                                 configuration_p->periodFrames : FWI_AUDIO_PERIOD_FRAMES;
+    nativeStream->periods      = configuration_p->periods != 0 ? configuration_p->periods :
+                                                                 FWI_AUDIO_PERIODS;
+
+    const char* device_p = configuration_p->device_p != nullptr ? configuration_p->device_p :
+                                                                  "default";
+    int32_t error = snd_pcm_open(&nativeStream->pcm_p, device_p,
+                                 nativeStream->direction == fwAudioDirectionPlayback ?
+                                 SND_PCM_STREAM_PLAYBACK : SND_PCM_STREAM_CAPTURE, 0);
+    if (error < 0) {
+        FWI_LOG_ERROR("Audio device %s could not be opened: %s", device_p, snd_strerror(error));
+        nativeStream->pcm_p = nullptr;
+        fwiAudioStreamFree(nativeStream);
+        return fwErrorAudioDevice;
+    }
+    fwError ret = fwiAudioConfigureDevice(nativeStream);
+    if (ret != fwErrorSuccess) {
+        fwiAudioStreamFree(nativeStream);
+        return ret;
+    }
+
+    // The ring only holds whole periods of the negotiated size
+    uint32_t ringFrames = configuration_p->ringFrames != 0 ? configuration_p->ringFrames :
+                          nativeStream->periodFrames * FWI_AUDIO_RING_PERIODS;
+    ringFrames = ringFrames > nativeStream->periodFrames ? ringFrames :
+                                                           nativeStream->periodFrames;
+    nativeStream->ringFrames = 1;
+    while (nativeStream->ringFrames < ringFrames) {
+        nativeStream->ringFrames <<= 1;
+    }
+
+    // Written through once and locked, so the audio thread never takes a page fault on them
+    const size_t frameSize = nativeStream->channels * sizeof(int16_t);
+    nativeStream->ringSize   = (size_t)nativeStream->ringFrames * frameSize;
+    nativeStream->periodSize = (size_t)nativeStream->periodFrames * frameSize;
+    nativeStream->ring_p     = malloc(nativeStream->ringSize);
+    nativeStream->period_p   = malloc(nativeStream->periodSize);
+    if (nativeStream->ring_p == nullptr || nativeStream->period_p == nullptr) {
+        fwiAudioStreamFree(nativeStream);
+        return fwErrorOutOfMemory;
+    }
+    memset(nativeStream->ring_p, 0, nativeStream->ringSize);
+    memset(nativeStream->period_p, 0, nativeStream->periodSize);
+    if (mlock(nativeStream->ring_p, nativeStream->ringSize) != 0 ||
+        mlock(nativeStream->period_p, nativeStream->periodSize) != 0) {
+        FWI_LOG_WARNING("Audio buffers could not be locked into memory");
+    }
+
+    if (nativeStream->direction == fwAudioDirectionCapture) {
+        snd_pcm_start(nativeStream->pcm_p);
+    }
+    atomic_store(&nativeStream->running, true);
+
+    // Real-time scheduling needs a privilege or an RLIMIT_RTPRIO, without it the stream still
+    // works but is preempted like any other thread
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setinheritsched(&attributes, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attributes, SCHED_FIFO);
+    const struct sched_param parameters = {.sched_priority = FWI_AUDIO_PRIORITY};
+    pthread_attr_setschedparam(&attributes, &parameters);
+    error = pthread_create(&nativeStream->thread, &attributes, fwiAudioThreadMain, nativeStream);
+    pthread_attr_destroy(&attributes);
+    if (error == EPERM) {
+        FWI_LOG_WARNING("Audio thread runs without real-time priority");
+        error = pthread_create(&nativeStream->thread, nullptr, fwiAudioThreadMain, nativeStream);
+    }
+    if (error != 0) {
+        errno = error;
+        FWI_LOG_ERRNO;
+        fwiAudioStreamFree(nativeStream);
+        return fwErrorOutOfMemory;
+    }
+
+    fwiGetNativeState()->audioStreamCount++;
+    *stream_p = (uintptr_t)nativeStream;
+    FWI_LOG_INFO("Audio stream (ID: %lX) on %s runs at %u Hz with %u periods of %u frames",
+                 *stream_p, device_p, nativeStream->sampleRate, nativeStream->periods,
+                 nativeStream->periodFrames);
+    return fwErrorSuccess;
+}
+
+fwError fwAudioStreamDestroy(const fwAudioStream stream) {
+    struct fwiAudioStream* nativeStream = {(struct fwiAudioStream*)stream};
+
+    // Transfers block for at most a period, dropping the device makes a pending one return now
+    atomic_store(&nativeStream->running, false);
+    snd_pcm_drop(nativeStream->pcm_p);
+    pthread_join(nativeStream->thread, nullptr);
+
+    const uint64_t xruns = atomic_load(&nativeStream->xruns);
+    if (xruns != 0 || atomic_load(&nativeStream->starved) != 0) {
+        FWI_LOG_WARNING("Audio stream (ID: %lX) had %lu xruns and %lu starved periods", stream,
+                        xruns, atomic_load(&nativeStream->starved));
+    }
+    fwiGetNativeState()->audioStreamCount--;
+    fwiAudioStreamFree(nativeStream);
+
+    FWI_LOG_INFO("Audio stream (ID: %lX) was destroyed", stream);
+    return fwErrorSuccess;
+}
+
+fwError fwAudioStreamWrite(const fwAudioStream stream, const int16_t* samples_p,
+                           const uint32_t frames, uint32_t* written_p) {
+    struct fwiAudioStream* nativeStream = {(struct fwiAudioStream*)stream};
+    if (nativeStream->direction != fwAudioDirectionPlayback || nativeStream->callback != nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    const uint32_t written = fwiAudioRingPush(nativeStream, samples_p, frames);
+    if (written != 0) {
+        atomic_store_explicit(&nativeStream->primed, true, memory_order_relaxed);
+    }
+    if (written_p != nullptr) {
+        *written_p = written;
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwAudioStreamRead(const fwAudioStream stream, int16_t* samples_p, const uint32_t frames,
+                          uint32_t* read_p) {
+    struct fwiAudioStream* nativeStream = {(struct fwiAudioStream*)stream};
+    if (nativeStream->direction != fwAudioDirectionCapture || nativeStream->callback != nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    const uint32_t read = fwiAudioRingPop(nativeStream, samples_p, frames);
+    if (read_p != nullptr) {
+        *read_p = read;
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwAudioStreamGetStats(const fwAudioStream stream, struct fwAudioStats* stats_p) {
+    const struct fwiAudioStream* nativeStream = {(const struct fwiAudioStream*)stream};
+
+    stats_p->frames       = atomic_load_explicit(&nativeStream->frames, memory_order_relaxed);
+    stats_p->xruns        = atomic_load_explicit(&nativeStream->xruns, memory_order_relaxed);
+    stats_p->starved      = atomic_load_explicit(&nativeStream->starved, memory_order_relaxed);
+    stats_p->sampleRate   = nativeStream->sampleRate;
+    stats_p->periodFrames = nativeStream->periodFrames;
+    stats_p->periods      = nativeStream->periods;
+
+    if (atomic_load_explicit(&nativeStream->failed, memory_order_relaxed)) {
+        return fwErrorAudioDevice;
+    }
+    return fwErrorSuccess;
+}
+
+/**
+ * @brief The contents of one file, linked into a bucket while cached and into the eviction order
+ *        while nobody holds it
+ */
+struct fwiFileCacheEntry {
+    struct fwiFileCacheEntry* next_p; // next in the bucket
+    struct fwiFileCacheEntry* older_p;
+    struct fwiFileCacheEntry* newer_p;
+    const void* data_p;
+    uint64_t size;
+    uint64_t hash;
+    struct stat stats; // the file at the time it was loaded, compared against for unwatched files
+    int64_t checked;   // monotonic milliseconds of the last comparison
+    uint32_t references;
+    int32_t watch;     // -1 if the file is checked with stat
+    bool mapped;
+    bool cached;       // false once dropped, the last release frees the entry then
+    char path[];
+};
+
+/**
+ * @brief An inotify watch, hard links and repeated names of a file share one and it is only
+ *        removed with the last entry
+ */
+struct fwiFileCacheWatch {
+    struct fwiFileCacheWatch* next_p; // next in the bucket
+    int32_t watch;
+    uint32_t entries;
+};
+
+struct fwiFileCache {
+    struct fwFileCacheConfiguration configuration;
+    pthread_mutex_t mutex;
+    struct fwiFileCacheEntry** buckets_p;
+    struct fwiFileCacheWatch** watches_p; // hashed by descriptor, as many buckets as the entries
+    uint32_t bucketCount;
+    int32_t inotify;  // -1 if inotify is unavailable, every file is checked with stat then
+    int64_t drained;  // monotonic milliseconds the watch events were last read
+    struct fwiFileCacheEntry* oldest_p; // entries nobody holds, evicted from the oldest on
+    struct fwiFileCacheEntry* newest_p;
+    uint32_t held;    // acquisitions that were not released yet, dropped entries included
+    struct fwFileCacheStats stats;
+};
+
+static uint64_t fwiFileCacheHash(const char* path_p) {
+    uint64_t hash = 14695981039346656037ull; // FNV-1a
+    for (; *path_p != '\0'; path_p++) {
+        hash = (hash ^ (uint8_t)*path_p) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static void fwiFileCacheFree(struct fwiFileCacheEntry* entry_p) {
+    if (entry_p->mapped) {
+        fwUnmapFile(entry_p->data_p, entry_p->size);
+    }
+    else {
+        free((void*)entry_p->data_p);
+    }
+    free(entry_p);
+}
+
+static void fwiFileCacheLinkIdle(struct fwiFileCache* nativeCache,
+                                 struct fwiFileCacheEntry* entry_p) {
+    entry_p->older_p = nativeCache->newest_p;
+    entry_p->newer_p = nullptr;
+    if (nativeCache->newest_p != nullptr) {
+        nativeCache->newest_p->newer_p = entry_p;
+    }
+    else {
+        nativeCache->oldest_p = entry_p;
+    }
+    nativeCache->newest_p = entry_p;
+}
+
+static void fwiFileCacheUnlinkIdle(struct fwiFileCache* nativeCache,
+                                   struct fwiFileCacheEntry* entry_p) {
+    if (entry_p->older_p != nullptr) {
+        entry_p->older_p->newer_p = entry_p->newer_p;
+    }
+    else {
+        nativeCache->oldest_p = entry_p->newer_p;
+    }
+    if (entry_p->newer_p != nullptr) {
+        entry_p->newer_p->older_p = entry_p->older_p;
+    }
+    else {
+        nativeCache->newest_p = entry_p->older_p;
+    }
+}
+
+static struct fwiFileCacheWatch** fwiFileCacheFindWatch(const struct fwiFileCache* nativeCache,
+                                                        const int32_t watch) {
+    struct fwiFileCacheWatch** link_pp =
+        &nativeCache->watches_p[(uint32_t)watch % nativeCache->bucketCount];
+    while (*link_pp != nullptr && (*link_pp)->watch != watch) {
+        link_pp = &(*link_pp)->next_p;
+    }
+    return link_pp;
+}
+
+/**
+ * @brief Counts one more entry on a watch, false if it could not be recorded and was removed
+ */
+static bool fwiFileCacheRetainWatch(struct fwiFileCache* nativeCache, const int32_t watch) {
+    struct fwiFileCacheWatch** link_pp = fwiFileCacheFindWatch(nativeCache, watch);
+    if (*link_pp == nullptr) {
+        // No other entry has the watch, so nobody else loses it
+        if ((*link_pp = calloc(1, sizeof(struct fwiFileCacheWatch))) == nullptr) {
+            inotify_rm_watch(nativeCache->inotify, watch);
+            return false;
+        }
+        (*link_pp)->watch = watch;
+    }
+    (*link_pp)->entries++;
+    return true;
+}
+
+static void fwiFileCacheUnwatch(struct fwiFileCache* nativeCache, const int32_t watch) {
+    if (watch == -1) {
+        return;
+    }
+    struct fwiFileCacheWatch** link_pp = fwiFileCacheFindWatch(nativeCache, watch);
+    struct fwiFileCacheWatch* watch_p = *link_pp;
+    if (--watch_p->entries == 0) {
+        *link_pp = watch_p->next_p;
+        free(watch_p);
+        inotify_rm_watch(nativeCache->inotify, watch);
+    }
+}
+
+/**
+ * @brief Unlinks an entry from its bucket, held entries live on until their last release
+ */
+static void fwiFileCacheDrop(struct fwiFileCache* nativeCache,
+                             struct fwiFileCacheEntry** link_pp, const bool changed) {
+    struct fwiFileCacheEntry* entry_p = *link_pp;
+    *link_pp = entry_p->next_p;
+    entry_p->cached = false;
+    nativeCache->stats.entries--;
+    nativeCache->stats.bytes -= entry_p->size;
+    if (changed) {
+        nativeCache->stats.invalidations++;
+    }
+    else {
+        nativeCache->stats.evictions++;
+    }
+
+    fwiFileCacheUnwatch(nativeCache, entry_p->watch);
+    if (entry_p->references == 0) {
+        fwiFileCacheUnlinkIdle(nativeCache, entry_p);
+        fwiFileCacheFree(entry_p);
+    }
+}
+
+static void fwiFileCacheEvict(struct fwiFileCache* nativeCache) {
+    while (nativeCache->stats.bytes > nativeCache->configuration.budget &&
+           nativeCache->oldest_p != nullptr) {
+        const struct fwiFileCacheEntry* victim_p = nativeCache->oldest_p;
+        struct fwiFileCacheEntry** link_pp =
+            &nativeCache->buckets_p[victim_p->hash % nativeCache->bucketCount];
+        while (*link_pp != victim_p) {
+            link_pp = &(*link_pp)->next_p;
+        }
+        fwiFileCacheDrop(nativeCache, link_pp, false);
+    }
+}
+
+// A watch of -1 drops every watched entry, after the kernel lost events
+static void fwiFileCacheDropWatched(struct fwiFileCache* nativeCache, const int32_t watch) {
+    for (uint32_t i = 0; i < nativeCache->bucketCount; i++) {
+        struct fwiFileCacheEntry** link_pp = &nativeCache->buckets_p[i];
+        while (*link_pp != nullptr) {
+            const int32_t entryWatch = (*link_pp)->watch;
+            if (entryWatch != -1 && (watch == -1 || entryWatch == watch)) {
+                fwiFileCacheDrop(nativeCache, link_pp, true);
+            }
+            else {
+                link_pp = &(*link_pp)->next_p;
+            }
+        }
+    }
+}
+
+static void fwiFileCacheDrain(struct fwiFileCache* nativeCache) {
+    alignas(struct inotify_event) uint8_t events[4096];
+    ssize_t received = 0;
+    while ((received = read(nativeCache->inotify, events, sizeof(events))) > 0) {
+        for (ssize_t offset = 0; offset < received;) {
+            const struct inotify_event* event_p = (const struct inotify_event*)(events + offset);
+            fwiFileCacheDropWatched(nativeCache, event_p->mask & IN_Q_OVERFLOW ? -1 : event_p->wd);
+            offset += sizeof(struct inotify_event) + event_p->len;
+        }
+    }
+}
+
+static bool fwiFileCacheUnchanged(const struct stat* before_p, const struct stat* now_p) {
+    return before_p->st_ino == now_p->st_ino && before_p->st_dev == now_p->st_dev &&
+           before_p->st_size == now_p->st_size &&
+           before_p->st_mtim.tv_sec == now_p->st_mtim.tv_sec &&
+           before_p->st_mtim.tv_nsec == now_p->st_mtim.tv_nsec &&
+           before_p->st_ctim.tv_sec == now_p->st_ctim.tv_sec &&
+           before_p->st_ctim.tv_nsec == now_p->st_ctim.tv_nsec;
+}
+
+static void fwiFileCacheGrow(struct fwiFileCache* nativeCache) {
+    const uint32_t bucketCount = nativeCache->bucketCount * 2;
+    struct fwiFileCacheEntry** buckets_p = calloc(bucketCount, sizeof(struct fwiFileCacheEntry*));
+    struct fwiFileCacheWatch** watches_p = calloc(bucketCount, sizeof(struct fwiFileCacheWatch*));
+    if (buckets_p == nullptr || watches_p == nullptr) {
+        free(buckets_p);
+        free(watches_p);
+        return; // longer chains are still correct
+    }
+    for (uint32_t i = 0; i < nativeCache->bucketCount; i++) {
+        struct fwiFileCacheWatch* watch_p = nativeCache->watches_p[i];
+        while (watch_p != nullptr) {
+            struct fwiFileCacheWatch* next_p = watch_p->next_p;
+            watch_p->next_p = watches_p[(uint32_t)watch_p->watch % bucketCount];
+            watches_p[(uint32_t)watch_p->watch % bucketCount] = watch_p;
+            watch_p = next_p;
+        }
+    }
+    for (uint32_t i = 0; i < nativeCache->bucketCount; i++) {
+        struct fwiFileCacheEntry* entry_p = nativeCache->buckets_p[i];
+        while (entry_p != nullptr) {
+            struct fwiFileCacheEntry* next_p = entry_p->next_p;
+            entry_p->next_p = buckets_p[entry_p->hash % bucketCount];
+            buckets_p[entry_p->hash % bucketCount] = entry_p;
+            entry_p = next_p;
+        }
+    }
+    free(nativeCache->buckets_p);
+    free(nativeCache->watches_p);
+    nativeCache->buckets_p = buckets_p;
+    nativeCache->watches_p = watches_p;
+    nativeCache->bucketCount = bucketCount;
+}
+
+/**
+ * @brief Reads a file that is not cached, the watch is placed before reading so that no change
+ *        after the read can go unnoticed
+ */
+static fwError fwiFileCacheLoad(struct fwiFileCache* nativeCache, const char* filename_p,
+                                const uint64_t hash, const int64_t now,
+                                struct fwiFileCacheEntry** entry_pp) {
+    int32_t watch = -1;
+    if (nativeCache->inotify != -1) {
+        watch = inotify_add_watch(nativeCache->inotify, filename_p, FWI_FILE_CACHE_WATCH_MASK);
+        if (watch != -1 && !fwiFileCacheRetainWatch(nativeCache, watch)) {
+            watch = -1; // checked with stat instead
+        }
+    }
+
+    fwError error = fwErrorSuccess;
+    struct stat fileStats;
+    const size_t length = strlen(filename_p) + 1;
+    struct fwiFileCacheEntry* entry_p = nullptr;
+    if (stat(filename_p, &fileStats) != 0 || !S_ISREG(fileStats.st_mode)) {
+        error = fwErrorFileUnableToOpen;
+    }
+    else if ((entry_p = calloc(1, sizeof(struct fwiFileCacheEntry) + length)) == nullptr) {
+        error = fwErrorOutOfMemory;
+    }
+    else if (fileStats.st_size > 0) {
+        const uint64_t threshold = nativeCache->configuration.mapThreshold;
+        entry_p->mapped = threshold != 0 && (uint64_t)fileStats.st_size >= threshold;
+        error = entry_p->mapped ?
+            fwMapFile(filename_p, fwFileMapHintNone, &entry_p->data_p, &entry_p->size) :
+            fwLoadFileToMem(filename_p, (void**)&entry_p->data_p, &entry_p->size);
+    }
+    if (error != fwErrorSuccess) {
+        free(entry_p);
+        fwiFileCacheUnwatch(nativeCache, watch);
+        return error;
+    }
+    if (entry_p->size == 0 && !entry_p->mapped) { // also if the file was emptied since the stat
+        free((void*)entry_p->data_p);
+        entry_p->data_p = nullptr;
+    }
+
+    entry_p->hash       = hash;
+    entry_p->stats      = fileStats;
+    entry_p->checked    = now;
+    entry_p->references = 1;
+    entry_p->watch      = watch;
+    entry_p->cached     = true;
+    memcpy(entry_p->path, filename_p, length);
+    *entry_pp = entry_p;
+    return fwErrorSuccess;
+}
+
+fwError fwFileCacheCreate(const struct fwFileCacheConfiguration* configuration_p,
+                          fwFileCache* cache_p) {
+    if (configuration_p == nullptr || cache_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    struct fwiFileCache* nativeCache = calloc(1, sizeof(struct fwiFileCache));
+    if (nativeCache == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+    nativeCache->bucketCount = FWI_FILE_CACHE_BUCKETS;
+    nativeCache->buckets_p = calloc(FWI_FILE_CACHE_BUCKETS, sizeof(struct fwiFileCacheEntry*));
+    nativeCache->watches_p = calloc(FWI_FILE_CACHE_BUCKETS, sizeof(struct fwiFileCacheWatch*));
+    if (nativeCache->buckets_p == nullptr || nativeCache->watches_p == nullptr) {
+        free(nativeCache->buckets_p);
+        free(nativeCache->watches_p);
+        free(nativeCache);
+        return fwErrorOutOfMemory;
+    }
+
+    nativeCache->configuration = *configuration_p;
+    if (nativeCache->configuration.budget == 0) {
+        nativeCache->configuration.budget = FWI_FILE_CACHE_BUDGET;
+    }
+    // Without inotify, for example once the watch limit of the user is reached, stat takes over
+    nativeCache->inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    nativeCache->drained = fwiMonotonicMilliseconds();
+    pthread_mutex_init(&nativeCache->mutex, nullptr);
+
+    *cache_p = (uintptr_t)nativeCache;
+    return fwErrorSuccess;
+}
+
+fwError fwFileCacheDestroy(const fwFileCache cache) {
+    struct fwiFileCache* nativeCache = {(struct fwiFileCache*)cache};
+    pthread_mutex_lock(&nativeCache->mutex);
+    const uint32_t held = nativeCache->held;
+    pthread_mutex_unlock(&nativeCache->mutex);
+    if (held != 0) {
+        FWI_LOG_WARNING("File cache still has %u held entries, it is kept", held);
+        return fwErrorInvalidParameter;
+    }
+
+    for (uint32_t i = 0; i < nativeCache->bucketCount; i++) {
+        struct fwiFileCacheEntry* entry_p = nativeCache->buckets_p[i];
+        while (entry_p != nullptr) {
+            struct fwiFileCacheEntry* next_p = entry_p->next_p;
+            fwiFileCacheFree(entry_p);
+            entry_p = next_p;
+        }
+        struct fwiFileCacheWatch* watch_p = nativeCache->watches_p[i];
+        while (watch_p != nullptr) {
+            struct fwiFileCacheWatch* next_p = watch_p->next_p;
+            free(watch_p);
+            watch_p = next_p;
+        }
+    }
+    if (nativeCache->inotify != -1) {
+        close(nativeCache->inotify); // takes all watches with it
+    }
+
+    pthread_mutex_destroy(&nativeCache->mutex);
+    free(nativeCache->buckets_p);
+    free(nativeCache->watches_p);
+    free(nativeCache);
+    return fwErrorSuccess;
+}
+
+fwError fwFileCacheAcquire(const fwFileCache cache, const char* filename_p,
+                           fwFileCacheEntry* entry_p, const void** data_pp, uint64_t* size_p) {
+    struct fwiFileCache* nativeCache = {(struct fwiFileCache*)cache};
+    if (filename_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    const uint64_t hash = fwiFileCacheHash(filename_p);
+    const uint32_t interval = nativeCache->configuration.checkInterval;
+    pthread_mutex_lock(&nativeCache->mutex);
+    const int64_t now = fwiMonotonicMilliseconds();
+    if (nativeCache->inotify != -1 && now - nativeCache->drained >= interval) {
+        fwiFileCacheDrain(nativeCache);
+        nativeCache->drained = now;
+    }
+
+    struct fwiFileCacheEntry** link_pp = &nativeCache->buckets_p[hash % nativeCache->bucketCount];
+    while (*link_pp != nullptr &&
+           ((*link_pp)->hash != hash || strcmp((*link_pp)->path, filename_p) != 0)) {
+        link_pp = &(*link_pp)->next_p;
+    }
+
+    struct fwiFileCacheEntry* cached_p = *link_pp;
+    if (cached_p != nullptr && cached_p->watch == -1 && now - cached_p->checked >= interval) {
+        struct stat fileStats;
+        if (stat(filename_p, &fileStats) != 0 ||
+            !fwiFileCacheUnchanged(&cached_p->stats, &fileStats)) {
+            fwiFileCacheDrop(nativeCache, link_pp, true);
+            cached_p = nullptr;
+        }
+        else {
+            cached_p->checked = now;
+        }
+    }
+
+    if (cached_p != nullptr) {
+        if (cached_p->references++ == 0) {
+            fwiFileCacheUnlinkIdle(nativeCache, cached_p);
+        }
+        nativeCache->stats.hits++;
+    }
+    else {
+        nativeCache->stats.misses++;
+        const fwError error = fwiFileCacheLoad(nativeCache, filename_p, hash, now, &cached_p);
+        if (error != fwErrorSuccess) {
+            pthread_mutex_unlock(&nativeCache->mutex);
+            return error;
+        }
+
+        struct fwiFileCacheEntry** bucket_pp =
+            &nativeCache->buckets_p[hash % nativeCache->bucketCount];
+        cached_p->next_p = *bucket_pp;
+        *bucket_pp = cached_p;
+        nativeCache->stats.entries++;
+        nativeCache->stats.bytes += cached_p->size;
+        if (nativeCache->stats.entries > nativeCache->bucketCount) {
+            fwiFileCacheGrow(nativeCache);
+        }
+        fwiFileCacheEvict(nativeCache);
+    }
+    nativeCache->held++;
+    pthread_mutex_unlock(&nativeCache->mutex);
+
+    *entry_p = (uintptr_t)cached_p;
+    *data_pp = cached_p->data_p;
+    *size_p  = cached_p->size;
+    return fwErrorSuccess;
+}
+
+fwError fwFileCacheRelease(const fwFileCache cache, const fwFileCacheEntry entry) {
+    struct fwiFileCache* nativeCache = {(struct fwiFileCache*)cache};
+    struct fwiFileCacheEntry* entry_p = {(struct fwiFileCacheEntry*)entry};
+
+    pthread_mutex_lock(&nativeCache->mutex);
+    nativeCache->held--;
+    if (--entry_p->references == 0) {
+        if (entry_p->cached) {
+            fwiFileCacheLinkIdle(nativeCache, entry_p);
+            fwiFileCacheEvict(nativeCache);
+        }
+        else {
+            fwiFileCacheFree(entry_p);
+        }
+    }
+    pthread_mutex_unlock(&nativeCache->mutex);
+    return fwErrorSuccess;
+}
 
-    fwiLogA(fwiLogLevelInfo, "Socket (ID: %X) was closed", sfdop);
+fwError fwFileCacheGetStats(const fwFileCache cache, struct fwFileCacheStats* stats_p) {
+    struct fwiFileCache* nativeCache = {(struct fwiFileCache*)cache};
+    pthread_mutex_lock(&nativeCache->mutex);
+    *stats_p = nativeCache->stats;
+    pthread_mutex_unlock(&nativeCache->mutex);
     return fwErrorSuccess;
 }
 
 void fwiLogErrno(const char* location, const int32_t line) {
     const int32_t err = errno;
-    fwiLogA(fwiLogLevelError, "System call failure with code %d at line %d in function %s", err,
+    FWI_LOG_ERROR("System call failure with code %d at line %d in function %s", err,
             line, location);
 }
 
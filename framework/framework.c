@@ -14,14 +14,42 @@
 
 // This implementation file contains implementations for platform independant, exposed symbols
 
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "framework.h"
 #include "internal.h"
 
-fwError fwStartModule(const fwModule module, const uint32_t flags) {
-    if (!fwiGetState()->baseIsUp) {
-        fwiStartNativeModuleBase();
-    }
+#define FWI_BENCH_HISTOGRAM_WIDTH 40
+#define FWI_SOCKET_STREAM_CAPACITY 65536
+#define FWI_BUFFER_INDEX_SLICE 65536 // bytes scanned per growth step of the offsets
+#define FWI_BUFFER_INDEX_CHUNK_MIN 8388608 // smaller chunks are not worth a job
+#define FWI_BUFFER_INDEX_CHUNKS_MAX 256
+#define FWI_MODULE_GROUPS 4
 
+// Modules in one group start one after the other, the groups start concurrently. The render
+// module needs the display connection of the window module.
+static const uint8_t moduleGroups_s[FWI_MODULE_GROUPS] = {
+    fwModuleWindow | fwModuleRender, fwModuleNetwork, fwModuleMultimedia, fwModuleJob
+};
+
+/**
+ * @brief What one group of @c fwStartModules starts, the groups share the stats but each one only
+ *        writes the entries of its own modules
+ */
+struct fwiModuleStart {
+    uint8_t modules;
+    uint32_t flags;
+    struct fwModuleStartStats* stats_p;
+};
+
+static bool fwiModuleValid(const uint32_t module) {
+    return module != 0 && (module & (module - 1)) == 0 && module < 1u << FW_MODULE_COUNT;
+}
+
+static fwError fwiStartModule(const fwModule module, const uint32_t flags) {
     switch (module) {
         case fwModuleWindow: {
             return fwiStartNativeModuleWindow();
@@ -30,20 +58,158 @@ fwError fwStartModule(const fwModule module, const uint32_t flags) {
             return fwiStartNativeModuleRenderer();
         }
         case fwModuleNetwork: {
-            return fwiStartNativeModuleNetwork();
+            return fwiStartNativeModuleNetwork(flags);
         }
         case fwModuleMultimedia: {
             return fwiStartNativeModuleMultimedia();
         }
+        case fwModuleJob: {
+            return fwiStartNativeModuleJob();
+        }
         default: {
             return fwErrorInvalidParameter;
         }
     }
 }
 
+static void* fwiStartModuleGroup(void* start_p) {
+    const struct fwiModuleStart* group_p = start_p;
+    struct fwModuleStartStats* stats_p = group_p->stats_p;
+    for (uint32_t i = 0; i < FW_MODULE_COUNT; i++) {
+        const fwModule module = (fwModule)(1u << i);
+        if (!(group_p->modules & module)) {
+            continue;
+        }
+
+        uint64_t begin = 0, end = 0;
+        fwBenchNow(&begin);
+        stats_p->errors[i] = fwiStartModule(module, group_p->flags);
+        fwBenchNow(&end);
+        stats_p->modules[i] = end - begin;
+    }
+    return nullptr;
+}
+
+static fwError fwiStartBase(uint64_t* nanoseconds_p) {
+    if (fwiGetState()->baseIsUp) {
+        return fwErrorSuccess;
+    }
+
+    uint64_t begin = 0, end = 0;
+    fwBenchNow(&begin);
+    const fwError error = fwiStartNativeModuleBase();
+    fwBenchNow(&end);
+    *nanoseconds_p = end - begin;
+    return error;
+}
+
+fwError fwStartModule(const fwModule module, const uint32_t flags) {
+    if (!fwiModuleValid(module)) {
+        return fwErrorInvalidParameter;
+    }
+    uint64_t nanoseconds = 0;
+    fwError error = fwiStartBase(&nanoseconds);
+    if (error != fwErrorSuccess || fwiGetState()->activeModules & module) {
+        return error;
+    }
+
+    if ((error = fwiStartModule(module, flags)) == fwErrorSuccess) {
+        fwiGetState()->activeModules |= module;
+    }
+    return error;
+}
+
+fwError fwStartModules(const uint8_t modules, const uint32_t flags,
+                       const struct fwSocketAddress* warmup_p, const uint32_t warmupCount,
+                       struct fwModuleStartStats* stats_p) {
+    if (modules >> FW_MODULE_COUNT != 0 || (warmup_p == nullptr && warmupCount != 0)) {
+        return fwErrorInvalidParameter;
+    }
+
+    struct fwModuleStartStats stats = {};
+    uint64_t begin = 0, end = 0;
+    fwBenchNow(&begin);
+    fwError ret = fwiStartBase(&stats.base);
+    if (ret != fwErrorSuccess) {
+        return ret;
+    }
+
+    const uint8_t pending = modules & ~fwiGetState()->activeModules;
+    struct fwiModuleStart groups[FWI_MODULE_GROUPS];
+    uint32_t groupCount = 0;
+    for (uint32_t i = 0; i < FWI_MODULE_GROUPS; i++) {
+        if (pending & moduleGroups_s[i]) {
+            groups[groupCount++] = (struct fwiModuleStart){
+                .modules     = pending & moduleGroups_s[i],
+                .flags   = flags,
+                .stats_p = &stats
+            };
+        }
+    }
+
+    // The calling thread takes the first group, a group that gets no thread runs on it as well
+    pthread_t threads[FWI_MODULE_GROUPS];
+    bool spawned[FWI_MODULE_GROUPS] = {};
+    for (uint32_t i = 1; i < groupCount; i++) {
+        spawned[i] = pthread_create(&threads[i], nullptr, fwiStartModuleGroup, &groups[i]) == 0;
+    }
+    for (uint32_t i = 0; i < groupCount; i++) {
+        if (i == 0 || !spawned[i]) {
+            fwiStartModuleGroup(&groups[i]);
+        }
+    }
+    for (uint32_t i = 1; i < groupCount; i++) {
+        if (spawned[i]) {
+            pthread_join(threads[i], nullptr);
+        }
+    }
+
+    // The warmup prefetches through the job workers, which may only be touched once the job
+    // group is done with them
+    const uint32_t networkBit = __builtin_ctz(fwModuleNetwork);
+    if (pending & fwModuleNetwork && stats.errors[networkBit] == fwErrorSuccess &&
+        warmupCount != 0) {
+        uint64_t warmBegin = 0, warmEnd = 0;
+        fwBenchNow(&warmBegin);
+        if (fwResolverWarmup(warmup_p, warmupCount) != fwErrorSuccess) {
+            FWI_LOG_WARNING("Not every warmup name could be resolved");
+        }
+        fwBenchNow(&warmEnd);
+        stats.warmup = warmEnd - warmBegin;
+    }
+
+    for (uint32_t i = 0; i < FW_MODULE_COUNT; i++) {
+        if (!(pending & 1u << i)) {
+            continue;
+        }
+        if (stats.errors[i] == fwErrorSuccess) {
+            fwiGetState()->activeModules |= 1u << i;
+        }
+        else if (ret == fwErrorSuccess) {
+            ret = stats.errors[i];
+        }
+    }
+
+    fwBenchNow(&end);
+    stats.total = end - begin;
+    if (pending != 0) {
+        FWI_LOG_INFO("Modules 0x%02X were started in %" PRIu64 " us", pending, stats.total / 1000);
+    }
+    if (stats_p != nullptr) {
+        *stats_p = stats;
+    }
+    return ret;
+}
+
 fwError fwStopModule(const enum fwModule module) {
-    bool fail = false;
-    fwError ret = 0;
+    if (!fwiModuleValid(module)) {
+        return fwErrorInvalidParameter;
+    }
+    if (!(fwiGetState()->activeModules & module)) {
+        return fwErrorSuccess;
+    }
+
+    fwError ret = fwErrorSuccess;
     switch (module) {
         case fwModuleWindow: {
             ret = fwiStopNativeModuleWindow();
@@ -61,23 +227,21 @@ fwError fwStopModule(const enum fwModule module) {
             ret = fwiStopNativeModuleRenderer();
             break;
         }
-        default: {
-            fail = true;
+        case fwModuleJob: {
+            ret = fwiStopNativeModuleJob();
+            break;
         }
     }
 
-    if (!fwiGetState()->baseIsUp) {
-        fwiStopNativeModuleBase();
-    }
-
-    if (fail) {
-        return fwErrorInvalidParameter;
-    }
-
+    fwiGetState()->activeModules &= ~module;
     return ret;
 }
 
 void fwStopAllModules(void) {
+    // The renderer goes before the display connection it draws through
+    if (fwiGetState()->activeModules & fwModuleRender) {
+        fwiStopNativeModuleRenderer();
+    }
     if (fwiGetState()->activeModules & fwModuleWindow) {
         fwiStopNativeModuleWindow();
     }
@@ -87,10 +251,907 @@ void fwStopAllModules(void) {
     if (fwiGetState()->activeModules & fwModuleMultimedia) {
         fwiStopNativeModuleMultimedia();
     }
-    if (fwiGetState()->activeModules & fwModuleRender) {
-        fwiStopNativeModuleRenderer();
+    if (fwiGetState()->activeModules & fwModuleJob) {
+        fwiStopNativeModuleJob();
     }
+    fwiGetState()->activeModules = 0;
+
     if (fwiGetState()->baseIsUp) {
         fwiStopNativeModuleBase();
     }
 }
+
+fwError fwBenchCreate(const struct fwBenchConfiguration* configuration_p, fwBench* bench_p) {
+    if (configuration_p == nullptr || bench_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    struct fwiBench* nativeBench = calloc(1, sizeof(struct fwiBench));
+    if (nativeBench == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+
+    nativeBench->configuration  = *configuration_p;
+    nativeBench->warmupLeft     = configuration_p->warmup;
+    nativeBench->sampleCapacity = configuration_p->repetitions != 0 ? configuration_p->repetitions
+                                                                    : 1024;
+    // Allocating all samples up front keeps reallocation out of the measured code
+    nativeBench->samples_p = malloc(nativeBench->sampleCapacity * sizeof(uint64_t));
+    if (nativeBench->samples_p == nullptr) {
+        free(nativeBench);
+        return fwErrorOutOfMemory;
+    }
+
+    *bench_p = (uintptr_t)nativeBench;
+    return fwErrorSuccess;
+}
+
+fwError fwBenchDestroy(const fwBench bench) {
+    struct fwiBench* nativeBench = {(struct fwiBench*)bench};
+    free(nativeBench->samples_p);
+    free(nativeBench);
+    return fwErrorSuccess;
+}
+
+fwError fwBenchBegin(const fwBench bench) {
+    struct fwiBench* nativeBench = {(struct fwiBench*)bench};
+    return fwBenchNow(&nativeBench->scopeStart);
+}
+
+fwError fwBenchEnd(const fwBench bench) {
+    uint64_t now = 0;
+    fwBenchNow(&now);
+
+    struct fwiBench* nativeBench = {(struct fwiBench*)bench};
+    return fwBenchRecord(bench, now - nativeBench->scopeStart);
+}
+
+static fwError fwiBenchReserve(struct fwiBench* nativeBench, const uint64_t additional) {
+    if (nativeBench->sampleCount + additional <= nativeBench->sampleCapacity) {
+        return fwErrorSuccess;
+    }
+
+    uint64_t capacity = nativeBench->sampleCapacity * 2;
+    while (capacity < nativeBench->sampleCount + additional) {
+        capacity *= 2;
+    }
+
+    uint64_t* samples_p = realloc(nativeBench->samples_p, capacity * sizeof(uint64_t));
+    if (samples_p == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+
+    nativeBench->samples_p      = samples_p;
+    nativeBench->sampleCapacity = capacity;
+    return fwErrorSuccess;
+}
+
+fwError fwBenchRecord(const fwBench bench, const uint64_t nanoseconds) {
+    struct fwiBench* nativeBench = {(struct fwiBench*)bench};
+    if (nativeBench->warmupLeft != 0) {
+        --nativeBench->warmupLeft;
+        return fwErrorSuccess;
+    }
+
+    const fwError ret = fwiBenchReserve(nativeBench, 1);
+    if (ret != fwErrorSuccess) {
+        return ret;
+    }
+
+    nativeBench->samples_p[nativeBench->sampleCount++] = nanoseconds;
+    return fwErrorSuccess;
+}
+
+fwError fwBenchMerge(const fwBench destination, const fwBench source) {
+    struct fwiBench* nativeDestination = {(struct fwiBench*)destination};
+    const struct fwiBench* nativeSource = {(struct fwiBench*)source};
+
+    const fwError ret = fwiBenchReserve(nativeDestination, nativeSource->sampleCount);
+    if (ret != fwErrorSuccess) {
+        return ret;
+    }
+
+    memcpy(nativeDestination->samples_p + nativeDestination->sampleCount, nativeSource->samples_p,
+           nativeSource->sampleCount * sizeof(uint64_t));
+    nativeDestination->sampleCount += nativeSource->sampleCount;
+    return fwErrorSuccess;
+}
+
+fwError fwBenchRun(const fwBench bench, const fwBenchFunction function, void* user_p) {
+    if (function == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    const struct fwiBench* nativeBench = {(struct fwiBench*)bench};
+    const uint64_t iterations = (uint64_t)nativeBench->warmupLeft
+                              + nativeBench->configuration.repetitions;
+
+    for (uint64_t i = 0; i < iterations; ++i) {
+        fwBenchBegin(bench);
+        const fwError ret = function(user_p);
+        if (ret != fwErrorSuccess) {
+            return ret;
+        }
+        fwBenchEnd(bench);
+    }
+
+    return fwErrorSuccess;
+}
+
+static int32_t fwiBenchCompare(const void* first_p, const void* second_p) {
+    const uint64_t first  = *(const uint64_t*)first_p;
+    const uint64_t second = *(const uint64_t*)second_p;
+    return (first > second) - (first < second);
+}
+
+static uint64_t fwiBenchPercentile(const uint64_t* sorted_p, const uint64_t count,
+                                   const uint64_t perMille) {
+    // Nearest rank, so every reported value is a sample that was actually measured
+    const uint64_t rank = (perMille * count + 999) / 1000;
+    return sorted_p[rank != 0 ? rank - 1 : 0];
+}
+
+fwError fwBenchReport(const fwBench bench, struct fwBenchResult* result_p) {
+    const struct fwiBench* nativeBench = {(struct fwiBench*)bench};
+    const char* name_p = nativeBench->configuration.name_p;
+    struct fwBenchResult result = {};
+
+    result.samples = nativeBench->sampleCount;
+    if (result.samples == 0) {
+        FWI_LOG_BENCH("%s: no samples were recorded", name_p);
+        if (result_p != nullptr) {
+            *result_p = result;
+        }
+        return fwErrorSuccess;
+    }
+
+    // Sorting a copy leaves the recording order intact for further merges
+    uint64_t* sorted_p = malloc(result.samples * sizeof(uint64_t));
+    if (sorted_p == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+    memcpy(sorted_p, nativeBench->samples_p, result.samples * sizeof(uint64_t));
+    qsort(sorted_p, result.samples, sizeof(uint64_t), fwiBenchCompare);
+
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < result.samples; ++i) {
+        sum += sorted_p[i];
+        const uint32_t bucket = sorted_p[i] > 1 ? 63 - __builtin_clzll(sorted_p[i]) : 0;
+        ++result.histogram[bucket];
+    }
+
+    result.minimum = sorted_p[0];
+    result.maximum = sorted_p[result.samples - 1];
+    result.mean    = sum / result.samples;
+    result.median  = fwiBenchPercentile(sorted_p, result.samples, 500);
+    result.p90     = fwiBenchPercentile(sorted_p, result.samples, 900);
+    result.p99     = fwiBenchPercentile(sorted_p, result.samples, 990);
+    result.p999    = fwiBenchPercentile(sorted_p, result.samples, 999);
+    if (nativeBench->configuration.bytes != 0 && sum != 0) {
+        result.throughput = (double)nativeBench->configuration.bytes * (double)result.samples
+                          / ((double)sum / 1e9);
+    }
+    free(sorted_p);
+
+    FWI_LOG_BENCH("%s: %"PRIu64" samples, min %"PRIu64" ns, median %"PRIu64" ns, p90 %"PRIu64
+                  " ns, p99 %"PRIu64" ns, p99.9 %"PRIu64" ns, max %"PRIu64" ns, mean %"PRIu64" ns",
+                  name_p, result.samples, result.minimum, result.median, result.p90, result.p99,
+                  result.p999, result.maximum, result.mean);
+    if (result.throughput != 0.0) {
+        fwiLogFollowupA(false, "throughput %.1f MiB/s", result.throughput / 1048576.0);
+    }
+
+    uint32_t first = FW_BENCH_HISTOGRAM_BUCKETS;
+    uint32_t last = 0;
+    uint64_t tallest = 0;
+    for (uint32_t i = 0; i < FW_BENCH_HISTOGRAM_BUCKETS; ++i) {
+        if (result.histogram[i] != 0) {
+            first = first < i ? first : i;
+            last = i;
+            tallest = tallest > result.histogram[i] ? tallest : result.histogram[i];
+        }
+    }
+
+    static const char bar[FWI_BENCH_HISTOGRAM_WIDTH + 1] = "########################################";
+    for (uint32_t i = first; i <= last; ++i) {
+        const int32_t width = (int32_t)(result.histogram[i] * FWI_BENCH_HISTOGRAM_WIDTH / tallest);
+        fwiLogFollowupA(i == last, ">= %12"PRIu64" ns %10"PRIu64" %.*s", i != 0 ? 1ull << i : 0ull,
+                        result.histogram[i], width, bar);
+    }
+
+    if (result_p != nullptr) {
+        *result_p = result;
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwArenaCreate(const struct fwArenaConfiguration* configuration_p, fwArena* arena_p) {
+    if (configuration_p == nullptr || arena_p == nullptr || configuration_p->size == 0) {
+        return fwErrorInvalidParameter;
+    }
+
+    struct fwiArena* nativeArena = calloc(1, sizeof(struct fwiArena));
+    if (nativeArena == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+
+    void* memory_p = nullptr;
+    const fwError ret = fwiMapMemory(configuration_p->size, configuration_p->numaNode,
+                                     configuration_p->flags, &memory_p, &nativeArena->mappedSize);
+    if (ret != fwErrorSuccess) {
+        free(nativeArena);
+        return ret;
+    }
+
+    nativeArena->base_p = memory_p;
+    nativeArena->size   = configuration_p->size;
+
+    *arena_p = (uintptr_t)nativeArena;
+    return fwErrorSuccess;
+}
+
+fwError fwArenaDestroy(const fwArena arena) {
+    struct fwiArena* nativeArena = {(struct fwiArena*)arena};
+    fwiUnmapMemory(nativeArena->base_p, nativeArena->mappedSize);
+    free(nativeArena);
+    return fwErrorSuccess;
+}
+
+fwError fwArenaAllocate(const fwArena arena, const uint64_t size, uint64_t alignment,
+                        void** memory_pp) {
+    alignment = alignment != 0 ? alignment : 16;
+    if (alignment & (alignment - 1)) {
+        return fwErrorInvalidParameter;
+    }
+
+    struct fwiArena* nativeArena = {(struct fwiArena*)arena};
+    const uintptr_t base = (uintptr_t)nativeArena->base_p;
+    const uint64_t start = ((base + nativeArena->offset + alignment - 1) & ~(alignment - 1)) - base;
+    if (start > nativeArena->size || size > nativeArena->size - start) {
+        return fwErrorOutOfMemory;
+    }
+
+    nativeArena->offset = start + size;
+    *memory_pp = nativeArena->base_p + start;
+    return fwErrorSuccess;
+}
+
+fwError fwArenaGetMarker(const fwArena arena, fwArenaMarker* marker_p) {
+    const struct fwiArena* nativeArena = {(struct fwiArena*)arena};
+    *marker_p = nativeArena->offset;
+    return fwErrorSuccess;
+}
+
+fwError fwArenaRewind(const fwArena arena, const fwArenaMarker marker) {
+    struct fwiArena* nativeArena = {(struct fwiArena*)arena};
+    if (marker > nativeArena->offset) {
+        return fwErrorInvalidParameter;
+    }
+
+    nativeArena->offset = marker;
+    return fwErrorSuccess;
+}
+
+fwError fwArenaReset(const fwArena arena) {
+    return fwArenaRewind(arena, 0);
+}
+
+fwError fwPoolCreate(const struct fwPoolConfiguration* configuration_p, fwPool* pool_p) {
+    if (configuration_p == nullptr || pool_p == nullptr || configuration_p->elementSize == 0 ||
+        configuration_p->elementCount == 0) {
+        return fwErrorInvalidParameter;
+    }
+
+    // Every element has to be able to hold the free list link, 16 also keeps SSE loads aligned
+    const uint64_t elementSize = (configuration_p->elementSize + 15) & ~(uint64_t)15;
+    if (configuration_p->elementCount > UINT64_MAX / elementSize) {
+        return fwErrorInvalidParameter;
+    }
+
+    struct fwiPool* nativePool = calloc(1, sizeof(struct fwiPool));
+    if (nativePool == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+
+    void* memory_p = nullptr;
+    const fwError ret = fwiMapMemory(elementSize * configuration_p->elementCount,
+                                     configuration_p->numaNode, configuration_p->flags, &memory_p,
+                                     &nativePool->mappedSize);
+    if (ret != fwErrorSuccess) {
+        free(nativePool);
+        return ret;
+    }
+
+    nativePool->base_p       = memory_p;
+    nativePool->elementSize  = elementSize;
+    nativePool->elementCount = configuration_p->elementCount;
+
+    // Linked back to front so that the elements are handed out in address order
+    for (uint64_t i = nativePool->elementCount; i-- > 0;) {
+        void** element_pp = (void**)(nativePool->base_p + i * elementSize);
+        *element_pp = nativePool->free_p;
+        nativePool->free_p = element_pp;
+    }
+
+    *pool_p = (uintptr_t)nativePool;
+    return fwErrorSuccess;
+}
+
+fwError fwPoolDestroy(const fwPool pool) {
+    struct fwiPool* nativePool = {(struct fwiPool*)pool};
+    fwiUnmapMemory(nativePool->base_p, nativePool->mappedSize);
+    free(nativePool);
+    return fwErrorSuccess;
+}
+
+fwError fwPoolAllocate(const fwPool pool, void** element_pp) {
+    struct fwiPool* nativePool = {(struct fwiPool*)pool};
+    if (nativePool->free_p == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+
+    *element_pp = nativePool->free_p;
+    nativePool->free_p = *(void**)nativePool->free_p;
+    return fwErrorSuccess;
+}
+
+fwError fwPoolFree(const fwPool pool, void* element_p) {
+    struct fwiPool* nativePool = {(struct fwiPool*)pool};
+    const uintptr_t offset = (uintptr_t)element_p - (uintptr_t)nativePool->base_p;
+    if ((uintptr_t)element_p < (uintptr_t)nativePool->base_p ||
+        offset >= nativePool->elementSize * nativePool->elementCount ||
+        offset % nativePool->elementSize != 0) {
+        return fwErrorInvalidParameter;
+    }
+
+    *(void**)element_p = nativePool->free_p;
+    nativePool->free_p = element_p;
+    return fwErrorSuccess;
+}
+
+fwError fwSocketStreamCreate(const struct fwSocketStreamConfiguration* configuration_p,
+                             fwSocketStream* stream_p) {
+    if (configuration_p == nullptr || stream_p == nullptr || configuration_p->socket == 0) {
+        return fwErrorInvalidParameter;
+    }
+
+    struct fwiSocketStream* nativeStream = calloc(1, sizeof(struct fwiSocketStream));
+    if (nativeStream == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+
+    nativeStream->socket        = configuration_p->socket;
+    nativeStream->readCapacity  = configuration_p->readCapacity != 0 ?
+                                  configuration_p->readCapacity : FWI_SOCKET_STREAM_CAPACITY;
+    nativeStream->writeCapacity = configuration_p->writeCapacity != 0 ?
+                                  configuration_p->writeCapacity : FWI_SOCKET_STREAM_CAPACITY;
+
+    // Both buffers share one allocation
+    nativeStream->read_p = malloc((size_t)nativeStream->readCapacity + nativeStream->writeCapacity);
+    if (nativeStream->read_p == nullptr) {
+        free(nativeStream);
+        return fwErrorOutOfMemory;
+    }
+    nativeStream->write_p = nativeStream->read_p + nativeStream->readCapacity;
+
+    *stream_p = (uintptr_t)nativeStream;
+    return fwErrorSuccess;
+}
+
+fwError fwSocketStreamDestroy(const fwSocketStream stream) {
+    struct fwiSocketStream* nativeStream = {(struct fwiSocketStream*)stream};
+    free(nativeStream->read_p);
+    free(nativeStream);
+    return fwErrorSuccess;
+}
+
+static void fwiSocketStreamConsume(struct fwiSocketStream* nativeStream, const size_t ammount) {
+    nativeStream->readStart  += ammount;
+    nativeStream->readScanned = 0;
+    if (nativeStream->readStart == nativeStream->readEnd) {
+        nativeStream->readStart = 0;
+        nativeStream->readEnd   = 0;
+    }
+}
+
+/**
+ * @brief Receives once into the free tail of the read buffer, first moving the unread bytes to the
+ *        front if a frame of the given total size would not fit behind them otherwise
+ */
+static fwError fwiSocketStreamFill(struct fwiSocketStream* nativeStream, const size_t needed) {
+    if (nativeStream->readStart + needed > nativeStream->readCapacity ||
+        nativeStream->readEnd == nativeStream->readCapacity) {
+        const size_t buffered = nativeStream->readEnd - nativeStream->readStart;
+        memmove(nativeStream->read_p, nativeStream->read_p + nativeStream->readStart, buffered);
+        nativeStream->readStart = 0;
+        nativeStream->readEnd   = buffered;
+    }
+    if (nativeStream->readEnd == nativeStream->readCapacity) {
+        return fwErrorSocketFrame;
+    }
+
+    size_t received = 0;
+    const fwError ret = fwSocketReceive(nativeStream->socket,
+                                        nativeStream->read_p + nativeStream->readEnd,
+                                        nativeStream->readCapacity - nativeStream->readEnd,
+                                        &received);
+    if (ret != fwErrorSuccess) {
+        return ret;
+    }
+    if (received == 0) {
+        return fwErrorSocketClosed;
+    }
+
+    nativeStream->readEnd += received;
+    return fwErrorSuccess;
+}
+
+/**
+ * @brief Receives until at least the given number of bytes is buffered
+ */
+static fwError fwiSocketStreamFillTo(struct fwiSocketStream* nativeStream, const size_t needed) {
+    while (nativeStream->readEnd - nativeStream->readStart < needed) {
+        const fwError ret = fwiSocketStreamFill(nativeStream, needed);
+        if (ret != fwErrorSuccess) {
+            return ret;
+        }
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwSocketStreamRead(const fwSocketStream stream, void* buffer, const size_t ammount,
+                           size_t* read_p) {
+    struct fwiSocketStream* nativeStream = {(struct fwiSocketStream*)stream};
+    size_t copied = 0;
+    if (nativeStream->readStart == nativeStream->readEnd) {
+        // Copying through the buffer would only cost time when the caller takes all of it anyway
+        if (ammount >= nativeStream->readCapacity) {
+            const fwError ret = fwSocketReceive(nativeStream->socket, buffer, ammount, &copied);
+            if (ret != fwErrorSuccess) {
+                return ret;
+            }
+            if (copied == 0 && ammount != 0) {
+                return fwErrorSocketClosed;
+            }
+            if (read_p != nullptr) {
+                *read_p = copied;
+            }
+            return fwErrorSuccess;
+        }
+
+        const fwError ret = fwiSocketStreamFill(nativeStream, 1);
+        if (ret != fwErrorSuccess) {
+            return ret;
+        }
+    }
+
+    const size_t buffered = nativeStream->readEnd - nativeStream->readStart;
+    copied = ammount < buffered ? ammount : buffered;
+    memcpy(buffer, nativeStream->read_p + nativeStream->readStart, copied);
+    fwiSocketStreamConsume(nativeStream, copied);
+    if (read_p != nullptr) {
+        *read_p = copied;
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwSocketStreamReadExact(const fwSocketStream stream, void* buffer, const size_t ammount) {
+    struct fwiSocketStream* nativeStream = {(struct fwiSocketStream*)stream};
+    if (ammount <= nativeStream->readCapacity) {
+        const fwError ret = fwiSocketStreamFillTo(nativeStream, ammount);
+        if (ret != fwErrorSuccess) {
+            return ret;
+        }
+        memcpy(buffer, nativeStream->read_p + nativeStream->readStart, ammount);
+        fwiSocketStreamConsume(nativeStream, ammount);
+        return fwErrorSuccess;
+    }
+
+    // Drain what is buffered, the rest goes straight into the destination
+    const size_t buffered = nativeStream->readEnd - nativeStream->readStart;
+    memcpy(buffer, nativeStream->read_p + nativeStream->readStart, buffered);
+    fwiSocketStreamConsume(nativeStream, buffered);
+    for (size_t total = buffered; total < ammount;) {
+        size_t received = 0;
+        const fwError ret = fwSocketReceive(nativeStream->socket, (uint8_t*)buffer + total,
+                                            ammount - total, &received);
+        if (ret != fwErrorSuccess) {
+            return ret;
+        }
+        if (received == 0) {
+            return fwErrorSocketClosed;
+        }
+        total += received;
+    }
+    return fwErrorSuccess;
+}
+
+static bool fwiSocketStreamPrefixValid(const uint8_t prefixSize) {
+    return prefixSize == 1 || prefixSize == 2 || prefixSize == 4 || prefixSize == 8;
+}
+
+fwError fwSocketStreamReadFrame(const fwSocketStream stream, const uint8_t prefixSize,
+                                const void** frame_pp, size_t* length_p) {
+    struct fwiSocketStream* nativeStream = {(struct fwiSocketStream*)stream};
+    if (!fwiSocketStreamPrefixValid(prefixSize) || prefixSize > nativeStream->readCapacity) {
+        return fwErrorInvalidParameter;
+    }
+
+    fwError ret = fwiSocketStreamFillTo(nativeStream, prefixSize);
+    if (ret != fwErrorSuccess) {
+        return ret;
+    }
+    uint64_t length = 0;
+    for (uint8_t i = 0; i < prefixSize; ++i) {
+        length = length << 8 | nativeStream->read_p[nativeStream->readStart + i];
+    }
+    if (length > nativeStream->readCapacity - prefixSize) {
+        return fwErrorSocketFrame;
+    }
+
+    ret = fwiSocketStreamFillTo(nativeStream, prefixSize + length);
+    if (ret != fwErrorSuccess) {
+        return ret;
+    }
+    *frame_pp = nativeStream->read_p + nativeStream->readStart + prefixSize;
+    *length_p = length;
+    fwiSocketStreamConsume(nativeStream, prefixSize + length);
+    return fwErrorSuccess;
+}
+
+fwError fwSocketStreamReadUntil(const fwSocketStream stream, const void* delimiter_p,
+                                const size_t delimiterLength, const void** frame_pp,
+                                size_t* length_p) {
+    struct fwiSocketStream* nativeStream = {(struct fwiSocketStream*)stream};
+    if (delimiter_p == nullptr || delimiterLength == 0) {
+        return fwErrorInvalidParameter;
+    }
+
+    const uint8_t first = *(const uint8_t*)delimiter_p;
+    while (true) {
+        const uint8_t* start_p = nativeStream->read_p + nativeStream->readStart;
+        const size_t buffered = nativeStream->readEnd - nativeStream->readStart;
+
+        // A delimiter can straddle the end of the previous scan
+        size_t position = nativeStream->readScanned >= delimiterLength ?
+                          nativeStream->readScanned - delimiterLength + 1 : 0;
+        while (buffered >= delimiterLength && position <= buffered - delimiterLength) {
+            const uint8_t* candidate_p = memchr(start_p + position, first,
+                                                buffered - delimiterLength + 1 - position);
+            if (candidate_p == nullptr) {
+                break;
+            }
+            if (memcmp(candidate_p, delimiter_p, delimiterLength) == 0) {
+                *frame_pp = start_p;
+                *length_p = candidate_p - start_p;
+                fwiSocketStreamConsume(nativeStream, *length_p + delimiterLength);
+                return fwErrorSuccess;
+            }
+            position = candidate_p - start_p + 1;
+        }
+        nativeStream->readScanned = buffered;
+
+        const fwError ret = fwiSocketStreamFill(nativeStream, buffered + 1);
+        if (ret != fwErrorSuccess) {
+            return ret;
+        }
+    }
+}
+
+fwError fwSocketStreamFlush(const fwSocketStream stream) {
+    struct fwiSocketStream* nativeStream = {(struct fwiSocketStream*)stream};
+    while (nativeStream->writeStart < nativeStream->writeEnd) {
+        size_t sent = 0;
+        const fwError ret = fwSocketSend(nativeStream->socket,
+                                         nativeStream->write_p + nativeStream->writeStart,
+                                         nativeStream->writeEnd - nativeStream->writeStart, &sent);
+        if (ret != fwErrorSuccess) {
+            return ret;
+        }
+        nativeStream->writeStart += sent;
+    }
+
+    nativeStream->writeStart = 0;
+    nativeStream->writeEnd   = 0;
+    return fwErrorSuccess;
+}
+
+/**
+ * @brief Makes room for the given number of bytes at the end of the write buffer, flushing it if
+ *        it is too full, the size must not exceed the capacity
+ */
+static fwError fwiSocketStreamReserve(struct fwiSocketStream* nativeStream, const size_t size) {
+    if (nativeStream->writeCapacity - nativeStream->writeEnd >= size) {
+        return fwErrorSuccess;
+    }
+
+    const fwError ret = fwSocketStreamFlush((uintptr_t)nativeStream);
+    if (ret == fwErrorSuccess) {
+        return fwErrorSuccess;
+    }
+
+    // The kernel took part of it, which can already be enough
+    const size_t pending = nativeStream->writeEnd - nativeStream->writeStart;
+    memmove(nativeStream->write_p, nativeStream->write_p + nativeStream->writeStart, pending);
+    nativeStream->writeStart = 0;
+    nativeStream->writeEnd   = pending;
+    return nativeStream->writeCapacity - pending >= size ? fwErrorSuccess : ret;
+}
+
+/**
+ * @brief Sends what is buffered followed by data that is too large for the buffer, with as few
+ *        syscalls as the kernel allows
+ */
+static fwError fwiSocketStreamWriteThrough(struct fwiSocketStream* nativeStream,
+                                           const uint8_t* data_p, const size_t ammount) {
+    size_t offset = 0;
+    while (offset < ammount) {
+        fwSocketBuffer buffers[2] = {};
+        uint32_t count = 0;
+        const size_t pending = nativeStream->writeEnd - nativeStream->writeStart;
+        if (pending != 0) {
+            buffers[count].data_p = nativeStream->write_p + nativeStream->writeStart;
+            buffers[count].size   = pending;
+            count++;
+        }
+        buffers[count].data_p = (void*)(data_p + offset);
+        buffers[count].size   = ammount - offset;
+        count++;
+
+        size_t sent = 0;
+        const fwError ret = fwSocketSendv(nativeStream->socket, buffers, count, &sent);
+        if (ret != fwErrorSuccess) {
+            return ret;
+        }
+        if (sent >= pending) {
+            nativeStream->writeStart = 0;
+            nativeStream->writeEnd   = 0;
+            offset += sent - pending;
+        } else {
+            nativeStream->writeStart += sent;
+        }
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwSocketStreamWrite(const fwSocketStream stream, const void* data, const size_t ammount) {
+    struct fwiSocketStream* nativeStream = {(struct fwiSocketStream*)stream};
+    if (ammount >= nativeStream->writeCapacity) {
+        return fwiSocketStreamWriteThrough(nativeStream, data, ammount);
+    }
+
+    const fwError ret = fwiSocketStreamReserve(nativeStream, ammount);
+    if (ret != fwErrorSuccess) {
+        return ret;
+    }
+    memcpy(nativeStream->write_p + nativeStream->writeEnd, data, ammount);
+    nativeStream->writeEnd += ammount;
+    return fwErrorSuccess;
+}
+
+fwError fwSocketStreamWriteFrame(const fwSocketStream stream, const uint8_t prefixSize,
+                                 const void* data, const size_t ammount) {
+    struct fwiSocketStream* nativeStream = {(struct fwiSocketStream*)stream};
+    if (!fwiSocketStreamPrefixValid(prefixSize) || prefixSize > nativeStream->writeCapacity ||
+        (prefixSize < 8 && (uint64_t)ammount >> (prefixSize * 8) != 0)) {
+        return fwErrorInvalidParameter;
+    }
+
+    uint8_t prefix[8] = {};
+    for (uint8_t i = 0; i < prefixSize; ++i) {
+        prefix[i] = (uint8_t)((uint64_t)ammount >> ((prefixSize - 1 - i) * 8));
+    }
+
+    // Prefix and frame are queued together so that a refused write leaves no half frame behind
+    const bool buffered = ammount <= nativeStream->writeCapacity - prefixSize;
+    const fwError ret = fwiSocketStreamReserve(nativeStream, buffered ? prefixSize + ammount :
+                                                                        prefixSize);
+    if (ret != fwErrorSuccess) {
+        return ret;
+    }
+    memcpy(nativeStream->write_p + nativeStream->writeEnd, prefix, prefixSize);
+    nativeStream->writeEnd += prefixSize;
+    if (!buffered) {
+        return fwiSocketStreamWriteThrough(nativeStream, data, ammount);
+    }
+    memcpy(nativeStream->write_p + nativeStream->writeEnd, data, ammount);
+    nativeStream->writeEnd += ammount;
+    return fwErrorSuccess;
+}
+
+static _Atomic(const struct fwiScanKernels*) scanKernels_s = nullptr;
+
+// Selecting twice is harmless, both threads end up with the same kernels
+static const struct fwiScanKernels* fwiScanGetKernels(void) {
+    const struct fwiScanKernels* kernels_p = scanKernels_s;
+    if (kernels_p == nullptr) {
+        kernels_p = fwiScanSelectKernels();
+        scanKernels_s = kernels_p;
+    }
+    return kernels_p;
+}
+
+fwError fwBufferFindByte(const void* buffer_p, const uint64_t size, const uint8_t byte,
+                         uint64_t* offset_p) {
+    // The memchr of the C library already compares a vector at a time
+    const uint8_t* found_p = size == 0 ? nullptr : memchr(buffer_p, byte, size);
+    *offset_p = found_p == nullptr ? size : (uint64_t)(found_p - (const uint8_t*)buffer_p);
+    return fwErrorSuccess;
+}
+
+fwError fwBufferFindAny(const void* buffer_p, const uint64_t size, const uint8_t* set_p,
+                        const uint32_t setSize, uint64_t* offset_p) {
+    if (setSize == 0) {
+        return fwErrorInvalidParameter;
+    }
+    if (size == 0) {
+        *offset_p = 0;
+        return fwErrorSuccess;
+    }
+
+    const struct fwiScanKernels* kernels_p = setSize > FWI_SCAN_VECTOR_SET ?
+                                             fwiScanScalarKernels() : fwiScanGetKernels();
+    *offset_p = kernels_p->findAny(buffer_p, size, set_p, setSize);
+    return fwErrorSuccess;
+}
+
+// Appends the end offsets of every record in the range, the array grows one slice at a time so
+// that sparse delimiters do not cost eight bytes of offsets per byte of buffer
+static fwError fwiBufferIndexScan(const struct fwiScanKernels* kernels_p, const uint8_t* data_p,
+                                  const uint64_t size, const uint8_t delimiter,
+                                  const uint64_t base, uint64_t** offsets_pp, uint64_t* count_p,
+                                  uint64_t* capacity_p) {
+    for (uint64_t position = 0; position < size; position += FWI_BUFFER_INDEX_SLICE) {
+        const uint64_t slice = size - position < FWI_BUFFER_INDEX_SLICE ? size - position :
+                                                                          FWI_BUFFER_INDEX_SLICE;
+        if (*capacity_p - *count_p < slice) {
+            const uint64_t capacity = *capacity_p * 2 > *count_p + slice ? *capacity_p * 2 :
+                                                                           *count_p + slice;
+            uint64_t* offsets_p = realloc(*offsets_pp, capacity * sizeof(uint64_t));
+            if (offsets_p == nullptr) {
+                return fwErrorOutOfMemory;
+            }
+            *offsets_pp = offsets_p;
+            *capacity_p = capacity;
+        }
+        *count_p += kernels_p->collect(data_p + position, slice, delimiter, base + position,
+                                       *offsets_pp + *count_p);
+    }
+    return fwErrorSuccess;
+}
+
+struct fwiBufferIndexChunk {
+    const struct fwiScanKernels* kernels_p;
+    const uint8_t* data_p;
+    uint64_t size;
+    uint64_t base;
+    uint64_t* offsets_p;
+    uint64_t count;
+    uint64_t capacity;
+    fwError error;
+    uint8_t delimiter;
+};
+
+static void fwiBufferIndexChunkJob(void* user_p) {
+    struct fwiBufferIndexChunk* chunk_p = user_p;
+    chunk_p->error = fwiBufferIndexScan(chunk_p->kernels_p, chunk_p->data_p, chunk_p->size,
+                                        chunk_p->delimiter, chunk_p->base, &chunk_p->offsets_p,
+                                        &chunk_p->count, &chunk_p->capacity);
+}
+
+// Chunks found their offsets on their own, they are only stitched together in order here
+static fwError fwiBufferIndexParallel(const struct fwiScanKernels* kernels_p, const uint8_t* data_p,
+                                      const uint64_t size, const uint8_t delimiter,
+                                      const uint32_t chunkCount, uint64_t** offsets_pp,
+                                      uint64_t* count_p, uint64_t* capacity_p) {
+    struct fwiBufferIndexChunk chunks[FWI_BUFFER_INDEX_CHUNKS_MAX];
+    fwJob jobs[FWI_BUFFER_INDEX_CHUNKS_MAX];
+    const uint64_t chunkSize = size / chunkCount;
+    for (uint32_t i = 0; i < chunkCount; i++) {
+        const uint64_t base = chunkSize * i;
+        chunks[i] = (struct fwiBufferIndexChunk){
+            .kernels_p = kernels_p,
+            .data_p    = data_p + base,
+            .size      = i + 1 == chunkCount ? size - base : chunkSize,
+            .base      = base,
+            .delimiter = delimiter
+        };
+        jobs[i] = (fwJob){.function = fwiBufferIndexChunkJob, .user_p = &chunks[i]};
+    }
+
+    // Without a counter or when the workers went away the chunks are simply scanned right here
+    fwJobCounter counter = 0;
+    if (fwJobCounterCreate(&counter) == fwErrorSuccess &&
+        fwJobSubmit(jobs, chunkCount, counter) == fwErrorSuccess) {
+        fwJobWait(counter);
+    } else {
+        for (uint32_t i = 0; i < chunkCount; i++) {
+            fwiBufferIndexChunkJob(&chunks[i]);
+        }
+    }
+    if (counter != 0) {
+        fwJobCounterDestroy(counter);
+    }
+
+    fwError ret = fwErrorSuccess;
+    uint64_t total = *count_p;
+    for (uint32_t i = 0; i < chunkCount; i++) {
+        if (chunks[i].error != fwErrorSuccess) {
+            ret = chunks[i].error;
+        }
+        total += chunks[i].count;
+    }
+    if (ret == fwErrorSuccess && total > *capacity_p) {
+        uint64_t* offsets_p = realloc(*offsets_pp, total * sizeof(uint64_t));
+        if (offsets_p == nullptr) {
+            ret = fwErrorOutOfMemory;
+        } else {
+            *offsets_pp = offsets_p;
+            *capacity_p = total;
+        }
+    }
+    for (uint32_t i = 0; i < chunkCount; i++) {
+        if (ret == fwErrorSuccess) {
+            memcpy(*offsets_pp + *count_p, chunks[i].offsets_p, chunks[i].count * sizeof(uint64_t));
+            *count_p += chunks[i].count;
+        }
+        free(chunks[i].offsets_p);
+    }
+    return ret;
+}
+
+fwError fwBufferIndexCreate(const void* buffer_p, const uint64_t size, const uint8_t delimiter,
+                            const uint8_t flags, struct fwBufferIndex* index_p) {
+    const struct fwiScanKernels* kernels_p = fwiScanGetKernels();
+    uint64_t capacity = 1;
+    uint64_t count = 1; // the first record starts at 0
+    uint64_t* offsets_p = malloc(sizeof(uint64_t));
+    if (offsets_p == nullptr) {
+        return fwErrorOutOfMemory;
+    }
+    offsets_p[0] = 0;
+
+    uint32_t chunkCount = 1;
+    uint32_t workers = 0;
+    if ((flags & fwBufferIndexFlagParallel) && size / FWI_BUFFER_INDEX_CHUNK_MIN > 1 &&
+        fwJobGetWorkerCount(&workers) == fwErrorSuccess) {
+        // A few chunks per thread so that one slow chunk does not hold up the rest
+        const uint64_t wanted = (uint64_t)(workers + 1) * 4;
+        chunkCount = (uint32_t)(size / FWI_BUFFER_INDEX_CHUNK_MIN < wanted ?
+                                size / FWI_BUFFER_INDEX_CHUNK_MIN : wanted);
+        if (chunkCount > FWI_BUFFER_INDEX_CHUNKS_MAX) {
+            chunkCount = FWI_BUFFER_INDEX_CHUNKS_MAX;
+        }
+    }
+
+    fwError ret = chunkCount > 1 ?
+        fwiBufferIndexParallel(kernels_p, buffer_p, size, delimiter, chunkCount, &offsets_p,
+                               &count, &capacity) :
+        fwiBufferIndexScan(kernels_p, buffer_p, size, delimiter, 0, &offsets_p, &count,
+                           &capacity);
+    if (ret != fwErrorSuccess) {
+        free(offsets_p);
+        return ret;
+    }
+
+    // An unterminated last record ends where its delimiter would have been
+    const bool terminated = offsets_p[count - 1] == size;
+    uint64_t* shrunk_p = realloc(offsets_p, (count + !terminated) * sizeof(uint64_t));
+    if (shrunk_p == nullptr && !terminated) {
+        free(offsets_p);
+        return fwErrorOutOfMemory;
+    }
+    offsets_p = shrunk_p == nullptr ? offsets_p : shrunk_p;
+    if (!terminated) {
+        offsets_p[count++] = size + 1;
+    }
+
+    *index_p = (struct fwBufferIndex){.offsets_p = offsets_p, .count = count - 1};
+    return fwErrorSuccess;
+}
+
+fwError fwBufferIndexDestroy(struct fwBufferIndex* index_p) {
+    free(index_p->offsets_p);
+    *index_p = (struct fwBufferIndex){};
+    return fwErrorSuccess;
+}
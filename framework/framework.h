@@ -32,6 +32,7 @@ typedef enum fwError : uint8_t {
 
     fwErrorFileUnableToOpen /*! Unable to open or correctly open the requested file */,
     fwErrorFileStats /*! Failed to retrieve file information */,
+    fwErrorFileMap /*! Failed to map the file into memory */,
 
     fwErrorSocketAddressInUse /*! This local address is already being used by another socket */,
     fwErrorSocketTargetName /*! Failed to resolve host / domain name */,
@@ -42,8 +43,22 @@ typedef enum fwError : uint8_t {
     fwErrorSocketListen /*! Failed to put a socket into the listening state */,
     fwErrorSocketAccept /*! Failed to accept a new connection */,
     fwErrorSocketNotBound /*! Could not listen on the socket since it was not bound */,
+    fwErrorSocketWouldBlock /*! The operation would block on a non-blocking socket */,
+    fwErrorSocketClosed /*! The peer closed the connection */,
+    fwErrorSocketFrame /*! A frame was malformed or larger than the stream buffer */,
+    fwErrorSocketTimeout /*! The operation did not complete before its timeout ran out */,
+
+    fwErrorEventLoop /*! The event loop could not be created or failed to wait for events */,
+
+    fwErrorIoQueue /*! The I/O queue could not be created or failed to submit to the kernel */,
+    fwErrorIoQueueFull /*! The I/O queue has no room for more operations until it is reaped */,
 
     fwErrorWindowConnect /*! Could not connect to the wayland server */,
+    fwErrorRenderBusy /*! Every buffer of the surface is still held by the compositor */,
+
+    fwErrorPermission /*! The process lacks the privilege the operation needs */,
+
+    fwErrorAudioDevice /*! The audio device could not be opened or does not support the format */,
 
     fwErrorGoodJob /*! You somehow caused a theoretically impossible failure */
 } fwError;
@@ -56,26 +71,80 @@ typedef enum fwModule : uint8_t {
     fwModuleWindow      = 0b0000'0001 /*! Module for windowed UI */,
     fwModuleRender      = 0b0000'0010 /*! Module for the renderer */,
     fwModuleNetwork     = 0b0000'0100 /*! Module for networking and sockets*/,
-    fwModuleMultimedia  = 0b0000'1000 /*! Module for multimedia like video and sound */
+    fwModuleMultimedia  = 0b0000'1000 /*! Module for multimedia like video and sound */,
+    fwModuleJob         = 0b0001'0000 /*! Module for the work-stealing job system */
 } fwModule;
 
 typedef enum fwModuleFlags : uint32_t {
     /*! Test */
-    fwModuleFlag        = 0b0000'0000'0000'0000'0000'0000'0000'0000
+    fwModuleFlag                 = 0b0000'0000'0000'0000'0000'0000'0000'0000,
+    /*! Network: create a default event loop, retrievable with @c fwEventLoopGetDefault */
+    fwModuleFlagNetworkEventLoop = 0b0000'0000'0000'0000'0000'0000'0000'0001,
+    /*! Network: enable the io_uring engine, see @c fwIoQueueGetDefault */
+    fwModuleFlagNetworkIoUring   = 0b0000'0000'0000'0000'0000'0000'0000'0010
 } fwModuleFlags;
 
+// Number of modules, which is also the number of bits a mask of fwModule can have set
+#define FW_MODULE_COUNT 5
+
 /**
  * @brief Starts a module of the framework.
  * @param module[in] Which module is supposed to be started
  * @param flags[in] Flags for the module, these may modify the behaviour of it
  * @return @c fwErrorSuccess No error occured
  * @return @c fwErrorInvalidParameter The provided module was not valid
+ * @note Starting a module that is already running does nothing, its flags stay as they were.
  */ // PlatIndepImp
 fwError fwStartModule(
     fwModule module,
     uint32_t flags
     );
 
+/**
+ * @brief Time every part of @c fwStartModules took, in nanoseconds.
+ * @param total The entire call
+ * @param base Starting the base module, 0 if it was running already
+ * @param modules Starting each module, indexed by the bit position of the module, 0 for modules
+ *                that were not started by the call
+ * @param warmup Resolving the warmup names after all modules came up
+ * @param errors Result of starting each module, indexed like @c modules
+ * @note The modules start concurrently, so their times add up to more than the total.
+ */
+typedef struct fwModuleStartStats {
+    uint64_t total;
+    uint64_t base;
+    uint64_t modules[FW_MODULE_COUNT];
+    uint64_t warmup;
+    fwError errors[FW_MODULE_COUNT];
+} fwModuleStartStats;
+
+struct fwSocketAddress; // defined with the socket functions
+
+/**
+ * @brief Starts several modules at once, the ones that do not depend on each other concurrently.
+ * @param modules[in] Mask of @c fwModule
+ * @param flags[in] Flags for the modules, see @c fwModuleFlags
+ * @param warmup_p[in] Names resolved into the resolver cache once all modules are up, only if the
+ *                     network module started, can be @c nullptr
+ * @param warmupCount[in] Number of entries in @c warmup_p
+ * @param stats_p[out] Filled with the time every part took, can be @c nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The mask contained bits that are no module
+ * @return The error of the first module, in the order of their bits, that failed to start, the
+ *         others keep running
+ * @note The window module connects to the display while the network module is set up and the job
+ *       workers are spawned, the render module waits for the window module. Modules that are
+ *       running already are skipped.
+ * @note A warmup name that cannot be resolved does not fail the call, it is only logged.
+ */ // PlatIndepImp
+fwError fwStartModules(
+    uint8_t modules,
+    uint32_t flags,
+    const struct fwSocketAddress* warmup_p,
+    uint32_t warmupCount,
+    struct fwModuleStartStats* stats_p
+    );
+
 /**
  * @brief Stops a module of the framework.
  * @param module[in] Which module is supposed to be stopped
@@ -94,21 +163,100 @@ void fwStopAllModules(
     void
     );
 
+/**
+ * @brief Configuration of the framework's logger.
+ * @param filename_p File that release builds, and builds with binary logging, append their log to,
+ *                   @c nullptr selects "lpaf.log" inside of the working directory
+ * @param flushInterval How often, in milliseconds, buffered messages are written out, 0 selects
+ *                      the default of 10 ms for debug and 250 ms for release builds
+ * @note Used as param for @c fwConfigureLogger.
+ */
+typedef struct fwLoggerConfiguration {
+    const char* filename_p;
+    uint32_t flushInterval;
+} fwLoggerConfiguration;
+
+/**
+ * @brief Configures how and where the framework writes its log.
+ * @param configuration_p[in] The new configuration, the filename is copied
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The configuration was @c nullptr or the filename is longer
+ *                                    than 255 characters
+ * @return @c fwErrorModule A module was already started, the logger is configured when the first
+ *                          module starts
+ * @note Messages are collected in per-thread buffers and written out by a background thread, a
+ *       thread that logs faster than the writer keeps up with drops messages instead of blocking.
+ */ // PlatIndepImp
+fwError fwConfigureLogger(
+    const struct fwLoggerConfiguration* configuration_p
+    );
+
+// Upper bounds of the topology that @c fwGetSystemConfiguration reports, CPUs and nodes beyond
+// them are left out
+#define FW_SYSTEM_CPUS_MAX 256
+#define FW_SYSTEM_NUMA_NODES_MAX 16
+
+/**
+ * @brief One NUMA node of the system.
+ * @param id Number of the node as the kernel knows it, numbering can have holes
+ * @param memory Physical memory attached to the node in @b MebbiByte
+ * @param cpuCount Number of online CPUs of the node
+ * @param cpus Bitmask of the online CPUs of the node, CPU @c n is bit @c n%64 of @c cpus[n/64]
+ */
+typedef struct fwSystemNumaNode {
+    uint16_t id;
+    uint64_t memory;
+    uint16_t cpuCount;
+    uint64_t cpus[FW_SYSTEM_CPUS_MAX / 64];
+} fwSystemNumaNode;
+
 /**
  * @brief Struct containing system configuration information.
  * @param memory Physical memory in @b MebbiByte
- * @param cores Online cores per socket
+ * @param memoryAvailable Memory that can be allocated without swapping in @b MebbiByte
+ * @param cores Online logical processors, SMT siblings count individually
+ * @param physicalCores Online physical cores across all sockets
+ * @param threadsPerCore SMT siblings per physical core
  * @param sockets Sockets with processors installed
+ * @param cacheLine Size of a cache line in bytes
+ * @param l1DataCache Size of the level 1 data cache of one core in bytes
+ * @param l1InstructionCache Size of the level 1 instruction cache of one core in bytes
+ * @param l2Cache Size of the level 2 cache of one core in bytes
+ * @param l3Cache Size of the level 3 cache of one socket in bytes, @c 0 without one
+ * @param pageSize Size of a regular page in bytes
+ * @param hugePageSize Size of a default huge page in bytes, @c 0 if the kernel has no support
+ * @param hugePagesFree Free pages of @c hugePageSize in the hugetlb pool
+ * @param transparentHugePages Transparent huge pages are enabled, always or through madvise
+ * @param numaNodeCount Number of valid entries in @c numaNodes
+ * @param numaNodes The NUMA nodes of the system, a system without NUMA reports one node
  * @note Used as param for @c fwGetSystemConfiguration.
  */
 typedef struct fwSystemConfiguration {
     uint64_t memory;
+    uint64_t memoryAvailable;
     uint16_t cores;
+    uint16_t physicalCores;
+    uint8_t threadsPerCore;
     uint8_t sockets;
+    uint16_t cacheLine;
+    uint32_t l1DataCache;
+    uint32_t l1InstructionCache;
+    uint32_t l2Cache;
+    uint32_t l3Cache;
+    uint32_t pageSize;
+    uint64_t hugePageSize;
+    uint64_t hugePagesFree;
+    bool transparentHugePages;
+    uint8_t numaNodeCount;
+    struct fwSystemNumaNode numaNodes[FW_SYSTEM_NUMA_NODES_MAX];
 } fwSystemConfiguration;
 
 /**
  * @brief Retrieves the system configuration.
+ * @param res_p[out] Filled with the configuration of the running system
+ * @return @c fwErrorSuccess No error occured
+ * @note The topology is read from sysfs, values that the system does not expose are reported as
+ *       @c 0 except for @c cores, @c memory and @c pageSize which always come from @c sysconf.
  */ // PlatDepImp
 fwError fwGetSystemConfiguration(
     struct fwSystemConfiguration* res_p
@@ -134,6 +282,308 @@ fwError fwLoadFileToMem(
     uint64_t* fileSize_p
     );
 
+/**
+ * @brief Access pattern hints for a file mapping, these never change the contents of the view.
+ * @note Used as parameter for @c fwMapFile .
+ */
+typedef enum fwFileMapHint : uint8_t {
+    fwFileMapHintNone       = 0b0000'0000 /*! Leave paging to the kernel defaults */,
+    fwFileMapHintSequential = 0b0000'0001 /*! Read front to back, aggressive read-ahead */,
+    fwFileMapHintRandom     = 0b0000'0010 /*! Accessed randomly, no read-ahead */,
+    fwFileMapHintWillNeed   = 0b0000'0100 /*! Start reading the entire file in the background */,
+    fwFileMapHintHugePage   = 0b0000'1000 /*! Back the view with huge pages where possible */
+} fwFileMapHint;
+
+/**
+ * @brief Maps an entire file read-only into memory without copying it.
+ * @param filename_p[in] Name of, or path to, the file
+ * @param hints[in] Mask of @c fwFileMapHint
+ * @param view_pp[out] Address of a pointer that will point to the first byte of the file
+ * @param fileSize_p[out] Size of the file and the view in bytes
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorFileUnableToOpen The file could not be opened, due to either permissions
+ *         or the file not existing
+ * @return @c fwErrorFileStats An I/O error occurs at syscall
+ * @return @c fwErrorFileMap The file could not be mapped
+ * @note Pages are loaded on first access and are shared with every other process mapping or
+ *       reading the same file. The view must be released with @c fwUnmapFile .
+ * @note An empty file results in a @c nullptr view of size 0.
+ */ // PlatDepImp
+fwError fwMapFile(
+    const char* filename_p,
+    uint8_t hints,
+    const void** view_pp,
+    uint64_t* fileSize_p
+    );
+
+/**
+ * @brief Releases a view created by @c fwMapFile .
+ * @param view_p[in] The view
+ * @param fileSize[in] Size that was returned together with the view
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The view was not a mapping
+ */ // PlatDepImp
+fwError fwUnmapFile(
+    const void* view_p,
+    uint64_t fileSize
+    );
+
+typedef uintptr_t fwFileReader;
+
+/**
+ * @brief Opens a file for streaming it front to back in chunks with constant memory.
+ * @param filename_p[in] Name of, or path to, the file
+ * @param chunkSize[in] Maximum size of one chunk in bytes, the reader allocates two of them
+ * @param reader_p[out] Identifier for the new reader
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The chunk size was 0
+ * @return @c fwErrorFileUnableToOpen The file could not be opened, due to either permissions
+ *         or the file not existing
+ * @return @c fwErrorOutOfMemory Out of memory
+ * @note While the caller works on one chunk the next one is already being read. With the io_uring
+ *       engine (see @c fwModuleFlagNetworkIoUring ) this happens asynchronously into the second
+ *       buffer, otherwise the kernel is told to read ahead into the page cache.
+ */ // PlatDepImp
+fwError fwFileReaderOpen(
+    const char* filename_p,
+    size_t chunkSize,
+    fwFileReader* reader_p
+    );
+
+/**
+ * @brief Retrieves the next chunk of the file.
+ * @param reader[in] Reader to advance
+ * @param chunk_pp[out] Address of a pointer that will point to the chunk
+ * @param chunkSize_p[out] Size of the chunk in bytes, 0 once the end of the file was reached
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorFileStats An I/O error occurs at syscall
+ * @note The chunk stays valid until the next call for the same reader. Chunks can be shorter than
+ *       the chunk size of the reader, not only at the end of the file.
+ */ // PlatDepImp
+fwError fwFileReaderNext(
+    fwFileReader reader,
+    const void** chunk_pp,
+    size_t* chunkSize_p
+    );
+
+/**
+ * @brief Closes the file and releases the buffers of a reader.
+ * @param reader[in] Reader to close
+ * @return @c fwErrorSuccess No error occured
+ */ // PlatDepImp
+fwError fwFileReaderClose(
+    fwFileReader reader
+    );
+
+/**
+ * @brief Handle to a cache of file contents, keyed by path.
+ */
+typedef uintptr_t fwFileCache;
+
+/**
+ * @brief Reference to the contents of one file in a cache, held until it is released.
+ */
+typedef uintptr_t fwFileCacheEntry;
+
+/**
+ * @brief Struct describing a file cache.
+ * @param budget Bytes of file contents the cache keeps, 0 selects 64 MiB
+ * @param mapThreshold Files of at least this size are mapped instead of copied, 0 always copies
+ * @param checkInterval Milliseconds cached contents are handed out without looking for changes,
+ *                      0 looks on every acquire
+ * @note Used as parameter for @c fwFileCacheCreate .
+ */
+typedef struct fwFileCacheConfiguration {
+    uint64_t budget;
+    uint64_t mapThreshold;
+    uint32_t checkInterval;
+} fwFileCacheConfiguration;
+
+/**
+ * @brief Counters of a file cache since it was created.
+ * @param hits Acquires that were served from the cache
+ * @param misses Acquires that had to load the file
+ * @param invalidations Entries that were dropped because their file changed
+ * @param evictions Entries that were dropped to stay within the budget
+ * @param entries Files currently cached
+ * @param bytes Size of the currently cached contents, can exceed the budget while entries are held
+ * @note Filled by @c fwFileCacheGetStats .
+ */
+typedef struct fwFileCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t invalidations;
+    uint64_t evictions;
+    uint64_t entries;
+    uint64_t bytes;
+} fwFileCacheStats;
+
+/**
+ * @brief Creates a new file cache.
+ * @param configuration_p[in] Description of the cache
+ * @param cache_p[out] The new cache
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The configuration was missing
+ * @return @c fwErrorOutOfMemory Out of memory
+ */ // PlatDepImp
+fwError fwFileCacheCreate(
+    const struct fwFileCacheConfiguration* configuration_p,
+    fwFileCache* cache_p
+    );
+
+/**
+ * @brief Destroys a file cache and releases the cached contents.
+ * @param cache[in] Cache to be destroyed
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter Entries of the cache are still held, the cache is kept
+ */ // PlatDepImp
+fwError fwFileCacheDestroy(
+    fwFileCache cache
+    );
+
+/**
+ * @brief Retrieves the contents of a file, loading it only if the cache has no current copy.
+ * @param cache[in] Cache to look in
+ * @param filename_p[in] Name of, or path to, the file, the same file under another name is cached
+ *                       separately
+ * @param entry_p[out] Reference to the contents, release it with @c fwFileCacheRelease
+ * @param data_pp[out] Address of a pointer that will point to the contents, @c nullptr for an
+ *                     empty file
+ * @param size_p[out] Size of the contents in bytes
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The name was missing
+ * @return @c fwErrorFileUnableToOpen The file could not be opened, due to either permissions
+ *         or the file not existing
+ * @return @c fwErrorFileStats An I/O error occurs at syscall
+ * @return @c fwErrorFileMap The file could not be mapped
+ * @return @c fwErrorOutOfMemory Out of memory
+ * @note The contents are shared with every other holder and must not be written. They stay the
+ *       same until released, even if the file is changed meanwhile, except for mapped files that
+ *       are written in place instead of being replaced.
+ * @note Changes are noticed through inotify, files that cannot be watched are checked with a
+ *       @c stat instead. Files that are not cached yet are loaded while the cache is locked.
+ */ // PlatDepImp
+fwError fwFileCacheAcquire(
+    fwFileCache cache,
+    const char* filename_p,
+    fwFileCacheEntry* entry_p,
+    const void** data_pp,
+    uint64_t* size_p
+    );
+
+/**
+ * @brief Releases a reference to cached contents.
+ * @param cache[in] Cache the entry was acquired from
+ * @param entry[in] The entry
+ * @return @c fwErrorSuccess No error occured
+ * @note Once no reference is left the entry becomes the newest candidate for eviction.
+ */ // PlatDepImp
+fwError fwFileCacheRelease(
+    fwFileCache cache,
+    fwFileCacheEntry entry
+    );
+
+/**
+ * @brief Retrieves the counters of a file cache.
+ * @param cache[in] Cache to query
+ * @param stats_p[out] Filled with the counters
+ * @return @c fwErrorSuccess No error occured
+ */ // PlatDepImp
+fwError fwFileCacheGetStats(
+    fwFileCache cache,
+    struct fwFileCacheStats* stats_p
+    );
+
+/**
+ * @brief Finds the first occurence of a byte in a buffer.
+ * @param buffer_p[in] Buffer to search, may be @c nullptr if the size is 0
+ * @param size[in] Size of the buffer in bytes
+ * @param byte[in] Byte to look for
+ * @param offset_p[out] Offset of the first occurence, @c size if the byte does not occur
+ * @return @c fwErrorSuccess No error occured
+ */ // PlatIndepImp
+fwError fwBufferFindByte(
+    const void* buffer_p,
+    uint64_t size,
+    uint8_t byte,
+    uint64_t* offset_p
+    );
+
+/**
+ * @brief Finds the first byte in a buffer that is one of a set, like a delimiter of a format.
+ * @param buffer_p[in] Buffer to search, may be @c nullptr if the size is 0
+ * @param size[in] Size of the buffer in bytes
+ * @param set_p[in] Bytes to look for
+ * @param setSize[in] Number of bytes in the set, at least 1
+ * @param offset_p[out] Offset of the first byte that is in the set, @c size if there is none
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The set was empty
+ * @note Sets of up to 16 bytes are compared 16 or 32 bytes of the buffer at a time, larger sets
+ *       are looked up one byte at a time in a table.
+ */ // PlatIndepImp
+fwError fwBufferFindAny(
+    const void* buffer_p,
+    uint64_t size,
+    const uint8_t* set_p,
+    uint32_t setSize,
+    uint64_t* offset_p
+    );
+
+/**
+ * @brief Offsets of the records of a buffer, for example of the lines of a file.
+ * @param offsets_p Array of @c count + 1 offsets, record @c i spans from @c offsets_p[i] up to
+ *                  but excluding the delimiter at @c offsets_p[i+1] - 1
+ * @param count Number of records, a delimiter at the very end does not start an empty record
+ * @note Filled by @c fwBufferIndexCreate .
+ */
+typedef struct fwBufferIndex {
+    uint64_t* offsets_p;
+    uint64_t count;
+} fwBufferIndex;
+
+/**
+ * @brief Flags changing how a buffer index is created.
+ * @note Used as parameter for @c fwBufferIndexCreate .
+ */
+typedef enum fwBufferIndexFlags : uint8_t {
+    fwBufferIndexFlagNone     = 0b0000'0000 /*! Scan on the calling thread */,
+    fwBufferIndexFlagParallel = 0b0000'0001 /*! Split large buffers across the job workers */
+} fwBufferIndexFlags;
+
+/**
+ * @brief Finds every delimiter of a buffer and stores where the records between them start.
+ * @param buffer_p[in] Buffer to index, may be @c nullptr if the size is 0
+ * @param size[in] Size of the buffer in bytes
+ * @param delimiter[in] Byte that ends a record, @c '\n' to index lines
+ * @param flags[in] Mask of @c fwBufferIndexFlags
+ * @param index_p[out] The index, release it with @c fwBufferIndexDestroy
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorOutOfMemory There was no memory for the offsets
+ * @note The last record does not need a delimiter, its end offset is then @c size + 1 so that every
+ *       record ends one byte before the next offset. An empty buffer has no records.
+ * @note With @c fwBufferIndexFlagParallel buffers of several MiB are scanned in chunks by the job
+ *       workers, without a running job module the flag is ignored.
+ */ // PlatIndepImp
+fwError fwBufferIndexCreate(
+    const void* buffer_p,
+    uint64_t size,
+    uint8_t delimiter,
+    uint8_t flags,
+    struct fwBufferIndex* index_p
+    );
+
+/**
+ * @brief Releases the offsets of a buffer index.
+ * @param index_p[in] Index created by @c fwBufferIndexCreate , it is reset to no records
+ * @return @c fwErrorSuccess No error occured
+ */ // PlatIndepImp
+fwError fwBufferIndexDestroy(
+    struct fwBufferIndex* index_p
+    );
+
+/**
+ * @brief Identifier of a socket, closed sockets are detected instead of being reused by accident.
+ */
 typedef uintptr_t fwSocket;
 
 /**
@@ -143,7 +593,7 @@ typedef uintptr_t fwSocket;
 typedef enum fwSocketAddressFamily : uint8_t {
     fwSocketAddressFamilyIPv4 /*! IPv4 internet address space */,
     fwSocketAddressFamilyIPv6 /*! IPv6 internet address space */,
-    fwSocketAddressFamilyLocal /*! Machine-local address space */, // TODO: implement local sockets
+    fwSocketAddressFamilyLocal /*! Machine-local address space, addresses are filesystem paths */,
 } fwSocketAddressFamily;
 
 /**
@@ -164,6 +614,10 @@ typedef enum fwSocketProtocol : uint8_t {
  * @return @c fwErrorSuccess No error occured
  * @return @c fwErrorInvalidParameter A value that does not correspond to an enumerated identifier
  *                                    was passed to @c sockCrtInf
+ * @return @c fwErrorModule The network module is not running
+ * @return @c fwErrorOutOfMemory As many sockets exist as the process may open file descriptors
+ * @return @c fwErrorPermission The process may not create such a socket, raw sockets for example
+ *                              need CAP_NET_RAW
  * @note See @c fwSocketAddressFamily for address families and @c fwSocketProtocol for protocols.
  */ // PlatDepImp
 fwError fwSocketCreate(
@@ -198,6 +652,9 @@ typedef struct fwSocketAddress {
  * @return @c fwErrorSuccess No error occured
  * @return @c fwErrorSocketTargetName Could not resolve the name of the target to an IP address
  * @return @c fwErrorSocketConnection Could not connect to the target
+ * @return @c fwErrorSocketWouldBlock The socket is non-blocking and the connection is still being
+ *         established, @c fwEventWrite is reported once it is done. Calling again reports how it
+ *         ended, without starting a new attempt.
  * @return @c fwErrorInvalidParameter Invalid enumerations in @c createInfo_p
  */ // PlatDepImp
 fwError fwSocketConnect(
@@ -205,6 +662,219 @@ fwError fwSocketConnect(
     const struct fwSocketAddress* connectInfo_p
     );
 
+/**
+ * @brief Connects a stream socket by racing the resolved addresses of both families against each
+ *        other, as described by RFC 8305 (Happy Eyeballs), and keeps the first one to succeed
+ * @param sfdop[in] Identifier for the socket that is supposed to be connected
+ * @param connectInfo_p[in] Information about where to connect the socket to
+ * @param timeout[in] Milliseconds until all attempts are given up, 0 waits as long as the
+ *                    attempts take
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket was not valid or is registered with an event loop
+ * @return @c fwErrorSocketTargetName Could not resolve the name of the target to an IP address
+ * @return @c fwErrorSocketConnection No attempt succeeded before the timeout
+ * @note A new attempt starts every 250 ms, or as soon as the previous one failed, so a dead address
+ *       costs 250 ms instead of a full SYN timeout.
+ * @note The address family of the socket may change to the one that won. Datagram and local
+ *       sockets are connected like with @c fwSocketConnect .
+ * @note Options set through @c fwSocketConfigure and zero-copy sends carry over to the descriptor
+ *       that won, except for TCP fast open.
+ */ // PlatDepImp
+fwError fwSocketConnectParallel(
+    fwSocket sfdop,
+    const struct fwSocketAddress* connectInfo_p,
+    uint32_t timeout
+    );
+
+/**
+ * @brief Connects a socket like @c fwSocketConnect , but gives up once a deadline passed
+ * @param sfdop[in] Identifier for the socket that is supposed to be connected
+ * @param connectInfo_p[in] Information about where to connect the socket to
+ * @param timeout[in] Milliseconds all addresses together may take, 0 waits as long as the
+ *                    attempts take
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket passed was not valid
+ * @return @c fwErrorSocketTargetName Could not resolve the name of the target to an IP address
+ * @return @c fwErrorSocketConnection Every address refused the connection
+ * @return @c fwErrorSocketTimeout The deadline passed while a handshake was still in flight, the
+ *                                 attempt is aborted and the socket can be connected again
+ * @note Works on blocking and non-blocking sockets alike, the socket keeps its mode.
+ */ // PlatDepImp
+fwError fwSocketConnectTimeout(
+    fwSocket sfdop,
+    const struct fwSocketAddress* connectInfo_p,
+    uint32_t timeout
+    );
+
+/**
+ * @brief Struct describing how long the resolver keeps results.
+ * @param ttl Milliseconds a successful lookup is reused, 0 selects the default of one minute
+ * @param negativeTtl Milliseconds a failed lookup is reported without asking again, 0 disables
+ *                    negative caching
+ * @note Used as param for @c fwResolverConfigure.
+ */
+typedef struct fwResolverConfiguration {
+    uint32_t ttl;
+    uint32_t negativeTtl;
+} fwResolverConfiguration;
+
+/**
+ * @brief Changes the lifetimes of resolver cache entries, entries that exist keep theirs.
+ * @param configuration_p[in] The new configuration
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The configuration was @c nullptr
+ * @note The connect functions resolve names through a cache that is shared by all sockets,
+ *       concurrent lookups of the same name wait for one query instead of issuing their own.
+ *       @c getaddrinfo does not report record TTLs, so entries live as long as configured here.
+ */ // PlatDepImp
+fwError fwResolverConfigure(
+    const struct fwResolverConfiguration* configuration_p
+    );
+
+/**
+ * @brief Starts resolving names on the job system without waiting for the results.
+ * @param addresses_p[in] Names and ports to resolve
+ * @param count[in] Number of entries in @c addresses_p
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorModule The job module is not running
+ * @return @c fwErrorInvalidParameter The addresses were @c nullptr
+ * @note Names that are cached or already being resolved are skipped. A connect to a name that is
+ *       still being resolved waits for that lookup.
+ */ // PlatDepImp
+fwError fwResolverPrefetch(
+    const struct fwSocketAddress* addresses_p,
+    uint32_t count
+    );
+
+/**
+ * @brief Resolves names into the cache and waits until all of them are done, meant for startup.
+ * @param addresses_p[in] Names and ports to resolve
+ * @param count[in] Number of entries in @c addresses_p
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The addresses were @c nullptr
+ * @return @c fwErrorSocketTargetName At least one name could not be resolved, the others are
+ *                                    cached regardless
+ * @note The lookups run in parallel on the job system if it is running, one after the other
+ *       otherwise.
+ */ // PlatDepImp
+fwError fwResolverWarmup(
+    const struct fwSocketAddress* addresses_p,
+    uint32_t count
+    );
+
+/**
+ * @brief Drops every cached lookup, lookups that are in progress still complete.
+ * @return @c fwErrorSuccess No error occured
+ */ // PlatDepImp
+fwError fwResolverFlush(
+    void
+    );
+
+/**
+ * @brief Handle to a pool of idle outbound connections.
+ */
+typedef uintptr_t fwConnectionPool;
+
+/**
+ * @brief Struct describing a connection pool.
+ * @param addressFamily Family new sockets are created with, connects may still switch to the
+ *                      other one if it answers first
+ * @param maxIdle Idle connections kept per target and shard, 0 selects 8
+ * @param maxIdleTime Milliseconds an idle connection is kept, 0 selects 30 seconds
+ * @param maxAge Milliseconds after the connect a connection is no longer reused, 0 for no limit
+ * @param connectTimeout Milliseconds new connections may take, 0 waits as long as the attempts
+ *                       take
+ * @param shards Number of independently locked shards, threads are spread over them, 0 selects
+ *               one per processor
+ * @note Used as parameter for @c fwConnectionPoolCreate.
+ */
+typedef struct fwConnectionPoolConfiguration {
+    enum fwSocketAddressFamily addressFamily;
+    uint32_t maxIdle;
+    uint32_t maxIdleTime;
+    uint32_t maxAge;
+    uint32_t connectTimeout;
+    uint32_t shards;
+} fwConnectionPoolConfiguration;
+
+/**
+ * @brief Creates a new connection pool.
+ * @param configuration_p[in] Description of the pool
+ * @param pool_p[out] The new pool
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The configuration was missing or the family was not valid
+ * @return @c fwErrorOutOfMemory The shards could not be allocated
+ */ // PlatDepImp
+fwError fwConnectionPoolCreate(
+    const struct fwConnectionPoolConfiguration* configuration_p,
+    fwConnectionPool* pool_p
+    );
+
+/**
+ * @brief Destroys a connection pool and closes its idle connections.
+ * @param pool[in] Pool to be destroyed
+ * @return @c fwErrorSuccess No error occured
+ * @note Connections that are checked out have to be released or closed before.
+ */ // PlatDepImp
+fwError fwConnectionPoolDestroy(
+    fwConnectionPool pool
+    );
+
+/**
+ * @brief Checks out a connected stream socket to the given target, reusing an idle one if the
+ *        pool has a healthy one.
+ * @param pool[in] Pool to take the connection from
+ * @param address_p[in] Target and port of the connection
+ * @param socket_p[out] The connected socket
+ * @param reused_p[out] Whether the socket was taken from the pool, can be nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The address was missing
+ * @return @c fwErrorSocketTargetName Could not resolve the name of the target to an IP address
+ * @return @c fwErrorSocketConnection No idle connection was available and connecting failed
+ * @note Idle connections that were closed by the peer, have unread data, are older than the
+ *       configured limits or report a socket error are closed instead of being returned. The
+ *       shard of the calling thread is searched first, the others are only searched if their lock
+ *       is free.
+ * @note Even a checked connection can be closed by the peer right after the check, callers that
+ *       receive a reused connection should retry once on a fresh one if the first request fails.
+ */ // PlatDepImp
+fwError fwConnectionPoolAcquire(
+    fwConnectionPool pool,
+    const struct fwSocketAddress* address_p,
+    fwSocket* socket_p,
+    bool* reused_p
+    );
+
+/**
+ * @brief Returns a connection that was checked out of a pool.
+ * @param pool[in] Pool the connection was taken from
+ * @param socket[in] The connection
+ * @param reusable[in] False if the connection is in an unknown state, for example after an
+ *                     error or a response that was not read completely, it is closed then
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket was not valid or did not come from a pool
+ * @note The connection is also closed if its shard already holds the maximum of idle
+ *       connections to the target or it is older than the maximum age.
+ */ // PlatDepImp
+fwError fwConnectionPoolRelease(
+    fwConnectionPool pool,
+    fwSocket socket,
+    bool reusable
+    );
+
+/**
+ * @brief Closes idle connections that exceeded the idle time or the maximum age.
+ * @param pool[in] Pool to be pruned
+ * @param closed_p[out] Number of connections that were closed, can be nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @note Expired connections are also dropped on checkout, pruning only matters for targets that
+ *       are no longer used, so calling it every few seconds is plenty.
+ */ // PlatDepImp
+fwError fwConnectionPoolPrune(
+    fwConnectionPool pool,
+    uint32_t* closed_p
+    );
+
 /**
  * @brief Binds a socket to a local interface and port number
  * @param sfdop[in] Socket that is supposed to be bound
@@ -217,6 +887,46 @@ fwError fwSocketBind(
     const struct fwSocketAddress* localAddress
     );
 
+/**
+ * @brief Puts a bound stream socket into the listening state
+ * @param sfdop[in] Socket that is supposed to accept connections
+ * @param backlog[in] Connections the kernel queues before refusing new ones, 0 or less selects
+ *                    the system maximum
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket passed was not valid
+ * @return @c fwErrorSocketNotBound The socket was not bound
+ * @return @c fwErrorSocketListen The system call, marking the socket as listening, failed
+ * @note Calling this again on a listening socket changes its backlog.
+ */ // PlatDepImp
+fwError fwSocketListen(
+    fwSocket sfdop,
+    int32_t backlog
+    );
+
+/**
+ * @brief Creates a group of listening sockets that share one address through @c SO_REUSEPORT,
+ *        the kernel gives each of them its own accept queue
+ * @param addressFamily[in] Address family of the sockets
+ * @param localAddress[in] Address all sockets are bound to
+ * @param shards[in] Number of sockets to create, usually one per worker or event loop
+ * @param backlog[in] Backlog of each socket, see @c fwSocketListen
+ * @param sockets_p[out] Receives @c shards sockets, all of them non-blocking
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter No shards were requested or a pointer was @c nullptr
+ * @return @c fwErrorSocketBind A socket could not be bound, no sockets are left open
+ * @return @c fwErrorSocketListen A socket could not be put into the listening state
+ * @note New connections go to the shard with the index of the CPU that received them modulo
+ *       @c shards . With one shard per core and each shard served from a thread pinned to that
+ *       core, a connection is handled where its packets arrive.
+ */ // PlatDepImp
+fwError fwSocketListenSharded(
+    enum fwSocketAddressFamily addressFamily,
+    const struct fwSocketAddress* localAddress,
+    uint32_t shards,
+    int32_t backlog,
+    fwSocket* sockets_p
+    );
+
 /**
  * @brief Waits for, and then accepts an incoming connection on a socket
  * @param sfdop[in] Socket that will be handeling the incomming connection
@@ -226,8 +936,12 @@ fwError fwSocketBind(
  * @return @c fwErrorOutOfMemory Out of memory
  * @return @c fwErrorSocketNotBound The socket that is supposed to handle the incomming
  *                                  connection was not bound
- * @return @c fwErrorSocketListen The system call, marking the socket as listening, failed
+ * @return @c fwErrorSocketListen The socket was not listening yet and could not be put into the
+ *                                listening state
  * @return @c fwErrorSocketAccept Failed to accept the new connection
+ * @return @c fwErrorSocketWouldBlock The socket is non-blocking and no connection is pending
+ * @note A socket that was not passed to @c fwSocketListen before is put into the listening state
+ *       with the default backlog on the first call.
  * @note The reason why using one socket to accept the connection and then spawning another, is to
  *       re-use the old socket to accept more connections. Each new socket spawned is the connected
  *       state, such that it can immediatly be used to interact with the peer.
@@ -242,36 +956,464 @@ fwError fwSocketAccept(
     char* foreignAddress
     );
 
+/**
+ * @brief Accepts an incoming connection like @c fwSocketAccept , but waits at most until a
+ *        deadline
+ * @param sfdop[in] Socket that will be handeling the incomming connection
+ * @param newSocket[out] New socket created from the connection
+ * @param foreignAddress[out] Address of the peer that opened the connection, may be @c nullptr
+ * @param timeout[in] Milliseconds to wait for a connection, 0 waits indefinitely
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket passed was not valid
+ * @return @c fwErrorSocketTimeout No connection arrived before the deadline
+ * @return The errors of @c fwSocketAccept
+ * @note A blocking socket shared by several accepting threads may still wait past the deadline,
+ *       when another thread takes the connection this one was woken for.
+ */ // PlatDepImp
+fwError fwSocketAcceptTimeout(
+    fwSocket sfdop,
+    fwSocket* newSocket,
+    char* foreignAddress,
+    uint32_t timeout
+    );
+
+/**
+ * @brief Accepts every pending connection on a socket up to a limit, without waiting
+ * @param sfdop[in] Listening socket
+ * @param sockets_p[out] Receives the new sockets, all of them non-blocking
+ * @param count[in] Capacity of @c sockets_p
+ * @param accepted_p[out] Number of sockets that were accepted, may be @c nullptr
+ * @return @c fwErrorSuccess At least one connection was accepted
+ * @return @c fwErrorInvalidParameter The socket passed was not valid
+ * @return @c fwErrorSocketNotBound The socket was not bound
+ * @return @c fwErrorSocketWouldBlock No connection was pending
+ * @return @c fwErrorSocketAccept Failed to accept a connection
+ * @note Meant to be called when an event loop reports the listener as readable, draining the
+ *       whole queue takes one wakeup instead of one per connection.
+ */ // PlatDepImp
+fwError fwSocketAcceptBatch(
+    fwSocket sfdop,
+    fwSocket* sockets_p,
+    uint32_t count,
+    uint32_t* accepted_p
+    );
+
 /**
  * @brief Sends data over a connected socket.
  * @param sfdop[in] Socket that is supposed to send the data
  * @param data[in] Buffer containing the data
  * @param ammount[in] Number of bytes that are supposed to be sent
+ * @param sent_p[out] Number of bytes that were actually sent, may be @c nullptr
  * @return @c fwErrorSuccess No error occured
  * @return @c fwErrorSocketSend Failed to send data
+ * @return @c fwErrorSocketWouldBlock The socket is non-blocking and its send buffer is full
  * @note Passing an identifier to a socket that is not connected or one that operates over a
  *       connection-less protocol will cause failure.
+ * @note On a non-blocking socket fewer than @c ammount bytes may be sent, check @c sent_p .
  */ // PlatDepImp
 fwError fwSocketSend(
     fwSocket sfdop,
     const void* data,
-    size_t ammount
+    size_t ammount,
+    size_t* sent_p
     );
 
 /**
- * @brief Receives data over a connected socket.
- * @param sfdop[in] Socket that is supposed the receive the data
- * @param buffer[in] Destination buffer
- * @param ammount[in] Maximum ammount of bytes the call is allowed to write to @c buffer
+ * @brief Sends part of an open file over a connected socket without copying it through user
+ *        memory.
+ * @param sfdop[in] Socket that is supposed to send the data
+ * @param fileHandle[in] Handle of a file that was opened for reading, a file descriptor on Linux
+ * @param offset[in] Position in the file to start at, the position of the handle is not changed
+ * @param length[in] Number of bytes to send, 0 sends everything up to the end of the file
+ * @param sent_p[out] Number of bytes that were actually sent, may be @c nullptr
  * @return @c fwErrorSuccess No error occured
- * @return @c fwErrorSocketReceive Failed to receive data
- * @note Passing an identifier to a socket that is not connected or one that operates over a
- *       connection-less protocol will cause failure.
+ * @return @c fwErrorInvalidParameter The socket or the file handle was not valid, or the handle
+ *                                    is not seekable like a pipe
+ * @return @c fwErrorFileStats The size of the file could not be determined
+ * @return @c fwErrorSocketSend Failed to send the data
+ * @return @c fwErrorSocketWouldBlock The socket is non-blocking and its send buffer is full
+ * @note Uses @c sendfile, which moves pages from the page cache straight to the socket. Files
+ *       that do not support that are moved through a pipe with @c splice instead.
+ * @note On a non-blocking socket fewer than @c length bytes may be sent, continue at
+ *       @c offset + @c *sent_p once the socket is writable again.
  */ // PlatDepImp
-fwError fwSocketReceive(
+fwError fwSocketSendFileHandle(
+    fwSocket sfdop,
+    intptr_t fileHandle,
+    uint64_t offset,
+    uint64_t length,
+    uint64_t* sent_p
+    );
+
+/**
+ * @brief Opens a file and sends part of it over a connected socket, see
+ *        @c fwSocketSendFileHandle .
+ * @param sfdop[in] Socket that is supposed to send the data
+ * @param filename_p[in] Name of, or path to, the file
+ * @param offset[in] Position in the file to start at
+ * @param length[in] Number of bytes to send, 0 sends everything up to the end of the file
+ * @param sent_p[out] Number of bytes that were actually sent, may be @c nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorFileUnableToOpen The file could not be opened
+ * @return Any error of @c fwSocketSendFileHandle
+ */ // PlatDepImp
+fwError fwSocketSendFile(
+    fwSocket sfdop,
+    const char* filename_p,
+    uint64_t offset,
+    uint64_t length,
+    uint64_t* sent_p
+    );
+
+/**
+ * @brief Reported by @c fwSocketSendZeroCopy for sends that were copied, their buffer can be
+ *        reused right away.
+ */
+#define FW_SOCKET_ZEROCOPY_NONE UINT32_MAX
+
+/**
+ * @brief Called once the kernel let go of the buffers of a range of zero-copy sends.
+ * @param sfdop[in] Socket the data was sent over
+ * @param first[in] Identifier of the first send whose buffer can be reused
+ * @param last[in] Identifier of the last send whose buffer can be reused, inclusive
+ * @param copied[in] The kernel copied the data after all, for example over loopback, a hint that
+ *                   zero-copy does not pay off for this socket
+ * @param user_p[in] Pointer that was passed to @c fwSocketEnableZeroCopy
+ */
+typedef void (*fwSocketZeroCopyCallback)(
+    fwSocket sfdop,
+    uint32_t first,
+    uint32_t last,
+    bool copied,
+    void* user_p
+    );
+
+/**
+ * @brief Allows zero-copy sends on a stream socket.
+ * @param sfdop[in] Socket to be modified
+ * @param threshold[in] Sends smaller than this are copied as usual, 0 selects 16 KiB
+ * @param callback[in] Receives the completion notifications
+ * @param user_p[in] Passed to the callback, may be @c nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket passed was not valid or the callback was @c nullptr
+ * @return @c fwErrorUnimplemented The kernel or the socket type does not support zero-copy
+ * @note Notifications are delivered by the event loop the socket is registered with, before the
+ *       event callback is called, or by @c fwSocketReapZeroCopy .
+ */ // PlatDepImp
+fwError fwSocketEnableZeroCopy(
+    fwSocket sfdop,
+    size_t threshold,
+    fwSocketZeroCopyCallback callback,
+    void* user_p
+    );
+
+/**
+ * @brief Sends data without copying it into the kernel, the pages of the buffer are sent from
+ *        directly. The buffer must not be modified until its send was reported as complete.
+ * @param sfdop[in] Socket that is supposed to send the data
+ * @param data[in] Buffer containing the data
+ * @param ammount[in] Number of bytes that are supposed to be sent
+ * @param sent_p[out] Number of bytes that were actually sent, may be @c nullptr
+ * @param id_p[out] Identifier of the send in the completion notifications, or
+ *                  @c FW_SOCKET_ZEROCOPY_NONE if the data was copied
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket passed was not valid
+ * @return @c fwErrorSocketSend Failed to send the data
+ * @return @c fwErrorSocketWouldBlock The send buffer is full or too much memory is pinned by sends
+ *                                    that were not reaped yet
+ * @note Without @c fwSocketEnableZeroCopy this behaves like @c fwSocketSend .
+ */ // PlatDepImp
+fwError fwSocketSendZeroCopy(
+    fwSocket sfdop,
+    const void* data,
+    size_t ammount,
+    size_t* sent_p,
+    uint32_t* id_p
+    );
+
+/**
+ * @brief Delivers pending zero-copy notifications of a socket to its callback, for sockets that
+ *        are not registered with an event loop.
+ * @param sfdop[in] Socket to be reaped
+ * @param reaped_p[out] Number of notifications that were delivered, may be @c nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket was not valid or zero-copy was not enabled
+ */ // PlatDepImp
+fwError fwSocketReapZeroCopy(
+    fwSocket sfdop,
+    uint32_t* reaped_p
+    );
+
+/**
+ * @brief Receives data over a connected socket.
+ * @param sfdop[in] Socket that is supposed the receive the data
+ * @param buffer[in] Destination buffer
+ * @param ammount[in] Maximum ammount of bytes the call is allowed to write to @c buffer
+ * @param received_p[out] Number of bytes that were written to @c buffer , may be @c nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorSocketReceive Failed to receive data
+ * @return @c fwErrorSocketWouldBlock The socket is non-blocking and no data is available
+ * @note Passing an identifier to a socket that is not connected or one that operates over a
+ *       connection-less protocol will cause failure.
+ * @note A received byte count of zero means that the peer has closed the connection.
+ */ // PlatDepImp
+fwError fwSocketReceive(
     fwSocket sfdop,
     void* buffer,
-    size_t ammount
+    size_t ammount,
+    size_t* received_p
+    );
+
+/**
+ * @brief One contiguous piece of memory taking part in a scatter-gather transfer.
+ * @param data_p Start of the memory
+ * @param size Size of the memory in bytes
+ * @note Used as parameter for @c fwSocketSendv , @c fwSocketReceivev and @c fwSocketDatagram .
+ */
+typedef struct fwSocketBuffer {
+    void* data_p;
+    size_t size;
+} fwSocketBuffer;
+
+/**
+ * @brief Sends the contents of multiple buffers, in order, with a single syscall.
+ * @param sfdop[in] Socket that is supposed to send the data
+ * @param buffers_p[in] Array of buffers, for example a header followed by a payload
+ * @param count[in] Number of elements in @c buffers_p
+ * @param sent_p[out] Number of bytes that were actually sent, may be @c nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorSocketSend Failed to send data
+ * @return @c fwErrorSocketWouldBlock The socket is non-blocking and its send buffer is full
+ * @note On a datagram socket all buffers together form a single datagram.
+ */ // PlatDepImp
+fwError fwSocketSendv(
+    fwSocket sfdop,
+    const fwSocketBuffer* buffers_p,
+    uint32_t count,
+    size_t* sent_p
+    );
+
+/**
+ * @brief Receives data and distributes it, in order, across multiple buffers with a single
+ *        syscall.
+ * @param sfdop[in] Socket that is supposed to receive the data
+ * @param buffers_p[in] Array of destination buffers, each one is filled before the next one
+ * @param count[in] Number of elements in @c buffers_p
+ * @param received_p[out] Number of bytes that were received in total, may be @c nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorSocketReceive Failed to receive data
+ * @return @c fwErrorSocketWouldBlock The socket is non-blocking and no data is available
+ */ // PlatDepImp
+fwError fwSocketReceivev(
+    fwSocket sfdop,
+    const fwSocketBuffer* buffers_p,
+    uint32_t count,
+    size_t* received_p
+    );
+
+/**
+ * @brief A single datagram of a batched transfer.
+ * @param buffer Memory holding, or receiving, the datagram
+ * @param transferred Bytes of the datagram that were sent or received
+ * @note Used as parameter for @c fwSocketSendBatch and @c fwSocketReceiveBatch .
+ */
+typedef struct fwSocketDatagram {
+    fwSocketBuffer buffer;
+    size_t transferred;
+} fwSocketDatagram;
+
+/**
+ * @brief Sends many datagrams over a connected datagram socket with as few syscalls as possible.
+ * @param sfdop[in] Socket of protocol @c fwSocketProtocolDatagram
+ * @param datagrams_p[in,out] Datagrams to send, @c transferred is filled in
+ * @param count[in] Number of elements in @c datagrams_p
+ * @param sent_p[out] Number of datagrams that were sent, may be @c nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket does not use the datagram protocol
+ * @return @c fwErrorSocketSend Failed to send data
+ * @return @c fwErrorSocketWouldBlock The socket is non-blocking and not a single datagram fit
+ *         into the send buffer
+ */ // PlatDepImp
+fwError fwSocketSendBatch(
+    fwSocket sfdop,
+    fwSocketDatagram* datagrams_p,
+    uint32_t count,
+    uint32_t* sent_p
+    );
+
+/**
+ * @brief Receives as many queued datagrams as possible, waiting only for the first one.
+ * @param sfdop[in] Socket of protocol @c fwSocketProtocolDatagram
+ * @param datagrams_p[in,out] Buffers the datagrams are written to, @c transferred is filled in
+ * @param count[in] Number of elements in @c datagrams_p
+ * @param received_p[out] Number of datagrams that were received, may be @c nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket does not use the datagram protocol
+ * @return @c fwErrorSocketReceive Failed to receive data
+ * @return @c fwErrorSocketWouldBlock The socket is non-blocking and no datagram is available
+ * @note Datagrams larger than their buffer are truncated.
+ */ // PlatDepImp
+fwError fwSocketReceiveBatch(
+    fwSocket sfdop,
+    fwSocketDatagram* datagrams_p,
+    uint32_t count,
+    uint32_t* received_p
+    );
+
+/**
+ * @brief Switches a socket between blocking and non-blocking operation.
+ * @param sfdop[in] Socket to be modified
+ * @param nonBlocking[in] If calls on the socket should return @c fwErrorSocketWouldBlock instead
+ *                        of waiting
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket passed was not valid
+ * @note Sockets registered with an event loop are switched to non-blocking automatically.
+ */ // PlatDepImp
+fwError fwSocketSetNonBlocking(
+    fwSocket sfdop,
+    bool nonBlocking
+    );
+
+/**
+ * @brief Bundles of socket options for common workloads.
+ * @note Used as parameter for @c fwSocketConfigure.
+ */
+typedef enum fwSocketPreset : uint8_t {
+    fwSocketPresetDefault /*! The system defaults, only the overrides are applied */,
+    fwSocketPresetLowLatency /*! TCP_NODELAY, TCP_QUICKACK, 50 us of SO_BUSY_POLL and 64 KiB
+                                 buffers, for request-response traffic */,
+    fwSocketPresetThroughput /*! TCP_CORK, TCP_FASTOPEN and 4 MiB buffers, for bulk transfers */
+} fwSocketPreset;
+
+/**
+ * @brief Selects the fields of @c fwSocketOptions that replace the value of the preset.
+ */
+typedef enum fwSocketOption : uint32_t {
+    fwSocketOptionNoDelay = 0b0000'0001,
+    fwSocketOptionQuickAck = 0b0000'0010,
+    fwSocketOptionCork = 0b0000'0100,
+    fwSocketOptionFastOpen = 0b0000'1000,
+    fwSocketOptionSendBuffer = 0b0001'0000,
+    fwSocketOptionReceiveBuffer = 0b0010'0000,
+    fwSocketOptionBusyPoll = 0b0100'0000
+} fwSocketOption;
+
+/**
+ * @brief Struct describing the options of a socket.
+ * @param preset Preset that provides every value that is not overridden
+ * @param overrides Combination of @c fwSocketOption, the selected fields are used instead of the
+ *                  values of the preset
+ * @param noDelay Send segments immediately instead of collecting small writes (TCP_NODELAY)
+ * @param quickAck Acknowledge segments immediately instead of delaying the ACK (TCP_QUICKACK)
+ * @param cork Only send full segments until @c fwSocketFlush is called or 200 ms passed (TCP_CORK)
+ * @param fastOpen Send data with the SYN of connections to known peers and accept such data on
+ *                 listeners (TCP_FASTOPEN), has to be set before connecting or listening
+ * @param sendBuffer Size of the kernel send buffer in bytes, negative for the system default
+ * @param receiveBuffer Size of the kernel receive buffer in bytes, negative for the system default
+ * @param busyPoll Microseconds a blocking receive spins on the device queue before sleeping
+ *                 (SO_BUSY_POLL), negative for the system default
+ * @note Used as parameter for @c fwSocketConfigure.
+ */
+typedef struct fwSocketOptions {
+    fwSocketPreset preset;
+    uint32_t overrides;
+    bool noDelay;
+    bool quickAck;
+    bool cork;
+    bool fastOpen;
+    int32_t sendBuffer;
+    int32_t receiveBuffer;
+    int32_t busyPoll;
+} fwSocketOptions;
+
+/**
+ * @brief Applies a preset of socket options, with individual overrides, to a socket.
+ * @param sfdop[in] Socket to be configured
+ * @param options_p[in] The preset and overrides
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket or the preset was not valid
+ * @return @c fwErrorPermission A busy poll time was overridden explicitly but needs CAP_NET_ADMIN,
+ *                              the other options were applied regardless
+ * @return @c fwErrorUnimplemented At least one option was refused, the other options were applied
+ *                                 regardless
+ * @note The busy poll time of a preset is applied on a best-effort basis, without CAP_NET_ADMIN it
+ *       is only logged.
+ * @note TCP options are skipped for other protocols. Buffer sizes are doubled by the kernel to
+ *       make room for its bookkeeping.
+ */ // PlatDepImp
+fwError fwSocketConfigure(
+    fwSocket sfdop,
+    const struct fwSocketOptions* options_p
+    );
+
+/**
+ * @brief Sends data that a corked socket is holding back right away.
+ * @param sfdop[in] Socket to be flushed
+ * @return @c fwErrorSuccess No error occured, also if the socket was not corked
+ * @return @c fwErrorInvalidParameter The socket passed was not valid
+ */ // PlatDepImp
+fwError fwSocketFlush(
+    fwSocket sfdop
+    );
+
+/**
+ * @brief Number of buckets in the latency histograms of @c fwSocketStats .
+ */
+#define FW_SOCKET_LATENCY_BUCKETS 32
+
+/**
+ * @brief Struct containing I/O counters of a socket, or of all sockets.
+ * @param bytesSent Bytes that were handed to the kernel
+ * @param bytesReceived Bytes that were received
+ * @param syscalls Send and receive calls that were made into the kernel
+ * @param shortWrites Sends that transferred less than was requested
+ * @param shortReads Receives that returned less than the buffer could hold
+ * @param wouldBlock Calls on non-blocking sockets that returned @c fwErrorSocketWouldBlock
+ * @param errors Calls that failed for any other reason
+ * @param sendLatency Histogram of send calls, bucket n counts calls that took at least 2^n and
+ *                    less than 2^(n + 1) nanoseconds, the last bucket also counts anything slower
+ * @param receiveLatency Histogram of receive calls, laid out like @c sendLatency
+ * @note Used as param for @c fwSocketGetStats and @c fwSocketGetGlobalStats. Only every 16th call
+ *       is timed to keep clock reads off the hot path, so the histograms are a sample.
+ *       Completions of an @c fwIoQueue count bytes, short transfers and errors but no syscalls.
+ */
+typedef struct fwSocketStats {
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+    uint64_t syscalls;
+    uint64_t shortWrites;
+    uint64_t shortReads;
+    uint64_t wouldBlock;
+    uint64_t errors;
+    uint64_t sendLatency[FW_SOCKET_LATENCY_BUCKETS];
+    uint64_t receiveLatency[FW_SOCKET_LATENCY_BUCKETS];
+} fwSocketStats;
+
+/**
+ * @brief Retrieves the I/O counters of a socket.
+ * @param sfdop[in] Socket whose counters are retrieved
+ * @param stats_p[out] Receives the counters
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket is not open
+ * @note The counters are updated without synchronisation, a socket that is used by another thread
+ *       at the same time may show a send whose bytes are not counted yet.
+ */ // PlatDepImp
+fwError fwSocketGetStats(
+    fwSocket sfdop,
+    struct fwSocketStats* stats_p
+    );
+
+/**
+ * @brief Retrieves the I/O counters of every socket since the network module was started,
+ *        including sockets that were closed since.
+ * @param stats_p[out] Receives the counters
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorModule The network module is not running
+ * @note Walks every socket that is currently open, which is fine for monitoring but not meant to
+ *       be called per request.
+ */ // PlatDepImp
+fwError fwSocketGetGlobalStats(
+    struct fwSocketStats* stats_p
     );
 
 /**
@@ -287,6 +1429,1540 @@ fwError fwSocketClose(
     fwSocket sfdop
     );
 
+/**
+ * @brief Handle to a buffered stream on top of a connected stream socket.
+ */
+typedef uintptr_t fwSocketStream;
+
+/**
+ * @brief Struct describing a socket stream.
+ * @param socket Connected socket the stream reads from and writes to, it stays owned by the caller
+ * @param readCapacity Size of the read buffer in bytes, 0 selects 64 KiB, also the largest frame
+ *                     that can be read
+ * @param writeCapacity Size of the write buffer in bytes, 0 selects 64 KiB
+ * @note Used as parameter for @c fwSocketStreamCreate.
+ */
+typedef struct fwSocketStreamConfiguration {
+    fwSocket socket;
+    uint32_t readCapacity;
+    uint32_t writeCapacity;
+} fwSocketStreamConfiguration;
+
+/**
+ * @brief Creates a new socket stream.
+ * @param configuration_p[in] Description of the stream
+ * @param stream_p[out] The new stream
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The configuration was missing or did not name a socket
+ * @return @c fwErrorOutOfMemory The buffers could not be allocated
+ * @note Every receive fills the read buffer as far as the kernel allows, so many small messages
+ *       are served from a single syscall. Writes are collected until the buffer is full or
+ *       @c fwSocketStreamFlush is called. Streams are not thread safe.
+ */ // PlatIndepImp
+fwError fwSocketStreamCreate(
+    const struct fwSocketStreamConfiguration* configuration_p,
+    fwSocketStream* stream_p
+    );
+
+/**
+ * @brief Destroys a socket stream, the socket itself is not closed.
+ * @param stream[in] Stream to be destroyed
+ * @return @c fwErrorSuccess No error occured
+ * @note Data that is still in the write buffer is dropped, flush first to keep it.
+ */ // PlatIndepImp
+fwError fwSocketStreamDestroy(
+    fwSocketStream stream
+    );
+
+/**
+ * @brief Reads whatever is available, at most the given number of bytes.
+ * @param stream[in] Stream to read from
+ * @param buffer[out] Receives the data
+ * @param ammount[in] Size of the buffer in bytes
+ * @param read_p[out] Number of bytes copied, can be nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorSocketClosed The peer closed the connection and nothing is buffered
+ * @return @c fwErrorSocketWouldBlock The socket is non-blocking and no data is available
+ * @return @c fwErrorSocketReceive Receiving failed
+ * @note Only receives from the socket if the read buffer is empty.
+ */ // PlatIndepImp
+fwError fwSocketStreamRead(
+    fwSocketStream stream,
+    void* buffer,
+    size_t ammount,
+    size_t* read_p
+    );
+
+/**
+ * @brief Reads exactly the given number of bytes.
+ * @param stream[in] Stream to read from
+ * @param buffer[out] Receives the data
+ * @param ammount[in] Number of bytes to read
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorSocketClosed The peer closed the connection before enough data arrived
+ * @return @c fwErrorSocketWouldBlock The socket is non-blocking and not enough data is available
+ * @return @c fwErrorSocketReceive Receiving failed
+ * @note If the amount fits into the read buffer nothing is consumed until all of it arrived, so
+ *       a non-blocking caller can simply retry. Larger amounts bypass the buffer and can only be
+ *       read from blocking sockets.
+ */ // PlatIndepImp
+fwError fwSocketStreamReadExact(
+    fwSocketStream stream,
+    void* buffer,
+    size_t ammount
+    );
+
+/**
+ * @brief Reads one frame that is preceded by its length in network byte order.
+ * @param stream[in] Stream to read from
+ * @param prefixSize[in] Size of the length prefix in bytes, 1, 2, 4 or 8
+ * @param frame_pp[out] Start of the frame inside of the read buffer
+ * @param length_p[out] Length of the frame without the prefix
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The prefix size was not supported
+ * @return @c fwErrorSocketFrame The frame is larger than the read buffer
+ * @return @c fwErrorSocketClosed The peer closed the connection before the frame was complete
+ * @return @c fwErrorSocketWouldBlock The socket is non-blocking and the frame is not complete yet
+ * @return @c fwErrorSocketReceive Receiving failed
+ * @note The frame stays valid until the next read from the stream. An incomplete frame is not
+ *       consumed, so a non-blocking caller can retry.
+ */ // PlatIndepImp
+fwError fwSocketStreamReadFrame(
+    fwSocketStream stream,
+    uint8_t prefixSize,
+    const void** frame_pp,
+    size_t* length_p
+    );
+
+/**
+ * @brief Reads everything up to the next occurrence of a delimiter.
+ * @param stream[in] Stream to read from
+ * @param delimiter_p[in] The delimiter, for example "\r\n"
+ * @param delimiterLength[in] Length of the delimiter in bytes
+ * @param frame_pp[out] Start of the frame inside of the read buffer
+ * @param length_p[out] Length of the frame without the delimiter
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The delimiter was empty
+ * @return @c fwErrorSocketFrame The read buffer is full and does not contain the delimiter
+ * @return @c fwErrorSocketClosed The peer closed the connection before the delimiter arrived
+ * @return @c fwErrorSocketWouldBlock The socket is non-blocking and the delimiter did not arrive
+ * @return @c fwErrorSocketReceive Receiving failed
+ * @note The frame and the delimiter are consumed, the frame stays valid until the next read from
+ *       the stream. Data that was already scanned is not scanned again on retries.
+ */ // PlatIndepImp
+fwError fwSocketStreamReadUntil(
+    fwSocketStream stream,
+    const void* delimiter_p,
+    size_t delimiterLength,
+    const void** frame_pp,
+    size_t* length_p
+    );
+
+/**
+ * @brief Queues data for sending.
+ * @param stream[in] Stream to write to
+ * @param data[in] Data to be sent
+ * @param ammount[in] Size of the data in bytes
+ * @return @c fwErrorSuccess The data was queued or sent
+ * @return @c fwErrorSocketWouldBlock The socket is non-blocking, the buffer could not be drained
+ *                                    and nothing was queued
+ * @return @c fwErrorSocketSend Sending failed
+ * @note Data that does not fit into the write buffer is sent right away, together with what is
+ *       buffered, in a single syscall. On non-blocking sockets such large writes can be cut short,
+ *       keep messages below the write capacity there.
+ */ // PlatIndepImp
+fwError fwSocketStreamWrite(
+    fwSocketStream stream,
+    const void* data,
+    size_t ammount
+    );
+
+/**
+ * @brief Queues a frame preceded by its length in network byte order.
+ * @param stream[in] Stream to write to
+ * @param prefixSize[in] Size of the length prefix in bytes, 1, 2, 4 or 8
+ * @param data[in] The frame
+ * @param ammount[in] Length of the frame in bytes
+ * @return @c fwErrorSuccess The frame was queued or sent
+ * @return @c fwErrorInvalidParameter The prefix size was not supported or too small for the length
+ * @return @c fwErrorSocketWouldBlock The socket is non-blocking, the buffer could not be drained
+ *                                    and nothing was queued
+ * @return @c fwErrorSocketSend Sending failed
+ */ // PlatIndepImp
+fwError fwSocketStreamWriteFrame(
+    fwSocketStream stream,
+    uint8_t prefixSize,
+    const void* data,
+    size_t ammount
+    );
+
+/**
+ * @brief Sends everything that is in the write buffer.
+ * @param stream[in] Stream to flush
+ * @return @c fwErrorSuccess No error occured, the buffer is empty
+ * @return @c fwErrorSocketWouldBlock The socket is non-blocking and the kernel buffer is full, what
+ *                                    was not sent stays buffered
+ * @return @c fwErrorSocketSend Sending failed
+ */ // PlatIndepImp
+fwError fwSocketStreamFlush(
+    fwSocketStream stream
+    );
+
+/**
+ * @brief Handle to a shared-memory channel between two processes on the same machine.
+ */
+typedef uintptr_t fwLocalChannel;
+
+/**
+ * @brief Struct describing a local channel.
+ * @param capacity Bytes that each direction can hold, rounded up to a power of two, 0 selects
+ *                 1 MiB. Only the connecting side chooses it.
+ * @param spins Rounds a waiting call checks the ring again before it sleeps, 0 sleeps right away
+ * @param nonBlocking If sends and receives should return @c fwErrorSocketWouldBlock instead of
+ *                    waiting
+ * @note Used as parameter for @c fwLocalChannelConnect and @c fwLocalChannelAccept .
+ */
+typedef struct fwLocalChannelConfiguration {
+    uint32_t capacity;
+    uint32_t spins;
+    bool nonBlocking;
+} fwLocalChannelConfiguration;
+
+/**
+ * @brief Sets up a channel over a connected local stream socket and hands it to the peer, which
+ *        takes it with @c fwLocalChannelAccept .
+ * @param sfdop[in] Connected socket of the family @c fwSocketAddressFamilyLocal
+ * @param configuration_p[in] Description of the channel, may be @c nullptr for the defaults
+ * @param channel_p[out] The new channel
+ * @return @c fwErrorSuccess No error occured, data can be sent before the peer accepted
+ * @return @c fwErrorInvalidParameter The socket was not a connected local stream socket
+ * @return @c fwErrorOutOfMemory The shared memory could not be created
+ * @return @c fwErrorSocketSend The channel could not be handed to the peer
+ * @note The socket only carries the handshake, a memfd with one single producer single consumer
+ *       ring per direction and an eventfd per side. Data then moves with one copy into and one
+ *       copy out of the shared memory, without any syscall while neither side is sleeping.
+ * @note The channel keeps a duplicate of the socket to notice a peer that went away, the socket
+ *       itself stays owned by the caller and may be closed.
+ */ // PlatDepImp
+fwError fwLocalChannelConnect(
+    fwSocket sfdop,
+    const struct fwLocalChannelConfiguration* configuration_p,
+    fwLocalChannel* channel_p
+    );
+
+/**
+ * @brief Takes the channel the peer set up with @c fwLocalChannelConnect .
+ * @param sfdop[in] Connected socket of the family @c fwSocketAddressFamilyLocal
+ * @param configuration_p[in] Description of the channel, may be @c nullptr for the defaults, the
+ *                            capacity is ignored
+ * @param channel_p[out] The new channel
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket was not a connected local stream socket
+ * @return @c fwErrorSocketWouldBlock The socket is non-blocking and the peer has not offered yet
+ * @return @c fwErrorSocketClosed The peer closed the socket without offering a channel
+ * @return @c fwErrorSocketReceive What arrived was not a valid channel
+ * @return @c fwErrorOutOfMemory The shared memory could not be mapped
+ */ // PlatDepImp
+fwError fwLocalChannelAccept(
+    fwSocket sfdop,
+    const struct fwLocalChannelConfiguration* configuration_p,
+    fwLocalChannel* channel_p
+    );
+
+/**
+ * @brief Sends data over a local channel.
+ * @param channel[in] Channel to send over
+ * @param data[in] Buffer containing the data
+ * @param ammount[in] Number of bytes to send
+ * @param sent_p[out] Number of bytes that were sent, may be @c nullptr
+ * @return @c fwErrorSuccess No error occured, a blocking channel sent everything
+ * @return @c fwErrorSocketWouldBlock The channel is non-blocking and the ring is full
+ * @return @c fwErrorSocketClosed The peer closed the channel
+ * @note A non-blocking channel sends as much as fits. Only one thread may send at a time.
+ */ // PlatDepImp
+fwError fwLocalChannelSend(
+    fwLocalChannel channel,
+    const void* data,
+    size_t ammount,
+    size_t* sent_p
+    );
+
+/**
+ * @brief Receives whatever is available on a local channel, waiting if nothing is.
+ * @param channel[in] Channel to receive from
+ * @param buffer[out] Receives the data
+ * @param ammount[in] Capacity of the buffer
+ * @param received_p[out] Number of bytes that were received, 0 once the peer closed the channel
+ *                        and everything was read, may be @c nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorSocketWouldBlock The channel is non-blocking and the ring is empty
+ * @return @c fwErrorSocketReceive The peer corrupted the ring
+ * @note Only one thread may receive at a time.
+ */ // PlatDepImp
+fwError fwLocalChannelReceive(
+    fwLocalChannel channel,
+    void* buffer,
+    size_t ammount,
+    size_t* received_p
+    );
+
+/**
+ * @brief Closes a local channel, the peer reads what was sent so far and then sees the end.
+ * @param channel[in] Channel to be closed
+ * @return @c fwErrorSuccess No error occured
+ */ // PlatDepImp
+fwError fwLocalChannelClose(
+    fwLocalChannel channel
+    );
+
 //TODO: checkable socket connection status
 
+typedef uintptr_t fwEventLoop;
+
+/**
+ * @brief Readiness events reported by an event loop.
+ * @note Used as interest mask for @c fwEventLoopRegister and as parameter of @c fwEventCallback .
+ */
+typedef enum fwEvent : uint8_t {
+    fwEventRead         = 0b0000'0001 /*! Data can be received or a connection can be accepted */,
+    fwEventWrite        = 0b0000'0010 /*! Data can be sent or a pending connect finished */,
+    fwEventHangup       = 0b0000'0100 /*! The peer closed the connection, always reported */,
+    fwEventError        = 0b0000'1000 /*! An error is pending on the socket, always reported */,
+    fwEventReadTimeout  = 0b0001'0000 /*! Nothing arrived for the read timeout of the socket */,
+    fwEventWriteTimeout = 0b0010'0000 /*! The socket stayed unwritable for its write timeout */,
+    fwEventIdleTimeout  = 0b0100'0000 /*! No event was reported for the idle timeout */
+} fwEvent;
+
+/**
+ * @brief Called by an event loop when a registered socket became ready.
+ * @param sfdop[in] Socket that became ready
+ * @param events[in] Mask of @c fwEvent that occured
+ * @param user_p[in] Pointer given at registration
+ * @note It is safe to modify, unregister or close any socket from within the callback.
+ */
+typedef void (*fwEventCallback)(
+    fwSocket sfdop,
+    uint8_t events,
+    void* user_p
+    );
+
+/**
+ * @brief Creates an event loop which dispatches readiness of many sockets on one thread.
+ * @param loop_p[out] Identifier for the new event loop
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorOutOfMemory Out of memory
+ * @return @c fwErrorEventLoop The kernel refused to create the loop
+ */ // PlatDepImp
+fwError fwEventLoopCreate(
+    fwEventLoop* loop_p
+    );
+
+/**
+ * @brief Destroys an event loop, sockets still registered remain open but are unregistered.
+ * @param loop[in] Event loop to be destroyed
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter Timers created on the loop still exist, the loop is kept
+ * @note Must not be called while the loop is running. Timers have to be destroyed before.
+ */ // PlatDepImp
+fwError fwEventLoopDestroy(
+    fwEventLoop loop
+    );
+
+/**
+ * @brief Retrieves the event loop owned by the network module.
+ * @param loop_p[out] Identifier of the default event loop
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorModule The network module was not started with
+ *         @c fwModuleFlagNetworkEventLoop
+ */ // PlatDepImp
+fwError fwEventLoopGetDefault(
+    fwEventLoop* loop_p
+    );
+
+/**
+ * @brief Registers a socket with an event loop.
+ * @param loop[in] Event loop that will be watching the socket
+ * @param sfdop[in] Socket to be watched
+ * @param interest[in] Mask of @c fwEventRead and @c fwEventWrite
+ * @param callback[in] Function called when the socket becomes ready
+ * @param user_p[in] Passed through to @c callback
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket is already registered or the callback is missing
+ * @return @c fwErrorEventLoop The kernel refused to watch the socket
+ * @note A socket can only be registered with one event loop at a time. It is made non-blocking.
+ */ // PlatDepImp
+fwError fwEventLoopRegister(
+    fwEventLoop loop,
+    fwSocket sfdop,
+    uint8_t interest,
+    fwEventCallback callback,
+    void* user_p
+    );
+
+/**
+ * @brief Changes which events of a registered socket are reported.
+ * @param sfdop[in] Registered socket
+ * @param interest[in] New mask of @c fwEventRead and @c fwEventWrite
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket is not registered
+ * @return @c fwErrorEventLoop The kernel refused the modification
+ */ // PlatDepImp
+fwError fwEventLoopModify(
+    fwSocket sfdop,
+    uint8_t interest
+    );
+
+/**
+ * @brief Removes a socket from the event loop it is registered with.
+ * @param sfdop[in] Registered socket
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket is not registered
+ * @note @c fwSocketClose unregisters the socket implicitly.
+ */ // PlatDepImp
+fwError fwEventLoopUnregister(
+    fwSocket sfdop
+    );
+
+/**
+ * @brief Lets an event loop dispatch the events of the window module, the Wayland display is
+ *        waited on next to the sockets of the loop and read by the thread that polls it.
+ * @param loop[in] Event loop to register the display with
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorModule The window module is not running
+ * @return @c fwErrorInvalidParameter The display already is registered with a loop
+ * @return @c fwErrorEventLoop The kernel refused the registration
+ * @note There is no dispatch thread, window events are only handled while the loop is polled.
+ *       Stopping the window module or destroying the loop unregisters the display implicitly.
+ */ // PlatDepImp
+fwError fwEventLoopRegisterWindow(
+    fwEventLoop loop
+    );
+
+/**
+ * @brief Removes the display of the window module from the event loop it is registered with.
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The display is not registered
+ */ // PlatDepImp
+fwError fwEventLoopUnregisterWindow(
+    void
+    );
+
+/**
+ * @brief Waits for events once and dispatches all callbacks that became ready.
+ * @param loop[in] Event loop to poll
+ * @param timeoutMs[in] Maximum time to wait in milliseconds, -1 waits indefinitely and 0 returns
+ *                      immediately
+ * @param dispatched_p[out] Number of events that were dispatched, may be @c nullptr
+ * @return @c fwErrorSuccess No error occured, this includes running into the timeout
+ * @return @c fwErrorEventLoop Waiting for events failed
+ */ // PlatDepImp
+fwError fwEventLoopPoll(
+    fwEventLoop loop,
+    int32_t timeoutMs,
+    uint32_t* dispatched_p
+    );
+
+/**
+ * @brief Dispatches events on the calling thread until @c fwEventLoopStop is called.
+ * @param loop[in] Event loop to run
+ * @return @c fwErrorSuccess The loop was stopped
+ * @return @c fwErrorEventLoop Waiting for events failed
+ */ // PlatDepImp
+fwError fwEventLoopRun(
+    fwEventLoop loop
+    );
+
+/**
+ * @brief Makes @c fwEventLoopRun return, can be called from any thread or from a callback.
+ * @param loop[in] Event loop to stop
+ * @return @c fwErrorSuccess No error occured
+ */ // PlatDepImp
+fwError fwEventLoopStop(
+    fwEventLoop loop
+    );
+
+typedef uintptr_t fwTimer;
+
+/**
+ * @brief Called by an event loop when a timer expired.
+ * @param timer[in] Timer that expired
+ * @param user_p[in] Pointer given at creation
+ * @note It is safe to arm, cancel or destroy any timer from within the callback.
+ */
+typedef void (*fwTimerCallback)(
+    fwTimer timer,
+    void* user_p
+    );
+
+/**
+ * @brief Creates a disarmed timer that is dispatched by an event loop.
+ * @param loop[in] Event loop that will be dispatching the timer
+ * @param callback[in] Function called when the timer expires
+ * @param user_p[in] Passed through to @c callback
+ * @param timer_p[out] Identifier for the new timer
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The callback is missing
+ * @return @c fwErrorOutOfMemory Out of memory
+ * @note Timers sit in a hierarchical timing wheel with a resolution of one millisecond, arming and
+ *       cancelling take constant time no matter how many timers there are. One timerfd per loop
+ *       wakes it for the earliest one.
+ */ // PlatDepImp
+fwError fwTimerCreate(
+    fwEventLoop loop,
+    fwTimerCallback callback,
+    void* user_p,
+    fwTimer* timer_p
+    );
+
+/**
+ * @brief Destroys a timer, disarming it if necessary.
+ * @param timer[in] Timer to be destroyed
+ * @return @c fwErrorSuccess No error occured
+ */ // PlatDepImp
+fwError fwTimerDestroy(
+    fwTimer timer
+    );
+
+/**
+ * @brief Arms a timer, re-arming an armed one replaces its expiry.
+ * @param timer[in] Timer to be armed
+ * @param timeout[in] Milliseconds until the timer expires
+ * @param interval[in] Milliseconds between further expiries, 0 expires only once
+ * @return @c fwErrorSuccess No error occured
+ * @note Must be called from the thread that runs the loop of the timer. Intervals are counted
+ *       from the previous expiry, so a late dispatch does not make the timer drift.
+ */ // PlatDepImp
+fwError fwTimerArm(
+    fwTimer timer,
+    uint32_t timeout,
+    uint32_t interval
+    );
+
+/**
+ * @brief Disarms a timer, nothing happens if it was not armed.
+ * @param timer[in] Timer to be disarmed
+ * @return @c fwErrorSuccess No error occured
+ * @note Must be called from the thread that runs the loop of the timer.
+ */ // PlatDepImp
+fwError fwTimerCancel(
+    fwTimer timer
+    );
+
+/**
+ * @brief Struct describing the timeouts of a socket, in milliseconds and 0 for none.
+ * @param read Time a receive or accept may wait for data or a connection
+ * @param write Time a send or connect may wait for room in the send buffer or the handshake
+ * @param idle Time a socket registered with an event loop may go without any event
+ * @note Used as parameter for @c fwSocketSetTimeouts .
+ */
+typedef struct fwSocketTimeouts {
+    uint32_t read;
+    uint32_t write;
+    uint32_t idle;
+} fwSocketTimeouts;
+
+/**
+ * @brief Sets the timeouts of a socket.
+ * @param sfdop[in] Socket to be modified
+ * @param timeouts_p[in] The new timeouts
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket passed was not valid
+ * @note Blocking calls return @c fwErrorSocketTimeout once the read or write timeout ran out,
+ *       instead of waiting for a stalled peer forever.
+ * @note For a socket registered with an event loop the timeouts are deadlines of the loop's timer
+ *       wheel. The read one is pushed back by every read event while read events are of interest,
+ *       the write one likewise and the idle one by any event. The callback receives
+ *       @c fwEventReadTimeout , @c fwEventWriteTimeout or @c fwEventIdleTimeout when one runs out,
+ *       and again after every further timeout without events.
+ */ // PlatDepImp
+fwError fwSocketSetTimeouts(
+    fwSocket sfdop,
+    const struct fwSocketTimeouts* timeouts_p
+    );
+
+typedef uintptr_t fwIoQueue;
+
+/**
+ * @brief Result of one operation of an I/O queue.
+ * @param tag Value given when the operation was queued
+ * @param transferred Bytes sent or received
+ * @param socket Newly connected socket if the operation was an accept
+ * @param error Outcome, same codes as the blocking counterpart of the operation
+ * @note Used as parameter for @c fwIoQueueReap .
+ */
+typedef struct fwIoCompletion {
+    uint64_t tag;
+    size_t transferred;
+    fwSocket socket;
+    fwError error;
+} fwIoCompletion;
+
+/**
+ * @brief Creates an I/O queue, operations queued on it are handed to the kernel in batches with a
+ *        single syscall.
+ * @param entries[in] Maximum number of operations that can be queued between two submits, rounded
+ *                    up to a power of two by the kernel
+ * @param queue_p[out] Identifier for the new queue
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorOutOfMemory Out of memory
+ * @return @c fwErrorIoQueue The kernel does not support io_uring or refused to create the queue
+ * @note A queue must only be used by one thread at a time.
+ */ // PlatDepImp
+fwError fwIoQueueCreate(
+    uint32_t entries,
+    fwIoQueue* queue_p
+    );
+
+/**
+ * @brief Destroys an I/O queue. Operations that were not reaped yet are cancelled by the kernel.
+ * @param queue[in] Queue to be destroyed
+ * @return @c fwErrorSuccess No error occured
+ */ // PlatDepImp
+fwError fwIoQueueDestroy(
+    fwIoQueue queue
+    );
+
+/**
+ * @brief Retrieves the I/O queue owned by the network module.
+ * @param queue_p[out] Identifier of the default queue
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorModule The network module was not started with @c fwModuleFlagNetworkIoUring
+ */ // PlatDepImp
+fwError fwIoQueueGetDefault(
+    fwIoQueue* queue_p
+    );
+
+/**
+ * @brief Queues sending data over a connected socket, the buffer must stay valid until the
+ *        operation was reaped.
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket is not valid or the ammount exceeds @c UINT32_MAX
+ * @return @c fwErrorIoQueueFull Submit and reap before queueing more
+ */ // PlatDepImp
+fwError fwIoQueueSend(
+    fwIoQueue queue,
+    fwSocket sfdop,
+    const void* data,
+    size_t ammount,
+    uint64_t tag
+    );
+
+/**
+ * @brief Queues receiving data over a connected socket, the buffer must stay valid until the
+ *        operation was reaped.
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket is not valid or the ammount exceeds @c UINT32_MAX
+ * @return @c fwErrorIoQueueFull Submit and reap before queueing more
+ */ // PlatDepImp
+fwError fwIoQueueReceive(
+    fwIoQueue queue,
+    fwSocket sfdop,
+    void* buffer,
+    size_t ammount,
+    uint64_t tag
+    );
+
+/**
+ * @brief Queues accepting a connection on a bound socket, the new socket is delivered in
+ *        @c fwIoCompletion::socket .
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorSocketNotBound The socket was not bound
+ * @return @c fwErrorSocketListen The socket could not be put into the listening state
+ * @return @c fwErrorIoQueueFull Submit and reap before queueing more
+ */ // PlatDepImp
+fwError fwIoQueueAccept(
+    fwIoQueue queue,
+    fwSocket sfdop,
+    uint64_t tag
+    );
+
+/**
+ * @brief Hands all queued operations to the kernel with one syscall.
+ * @param queue[in] Queue to be submitted
+ * @param waitFor[in] Number of completions to wait for before returning, 0 does not wait
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorIoQueue The submission failed
+ */ // PlatDepImp
+fwError fwIoQueueSubmit(
+    fwIoQueue queue,
+    uint32_t waitFor
+    );
+
+/**
+ * @brief Collects finished operations without making a syscall.
+ * @param queue[in] Queue to be reaped
+ * @param completions_p[out] Array receiving the results
+ * @param capacity[in] Number of elements @c completions_p can hold
+ * @param reaped_p[out] Number of elements written to @c completions_p
+ * @return @c fwErrorSuccess No error occured
+ */ // PlatDepImp
+fwError fwIoQueueReap(
+    fwIoQueue queue,
+    fwIoCompletion* completions_p,
+    uint32_t capacity,
+    uint32_t* reaped_p
+    );
+
+/**
+ * @brief Function run by the job system.
+ * @param user_p[in] The pointer the job was submitted with
+ */
+typedef void (*fwJobFunction)(
+    void* user_p
+    );
+
+/**
+ * @brief Struct describing a job.
+ * @param function Function that is run by a worker
+ * @param user_p Passed to the function
+ * @note Used as param for @c fwJobSubmit.
+ */
+typedef struct fwJob {
+    fwJobFunction function;
+    void* user_p;
+} fwJob;
+
+/**
+ * @brief Handle to a counter of jobs that have not finished yet, used to wait for jobs and to
+ *        start jobs once others have finished.
+ */
+typedef uintptr_t fwJobCounter;
+
+/**
+ * @brief Creates a new job counter with a value of 0.
+ * @param counter_p[out] The new counter
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorOutOfMemory There was no memory for the counter
+ */ // PlatDepImp
+fwError fwJobCounterCreate(
+    fwJobCounter* counter_p
+    );
+
+/**
+ * @brief Destroys a job counter.
+ * @param counter[in] Counter to be destroyed
+ * @return @c fwErrorSuccess No error occured
+ * @note No job may reference the counter anymore, wait on it first.
+ */ // PlatDepImp
+fwError fwJobCounterDestroy(
+    fwJobCounter counter
+    );
+
+/**
+ * @brief Hands jobs to the workers of the job system.
+ * @param jobs_p[in] Array of jobs, it is copied and may be reused right away
+ * @param count[in] Number of elements in @c jobs_p
+ * @param counter[in] Counter that is raised by @c count and lowered as the jobs finish, may be 0
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorModule The job module is not running
+ * @return @c fwErrorInvalidParameter A job has no function
+ * @return @c fwErrorOutOfMemory There was no memory for the jobs
+ * @note Jobs submitted from inside of a job stay on the worker that runs it, where their data is
+ *       still in cache, until an idle worker steals them.
+ */ // PlatDepImp
+fwError fwJobSubmit(
+    const fwJob* jobs_p,
+    uint32_t count,
+    fwJobCounter counter
+    );
+
+/**
+ * @brief Hands jobs to the workers once the dependency counter reached 0.
+ * @param dependency[in] The jobs are held back until this counter reaches 0
+ * @param jobs_p[in] Array of jobs, it is copied and may be reused right away
+ * @param count[in] Number of elements in @c jobs_p
+ * @param counter[in] Counter that is raised by @c count right away and lowered as the jobs
+ *                    finish, may be 0
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorModule The job module is not running
+ * @return @c fwErrorInvalidParameter A job has no function or the dependency was 0
+ * @return @c fwErrorOutOfMemory There was no memory for the jobs
+ * @note Nothing blocks, chains of jobs can be built up front this way.
+ */ // PlatDepImp
+fwError fwJobSubmitAfter(
+    fwJobCounter dependency,
+    const fwJob* jobs_p,
+    uint32_t count,
+    fwJobCounter counter
+    );
+
+/**
+ * @brief Waits until a counter reaches 0.
+ * @param counter[in] Counter to wait on
+ * @return @c fwErrorSuccess No error occured
+ * @note The calling thread runs queued jobs while it waits, so it is safe to wait from inside of
+ *       a job.
+ */ // PlatDepImp
+fwError fwJobWait(
+    fwJobCounter counter
+    );
+
+/**
+ * @brief Retrieves the number of worker threads of the job system.
+ * @param count_p[out] Number of workers
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorModule The job module is not running
+ */ // PlatDepImp
+fwError fwJobGetWorkerCount(
+    uint32_t* count_p
+    );
+
+/**
+ * @brief Struct describing the stacks of fibers.
+ * @param stackSize Usable size of each stack in bytes, rounded up to whole pages, 0 selects 64 KiB.
+ *                  A guard page below every stack turns an overflow into a crash instead of
+ *                  silent corruption.
+ * @param pooledStacks Stacks of finished fibers that are kept for reuse, 0 selects 1024
+ * @note Used as parameter for @c fwFiberConfigure.
+ */
+typedef struct fwFiberConfiguration {
+    uint32_t stackSize;
+    uint32_t pooledStacks;
+} fwFiberConfiguration;
+
+/**
+ * @brief Changes how fiber stacks are sized and pooled, already running fibers keep their stacks.
+ * @param configuration_p[in] The new configuration
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The configuration was missing
+ */ // PlatDepImp
+fwError fwFiberConfigure(
+    const struct fwFiberConfiguration* configuration_p
+    );
+
+/**
+ * @brief Starts a function as a fiber on the job system.
+ * @param function[in] Function the fiber runs
+ * @param user_p[in] Passed to the function
+ * @param counter[in] Counter that is raised now and lowered once the fiber returned, so
+ *                    @c fwJobWait can wait for fibers like for jobs, can be 0
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The function was missing
+ * @return @c fwErrorModule The job module is not running
+ * @return @c fwErrorUnimplemented There is no context switch for this architecture
+ * @return @c fwErrorOutOfMemory No stack could be mapped
+ * @note A fiber runs like a job until it waits on a socket or yields, then the worker moves on to
+ *       other jobs. Waiting fibers are resumed by an internal event loop thread on whichever worker
+ *       is free first, so a fiber can continue on a different thread than it started on and
+ *       should not keep pointers to thread local data across waits.
+ * @note Blocking calls other than the @c fwFiberSocket functions, including @c fwJobWait, block the
+ *       worker itself, not only the fiber.
+ */ // PlatDepImp
+fwError fwFiberSpawn(
+    fwJobFunction function,
+    void* user_p,
+    fwJobCounter counter
+    );
+
+/**
+ * @brief Lets other jobs and fibers run, the calling fiber is queued again right away.
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter Not called from a fiber
+ */ // PlatDepImp
+fwError fwFiberYield(
+    void
+    );
+
+/**
+ * @brief Waits until a socket is ready.
+ * @param sfdop[in] Socket to wait for
+ * @param interest[in] Combination of @c fwEventRead and @c fwEventWrite
+ * @param ready_p[out] Combination of the @c fwEvent that occured, can be nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket was not valid or is registered with an event loop
+ * @return @c fwErrorEventLoop The socket could not be watched
+ * @note Inside of a fiber only the fiber is parked, anywhere else the thread blocks. Only one fiber
+ *       can wait on a socket at a time.
+ */ // PlatDepImp
+fwError fwFiberSocketWait(
+    fwSocket sfdop,
+    uint8_t interest,
+    uint8_t* ready_p
+    );
+
+/**
+ * @brief Sends all of the data, parking the calling fiber whenever the kernel buffer is full.
+ * @param sfdop[in] Socket that is supposed to send the data
+ * @param data[in] Data to be sent
+ * @param ammount[in] Size of the data in bytes
+ * @param sent_p[out] Number of bytes that were sent, less than the amount only on errors, can be
+ *                    nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket was not valid or is registered with an event loop
+ * @return @c fwErrorSocketSend Sending failed
+ * @note Puts the socket into non-blocking mode, like all other @c fwFiberSocket functions.
+ */ // PlatDepImp
+fwError fwFiberSocketSend(
+    fwSocket sfdop,
+    const void* data,
+    size_t ammount,
+    size_t* sent_p
+    );
+
+/**
+ * @brief Receives data, parking the calling fiber until some arrived.
+ * @param sfdop[in] Socket that is supposed to receive the data
+ * @param buffer[out] Receives the data
+ * @param ammount[in] Size of the buffer in bytes
+ * @param received_p[out] Number of bytes received, 0 if the peer closed the connection, can be
+ *                        nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket was not valid or is registered with an event loop
+ * @return @c fwErrorSocketReceive Receiving failed
+ */ // PlatDepImp
+fwError fwFiberSocketReceive(
+    fwSocket sfdop,
+    void* buffer,
+    size_t ammount,
+    size_t* received_p
+    );
+
+/**
+ * @brief Accepts a connection, parking the calling fiber until one is pending.
+ * @param sfdop[in] The listening socket
+ * @param newSocket_p[out] The new connection
+ * @param foreignAddress[out] Address of the peer, like with @c fwSocketAccept , can be nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket was not valid or is registered with an event loop
+ * @return @c fwErrorSocketAccept Accepting failed
+ */ // PlatDepImp
+fwError fwFiberSocketAccept(
+    fwSocket sfdop,
+    fwSocket* newSocket_p,
+    char* foreignAddress
+    );
+
+/**
+ * @brief Connects a stream socket, parking the calling fiber during the handshake.
+ * @param sfdop[in] Socket that is supposed to be connected
+ * @param connectInfo_p[in] Information about where to connect the socket to
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The socket was not valid or is registered with an event loop
+ * @return @c fwErrorSocketTargetName Could not resolve the name of the target to an IP address
+ * @return @c fwErrorSocketConnection No address of the family of the socket accepted the connection
+ */ // PlatDepImp
+fwError fwFiberSocketConnect(
+    fwSocket sfdop,
+    const struct fwSocketAddress* connectInfo_p
+    );
+
+/**
+ * @brief Handle to a benchmark, collects timing samples and reports on them.
+ */
+typedef uintptr_t fwBench;
+
+/**
+ * @brief Number of buckets in @c fwBenchResult::histogram .
+ */
+#define FW_BENCH_HISTOGRAM_BUCKETS 64
+
+/**
+ * @brief Struct describing a benchmark.
+ * @param name_p Name that is used when reporting, has to outlive the benchmark
+ * @param warmup Samples that are discarded before measuring starts, they let caches, branch
+ *               predictors and the CPU clock settle
+ * @param repetitions Samples that are measured, @c fwBenchRun runs the function this often
+ * @param bytes Bytes processed per sample, used to report throughput, 0 if that does not apply
+ * @note Used as param for @c fwBenchCreate.
+ */
+typedef struct fwBenchConfiguration {
+    const char* name_p;
+    uint32_t warmup;
+    uint32_t repetitions;
+    uint64_t bytes;
+} fwBenchConfiguration;
+
+/**
+ * @brief Struct containing the statistics of a benchmark, all times are in nanoseconds.
+ * @param samples Number of measured samples
+ * @param minimum Fastest sample
+ * @param maximum Slowest sample
+ * @param mean Arithmetic mean of all samples
+ * @param median 50th percentile
+ * @param p90 90th percentile
+ * @param p99 99th percentile
+ * @param p999 99.9th percentile
+ * @param throughput Bytes per second based on the mean, 0 if no byte count was configured
+ * @param histogram Bucket n counts samples of at least 2^n and less than 2^(n + 1) nanoseconds,
+ *                  bucket 0 also counts samples of 0 nanoseconds
+ * @note Used as param for @c fwBenchReport.
+ */
+typedef struct fwBenchResult {
+    uint64_t samples;
+    uint64_t minimum;
+    uint64_t maximum;
+    uint64_t mean;
+    uint64_t median;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+    double throughput;
+    uint64_t histogram[FW_BENCH_HISTOGRAM_BUCKETS];
+} fwBenchResult;
+
+/**
+ * @brief Function timed by @c fwBenchRun.
+ * @param user_p[in] Pointer that was given to @c fwBenchRun
+ * @return Anything but @c fwErrorSuccess aborts the run
+ */
+typedef fwError (*fwBenchFunction)(
+    void* user_p
+    );
+
+/**
+ * @brief Reads the benchmark clock.
+ * @param nanoseconds_p[out] Current time in nanoseconds, only meaningful relative to other readings
+ * @return @c fwErrorSuccess No error occured
+ * @note Uses CLOCK_MONOTONIC_RAW on Linux, which is not slewed by NTP and read without a
+ *       syscall.
+ */ // PlatDepImp
+fwError fwBenchNow(
+    uint64_t* nanoseconds_p
+    );
+
+/**
+ * @brief Creates a new benchmark.
+ * @param configuration_p[in] Description of the benchmark
+ * @param bench_p[out] The new benchmark
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter A parameter was @c nullptr
+ * @return @c fwErrorOutOfMemory There was no memory for the samples
+ */ // PlatIndepImp
+fwError fwBenchCreate(
+    const struct fwBenchConfiguration* configuration_p,
+    fwBench* bench_p
+    );
+
+/**
+ * @brief Destroys a benchmark and its samples.
+ * @param bench[in] Benchmark to be destroyed
+ * @return @c fwErrorSuccess No error occured
+ */ // PlatIndepImp
+fwError fwBenchDestroy(
+    fwBench bench
+    );
+
+/**
+ * @brief Starts a timed scope, the scope ends with @c fwBenchEnd.
+ * @param bench[in] Benchmark the scope belongs to
+ * @return @c fwErrorSuccess No error occured
+ * @note Scopes of one benchmark do not nest and must not be used by multiple threads at once, give
+ *       every thread its own benchmark and combine them with @c fwBenchMerge.
+ */ // PlatIndepImp
+fwError fwBenchBegin(
+    fwBench bench
+    );
+
+/**
+ * @brief Ends the timed scope that was started by @c fwBenchBegin and records it as sample.
+ * @param bench[in] Benchmark the scope belongs to
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorOutOfMemory There was no memory for the sample
+ */ // PlatIndepImp
+fwError fwBenchEnd(
+    fwBench bench
+    );
+
+/**
+ * @brief Records a sample that was measured by other means.
+ * @param bench[in] Benchmark the sample belongs to
+ * @param nanoseconds[in] Duration of the sample
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorOutOfMemory There was no memory for the sample
+ * @note Counts towards the warmup like every other sample.
+ */ // PlatIndepImp
+fwError fwBenchRecord(
+    fwBench bench,
+    uint64_t nanoseconds
+    );
+
+/**
+ * @brief Adds the measured samples of one benchmark to another.
+ * @param destination[in] Benchmark that receives the samples
+ * @param source[in] Benchmark whose samples are copied, it is left unchanged
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorOutOfMemory There was no memory for the samples
+ */ // PlatIndepImp
+fwError fwBenchMerge(
+    fwBench destination,
+    fwBench source
+    );
+
+/**
+ * @brief Runs a function for the configured warmup and repetitions, timing every call.
+ * @param bench[in] Benchmark that records the samples
+ * @param function[in] Function that is timed
+ * @param user_p[in] Passed to the function, may be @c nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The function was @c nullptr
+ * @return Any error the function returned, the run stops at the first one
+ */ // PlatIndepImp
+fwError fwBenchRun(
+    fwBench bench,
+    fwBenchFunction function,
+    void* user_p
+    );
+
+/**
+ * @brief Computes the statistics of a benchmark and logs them at the benchmark log level.
+ * @param bench[in] Benchmark to be reported
+ * @param result_p[out] Receives the statistics, may be @c nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorOutOfMemory There was no memory to sort the samples
+ */ // PlatIndepImp
+fwError fwBenchReport(
+    fwBench bench,
+    struct fwBenchResult* result_p
+    );
+
+
+/**
+ * @brief Handle to a bump-pointer arena, allocations are only ever released all at once or back
+ *        to a marker.
+ */
+typedef uintptr_t fwArena;
+
+/**
+ * @brief Handle to a pool of equally sized elements.
+ */
+typedef uintptr_t fwPool;
+
+/**
+ * @brief Position inside of an arena, everything allocated after it is released on rewind.
+ */
+typedef uint64_t fwArenaMarker;
+
+/**
+ * @brief Where the memory of an arena or pool comes from, the flags can be combined.
+ */
+typedef enum fwMemoryFlags : uint8_t {
+    fwMemoryFlagHugePages = 0b0001 /*! Back the region with pages from the hugetlb pool, the size
+                                       is rounded up to the huge page size, falls back to regular
+                                       pages if the pool is exhausted */,
+    fwMemoryFlagTransparentHugePages = 0b0010 /*! Ask the kernel to use transparent huge pages for
+                                                  the region */,
+    fwMemoryFlagPrefault = 0b0100 /*! Touch every page when the region is created so that first
+                                      use does not fault */
+} fwMemoryFlags;
+
+/**
+ * @brief Struct describing an arena.
+ * @param size Capacity of the arena in bytes, the whole range is reserved up front
+ * @param numaNode Node the memory is placed on, @c FW_MEMORY_ANY_NODE to leave it to the kernel
+ * @param flags Combination of @c fwMemoryFlags
+ * @note Used as param for @c fwArenaCreate.
+ */
+typedef struct fwArenaConfiguration {
+    uint64_t size;
+    int16_t numaNode;
+    uint8_t flags;
+} fwArenaConfiguration;
+
+/**
+ * @brief Struct describing a pool.
+ * @param elementSize Size of one element in bytes, rounded up to a multiple of 16
+ * @param elementCount Number of elements the pool holds
+ * @param numaNode Node the memory is placed on, @c FW_MEMORY_ANY_NODE to leave it to the kernel
+ * @param flags Combination of @c fwMemoryFlags
+ * @note Used as param for @c fwPoolCreate.
+ */
+typedef struct fwPoolConfiguration {
+    uint64_t elementSize;
+    uint64_t elementCount;
+    int16_t numaNode;
+    uint8_t flags;
+} fwPoolConfiguration;
+
+/**
+ * @brief Value of @c numaNode that does not bind memory to any node.
+ */
+#define FW_MEMORY_ANY_NODE (-1)
+
+/**
+ * @brief Creates a new arena.
+ * @param configuration_p[in] Description of the arena
+ * @param arena_p[out] The new arena
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The size was 0 or the node does not exist
+ * @return @c fwErrorOutOfMemory The region could not be mapped
+ * @note Arenas are not thread safe, the intended use is one arena per thread, request or frame
+ *       that is reset once the work is done.
+ */ // PlatIndepImp
+fwError fwArenaCreate(
+    const struct fwArenaConfiguration* configuration_p,
+    fwArena* arena_p
+    );
+
+/**
+ * @brief Destroys an arena and unmaps its memory.
+ * @param arena[in] Arena to be destroyed
+ * @return @c fwErrorSuccess No error occured
+ */ // PlatIndepImp
+fwError fwArenaDestroy(
+    fwArena arena
+    );
+
+/**
+ * @brief Allocates memory from an arena.
+ * @param arena[in] Arena to allocate from
+ * @param size[in] Number of bytes
+ * @param alignment[in] Alignment of the allocation, has to be a power of two, 0 selects 16
+ * @param memory_pp[out] The allocation
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The alignment was not a power of two
+ * @return @c fwErrorOutOfMemory The arena has no room left
+ */ // PlatIndepImp
+fwError fwArenaAllocate(
+    fwArena arena,
+    uint64_t size,
+    uint64_t alignment,
+    void** memory_pp
+    );
+
+/**
+ * @brief Remembers the current position of an arena.
+ * @param arena[in] Arena whose position is taken
+ * @param marker_p[out] The position
+ * @return @c fwErrorSuccess No error occured
+ */ // PlatIndepImp
+fwError fwArenaGetMarker(
+    fwArena arena,
+    fwArenaMarker* marker_p
+    );
+
+/**
+ * @brief Releases everything that was allocated after a marker was taken.
+ * @param arena[in] Arena to rewind
+ * @param marker[in] Position that was returned by @c fwArenaGetMarker
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The marker lies behind the current position
+ */ // PlatIndepImp
+fwError fwArenaRewind(
+    fwArena arena,
+    fwArenaMarker marker
+    );
+
+/**
+ * @brief Releases every allocation of an arena, the memory stays mapped for reuse.
+ * @param arena[in] Arena to reset
+ * @return @c fwErrorSuccess No error occured
+ */ // PlatIndepImp
+fwError fwArenaReset(
+    fwArena arena
+    );
+
+/**
+ * @brief Creates a new pool, all elements are allocated up front.
+ * @param configuration_p[in] Description of the pool
+ * @param pool_p[out] The new pool
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter An element size or count was 0 or the node does not exist
+ * @return @c fwErrorOutOfMemory The region could not be mapped
+ * @note Pools are not thread safe either.
+ */ // PlatIndepImp
+fwError fwPoolCreate(
+    const struct fwPoolConfiguration* configuration_p,
+    fwPool* pool_p
+    );
+
+/**
+ * @brief Destroys a pool and unmaps its memory, elements that were not freed are gone as well.
+ * @param pool[in] Pool to be destroyed
+ * @return @c fwErrorSuccess No error occured
+ */ // PlatIndepImp
+fwError fwPoolDestroy(
+    fwPool pool
+    );
+
+/**
+ * @brief Takes an element from a pool.
+ * @param pool[in] Pool to take from
+ * @param element_pp[out] The element, aligned to 16 bytes
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorOutOfMemory Every element is in use
+ */ // PlatIndepImp
+fwError fwPoolAllocate(
+    fwPool pool,
+    void** element_pp
+    );
+
+/**
+ * @brief Returns an element to its pool.
+ * @param pool[in] Pool the element was taken from
+ * @param element_p[in] The element
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The element does not belong to the pool
+ */ // PlatIndepImp
+fwError fwPoolFree(
+    fwPool pool,
+    void* element_p
+    );
+
+typedef uintptr_t fwRenderSurface;
+
+/**
+ * @brief Struct describing a new render surface.
+ * @param width Width in pixels
+ * @param height Height in pixels
+ * @param title_p Title of the window, may be @c nullptr
+ * @note Used as parameter for @c fwRenderSurfaceCreate .
+ */
+typedef struct fwRenderSurfaceConfiguration {
+    uint32_t width;
+    uint32_t height;
+    const char* title_p;
+} fwRenderSurfaceConfiguration;
+
+/**
+ * @brief Rectangle on a render surface, parts outside of the surface are clipped away.
+ */
+typedef struct fwRenderRect {
+    int32_t x;
+    int32_t y;
+    uint32_t width;
+    uint32_t height;
+} fwRenderRect;
+
+/**
+ * @brief Pixels that are drawn onto a render surface.
+ * @param pixels_p Premultiplied ARGB8888, the same format as the surface
+ * @param width Width in pixels
+ * @param height Height in pixels
+ * @param stride Pixels from the start of one row to the start of the next one
+ */
+typedef struct fwRenderImage {
+    const uint32_t* pixels_p;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+} fwRenderImage;
+
+/**
+ * @brief Opens a window that the software renderer draws into.
+ * @param configuration_p[in] Description of the surface
+ * @param surface_p[out] The new surface
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorModule The render module is not running
+ * @return @c fwErrorInvalidParameter The surface has no size or its buffers exceed 2 GiB
+ * @return @c fwErrorOutOfMemory The buffers could not be created
+ * @return @c fwErrorWindowConnect The compositor refused the window
+ * @note The surface has three buffers, drawing continues into a free one while the compositor
+ *       still shows the others. Only what was drawn since a buffer was shown last is redrawn and
+ *       sent as damage.
+ * @note Create, draw and present on the thread that polls the event loop the window module is
+ *       registered with, see @c fwEventLoopRegisterWindow .
+ */ // PlatDepImp
+fwError fwRenderSurfaceCreate(
+    const struct fwRenderSurfaceConfiguration* configuration_p,
+    fwRenderSurface* surface_p
+    );
+
+/**
+ * @brief Closes the window of a render surface and releases its buffers.
+ * @param surface[in] Surface to be destroyed
+ * @return @c fwErrorSuccess No error occured
+ */ // PlatDepImp
+fwError fwRenderSurfaceDestroy(
+    fwRenderSurface surface
+    );
+
+/**
+ * @brief Fills a rectangle of the frame that is being drawn with one color.
+ * @param surface[in] Surface to draw on
+ * @param rect_p[in] Rectangle to fill, @c nullptr fills the whole surface
+ * @param color[in] Premultiplied ARGB8888 color, it replaces what was there
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorRenderBusy Every buffer is still held by the compositor, poll its events
+ */ // PlatDepImp
+fwError fwRenderFill(
+    fwRenderSurface surface,
+    const struct fwRenderRect* rect_p,
+    uint32_t color
+    );
+
+/**
+ * @brief Copies an image into the frame that is being drawn, replacing what was there.
+ * @param surface[in] Surface to draw on
+ * @param x[in] Column the left edge of the image goes to
+ * @param y[in] Row the top edge of the image goes to
+ * @param image_p[in] The image
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The image was missing
+ * @return @c fwErrorRenderBusy Every buffer is still held by the compositor, poll its events
+ */ // PlatDepImp
+fwError fwRenderBlit(
+    fwRenderSurface surface,
+    int32_t x,
+    int32_t y,
+    const struct fwRenderImage* image_p
+    );
+
+/**
+ * @brief Draws an image over the frame that is being drawn, blended by its alpha.
+ * @param surface[in] Surface to draw on
+ * @param x[in] Column the left edge of the image goes to
+ * @param y[in] Row the top edge of the image goes to
+ * @param image_p[in] The image
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The image was missing
+ * @return @c fwErrorRenderBusy Every buffer is still held by the compositor, poll its events
+ */ // PlatDepImp
+fwError fwRenderBlend(
+    fwRenderSurface surface,
+    int32_t x,
+    int32_t y,
+    const struct fwRenderImage* image_p
+    );
+
+/**
+ * @brief Hands the frame that was drawn to the compositor, only the damaged part is committed.
+ * @param surface[in] Surface to present
+ * @return @c fwErrorSuccess No error occured, this includes there being nothing to present
+ */ // PlatDepImp
+fwError fwRenderPresent(
+    fwRenderSurface surface
+    );
+
+typedef uintptr_t fwAudioStream;
+
+typedef enum fwAudioDirection : uint8_t {
+    fwAudioDirectionPlayback /*! Samples go from the application to the device */,
+    fwAudioDirectionCapture /*! Samples go from the device to the application */
+} fwAudioDirection;
+
+/**
+ * @brief Called on the audio thread once per period, instead of going through the ring.
+ * @param samples_p[in,out] Interleaved samples of one period, to be filled for playback and
+ *                          holding what was recorded for capture
+ * @param frames[in] Frames in @c samples_p
+ * @param user_p[in] Pointer given in the configuration
+ * @note Runs with real-time priority if the process may use it. It must not allocate, lock, log or
+ *       otherwise block, anything that takes longer than a period is heard as a dropout.
+ */
+typedef void (*fwAudioCallback)(
+    int16_t* samples_p,
+    uint32_t frames,
+    void* user_p
+    );
+
+/**
+ * @brief Struct describing an audio stream, 0 selects the default of a field.
+ * @param device_p Name of the ALSA device, @c nullptr selects "default". Direct hardware devices
+ *                 like "hw:0,0" skip the mixing of the sound server and achieve the lowest latency.
+ * @param sampleRate Frames per second, 48000 by default
+ * @param channels Samples per frame, 2 by default
+ * @param periodFrames Frames the device transfers at once, 128 by default. The latency of the
+ *                     device is @c periods times this.
+ * @param periods Periods the device buffers, 2 by default
+ * @param ringFrames Frames the ring between the application and the audio thread holds, rounded up
+ *                   to a power of two, 4 periods by default
+ * @param direction Whether the stream plays back or captures
+ * @param callback Called for every period instead of using the ring, may be @c nullptr
+ * @param user_p Passed to the callback
+ * @note Samples are signed 16 bit and interleaved. Used as parameter for @c fwAudioStreamCreate .
+ */
+typedef struct fwAudioConfiguration {
+    const char* device_p;
+    uint32_t sampleRate;
+    uint16_t channels;
+    uint32_t periodFrames;
+    uint32_t periods;
+    uint32_t ringFrames;
+    fwAudioDirection direction;
+    fwAudioCallback callback;
+    void* user_p;
+} fwAudioConfiguration;
+
+/**
+ * @brief Counters of an audio stream and what the device settled on.
+ * @param frames Frames that went to or came from the device
+ * @param xruns Times the device ran out of samples or room and had to be restarted
+ * @param starved Periods the ring could not fill completely during playback, the rest was
+ *                silence, or could not take completely during capture, the rest was dropped
+ * @param sampleRate Negotiated frames per second
+ * @param periodFrames Negotiated frames per period
+ * @param periods Negotiated periods in the device buffer
+ * @note Used as parameter for @c fwAudioStreamGetStats . Playback counts no starved periods
+ *       before the first frame was written.
+ */
+typedef struct fwAudioStats {
+    uint64_t frames;
+    uint64_t xruns;
+    uint64_t starved;
+    uint32_t sampleRate;
+    uint32_t periodFrames;
+    uint32_t periods;
+} fwAudioStats;
+
+/**
+ * @brief Opens an audio device and starts the thread that feeds or drains it.
+ * @param configuration_p[in] Description of the stream
+ * @param stream_p[out] The new stream
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorModule The multimedia module is not running
+ * @return @c fwErrorInvalidParameter The configuration was missing
+ * @return @c fwErrorOutOfMemory The ring or the thread could not be created
+ * @return @c fwErrorAudioDevice The device could not be opened or configured
+ * @note Everything the audio thread touches is allocated and locked into memory here, the thread
+ *       itself never allocates, locks or logs.
+ */ // PlatDepImp
+fwError fwAudioStreamCreate(
+    const struct fwAudioConfiguration* configuration_p,
+    fwAudioStream* stream_p
+    );
+
+/**
+ * @brief Stops the audio thread and closes the device.
+ * @param stream[in] Stream to be destroyed
+ * @return @c fwErrorSuccess No error occured
+ */ // PlatDepImp
+fwError fwAudioStreamDestroy(
+    fwAudioStream stream
+    );
+
+/**
+ * @brief Hands samples to a playback stream, never blocks.
+ * @param stream[in] Playback stream without callback
+ * @param samples_p[in] Interleaved samples
+ * @param frames[in] Frames in @c samples_p
+ * @param written_p[out] Frames that fit into the ring, may be @c nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The stream captures or has a callback
+ */ // PlatDepImp
+fwError fwAudioStreamWrite(
+    fwAudioStream stream,
+    const int16_t* samples_p,
+    uint32_t frames,
+    uint32_t* written_p
+    );
+
+/**
+ * @brief Takes recorded samples from a capture stream, never blocks.
+ * @param stream[in] Capture stream without callback
+ * @param samples_p[out] Receives interleaved samples
+ * @param frames[in] Frames @c samples_p can hold
+ * @param read_p[out] Frames that were taken from the ring, may be @c nullptr
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The stream plays back or has a callback
+ */ // PlatDepImp
+fwError fwAudioStreamRead(
+    fwAudioStream stream,
+    int16_t* samples_p,
+    uint32_t frames,
+    uint32_t* read_p
+    );
+
+/**
+ * @brief Retrieves the counters of an audio stream.
+ * @param stream[in] Stream whose counters are retrieved
+ * @param stats_p[out] Receives the counters
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorAudioDevice The device failed in a way it could not recover from, the stream
+ *         has stopped
+ */ // PlatDepImp
+fwError fwAudioStreamGetStats(
+    fwAudioStream stream,
+    struct fwAudioStats* stats_p
+    );
+
 #endif //LPAF_FRAMEWORK_H
@@ -19,58 +19,436 @@
 #include "internal.h"
 #include "linux.h"
 
+#include <errno.h>
+#include <string.h>
+#include <alsa/asoundlib.h>
 #include <wayland-client.h>
 
-static struct wl_display* display = {};
+#include "xdg-shell-client-protocol.h" // generated by wayland-scanner at build time
 
-fwError fwiStartNativeModuleWindow(void) {
-    display = wl_display_connect(nullptr);
+// Highest interface versions the framework is written against, older compositors get their own
+#define FWI_WINDOW_COMPOSITOR_VERSION 4
+#define FWI_WINDOW_SHM_VERSION 1
+#define FWI_WINDOW_WM_BASE_VERSION 1
+
+/**
+ * @brief A global the compositor announced, only bound once something asks for it
+ */
+struct fwiWindowGlobal {
+    void* proxy_p; // nullptr until bound
+    uint32_t name;
+    uint32_t version; // 0 while the compositor does not offer it
+};
+
+static struct fwiWindowState {
+    struct wl_display* display_p;
+    struct wl_registry* registry_p;
+    struct fwiWindowGlobal compositor, shm, wmBase;
+    struct fwiEventSource source; // display connection, registered with at most one loop
+    bool flushPending; // the socket to the compositor was full, waits for it to drain
+} window_s = {};
+
+struct fwiNativeState nativeState_s = {
+    .fileIoQueueMutex = PTHREAD_MUTEX_INITIALIZER
+};
+
+struct fwiNativeState* fwiGetNativeState(void) {
+    return &nativeState_s;
+}
+
+fwError fwiEventLoopAddSource(struct fwiNativeEventLoop* loop_p, struct fwiEventSource* source_p,
+                              const uint32_t events) {
+    struct epoll_event event = {};
+    event.events   = events;
+    event.data.ptr = source_p;
+
+    if (epoll_ctl(loop_p->epollFileDescriptor, EPOLL_CTL_ADD, source_p->fileDescriptor,
+                  &event) == -1) {
+        FWI_LOG_ERRNO;
+        return fwErrorEventLoop;
+    }
+
+    source_p->loop_p = loop_p;
+    loop_p->sourceCount++;
+    return fwErrorSuccess;
+}
+
+fwError fwiEventLoopModifySource(struct fwiEventSource* source_p, const uint32_t events) {
+    struct epoll_event event = {};
+    event.events   = events;
+    event.data.ptr = source_p;
+
+    if (epoll_ctl(source_p->loop_p->epollFileDescriptor, EPOLL_CTL_MOD, source_p->fileDescriptor,
+                  &event) == -1) {
+        FWI_LOG_ERRNO;
+        return fwErrorEventLoop;
+    }
+    return fwErrorSuccess;
+}
+
+fwError fwiEventLoopRemoveSource(struct fwiEventSource* source_p) {
+    struct fwiNativeEventLoop* loop_p = source_p->loop_p;
+
+    // Fails harmlessly if the descriptor was already closed, the kernel dropped it by itself then
+    epoll_ctl(loop_p->epollFileDescriptor, EPOLL_CTL_DEL, source_p->fileDescriptor, nullptr);
+
+    // A callback earlier in the batch may remove a source whose event is still queued behind it,
+    // dispatching that event would touch freed or recycled state
+    if (loop_p->dispatching_p != nullptr) {
+        for (int32_t i = loop_p->dispatchIndex + 1; i < loop_p->dispatchCount; i++) {
+            if (loop_p->dispatching_p[i].data.ptr == source_p) {
+                loop_p->dispatching_p[i].data.ptr = nullptr;
+            }
+        }
+    }
+
+    source_p->loop_p = nullptr;
+    loop_p->sourceCount--;
+    return fwErrorSuccess;
+}
+
+static void fwiWindowRegistryGlobal([[maybe_unused]] void* data_p,
+                                    [[maybe_unused]] struct wl_registry* registry_p,
+                                    const uint32_t name, const char* interface_p,
+                                    const uint32_t version) {
+    struct fwiWindowGlobal* global_p = nullptr;
+    if (strcmp(interface_p, wl_compositor_interface.name) == 0) {
+        global_p = &window_s.compositor;
+    }
+    else if (strcmp(interface_p, wl_shm_interface.name) == 0) {
+        global_p = &window_s.shm;
+    }
+    else if (strcmp(interface_p, xdg_wm_base_interface.name) == 0) {
+        global_p = &window_s.wmBase;
+    }
+
+    if (global_p != nullptr) {
+        global_p->name    = name;
+        global_p->version = version;
+    }
+}
+
+static void fwiWindowRegistryGlobalRemove([[maybe_unused]] void* data_p,
+                                          [[maybe_unused]] struct wl_registry* registry_p,
+                                          const uint32_t name) {
+    struct fwiWindowGlobal* globals[] = {&window_s.compositor, &window_s.shm, &window_s.wmBase};
+    for (uint32_t i = 0; i < sizeof(globals) / sizeof(globals[0]); i++) {
+        if (globals[i]->version != 0 && globals[i]->name == name) {
+            globals[i]->version = 0; // a proxy that was already bound stays valid but inert
+        }
+    }
+}
+
+static const struct wl_registry_listener fwiWindowRegistryListener = {
+    .global        = fwiWindowRegistryGlobal,
+    .global_remove = fwiWindowRegistryGlobalRemove
+};
+
+static void fwiWindowWmBasePing([[maybe_unused]] void* data_p, struct xdg_wm_base* wmBase_p,
+                                const uint32_t serial) {
+    xdg_wm_base_pong(wmBase_p, serial);
+}
+
+static const struct xdg_wm_base_listener fwiWindowWmBaseListener = {
+    .ping = fwiWindowWmBasePing
+};
+
+static void* fwiWindowBind(struct fwiWindowGlobal* global_p, const struct wl_interface* interface_p,
+                           const uint32_t version) {
+    if (global_p->proxy_p == nullptr && global_p->version != 0 && window_s.registry_p != nullptr) {
+        global_p->proxy_p = wl_registry_bind(window_s.registry_p, global_p->name, interface_p,
+                                             global_p->version < version ? global_p->version :
+                                                                           version);
+    }
+    return global_p->proxy_p;
+}
+
+struct wl_display* fwiWindowGetDisplay(void) {
+    return window_s.display_p;
+}
+
+struct wl_compositor* fwiWindowGetCompositor(void) {
+    return fwiWindowBind(&window_s.compositor, &wl_compositor_interface,
+                         FWI_WINDOW_COMPOSITOR_VERSION);
+}
+
+struct wl_shm* fwiWindowGetShm(void) {
+    return fwiWindowBind(&window_s.shm, &wl_shm_interface, FWI_WINDOW_SHM_VERSION);
+}
+
+struct xdg_wm_base* fwiWindowGetWmBase(void) {
+    const bool unbound = window_s.wmBase.proxy_p == nullptr;
+    struct xdg_wm_base* wmBase_p = fwiWindowBind(&window_s.wmBase, &xdg_wm_base_interface,
+                                                 FWI_WINDOW_WM_BASE_VERSION);
+    if (unbound && wmBase_p != nullptr) {
+        // The compositor considers clients that leave pings unanswered as hung
+        xdg_wm_base_add_listener(wmBase_p, &fwiWindowWmBaseListener, nullptr);
+    }
+    return wmBase_p;
+}
+
+// Sends what is buffered for the compositor, waits for the socket to drain if it is full
+static void fwiWindowFlush(void) {
+    const bool pending = wl_display_flush(window_s.display_p) == -1 && errno == EAGAIN;
+    if (pending != window_s.flushPending && window_s.source.loop_p != nullptr) {
+        window_s.flushPending = pending;
+        fwiEventLoopModifySource(&window_s.source, EPOLLIN | (pending ? EPOLLOUT : 0));
+    }
+}
+
+static void fwiDispatchWindowEvent([[maybe_unused]] struct fwiEventSource* source_p,
+                                   const uint32_t events) {
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        FWI_LOG_ERROR("Connection to the Wayland display was lost");
+        fwiWindowDetach();
+        return;
+    }
+
+    if (events & EPOLLOUT) {
+        fwiWindowFlush();
+    }
+    // The events were already read by fwiWindowFinishRead right after the wait
+    // A display in error stays readable but never reads again, it would wake the loop forever
+    if ((events & EPOLLIN) && wl_display_dispatch_pending(window_s.display_p) == -1) {
+        FWI_LOG_ERROR("Wayland display reported protocol error %d",
+                      wl_display_get_error(window_s.display_p));
+        fwiWindowDetach();
+    }
+}
+
+fwError fwiWindowAttach(struct fwiNativeEventLoop* loop_p) {
+    if (window_s.display_p == nullptr) {
+        return fwErrorModule;
+    }
+    if (window_s.source.loop_p != nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    window_s.flushPending = false;
+    const fwError error = fwiEventLoopAddSource(loop_p, &window_s.source, EPOLLIN);
+    if (error != fwErrorSuccess) {
+        return error;
+    }
+    loop_p->windowSource_p = &window_s.source;
+    return fwErrorSuccess;
+}
+
+fwError fwiWindowDetach(void) {
+    struct fwiNativeEventLoop* loop_p = window_s.source.loop_p;
+    if (loop_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+
+    loop_p->windowSource_p = nullptr;
+    return fwiEventLoopRemoveSource(&window_s.source);
+}
+
+void fwiWindowPrepareRead(void) {
+    // Events another read queued up have to be dispatched before this thread may read itself
+    while (wl_display_prepare_read(window_s.display_p) != 0) {
+        if (wl_display_dispatch_pending(window_s.display_p) == -1) {
+            FWI_LOG_ERROR("Wayland display reported protocol error %d",
+                          wl_display_get_error(window_s.display_p));
+            fwiWindowDetach(); // the queue is never emptied again, nothing could be read
+            return;
+        }
+    }
+    fwiWindowFlush();
+}
+
+void fwiWindowFinishRead(const bool readable) {
+    if (!readable) {
+        wl_display_cancel_read(window_s.display_p);
+        return;
+    }
+    if (wl_display_read_events(window_s.display_p) == -1 && errno != EAGAIN) {
+        FWI_LOG_ERRNO;
+    }
+}
 
-    struct wl_registry* reg = wl_display_get_registry(display);
+fwError fwiStartNativeModuleWindow(void) {
+    if ((window_s.display_p = wl_display_connect(nullptr)) == nullptr) {
+        FWI_LOG_ERROR("Could not connect to a Wayland display");
+        return fwErrorWindowConnect;
+    }
 
-    if (display == nullptr) {
+    // One roundtrip collects the globals, none of them is bound before it is needed
+    window_s.registry_p = wl_display_get_registry(window_s.display_p);
+    if (window_s.registry_p == nullptr ||
+        wl_registry_add_listener(window_s.registry_p, &fwiWindowRegistryListener, nullptr) != 0 ||
+        wl_display_roundtrip(window_s.display_p) == -1) {
+        FWI_LOG_ERROR("Could not fetch the globals of the Wayland display");
+        fwiStopNativeModuleWindow();
         return fwErrorWindowConnect;
     }
+
+    window_s.source.handler        = fwiDispatchWindowEvent;
+    window_s.source.context_p      = &window_s;
+    window_s.source.fileDescriptor = wl_display_get_fd(window_s.display_p);
+
+    FWI_LOG_INFO("Window module was started");
     return fwErrorSuccess;
 }
 
 fwError fwiStopNativeModuleWindow(void) {
-    wl_display_disconnect(display);
+    if (window_s.source.loop_p != nullptr) {
+        fwiWindowDetach();
+    }
+
+    if (window_s.wmBase.proxy_p != nullptr) {
+        xdg_wm_base_destroy(window_s.wmBase.proxy_p);
+    }
+    if (window_s.shm.proxy_p != nullptr) {
+        wl_shm_destroy(window_s.shm.proxy_p);
+    }
+    if (window_s.compositor.proxy_p != nullptr) {
+        wl_compositor_destroy(window_s.compositor.proxy_p);
+    }
+    if (window_s.registry_p != nullptr) {
+        wl_registry_destroy(window_s.registry_p);
+    }
+    if (window_s.display_p != nullptr) {
+        wl_display_disconnect(window_s.display_p);
+    }
+    window_s = (struct fwiWindowState){};
+
+    FWI_LOG_INFO("Window module was stopped");
     return fwErrorSuccess;
 }
 
-fwError fwiStartNativeModuleNetwork(void) {
-    fwiLogA(fwiLogLevelInfo, "Networking module was started");
-
+fwError fwiStartNativeModuleNetwork(const uint32_t flags) {
     // Because Linux is just better there is no state to be set before networking syscall can be
-    // used
+    // used, only the socket table and the optional parts of the module need setting up
+
+    const fwError tableError = fwiSocketTableCreate();
+    if (tableError != fwErrorSuccess) {
+        return tableError;
+    }
+
+    if (flags & fwModuleFlagNetworkEventLoop) {
+        const fwError error = fwEventLoopCreate(&nativeState_s.defaultEventLoop);
+        if (error != fwErrorSuccess) {
+            fwiStopNativeModuleNetwork();
+            return error;
+        }
+    }
 
+    if (flags & fwModuleFlagNetworkIoUring) {
+        fwError error = fwIoQueueCreate(FWI_IO_QUEUE_DEFAULT_ENTRIES,
+                                        &nativeState_s.defaultIoQueue);
+        if (error != fwErrorSuccess) {
+            fwiStopNativeModuleNetwork();
+            return error;
+        }
+
+        if ((error = fwIoQueueCreate(FWI_IO_QUEUE_FILE_ENTRIES, &nativeState_s.fileIoQueue)) !=
+            fwErrorSuccess) {
+            fwiStopNativeModuleNetwork();
+            return error;
+        }
+    }
+
+    FWI_LOG_INFO("Networking module was started");
     return fwErrorSuccess;
 }
 
 fwError fwiStopNativeModuleNetwork(void) {
-    fwiLogA(fwiLogLevelInfo, "Networking module was stopped");
+    if (nativeState_s.defaultEventLoop != 0) {
+        fwEventLoopDestroy(nativeState_s.defaultEventLoop);
+        nativeState_s.defaultEventLoop = 0;
+    }
+
+    if (nativeState_s.defaultIoQueue != 0) {
+        fwIoQueueDestroy(nativeState_s.defaultIoQueue);
+        nativeState_s.defaultIoQueue = 0;
+    }
+
+    if (nativeState_s.fileIoQueue != 0) {
+        pthread_mutex_lock(&nativeState_s.fileIoQueueMutex);
+        fwIoQueueDestroy(nativeState_s.fileIoQueue);
+        nativeState_s.fileIoQueue = 0;
+        pthread_mutex_unlock(&nativeState_s.fileIoQueueMutex);
+    }
 
-    // Because Linux is just better there is no state to be set after networking syscalls are done
-    // being used
+    fwiSocketTableDestroy();
+    fwResolverFlush();
 
+    FWI_LOG_INFO("Networking module was stopped");
+    return fwErrorSuccess;
+}
+
+fwError fwiStartNativeModuleJob(void) {
+    struct fwSystemConfiguration configuration = {};
+    fwGetSystemConfiguration(&configuration);
+
+    // The thread that waits on a counter runs jobs too, so one core is left to it
+    const uint32_t workers = configuration.cores > 1 ? configuration.cores - 1 : 1;
+    const fwError error = fwiJobSystemCreate(workers);
+    if (error != fwErrorSuccess) {
+        return error;
+    }
+
+    FWI_LOG_INFO("Job module was started with %u workers", workers);
+    return fwErrorSuccess;
+}
+
+fwError fwiStopNativeModuleJob(void) {
+    fwiJobSystemDestroy();
+
+    FWI_LOG_INFO("Job module was stopped");
     return fwErrorSuccess;
 }
 
 fwError fwiStartNativeModuleRenderer(void) {
-    return fwErrorUnimplemented;
+    if (window_s.display_p == nullptr) {
+        FWI_LOG_ERROR("Render module needs the window module to be running");
+        return fwErrorModule;
+    }
+    if (fwiWindowGetCompositor() == nullptr || fwiWindowGetShm() == nullptr ||
+        fwiWindowGetWmBase() == nullptr) {
+        FWI_LOG_ERROR("Compositor offers no wl_compositor, wl_shm or xdg_wm_base");
+        return fwErrorModule;
+    }
+
+    nativeState_s.renderKernels_p = fwiRenderSelectKernels();
+    FWI_LOG_INFO("Render module was started with %s kernels",
+                 nativeState_s.renderKernels_p->name_p);
+    return fwErrorSuccess;
 }
 
 fwError fwiStopNativeModuleRenderer(void) {
-    return fwErrorUnimplemented;
+    if (nativeState_s.renderSurfaceCount != 0) {
+        FWI_LOG_WARNING("Render module stopped with %u surfaces left",
+                        nativeState_s.renderSurfaceCount);
+    }
+
+    nativeState_s.renderKernels_p = nullptr;
+    FWI_LOG_INFO("Render module was stopped");
+    return fwErrorSuccess;
 }
 
 fwError fwiStartNativeModuleMultimedia(void) {
-    return fwErrorUnimplemented;
+    // Devices are opened per stream, but the first open would parse the configuration tree of
+    // alsa-lib, that is done here where it can overlap with other modules starting
+    const int32_t result = snd_config_update();
+    if (result < 0) {
+        FWI_LOG_WARNING("ALSA configuration could not be loaded: %s", snd_strerror(result));
+    }
+    nativeState_s.multimediaRunning = true;
+
+    FWI_LOG_INFO("Multimedia module was started");
+    return fwErrorSuccess;
 }
 
 fwError fwiStopNativeModuleMultimedia(void) {
-    return fwErrorUnimplemented;
+    if (nativeState_s.audioStreamCount != 0) {
+        FWI_LOG_WARNING("Multimedia module stopped with %u audio streams left",
+                        nativeState_s.audioStreamCount);
+    }
+
+    nativeState_s.multimediaRunning = false;
+    FWI_LOG_INFO("Multimedia module was stopped");
+    return fwErrorSuccess;
 }
 
 #endif // PLATFORM_LINUX
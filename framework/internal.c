@@ -14,185 +14,1500 @@
 
 // This implementation file contains implementations for platform independant, internal symbols
 
+#include <inttypes.h>
+#include <pthread.h>
 #include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <wchar.h>
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #include "internal.h"
 #include "framework.h"
 
+#define FWI_LOG_RING_SIZE           65536 // per thread, must be a power of two
+#define FWI_LOG_BATCH_SIZE          65536
+#define FWI_LOG_FILENAME_MAX        256
+#define FWI_LOG_DEFAULT_FILE        "lpaf.log"
+#if defined(BUILD_RELEASE)
+#define FWI_LOG_DEFAULT_INTERVAL    250 // ms
+#else
+#define FWI_LOG_DEFAULT_INTERVAL    10 // ms
+#endif
+
+#if defined(BUILD_DEBUG) || defined(BUILD_RELEASE)
+#define FWI_LOG_ENABLED
+#endif
+
+/**
+ * @brief Single producer single consumer ring, one per logging thread
+ * @note head and cachedTail are only touched by the owning thread, tail only by the writer thread.
+ *       They live on their own cache lines so the two sides do not fight over them.
+ */
+struct fwiLogRing {
+    alignas(64) _Atomic uint64_t head;
+    uint64_t cachedTail;
+    alignas(64) _Atomic uint64_t tail;
+    alignas(64) struct fwiLogRing* next_p;
+    atomic_uint_fast64_t dropped;
+    atomic_bool abandoned;
+    uint8_t data[FWI_LOG_RING_SIZE];
+};
+
+struct fwiLogger {
+    _Atomic(struct fwiLogRing*) rings_p;
+    FILE* sink_p;
+    pthread_t writer;
+    pthread_mutex_t wakeMutex;
+    pthread_cond_t wakeCondition;
+    pthread_key_t threadKey;
+    pthread_once_t keyOnce;
+    pthread_once_t exitOnce;
+    uint32_t flushInterval;
+    bool running;
+    bool writerIsUp;
+    int64_t stampSecond;
+    char stamp[32];
+    char filename[FWI_LOG_FILENAME_MAX];
+    char batch[FWI_LOG_BATCH_SIZE];
+};
+
 struct fwiState frameworkState_s = {0};
 
+static struct fwiLogger logger_s = {
+    .wakeMutex = PTHREAD_MUTEX_INITIALIZER,
+    .keyOnce = PTHREAD_ONCE_INIT,
+    .exitOnce = PTHREAD_ONCE_INIT,
+    .flushInterval = FWI_LOG_DEFAULT_INTERVAL,
+    .stampSecond = -1,
+    .filename = FWI_LOG_DEFAULT_FILE
+};
+
+static thread_local struct fwiLogRing* threadRing_s = nullptr;
+
+// Provided by the linker for the section that FWI_LOG places its sites in
+extern const struct fwiLogSite __start_fwi_log_sites[] __attribute__((weak));
+extern const struct fwiLogSite __stop_fwi_log_sites[] __attribute__((weak));
+
 struct fwiState* fwiGetState(void) {
     return &frameworkState_s;
 }
 
-void fwiLogA(const fwiLogLevel lll, const char* format_p,  ...) {
-#ifdef BUILD_DEBUG
-    const time_t rawTime  = time(nullptr);
-    const struct tm* time = localtime(&rawTime);
+static void fwiLogReleaseRing(void* ring_p) {
+    // The writer thread frees the ring once everything in it has been written out
+    threadRing_s = nullptr;
+    atomic_store_explicit(&((struct fwiLogRing*)ring_p)->abandoned, true, memory_order_release);
+}
 
-    char buf[10] = {};
-    const size_t bytesWritten = strftime(buf, 10, "[%H:%M:%S", time);
-    if (bytesWritten == 0) {
-        printf("Failed to get local time");
+static void fwiLogCreateKey(void) {
+    pthread_key_create(&logger_s.threadKey, fwiLogReleaseRing);
+}
+
+static struct fwiLogRing* fwiLogGetRing(void) {
+    if (threadRing_s != nullptr) {
+        return threadRing_s;
+    }
+
+    struct fwiLogRing* ring_p = aligned_alloc(64, sizeof(struct fwiLogRing));
+    if (ring_p == nullptr) {
+        return nullptr;
+    }
+    memset(ring_p, 0, offsetof(struct fwiLogRing, data));
+
+    pthread_once(&logger_s.keyOnce, fwiLogCreateKey);
+    pthread_setspecific(logger_s.threadKey, ring_p);
+
+    struct fwiLogRing* head_p = atomic_load_explicit(&logger_s.rings_p, memory_order_relaxed);
+    do {
+        ring_p->next_p = head_p;
+    } while (!atomic_compare_exchange_weak_explicit(&logger_s.rings_p, &head_p, ring_p,
+        memory_order_release, memory_order_relaxed));
+
+    threadRing_s = ring_p;
+    return ring_p;
+}
+
+static void fwiLogRingWrite(struct fwiLogRing* ring_p, const uint64_t position, const void* data_p,
+    const size_t size) {
+    const size_t offset = position & (FWI_LOG_RING_SIZE - 1);
+    const size_t first  = size < FWI_LOG_RING_SIZE - offset ? size : FWI_LOG_RING_SIZE - offset;
+    memcpy(ring_p->data + offset, data_p, first);
+    memcpy(ring_p->data, (const uint8_t*)data_p + first, size - first);
+}
+
+static void fwiLogRingRead(const struct fwiLogRing* ring_p, const uint64_t position, void* data_p,
+    const size_t size) {
+    const size_t offset = position & (FWI_LOG_RING_SIZE - 1);
+    const size_t first  = size < FWI_LOG_RING_SIZE - offset ? size : FWI_LOG_RING_SIZE - offset;
+    memcpy(data_p, ring_p->data + offset, first);
+    memcpy((uint8_t*)data_p + first, ring_p->data, size - first);
+}
+
+static void fwiLogPush(const fwiLogLevel lll, const fwiLogKind kind, const char* message_p,
+    const size_t length) {
+    struct fwiLogRing* ring_p = fwiLogGetRing();
+    if (ring_p == nullptr) {
+        return;
+    }
+
+    struct timespec now = {};
+    timespec_get(&now, TIME_UTC);
+
+    const struct fwiLogRecord record = {
+        .seconds = now.tv_sec,
+        .nanoseconds = (int32_t)now.tv_nsec,
+        .length = (uint16_t)length,
+        .level = lll,
+        .kind = kind
+    };
+    const uint64_t size = sizeof(record) + length;
+
+    const uint64_t head = atomic_load_explicit(&ring_p->head, memory_order_relaxed);
+    if (FWI_LOG_RING_SIZE - (head - ring_p->cachedTail) < size) {
+        ring_p->cachedTail = atomic_load_explicit(&ring_p->tail, memory_order_acquire);
+        if (FWI_LOG_RING_SIZE - (head - ring_p->cachedTail) < size) {
+            // Never block the caller, the writer reports how many messages went missing
+            atomic_fetch_add_explicit(&ring_p->dropped, 1, memory_order_relaxed);
+            return;
+        }
+    }
+
+    fwiLogRingWrite(ring_p, head, &record, sizeof(record));
+    fwiLogRingWrite(ring_p, head + sizeof(record), message_p, length);
+    atomic_store_explicit(&ring_p->head, head + size, memory_order_release);
+}
+
+static void fwiLogPushFormatA(const fwiLogLevel lll, const fwiLogKind kind, const char* format_p,
+    va_list args) {
+    char message[FWI_LOG_MESSAGE_MAX];
+    const int32_t written = vsnprintf(message, sizeof(message), format_p, args);
+    if (written < 0) {
+        return;
+    }
+
+    fwiLogPush(lll, kind, message, (size_t)written < sizeof(message) ? (size_t)written
+        : sizeof(message) - 1);
+}
+
+static void fwiLogPushFormatW(const fwiLogLevel lll, const fwiLogKind kind,
+    const wchar_t* format_p, va_list args) {
+    wchar_t wideMessage[FWI_LOG_MESSAGE_MAX];
+    if (vswprintf(wideMessage, FWI_LOG_MESSAGE_MAX, format_p, args) < 0) {
+        wideMessage[FWI_LOG_MESSAGE_MAX - 1] = L'\0'; // truncated
+    }
+
+    char message[FWI_LOG_MESSAGE_MAX];
+    const size_t length = wcstombs(message, wideMessage, sizeof(message) - 1);
+    if (length == (size_t)-1) {
+        static const char unconvertible[] = "(message could not be converted)";
+        fwiLogPush(lll, kind, unconvertible, sizeof(unconvertible) - 1);
         return;
     }
 
-    pthread_mutex_lock(&frameworkState_s.loggerMutex);
+    fwiLogPush(lll, kind, message, length);
+}
+
+void fwiLogA(const fwiLogLevel lll, const char* format_p,  ...) {
+#ifdef FWI_LOG_ENABLED
+    va_list args = {0u};
+    va_start(args);
+    fwiLogPushFormatA(lll, fwiLogKindMessage, format_p, args);
+    va_end(args);
+#endif // FWI_LOG_ENABLED
+}
+
+void fwiLogW(const fwiLogLevel lll, const wchar_t* format_p, ...) {
+#ifdef FWI_LOG_ENABLED
+    va_list args = {0u};
+    va_start(args);
+    fwiLogPushFormatW(lll, fwiLogKindMessage, format_p, args);
+    va_end(args);
+#endif // FWI_LOG_ENABLED
+}
+
+void fwiLogFollowupA(const bool isLast, const char* format_p, ...) {
+#ifdef FWI_LOG_ENABLED
+    va_list args = {0u};
+    va_start(args);
+    fwiLogPushFormatA(fwiLogLevelInfo, isLast ? fwiLogKindFollowupLast : fwiLogKindFollowup,
+        format_p, args);
+    va_end(args);
+#endif // FWI_LOG_ENABLED
+}
+
+void fwiLogFollowupW(const bool isLast, const wchar_t* format_p, ...) {
+#ifdef FWI_LOG_ENABLED
+    va_list args = {0u};
+    va_start(args);
+    fwiLogPushFormatW(fwiLogLevelInfo, isLast ? fwiLogKindFollowupLast : fwiLogKindFollowup,
+        format_p, args);
+    va_end(args);
+#endif // FWI_LOG_ENABLED
+}
+
+const char* fwiLogNextConversion(const char* format_p, struct fwiLogConversion* conversion_p) {
+    const char* cursor_p = strchr(format_p, '%');
+    if (cursor_p == nullptr) {
+        return nullptr;
+    }
+
+    *conversion_p = (struct fwiLogConversion){ .start_p = cursor_p };
+    ++cursor_p;
+
+    while (*cursor_p != '\0' && strchr("-+ #0'", *cursor_p) != nullptr) {
+        ++cursor_p;
+    }
+    for (uint8_t field = 0; field < 2; ++field) { // width, then precision
+        if (*cursor_p == '*') {
+            ++conversion_p->stars;
+            ++cursor_p;
+        }
+        while (*cursor_p >= '0' && *cursor_p <= '9') {
+            ++cursor_p;
+        }
+        if (field == 0 && *cursor_p == '.') {
+            ++cursor_p;
+        }
+        else {
+            break;
+        }
+    }
+
+    uint8_t longs = 0;
+    char modifier = '\0';
+    while (*cursor_p != '\0' && strchr("hlLjzt", *cursor_p) != nullptr) {
+        longs += *cursor_p == 'l';
+        modifier = *cursor_p;
+        ++cursor_p;
+    }
+
+    const char specifier = *cursor_p;
+    if (specifier != '\0') {
+        ++cursor_p;
+    }
+    conversion_p->length = (size_t)(cursor_p - conversion_p->start_p);
 
-    switch (lll) {
-        case fwiLogLevelError: {
-            printf("%s "FW_ESCAPE_RED"ERROR"FW_ESCAPE_NORMAL"]: ", buf);
+    switch (specifier) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': {
+            conversion_p->argument = modifier == 'j' ? fwiLogArgumentIntMax
+                : modifier == 'z' ? fwiLogArgumentSize
+                : modifier == 't' ? fwiLogArgumentPtrDiff
+                : longs >= 2 ? fwiLogArgumentLongLong
+                : longs == 1 ? fwiLogArgumentLong
+                : fwiLogArgumentInt;
+            break;
+        }
+        case 'c': {
+            conversion_p->argument = longs != 0 ? fwiLogArgumentWideChar : fwiLogArgumentInt;
             break;
         }
-        case fwiLogLevelWarning: {
-            printf("%s "FW_ESCAPE_YELLOW"WARNING"FW_ESCAPE_NORMAL"]: ", buf);
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+            conversion_p->argument = modifier == 'L' ? fwiLogArgumentLongDouble
+                : fwiLogArgumentDouble;
             break;
         }
-        case fwiLogLevelInfo: {
-            printf("%s "FW_ESCAPE_CYAN"INFO"FW_ESCAPE_NORMAL"]: ", buf);
+        case 's': {
+            conversion_p->argument = longs != 0 ? fwiLogArgumentWideString : fwiLogArgumentString;
             break;
         }
-        case fwiLogLevelDebug: {
-            printf("%s "FW_ESCAPE_GREEN"DEBUG"FW_ESCAPE_NORMAL"]: ", buf);
+        case 'p': {
+            conversion_p->argument = fwiLogArgumentPointer;
             break;
         }
-        case fwiLogLevelBench: {
-            printf("%s "FW_ESCAPE_MAGENTA"BENCHMARK"FW_ESCAPE_NORMAL"]: ", buf);
+        default: { // "%%", "%n" and malformed specifications do not take an argument
+            conversion_p->argument = fwiLogArgumentNone;
+            conversion_p->stars = 0;
             break;
         }
     }
 
+    return cursor_p;
+}
+
+static bool fwiLogEncode(uint8_t* payload_p, size_t* used_p, const void* data_p,
+    const size_t size) {
+    if (FWI_LOG_MESSAGE_MAX - *used_p < size) {
+        return false;
+    }
+
+    memcpy(payload_p + *used_p, data_p, size);
+    *used_p += size;
+    return true;
+}
+
+static bool fwiLogEncodeString(uint8_t* payload_p, size_t* used_p, const char* string_p,
+    size_t length) {
+    if (*used_p + sizeof(uint16_t) > FWI_LOG_MESSAGE_MAX) {
+        return false;
+    }
+    if (length > FWI_LOG_MESSAGE_MAX - *used_p - sizeof(uint16_t)) {
+        length = FWI_LOG_MESSAGE_MAX - *used_p - sizeof(uint16_t); // truncated, still decodable
+    }
+
+    const uint16_t encodedLength = (uint16_t)length;
+    fwiLogEncode(payload_p, used_p, &encodedLength, sizeof(encodedLength));
+    return fwiLogEncode(payload_p, used_p, string_p, length);
+}
+
+size_t fwiLogEncodeArguments(const char* format_p, uint8_t* payload_p, size_t used,
+    va_list args) {
+    struct fwiLogConversion conversion = {};
+    const char* cursor_p = format_p;
+    bool fits = true;
+    while (fits && (cursor_p = fwiLogNextConversion(cursor_p, &conversion)) != nullptr) {
+        for (uint8_t star = 0; star < conversion.stars && fits; ++star) {
+            const int32_t value = va_arg(args, int);
+            fits = fwiLogEncode(payload_p, &used, &value, sizeof(value));
+        }
+
+        uint64_t value = 0;
+        switch (conversion.argument) {
+            case fwiLogArgumentNone: {
+                continue;
+            }
+            case fwiLogArgumentInt: {
+                value = (uint64_t)(int64_t)va_arg(args, int);
+                break;
+            }
+            case fwiLogArgumentLong: {
+                value = (uint64_t)(int64_t)va_arg(args, long);
+                break;
+            }
+            case fwiLogArgumentLongLong: {
+                value = (uint64_t)va_arg(args, long long);
+                break;
+            }
+            case fwiLogArgumentIntMax: {
+                value = (uint64_t)va_arg(args, intmax_t);
+                break;
+            }
+            case fwiLogArgumentSize: {
+                value = (uint64_t)va_arg(args, size_t);
+                break;
+            }
+            case fwiLogArgumentPtrDiff: {
+                value = (uint64_t)va_arg(args, ptrdiff_t);
+                break;
+            }
+            case fwiLogArgumentWideChar: {
+                value = (uint64_t)va_arg(args, wint_t);
+                break;
+            }
+            case fwiLogArgumentDouble: {
+                const double real = va_arg(args, double);
+                memcpy(&value, &real, sizeof(value));
+                break;
+            }
+            case fwiLogArgumentLongDouble: {
+                const double real = (double)va_arg(args, long double);
+                memcpy(&value, &real, sizeof(value));
+                break;
+            }
+            case fwiLogArgumentPointer: {
+                value = (uint64_t)(uintptr_t)va_arg(args, void*);
+                break;
+            }
+            case fwiLogArgumentString: {
+                const char* string_p = va_arg(args, const char*);
+                if (string_p == nullptr) {
+                    string_p = "(null)";
+                }
+                fits = fwiLogEncodeString(payload_p, &used, string_p, strlen(string_p));
+                continue;
+            }
+            case fwiLogArgumentWideString: {
+                const wchar_t* wideString_p = va_arg(args, const wchar_t*);
+                char string[FWI_LOG_MESSAGE_MAX];
+                size_t length = wideString_p != nullptr ? wcstombs(string, wideString_p,
+                    sizeof(string) - 1) : (size_t)-1;
+                if (length == (size_t)-1) {
+                    length = 0;
+                }
+                fits = fwiLogEncodeString(payload_p, &used, string, length);
+                continue;
+            }
+        }
+        fits = fits && fwiLogEncode(payload_p, &used, &value, sizeof(value));
+    }
+
+    return used;
+}
+
+void fwiLogBinary(const struct fwiLogSite* site_p, ...) {
+#ifdef FWI_LOG_ENABLED
+    uint8_t payload[FWI_LOG_MESSAGE_MAX];
+    size_t used = 0;
+    const uint32_t index = (uint32_t)(site_p - __start_fwi_log_sites);
+    fwiLogEncode(payload, &used, &index, sizeof(index));
+
     va_list args = {0u};
     va_start(args);
-    vprintf(format_p, args);
+    used = fwiLogEncodeArguments(site_p->format_p, payload, used, args);
     va_end(args);
-    printf("\n");
 
-    pthread_mutex_unlock(&frameworkState_s.loggerMutex);
-#endif // BUILD_DEBUG
-#ifdef BUILD_RELEASE
-    // TODO: implement logging to file
-#endif // BUILD_RELEASE
+    // The decoder stops at the end of the payload, so a message that did not fit is cut short
+    fwiLogPush(site_p->level, fwiLogKindBinary, (const char*)payload, used);
+#endif // FWI_LOG_ENABLED
 }
 
-void fwiLogW(const fwiLogLevel lll, const wchar_t* format_p, ...) {
-#ifdef BUILD_DEBUG
-    const time_t rawTime  = time(nullptr);
-    const struct tm* time = localtime(&rawTime);
+struct fwiLogReader {
+    const uint8_t* data_p;
+    size_t size;
+    size_t offset;
+};
 
-    char buf[10]              = {};
-    const size_t bytesWritten = strftime(buf, 30, "[%H:%M:%S", time);
-    if (bytesWritten == 0) {
-        printf("Failed to get local time");
-        return;
+static bool fwiLogRead(struct fwiLogReader* reader_p, void* out_p, const size_t size) {
+    if (reader_p->size - reader_p->offset < size) {
+        return false;
     }
 
-    pthread_mutex_lock(&frameworkState_s.loggerMutex);
+    memcpy(out_p, reader_p->data_p + reader_p->offset, size);
+    reader_p->offset += size;
+    return true;
+}
 
-    switch (lll) {
-        case fwiLogLevelError: {
-            printf("%s ERROR]: ", buf);
-            break;
+static bool fwiLogReadString(struct fwiLogReader* reader_p, char* out_p, const size_t size) {
+    uint16_t length = 0;
+    if (!fwiLogRead(reader_p, &length, sizeof(length)) || length >= size) {
+        return false;
+    }
+
+    out_p[length] = '\0';
+    return fwiLogRead(reader_p, out_p, length);
+}
+
+/**
+ * @brief Copies a conversion specification while replacing '*' with the recorded values
+ */
+static bool fwiLogBuildSpecification(char* out_p, const size_t size,
+    const struct fwiLogConversion* conversion_p, struct fwiLogReader* payload_p) {
+    size_t used = 0;
+    for (size_t i = 0; i < conversion_p->length; ++i) {
+        const char character = conversion_p->start_p[i];
+        if (character == '*') {
+            int32_t value = 0;
+            if (!fwiLogRead(payload_p, &value, sizeof(value))) {
+                return false;
+            }
+            used += (size_t)snprintf(out_p + used, size - used, "%"PRId32, value);
         }
-        case fwiLogLevelWarning: {
-            printf("%s WARNING]: ", buf);
-            break;
+        else if (conversion_p->argument == fwiLogArgumentWideString && character == 'l') {
+            continue; // the encoder already converted the string to multibyte
         }
-        case fwiLogLevelInfo: {
-            printf("%s INFO]: ", buf);
-            break;
+        else if (used + 1 < size) {
+            out_p[used++] = character;
         }
-        case fwiLogLevelDebug: {
-            printf("%s DEBUG]: ", buf);
-            break;
+        if (used >= size) {
+            return false;
         }
-        case fwiLogLevelBench: {
-            printf("%s BENCHMARK]: ", buf);
+    }
+
+    out_p[used] = '\0';
+    return true;
+}
+
+void fwiLogRenderBinary(const char* format_p, const uint8_t* payload_p, const size_t length,
+    char* out_p, const size_t size) {
+    struct fwiLogReader payload = { .data_p = payload_p, .size = length };
+    size_t used = 0;
+    const char* cursor_p = format_p;
+    struct fwiLogConversion conversion = {};
+    const char* next_p = nullptr;
+
+    while (used < size && (next_p = fwiLogNextConversion(cursor_p, &conversion)) != nullptr) {
+        used += (size_t)snprintf(out_p + used, size - used, "%.*s",
+            (int32_t)(conversion.start_p - cursor_p), cursor_p);
+        cursor_p = next_p;
+        if (used >= size) {
             break;
         }
+
+        char specification[64];
+        char string[FWI_LOG_MESSAGE_MAX];
+        uint64_t value = 0;
+        double real = 0.0;
+        bool complete = conversion.length < sizeof(specification) - 16
+            && fwiLogBuildSpecification(specification, sizeof(specification), &conversion,
+                &payload);
+
+        if (complete && (conversion.argument == fwiLogArgumentString
+            || conversion.argument == fwiLogArgumentWideString)) {
+            complete = fwiLogReadString(&payload, string, sizeof(string));
+        }
+        else if (complete && conversion.argument != fwiLogArgumentNone) {
+            complete = fwiLogRead(&payload, &value, sizeof(value));
+            memcpy(&real, &value, sizeof(real));
+        }
+        if (!complete) {
+            snprintf(out_p + used, size - used, "<truncated>");
+            return;
+        }
+
+        const size_t room = size - used;
+        char* at_p = out_p + used;
+        int32_t written = 0;
+        switch (conversion.argument) {
+            case fwiLogArgumentNone: {
+                written = snprintf(at_p, room, "%s", specification[1] == '%' ? "%" : "");
+                break;
+            }
+            case fwiLogArgumentInt: {
+                written = snprintf(at_p, room, specification, (int32_t)value);
+                break;
+            }
+            case fwiLogArgumentLong: {
+                written = snprintf(at_p, room, specification, (long)value);
+                break;
+            }
+            case fwiLogArgumentLongLong: {
+                written = snprintf(at_p, room, specification, (long long)value);
+                break;
+            }
+            case fwiLogArgumentIntMax: {
+                written = snprintf(at_p, room, specification, (intmax_t)value);
+                break;
+            }
+            case fwiLogArgumentSize: {
+                written = snprintf(at_p, room, specification, (size_t)value);
+                break;
+            }
+            case fwiLogArgumentPtrDiff: {
+                written = snprintf(at_p, room, specification, (ptrdiff_t)value);
+                break;
+            }
+            case fwiLogArgumentWideChar: {
+                written = snprintf(at_p, room, specification, (wint_t)value);
+                break;
+            }
+            case fwiLogArgumentDouble: {
+                written = snprintf(at_p, room, specification, real);
+                break;
+            }
+            case fwiLogArgumentLongDouble: {
+                written = snprintf(at_p, room, specification, (long double)real);
+                break;
+            }
+            case fwiLogArgumentPointer: {
+                written = snprintf(at_p, room, specification, (void*)(uintptr_t)value);
+                break;
+            }
+            case fwiLogArgumentString:
+            case fwiLogArgumentWideString: {
+                written = snprintf(at_p, room, specification, string);
+                break;
+            }
+        }
+        used += written > 0 ? (size_t)written : 0;
     }
 
-    va_list args = {0u};
-    va_start(args);
-    vwprintf(format_p, args);
-    va_end(args);
-    printf("\n");
+    if (used < size) {
+        snprintf(out_p + used, size - used, "%s", cursor_p);
+    }
+}
+
+void fwiLogGetThreadCounters(uint64_t* pushed_p, uint64_t* dropped_p) {
+    const struct fwiLogRing* ring_p = threadRing_s;
+    *pushed_p  = ring_p != nullptr ? atomic_load_explicit(&ring_p->head, memory_order_relaxed) : 0;
+    *dropped_p = ring_p != nullptr ? atomic_load_explicit(&ring_p->dropped, memory_order_relaxed)
+        : 0;
+}
+
+static void fwiLogFlushBatch(size_t* used_p) {
+    if (*used_p == 0 || logger_s.sink_p == nullptr) {
+        *used_p = 0;
+        return;
+    }
+
+    fwrite(logger_s.batch, 1, *used_p, logger_s.sink_p);
+    fflush(logger_s.sink_p);
+    *used_p = 0;
+}
+
+static void fwiLogFormatRecord(size_t* used_p, const struct fwiLogRecord* record_p,
+    const char* message_p) {
+    if (FWI_LOG_BATCH_SIZE - *used_p < FWI_LOG_MESSAGE_MAX + 64) {
+        fwiLogFlushBatch(used_p);
+    }
+
+#ifdef FWI_LOG_BINARY
+    // Rendering is left to the offline decoder
+    memcpy(logger_s.batch + *used_p, record_p, sizeof(*record_p));
+    memcpy(logger_s.batch + *used_p + sizeof(*record_p), message_p, record_p->length);
+    *used_p += sizeof(*record_p) + record_p->length;
+    return;
+#endif // FWI_LOG_BINARY
+
+    char* out_p = logger_s.batch + *used_p;
+    const size_t room = FWI_LOG_BATCH_SIZE - *used_p;
+    int32_t written = 0;
+
+    if (record_p->kind != fwiLogKindMessage) {
+        written = snprintf(out_p, room, "%s - %.*s\n",
+            record_p->kind == fwiLogKindFollowupLast ? "\\" : "|", record_p->length, message_p);
+        *used_p += written > 0 ? (size_t)written : 0;
+        return;
+    }
+
+    // The timestamp only changes once per second, so there is no point formatting it every time
+    if (record_p->seconds != logger_s.stampSecond) {
+        const time_t rawTime = (time_t)record_p->seconds;
+        struct tm time = {};
+        localtime_r(&rawTime, &time);
+#ifdef BUILD_RELEASE
+        strftime(logger_s.stamp, sizeof(logger_s.stamp), "%Y-%m-%d %H:%M:%S", &time);
+#else
+        strftime(logger_s.stamp, sizeof(logger_s.stamp), "%H:%M:%S", &time);
+#endif // BUILD_RELEASE
+        logger_s.stampSecond = record_p->seconds;
+    }
 
-    pthread_mutex_unlock(&frameworkState_s.loggerMutex);
-#endif // BUILD_DEBUG
 #ifdef BUILD_RELEASE
-    // TODO: implement logging to file
+    static const char* const levels[] = {
+        [fwiLogLevelError]   = "ERROR",
+        [fwiLogLevelWarning] = "WARNING",
+        [fwiLogLevelInfo]    = "INFO",
+        [fwiLogLevelDebug]   = "DEBUG",
+        [fwiLogLevelBench]   = "BENCHMARK"
+    };
+    written = snprintf(out_p, room, "[%s.%03"PRId32" %s]: %.*s\n", logger_s.stamp,
+        record_p->nanoseconds / 1000000, levels[record_p->level], record_p->length, message_p);
+#else
+    static const char* const levels[] = {
+        [fwiLogLevelError]   = FW_ESCAPE_RED"ERROR"FW_ESCAPE_NORMAL,
+        [fwiLogLevelWarning] = FW_ESCAPE_YELLOW"WARNING"FW_ESCAPE_NORMAL,
+        [fwiLogLevelInfo]    = FW_ESCAPE_CYAN"INFO"FW_ESCAPE_NORMAL,
+        [fwiLogLevelDebug]   = FW_ESCAPE_GREEN"DEBUG"FW_ESCAPE_NORMAL,
+        [fwiLogLevelBench]   = FW_ESCAPE_MAGENTA"BENCHMARK"FW_ESCAPE_NORMAL
+    };
+    written = snprintf(out_p, room, "[%s %s]: %.*s\n", logger_s.stamp, levels[record_p->level],
+        record_p->length, message_p);
 #endif // BUILD_RELEASE
+    *used_p += written > 0 ? (size_t)written : 0;
 }
 
-void fwiLogFollowupA(const bool isLast, const char* format_p, ...) {
-#ifdef BUILD_DEBUG
-    va_list args = {0u};
-    va_start(args);
-    if (isLast) {
-        printf("\\ - ");
-        vprintf(format_p, args);
-        printf("\n");
+static void fwiLogUnlinkRing(struct fwiLogRing* previous_p, struct fwiLogRing* ring_p) {
+    if (previous_p == nullptr) {
+        struct fwiLogRing* expected_p = ring_p;
+        if (atomic_compare_exchange_strong_explicit(&logger_s.rings_p, &expected_p, ring_p->next_p,
+            memory_order_acq_rel, memory_order_acquire)) {
+            return;
+        }
+
+        // New rings were pushed in front of this one. Producers only ever touch the list head, so
+        // walking down to the ring and unlinking it there is safe.
+        previous_p = expected_p;
+        while (previous_p->next_p != ring_p) {
+            previous_p = previous_p->next_p;
+        }
+    }
+
+    previous_p->next_p = ring_p->next_p;
+}
+
+/**
+ * @brief Writes out everything that is currently inside of the rings, only the writer thread (or
+ *        whoever stopped it) may call this
+ */
+static void fwiLogDrain(void) {
+    size_t used = 0;
+    struct fwiLogRing* previous_p = nullptr;
+    struct fwiLogRing* ring_p = atomic_load_explicit(&logger_s.rings_p, memory_order_acquire);
+
+    while (ring_p != nullptr) {
+        struct fwiLogRing* next_p = ring_p->next_p;
+
+        // Checked before loading head, so a freshly abandoned ring gets drained completely
+        const bool abandoned = atomic_load_explicit(&ring_p->abandoned, memory_order_acquire);
+        const uint64_t head = atomic_load_explicit(&ring_p->head, memory_order_acquire);
+        uint64_t tail = atomic_load_explicit(&ring_p->tail, memory_order_relaxed);
+
+        while (tail != head) {
+            struct fwiLogRecord record = {};
+            char message[FWI_LOG_MESSAGE_MAX];
+            fwiLogRingRead(ring_p, tail, &record, sizeof(record));
+            fwiLogRingRead(ring_p, tail + sizeof(record), message, record.length);
+            fwiLogFormatRecord(&used, &record, message);
+            tail += sizeof(record) + record.length;
+        }
+        atomic_store_explicit(&ring_p->tail, tail, memory_order_release);
+
+        const uint64_t dropped = atomic_exchange_explicit(&ring_p->dropped, 0,
+            memory_order_relaxed);
+        if (dropped != 0) {
+            char message[FWI_LOG_MESSAGE_MAX];
+            struct timespec now = {};
+            timespec_get(&now, TIME_UTC);
+            const int32_t length = snprintf(message, sizeof(message),
+                "A thread dropped %"PRIu64" log messages because its log ring was full", dropped);
+            const struct fwiLogRecord record = {
+                .seconds = now.tv_sec,
+                .nanoseconds = (int32_t)now.tv_nsec,
+                .length = (uint16_t)length,
+                .level = fwiLogLevelWarning,
+                .kind = fwiLogKindMessage
+            };
+            fwiLogFormatRecord(&used, &record, message);
+        }
+
+        if (abandoned) {
+            fwiLogUnlinkRing(previous_p, ring_p);
+            free(ring_p);
+        }
+        else {
+            previous_p = ring_p;
+        }
+        ring_p = next_p;
+    }
+
+    fwiLogFlushBatch(&used);
+}
+
+static void* fwiLogWriterMain([[maybe_unused]] void* unused_p) {
+    pthread_mutex_lock(&logger_s.wakeMutex);
+    while (logger_s.running) {
+        pthread_mutex_unlock(&logger_s.wakeMutex);
+        fwiLogDrain();
+        pthread_mutex_lock(&logger_s.wakeMutex);
+
+        struct timespec deadline = {};
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += logger_s.flushInterval / 1000;
+        deadline.tv_nsec += (int64_t)(logger_s.flushInterval % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000;
+        }
+
+        while (logger_s.running && pthread_cond_timedwait(&logger_s.wakeCondition,
+            &logger_s.wakeMutex, &deadline) == 0) {
+        }
+    }
+    pthread_mutex_unlock(&logger_s.wakeMutex);
+
+    fwiLogDrain();
+    return nullptr;
+}
+
+static void fwiLogWriterStop(void) {
+    if (!logger_s.writerIsUp) {
+        return;
+    }
+
+    pthread_mutex_lock(&logger_s.wakeMutex);
+    logger_s.running = false;
+    pthread_cond_signal(&logger_s.wakeCondition);
+    pthread_mutex_unlock(&logger_s.wakeMutex);
+
+    pthread_join(logger_s.writer, nullptr);
+    pthread_cond_destroy(&logger_s.wakeCondition);
+    logger_s.writerIsUp = false;
+
+    if (logger_s.sink_p != stdout && logger_s.sink_p != stderr && logger_s.sink_p != nullptr) {
+        fclose(logger_s.sink_p);
+    }
+    logger_s.sink_p = nullptr;
+}
+
+static void fwiLogAtExit(void) {
+    // Whatever was logged right before exit would be lost otherwise
+    fwiLogWriterStop();
+}
+
+static void fwiLogRegisterAtExit(void) {
+    atexit(fwiLogAtExit);
+}
+
+#ifdef FWI_LOG_BINARY
+static void fwiLogWriteSiteTable(void) {
+    const uint32_t header[2] = {
+        FWI_LOG_BINARY_VERSION,
+        (uint32_t)(__stop_fwi_log_sites - __start_fwi_log_sites)
+    };
+    fwrite(FWI_LOG_BINARY_MAGIC, 1, sizeof(FWI_LOG_BINARY_MAGIC) - 1, logger_s.sink_p);
+    fwrite(header, sizeof(header), 1, logger_s.sink_p);
+
+    for (const struct fwiLogSite* site_p = __start_fwi_log_sites; site_p < __stop_fwi_log_sites;
+        ++site_p) {
+        const uint8_t level = site_p->level;
+        fwrite(&level, sizeof(level), 1, logger_s.sink_p);
+        fwrite(&site_p->line, sizeof(site_p->line), 1, logger_s.sink_p);
+
+        const char* const strings[] = { site_p->file_p, site_p->function_p, site_p->format_p };
+        for (uint8_t i = 0; i < 3; ++i) {
+            const uint16_t length = (uint16_t)strlen(strings[i]);
+            fwrite(&length, sizeof(length), 1, logger_s.sink_p);
+            fwrite(strings[i], 1, length, logger_s.sink_p);
+        }
+    }
+    fflush(logger_s.sink_p);
+}
+#endif // FWI_LOG_BINARY
+
+static fwError fwiLogWriterStart(void) {
+#if defined(FWI_LOG_BINARY)
+    logger_s.sink_p = fopen(logger_s.filename, "ab");
+    if (logger_s.sink_p == nullptr) {
+        fprintf(stderr, "Failed to open the binary log %s\n", logger_s.filename);
     }
     else {
-        printf("| - ");
-        vprintf(format_p, args);
-        printf("\n");
+        fwiLogWriteSiteTable();
     }
-    va_end(args);
-#endif // BUILD_DEBUG
-#ifdef BUILD_RELEASE
-    //TODO: implement follow-up logging to file
+#elif defined(BUILD_RELEASE)
+    logger_s.sink_p = fopen(logger_s.filename, "a");
+    if (logger_s.sink_p == nullptr) {
+        logger_s.sink_p = stderr;
+    }
+#else
+    logger_s.sink_p = stdout;
 #endif // BUILD_RELEASE
+
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&logger_s.wakeCondition, &attributes);
+    pthread_condattr_destroy(&attributes);
+
+    logger_s.running = true;
+    if (pthread_create(&logger_s.writer, nullptr, fwiLogWriterMain, nullptr) != 0) {
+        logger_s.running = false;
+        pthread_cond_destroy(&logger_s.wakeCondition);
+        // Better to write out synchronously once than to lose the reason for the failure
+        fwiLogDrain();
+        return fwErrorOutOfMemory;
+    }
+    logger_s.writerIsUp = true;
+
+    pthread_once(&logger_s.exitOnce, fwiLogRegisterAtExit);
+    return fwErrorSuccess;
 }
 
-void fwiLogFollowupW(const bool isLast, const wchar_t* format_p, ...) {
-#ifdef BUILD_DEBUG
-    va_list args = {0u};
-    va_start(args);
-    if (isLast) {
-        wprintf(L"\\ - ");
-        vwprintf(format_p, args);
-        wprintf(L"\n");
+fwError fwConfigureLogger(const struct fwLoggerConfiguration* configuration_p) {
+    if (configuration_p == nullptr) {
+        return fwErrorInvalidParameter;
+    }
+    if (frameworkState_s.baseIsUp) {
+        return fwErrorModule;
+    }
+
+    if (configuration_p->filename_p != nullptr) {
+        if (strlen(configuration_p->filename_p) >= FWI_LOG_FILENAME_MAX) {
+            return fwErrorInvalidParameter;
+        }
+        strcpy(logger_s.filename, configuration_p->filename_p);
     }
     else {
-        wprintf(L"| - ");
-        vwprintf(format_p, args);
-        wprintf(L"\n");
+        strcpy(logger_s.filename, FWI_LOG_DEFAULT_FILE);
     }
-    va_end(args);
-#endif // BUILD_DEBUG
-#ifdef BUILD_RELEASE
-    //TODO: implement follow-up logging to file
-#endif // BUILD_RELEASE
+
+    logger_s.flushInterval = configuration_p->flushInterval != 0 ? configuration_p->flushInterval
+        : FWI_LOG_DEFAULT_INTERVAL;
+
+    return fwErrorSuccess;
 }
 
 fwError fwiStartNativeModuleBase(void) {
-    pthread_mutex_init(&frameworkState_s.loggerMutex, nullptr);
+#ifdef FWI_LOG_ENABLED
+    const fwError ret = fwiLogWriterStart();
+    if (ret != fwErrorSuccess) {
+        fprintf(stderr, "Failed to start the log writer thread\n");
+        return ret;
+    }
+#endif // FWI_LOG_ENABLED
 
     const time_t rawTime        = time(nullptr);
-    const struct tm* time       = localtime(&rawTime);
+    struct tm time              = {};
+    localtime_r(&rawTime, &time); // the writer thread uses the time conversion as well
     char buf[14]                = {};
-    const size_t bytesWritten   = strftime(buf, 14, "%d.%m.%Y", time);
+    const size_t bytesWritten   = strftime(buf, 14, "%d.%m.%Y", &time);
     if (bytesWritten == 0) {
-        fwiLogA(fwiLogLevelError, "Failed to get local time");
+        FWI_LOG_ERROR("Failed to get local time");
     }
 
     fwiGetState()->baseIsUp = true;
 
-    fwiLogA(fwiLogLevelInfo, "Base module was started");
-    fwiLogA(fwiLogLevelInfo, "The current date is %s (D.M.Y)", buf);
+    FWI_LOG_INFO("Base module was started");
+    FWI_LOG_INFO("The current date is %s (D.M.Y)", buf);
 
     return fwErrorSuccess;
 }
 
 fwError fwiStopNativeModuleBase(void) {
     fwiGetState()->baseIsUp = false;
-    fwiLogA(fwiLogLevelInfo, "Base module was stopped");
-    pthread_mutex_destroy(&frameworkState_s.loggerMutex);
+    FWI_LOG_INFO("Base module was stopped");
+#ifdef FWI_LOG_ENABLED
+    fwiLogWriterStop();
+#endif // FWI_LOG_ENABLED
 
     return fwErrorSuccess;
 }
+
+#define FWI_TIMER_WHEEL_MASK (FWI_TIMER_WHEEL_SLOTS - 1)
+#define FWI_TIMER_WHEEL_SPAN (1ull << (FWI_TIMER_WHEEL_LEVELS * FWI_TIMER_WHEEL_BITS))
+#define FWI_TIMER_FIRING UINT16_MAX
+
+static void fwiTimerLink(struct fwiTimer** head_pp, struct fwiTimer* timer_p) {
+    timer_p->next_p = *head_pp;
+    if (timer_p->next_p != nullptr) {
+        timer_p->next_p->previous_pp = &timer_p->next_p;
+    }
+    timer_p->previous_pp = head_pp;
+    *head_pp = timer_p;
+}
+
+static void fwiTimerUnlink(struct fwiTimerWheel* wheel_p, struct fwiTimer* timer_p) {
+    *timer_p->previous_pp = timer_p->next_p;
+    if (timer_p->next_p != nullptr) {
+        timer_p->next_p->previous_pp = timer_p->previous_pp;
+    }
+    timer_p->previous_pp = nullptr;
+
+    // An emptied slot gives up its bit, so looking for the next expiry does not stop there
+    if (timer_p->slot != FWI_TIMER_FIRING) {
+        const uint32_t level = timer_p->slot / FWI_TIMER_WHEEL_SLOTS;
+        const uint32_t index = timer_p->slot % FWI_TIMER_WHEEL_SLOTS;
+        if (wheel_p->slots[level][index] == nullptr) {
+            wheel_p->occupied[level] &= ~(1ull << index);
+        }
+    }
+}
+
+/**
+ * @brief Puts a timer into the slot that is reached right before it expires
+ * @note A slot of a higher level is the slot that is reached when the wheel turns into the range
+ *       it covers. Passing the current one means the timer is a whole turn of that level away.
+ */
+static void fwiTimerInsert(struct fwiTimerWheel* wheel_p, struct fwiTimer* timer_p) {
+    uint64_t position = timer_p->expiry > wheel_p->now ? timer_p->expiry : wheel_p->now;
+    if (position - wheel_p->now >= FWI_TIMER_WHEEL_SPAN) {
+        position = wheel_p->now + FWI_TIMER_WHEEL_SPAN - 1; // waits at the top and comes back
+    }
+
+    const uint64_t delta = position - wheel_p->now;
+    uint32_t level = 0;
+    while (level < FWI_TIMER_WHEEL_LEVELS - 1 &&
+           delta >= 1ull << ((level + 1) * FWI_TIMER_WHEEL_BITS)) {
+        level++;
+    }
+
+    const uint32_t index = (position >> (level * FWI_TIMER_WHEEL_BITS)) & FWI_TIMER_WHEEL_MASK;
+    timer_p->slot = (uint16_t)(level * FWI_TIMER_WHEEL_SLOTS + index);
+    fwiTimerLink(&wheel_p->slots[level][index], timer_p);
+    wheel_p->occupied[level] |= 1ull << index;
+}
+
+static void fwiTimerCascade(struct fwiTimerWheel* wheel_p, const uint32_t level) {
+    const uint32_t index = (wheel_p->now >> (level * FWI_TIMER_WHEEL_BITS)) & FWI_TIMER_WHEEL_MASK;
+    struct fwiTimer* timer_p = wheel_p->slots[level][index];
+    wheel_p->slots[level][index] = nullptr;
+    wheel_p->occupied[level] &= ~(1ull << index);
+
+    while (timer_p != nullptr) {
+        struct fwiTimer* next_p = timer_p->next_p;
+        fwiTimerInsert(wheel_p, timer_p);
+        timer_p = next_p;
+    }
+}
+
+void fwiTimerWheelInit(struct fwiTimerWheel* wheel_p, const uint64_t now) {
+    memset(wheel_p, 0, sizeof(struct fwiTimerWheel));
+    wheel_p->now = now;
+}
+
+void fwiTimerWheelArm(struct fwiTimerWheel* wheel_p, struct fwiTimer* timer_p,
+                      const uint64_t expiry) {
+    if (timer_p->previous_pp != nullptr) {
+        fwiTimerUnlink(wheel_p, timer_p);
+    }
+    else {
+        wheel_p->count++;
+    }
+
+    timer_p->expiry = expiry;
+    fwiTimerInsert(wheel_p, timer_p);
+}
+
+void fwiTimerWheelCancel(struct fwiTimerWheel* wheel_p, struct fwiTimer* timer_p) {
+    if (timer_p->previous_pp == nullptr) {
+        return;
+    }
+
+    fwiTimerUnlink(wheel_p, timer_p);
+    wheel_p->count--;
+}
+
+uint32_t fwiTimerWheelAdvance(struct fwiTimerWheel* wheel_p, const uint64_t until) {
+    uint32_t fired = 0;
+
+    // Jumps straight to the next tick that has work, idle stretches cost nothing
+    uint64_t tick;
+    while ((tick = fwiTimerWheelNext(wheel_p)) <= until) {
+        wheel_p->now = tick;
+        for (uint32_t level = 1; level < FWI_TIMER_WHEEL_LEVELS &&
+             ((tick >> ((level - 1) * FWI_TIMER_WHEEL_BITS)) & FWI_TIMER_WHEEL_MASK) == 0;
+             level++) {
+            fwiTimerCascade(wheel_p, level);
+        }
+
+        // The slot is moved aside, a handler re-arming a whole turn ahead lands in the same one
+        const uint32_t index = tick & FWI_TIMER_WHEEL_MASK;
+        struct fwiTimer* expired_p = wheel_p->slots[0][index];
+        wheel_p->slots[0][index] = nullptr;
+        wheel_p->occupied[0] &= ~(1ull << index);
+        if (expired_p != nullptr) {
+            expired_p->previous_pp = &expired_p;
+        }
+        for (struct fwiTimer* timer_p = expired_p; timer_p != nullptr; timer_p = timer_p->next_p) {
+            timer_p->slot = FWI_TIMER_FIRING;
+        }
+
+        wheel_p->now = tick + 1;
+        while (expired_p != nullptr) {
+            struct fwiTimer* timer_p = expired_p;
+            fwiTimerUnlink(wheel_p, timer_p); // handlers may cancel the ones behind it
+            wheel_p->count--;
+            timer_p->handler(timer_p);
+            fired++;
+        }
+    }
+
+    if (wheel_p->now <= until) {
+        wheel_p->now = until + 1;
+    }
+    return fired;
+}
+
+uint64_t fwiTimerWheelNext(const struct fwiTimerWheel* wheel_p) {
+    if (wheel_p->count == 0) {
+        return UINT64_MAX;
+    }
+
+    uint64_t next = UINT64_MAX;
+    for (uint32_t level = 0; level < FWI_TIMER_WHEEL_LEVELS; level++) {
+        const uint64_t occupied = wheel_p->occupied[level];
+        if (occupied == 0) {
+            continue;
+        }
+
+        // The current slot was cascaded already, unless the wheel stands right at its first tick
+        const uint32_t shift = level * FWI_TIMER_WHEEL_BITS;
+        const uint64_t block = wheel_p->now >> shift;
+        const uint32_t index = block & FWI_TIMER_WHEEL_MASK;
+        const bool passed = (wheel_p->now & ((1ull << shift) - 1)) != 0;
+        const uint32_t first = passed ? index + 1 : index;
+        const uint64_t ahead = first < FWI_TIMER_WHEEL_SLOTS ? occupied & (~0ull << first) : 0;
+
+        const uint64_t slotBlock = ahead != 0 ?
+            block - index + (uint64_t)__builtin_ctzll(ahead) :
+            block - index + FWI_TIMER_WHEEL_SLOTS + (uint64_t)__builtin_ctzll(occupied);
+        const uint64_t tick = slotBlock << shift;
+        if (tick < next) {
+            next = tick;
+        }
+    }
+    return next;
+}
+
+// Premultiplied source over destination for one channel, the shifts divide by 255 with rounding and
+// are exact for every product of two bytes. The vectorized kernels compute exactly the same.
+static uint32_t fwiRenderBlendChannel(const uint32_t source, const uint32_t destination,
+                                      const uint32_t inverseAlpha) {
+    uint32_t t = destination * inverseAlpha + 128;
+    t = source + ((t + (t >> 8)) >> 8);
+    return t > 255 ? 255 : t;
+}
+
+static void fwiRenderFillScalar(uint32_t* destination_p, const uint32_t count,
+                                const uint32_t color) {
+    for (uint32_t i = 0; i < count; i++) {
+        destination_p[i] = color;
+    }
+}
+
+// Already as wide as the CPU allows, libc picks its own vectorized copy at load time
+static void fwiRenderCopy(uint32_t* destination_p, const uint32_t* source_p,
+                          const uint32_t count) {
+    memcpy(destination_p, source_p, (size_t)count * sizeof(uint32_t));
+}
+
+static void fwiRenderBlendScalar(uint32_t* destination_p, const uint32_t* source_p,
+                                 const uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t source = source_p[i];
+        const uint32_t inverseAlpha = 255 - (source >> 24);
+        if (inverseAlpha == 0) {
+            destination_p[i] = source;
+            continue;
+        }
+
+        const uint32_t destination = destination_p[i];
+        uint32_t result = 0;
+        for (uint32_t shift = 0; shift < 32; shift += 8) {
+            result |= fwiRenderBlendChannel((source >> shift) & 0xFF,
+                                            (destination >> shift) & 0xFF, inverseAlpha) << shift;
+        }
+        destination_p[i] = result;
+    }
+}
+
+static const struct fwiRenderKernels fwiRenderKernelsScalar = {
+    .fill = fwiRenderFillScalar, .copy = fwiRenderCopy, .blend = fwiRenderBlendScalar,
+    .name_p = "scalar"
+};
+
+const struct fwiRenderKernels* fwiRenderScalarKernels(void) {
+    return &fwiRenderKernelsScalar;
+}
+
+#if defined(__x86_64__)
+
+// SSE2 is part of x86-64, so these need no check
+static void fwiRenderFillSse2(uint32_t* destination_p, const uint32_t count,
+                              const uint32_t color) {
+    const __m128i pixels = _mm_set1_epi32((int32_t)color);
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128((__m128i*)(destination_p + i), pixels);
+    }
+    fwiRenderFillScalar(destination_p + i, count - i, color);
+}
+
+// Four pixels, every byte of the destination times 255 minus the alpha of its pixel
+static inline __m128i fwiRenderBlendSse2Pixels(const __m128i source, const __m128i destination) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i inverseAlpha = _mm_sub_epi32(_mm_set1_epi32(255), _mm_srli_epi32(source, 24));
+    inverseAlpha = _mm_or_si128(inverseAlpha, _mm_slli_epi32(inverseAlpha, 16));
+
+    __m128i low  = _mm_mullo_epi16(_mm_unpacklo_epi8(destination, zero),
+                                   _mm_unpacklo_epi32(inverseAlpha, inverseAlpha));
+    __m128i high = _mm_mullo_epi16(_mm_unpackhi_epi8(destination, zero),
+                                   _mm_unpackhi_epi32(inverseAlpha, inverseAlpha));
+    low  = _mm_add_epi16(low, _mm_set1_epi16(128));
+    high = _mm_add_epi16(high, _mm_set1_epi16(128));
+    low  = _mm_srli_epi16(_mm_add_epi16(low, _mm_srli_epi16(low, 8)), 8);
+    high = _mm_srli_epi16(_mm_add_epi16(high, _mm_srli_epi16(high, 8)), 8);
+    return _mm_adds_epu8(source, _mm_packus_epi16(low, high));
+}
+
+static void fwiRenderBlendSse2(uint32_t* destination_p, const uint32_t* source_p,
+                               const uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i source      = _mm_loadu_si128((const __m128i*)(source_p + i));
+        const __m128i destination = _mm_loadu_si128((const __m128i*)(destination_p + i));
+        _mm_storeu_si128((__m128i*)(destination_p + i),
+                         fwiRenderBlendSse2Pixels(source, destination));
+    }
+    fwiRenderBlendScalar(destination_p + i, source_p + i, count - i);
+}
+
+static const struct fwiRenderKernels fwiRenderKernelsSse2 = {
+    .fill = fwiRenderFillSse2, .copy = fwiRenderCopy, .blend = fwiRenderBlendSse2,
+    .name_p = "SSE2"
+};
+
+__attribute__((target("avx2")))
+static void fwiRenderFillAvx2(uint32_t* destination_p, const uint32_t count,
+                              const uint32_t color) {
+    const __m256i pixels = _mm256_set1_epi32((int32_t)color);
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_si256((__m256i*)(destination_p + i), pixels);
+    }
+    fwiRenderFillScalar(destination_p + i, count - i, color);
+}
+
+// Same as the SSE2 version, unpacking works within each 128 bit lane so the order still matches
+__attribute__((target("avx2")))
+static void fwiRenderBlendAvx2(uint32_t* destination_p, const uint32_t* source_p,
+                               const uint32_t count) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i rounding = _mm256_set1_epi16(128);
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i source      = _mm256_loadu_si256((const __m256i*)(source_p + i));
+        const __m256i destination = _mm256_loadu_si256((const __m256i*)(destination_p + i));
+        __m256i inverseAlpha = _mm256_sub_epi32(_mm256_set1_epi32(255),
+                                                _mm256_srli_epi32(source, 24));
+        inverseAlpha = _mm256_or_si256(inverseAlpha, _mm256_slli_epi32(inverseAlpha, 16));
+
+        __m256i low  = _mm256_mullo_epi16(_mm256_unpacklo_epi8(destination, zero),
+                                          _mm256_unpacklo_epi32(inverseAlpha, inverseAlpha));
+        __m256i high = _mm256_mullo_epi16(_mm256_unpackhi_epi8(destination, zero),
+                                          _mm256_unpackhi_epi32(inverseAlpha, inverseAlpha));
+        low  = _mm256_add_epi16(low, rounding);
+        high = _mm256_add_epi16(high, rounding);
+        low  = _mm256_srli_epi16(_mm256_add_epi16(low, _mm256_srli_epi16(low, 8)), 8);
+        high = _mm256_srli_epi16(_mm256_add_epi16(high, _mm256_srli_epi16(high, 8)), 8);
+        _mm256_storeu_si256((__m256i*)(destination_p + i),
+                            _mm256_adds_epu8(source, _mm256_packus_epi16(low, high)));
+    }
+    fwiRenderBlendSse2(destination_p + i, source_p + i, count - i);
+}
+
+static const struct fwiRenderKernels fwiRenderKernelsAvx2 = {
+    .fill = fwiRenderFillAvx2, .copy = fwiRenderCopy, .blend = fwiRenderBlendAvx2,
+    .name_p = "AVX2"
+};
+
+#elif defined(__aarch64__)
+
+// NEON is part of AArch64, so these need no check
+static void fwiRenderFillNeon(uint32_t* destination_p, const uint32_t count,
+                              const uint32_t color) {
+    const uint32x4_t pixels = vdupq_n_u32(color);
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_u32(destination_p + i, pixels);
+    }
+    fwiRenderFillScalar(destination_p + i, count - i, color);
+}
+
+static void fwiRenderBlendNeon(uint32_t* destination_p, const uint32_t* source_p,
+                               const uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // De-interleaved, so every register holds one channel of eight pixels
+        const uint8x8x4_t source = vld4_u8((const uint8_t*)(source_p + i));
+        uint8x8x4_t destination  = vld4_u8((const uint8_t*)(destination_p + i));
+        const uint8x8_t inverseAlpha = vmvn_u8(source.val[3]);
+        for (uint32_t c = 0; c < 4; c++) {
+            const uint16x8_t product = vmull_u8(destination.val[c], inverseAlpha);
+            // (p + 128 + ((p + 128) >> 8)) >> 8, the same rounding as the scalar kernel
+            const uint8x8_t scaled = vraddhn_u16(product, vrshrq_n_u16(product, 8));
+            destination.val[c] = vqadd_u8(source.val[c], scaled);
+        }
+        vst4_u8((uint8_t*)(destination_p + i), destination);
+    }
+    fwiRenderBlendScalar(destination_p + i, source_p + i, count - i);
+}
+
+static const struct fwiRenderKernels fwiRenderKernelsNeon = {
+    .fill = fwiRenderFillNeon, .copy = fwiRenderCopy, .blend = fwiRenderBlendNeon,
+    .name_p = "NEON"
+};
+
+#endif
+
+const struct fwiRenderKernels* fwiRenderSelectKernels(void) {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &fwiRenderKernelsAvx2;
+    }
+    return &fwiRenderKernelsSse2;
+#elif defined(__aarch64__)
+    return &fwiRenderKernelsNeon;
+#else
+    return &fwiRenderKernelsScalar;
+#endif
+}
+
+static uint64_t fwiScanFindAnyScalar(const uint8_t* data_p, const uint64_t size,
+                                     const uint8_t* set_p, const uint32_t setSize) {
+    uint64_t bitmap[4] = {0};
+    for (uint32_t j = 0; j < setSize; j++) {
+        bitmap[set_p[j] >> 6] |= 1ull << (set_p[j] & 63);
+    }
+    for (uint64_t i = 0; i < size; i++) {
+        if ((bitmap[data_p[i] >> 6] >> (data_p[i] & 63)) & 1) {
+            return i;
+        }
+    }
+    return size;
+}
+
+static uint64_t fwiScanCollectScalar(const uint8_t* data_p, const uint64_t size,
+                                     const uint8_t delimiter, const uint64_t base,
+                                     uint64_t* offsets_p) {
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < size; i++) {
+        if (data_p[i] == delimiter) {
+            offsets_p[count++] = base + i + 1;
+        }
+    }
+    return count;
+}
+
+static const struct fwiScanKernels fwiScanKernelsScalar = {
+    .findAny = fwiScanFindAnyScalar, .collect = fwiScanCollectScalar, .name_p = "scalar"
+};
+
+const struct fwiScanKernels* fwiScanScalarKernels(void) {
+    return &fwiScanKernelsScalar;
+}
+
+// Turns a mask of matching positions into offsets, one per set bit from the lowest up
+static inline uint64_t fwiScanEmit(uint64_t mask, const uint64_t position, uint64_t* offsets_p) {
+    uint64_t count = 0;
+    while (mask != 0) {
+        offsets_p[count++] = position + (uint64_t)__builtin_ctzll(mask) + 1;
+        mask &= mask - 1;
+    }
+    return count;
+}
+
+#if defined(__x86_64__)
+
+static uint64_t fwiScanFindAnySse2(const uint8_t* data_p, const uint64_t size,
+                                   const uint8_t* set_p, const uint32_t setSize) {
+    __m128i set[FWI_SCAN_VECTOR_SET];
+    for (uint32_t j = 0; j < setSize; j++) {
+        set[j] = _mm_set1_epi8((char)set_p[j]);
+    }
+
+    uint64_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i bytes = _mm_loadu_si128((const __m128i*)(data_p + i));
+        __m128i matches = _mm_cmpeq_epi8(bytes, set[0]);
+        for (uint32_t j = 1; j < setSize; j++) {
+            matches = _mm_or_si128(matches, _mm_cmpeq_epi8(bytes, set[j]));
+        }
+        const uint32_t mask = (uint32_t)_mm_movemask_epi8(matches);
+        if (mask != 0) {
+            return i + (uint64_t)__builtin_ctz(mask);
+        }
+    }
+    return i + fwiScanFindAnyScalar(data_p + i, size - i, set_p, setSize);
+}
+
+static uint64_t fwiScanCollectSse2(const uint8_t* data_p, const uint64_t size,
+                                   const uint8_t delimiter, const uint64_t base,
+                                   uint64_t* offsets_p) {
+    const __m128i needle = _mm_set1_epi8((char)delimiter);
+    uint64_t count = 0;
+    uint64_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i bytes = _mm_loadu_si128((const __m128i*)(data_p + i));
+        const uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, needle));
+        count += fwiScanEmit(mask, base + i, offsets_p + count);
+    }
+    return count + fwiScanCollectScalar(data_p + i, size - i, delimiter, base + i,
+                                        offsets_p + count);
+}
+
+static const struct fwiScanKernels fwiScanKernelsSse2 = {
+    .findAny = fwiScanFindAnySse2, .collect = fwiScanCollectSse2, .name_p = "SSE2"
+};
+
+__attribute__((target("avx2")))
+static uint64_t fwiScanFindAnyAvx2(const uint8_t* data_p, const uint64_t size,
+                                   const uint8_t* set_p, const uint32_t setSize) {
+    __m256i set[FWI_SCAN_VECTOR_SET];
+    for (uint32_t j = 0; j < setSize; j++) {
+        set[j] = _mm256_set1_epi8((char)set_p[j]);
+    }
+
+    uint64_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i bytes = _mm256_loadu_si256((const __m256i*)(data_p + i));
+        __m256i matches = _mm256_cmpeq_epi8(bytes, set[0]);
+        for (uint32_t j = 1; j < setSize; j++) {
+            matches = _mm256_or_si256(matches, _mm256_cmpeq_epi8(bytes, set[j]));
+        }
+        const uint32_t mask = (uint32_t)_mm256_movemask_epi8(matches);
+        if (mask != 0) {
+            return i + (uint64_t)__builtin_ctz(mask);
+        }
+    }
+    return i + fwiScanFindAnySse2(data_p + i, size - i, set_p, setSize);
+}
+
+// Two vectors per round, so one mask covers 64 bytes and sparse delimiters cost one branch
+__attribute__((target("avx2")))
+static uint64_t fwiScanCollectAvx2(const uint8_t* data_p, const uint64_t size,
+                                   const uint8_t delimiter, const uint64_t base,
+                                   uint64_t* offsets_p) {
+    const __m256i needle = _mm256_set1_epi8((char)delimiter);
+    uint64_t count = 0;
+    uint64_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        const __m256i low  = _mm256_loadu_si256((const __m256i*)(data_p + i));
+        const __m256i high = _mm256_loadu_si256((const __m256i*)(data_p + i + 32));
+        const uint64_t mask =
+            (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, needle)) |
+            (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, needle)) << 32;
+        count += fwiScanEmit(mask, base + i, offsets_p + count);
+    }
+    return count + fwiScanCollectSse2(data_p + i, size - i, delimiter, base + i,
+                                      offsets_p + count);
+}
+
+static const struct fwiScanKernels fwiScanKernelsAvx2 = {
+    .findAny = fwiScanFindAnyAvx2, .collect = fwiScanCollectAvx2, .name_p = "AVX2"
+};
+
+#elif defined(__aarch64__)
+
+// NEON has no movemask, narrowing the comparison leaves four bits per byte in a 64 bit mask
+static inline uint64_t fwiScanMaskNeon(const uint8x16_t matches) {
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+}
+
+static uint64_t fwiScanFindAnyNeon(const uint8_t* data_p, const uint64_t size,
+                                   const uint8_t* set_p, const uint32_t setSize) {
+    uint8x16_t set[FWI_SCAN_VECTOR_SET];
+    for (uint32_t j = 0; j < setSize; j++) {
+        set[j] = vdupq_n_u8(set_p[j]);
+    }
+
+    uint64_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const uint8x16_t bytes = vld1q_u8(data_p + i);
+        uint8x16_t matches = vceqq_u8(bytes, set[0]);
+        for (uint32_t j = 1; j < setSize; j++) {
+            matches = vorrq_u8(matches, vceqq_u8(bytes, set[j]));
+        }
+        const uint64_t mask = fwiScanMaskNeon(matches);
+        if (mask != 0) {
+            return i + (uint64_t)__builtin_ctzll(mask) / 4;
+        }
+    }
+    return i + fwiScanFindAnyScalar(data_p + i, size - i, set_p, setSize);
+}
+
+static uint64_t fwiScanCollectNeon(const uint8_t* data_p, const uint64_t size,
+                                   const uint8_t delimiter, const uint64_t base,
+                                   uint64_t* offsets_p) {
+    const uint8x16_t needle = vdupq_n_u8(delimiter);
+    uint64_t count = 0;
+    uint64_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        uint64_t mask = fwiScanMaskNeon(vceqq_u8(vld1q_u8(data_p + i), needle)) &
+                        0x8888888888888888ull; // one bit per byte is enough
+        while (mask != 0) {
+            offsets_p[count++] = base + i + (uint64_t)__builtin_ctzll(mask) / 4 + 1;
+            mask &= mask - 1;
+        }
+    }
+    return count + fwiScanCollectScalar(data_p + i, size - i, delimiter, base + i,
+                                        offsets_p + count);
+}
+
+static const struct fwiScanKernels fwiScanKernelsNeon = {
+    .findAny = fwiScanFindAnyNeon, .collect = fwiScanCollectNeon, .name_p = "NEON"
+};
+
+#endif
+
+const struct fwiScanKernels* fwiScanSelectKernels(void) {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &fwiScanKernelsAvx2;
+    }
+    return &fwiScanKernelsSse2;
+#elif defined(__aarch64__)
+    return &fwiScanKernelsNeon;
+#else
+    return &fwiScanKernelsScalar;
+#endif
+}
@@ -17,7 +17,7 @@
 #ifndef LPAF_INTERNAL_H
 #define LPAF_INTERNAL_H
 
-#include <pthread.h>
+#include <stdarg.h>
 #include <stdint.h>
 #include <wchar.h>
 
@@ -50,19 +50,421 @@ typedef enum fwiLogLevel : uint8_t {
     fwiLogLevelBench /*! Runtime benchmarking */
 } fwiLogLevel;
 
+/**
+ * @brief Most verbose log level that is compiled in, sites above it vanish together with their
+ *        arguments
+ * @note Override with -DFWI_LOG_LEVEL_MAX=<level>, benchmark results are always kept.
+ */
+#ifndef FWI_LOG_LEVEL_MAX
+#ifdef BUILD_RELEASE
+#define FWI_LOG_LEVEL_MAX fwiLogLevelInfo
+#else
+#define FWI_LOG_LEVEL_MAX fwiLogLevelDebug
+#endif // BUILD_RELEASE
+#endif // FWI_LOG_LEVEL_MAX
+
+#define FWI_LOG_LEVEL_ENABLED(lll) ((lll) <= FWI_LOG_LEVEL_MAX || (lll) == fwiLogLevelBench)
+
+/**
+ * @brief Static description of a log site, placed inside of its own section so that the whole
+ *        table can be written into the header of a binary log
+ * @note The sites are walked as an array, the explicit alignment keeps the compiler from padding
+ *       them apart.
+ */
+struct fwiLogSite {
+    const char* format_p;
+    const char* file_p;
+    const char* function_p;
+    uint32_t line;
+    fwiLogLevel level;
+};
+
+#define FWI_LOG_SITE_SECTION "fwi_log_sites"
+
+/**
+ * @brief Logs a message, the level has to be a constant so that disabled sites compile to nothing
+ * @note With FWI_LOG_BINARY defined the message is not formatted, only the site and the raw
+ *       arguments are recorded. The format has to be a string literal for that reason.
+ */
+#ifdef FWI_LOG_BINARY
+#define FWI_LOG(lll, format, ...) do { \
+    if (FWI_LOG_LEVEL_ENABLED(lll)) { \
+        static const struct fwiLogSite fwiLogSite_s \
+            __attribute__((section(FWI_LOG_SITE_SECTION), used, aligned(8))) = \
+            { format, __FILE__, __func__, __LINE__, lll }; \
+        fwiLogBinary(&fwiLogSite_s __VA_OPT__(,) __VA_ARGS__); \
+    } \
+} while (0)
+#else
+#define FWI_LOG(lll, format, ...) do { \
+    if (FWI_LOG_LEVEL_ENABLED(lll)) { \
+        fwiLogA(lll, format __VA_OPT__(,) __VA_ARGS__); \
+    } \
+} while (0)
+#endif // FWI_LOG_BINARY
+
+#define FWI_LOG_ERROR(format, ...)      FWI_LOG(fwiLogLevelError, format __VA_OPT__(,) __VA_ARGS__)
+#define FWI_LOG_WARNING(format, ...)    FWI_LOG(fwiLogLevelWarning, format __VA_OPT__(,) __VA_ARGS__)
+#define FWI_LOG_INFO(format, ...)       FWI_LOG(fwiLogLevelInfo, format __VA_OPT__(,) __VA_ARGS__)
+#define FWI_LOG_DEBUG(format, ...)      FWI_LOG(fwiLogLevelDebug, format __VA_OPT__(,) __VA_ARGS__)
+#define FWI_LOG_BENCH(format, ...)      FWI_LOG(fwiLogLevelBench, format __VA_OPT__(,) __VA_ARGS__)
+
+/**
+ * @brief Layout of a binary log: the header below, one entry per site and then the records
+ * @note Site entry: uint8_t level, uint32_t line and then file, function and format, each as
+ *       uint16_t length plus text. Record: the record header, for @c fwiLogKindBinary followed by the uint32_t
+ *       site index and the arguments in order, otherwise followed by the message text. Integers
+ *       and pointers take 8 bytes, floating point values are stored as double, '*' widths as
+ *       int32_t and strings as uint16_t length plus text. Everything is in host byte order.
+ */
+#define FWI_LOG_BINARY_MAGIC "LPAFBLOG"
+#define FWI_LOG_BINARY_VERSION 1
+#define FWI_LOG_MESSAGE_MAX 512 // longest text or binary payload of one record
+
+typedef enum fwiLogKind : uint8_t {
+    fwiLogKindMessage,
+    fwiLogKindFollowup,
+    fwiLogKindFollowupLast,
+    fwiLogKindBinary
+} fwiLogKind;
+
+/**
+ * @brief Header in front of every message, the payload follows directly
+ */
+struct fwiLogRecord {
+    int64_t seconds;
+    int32_t nanoseconds;
+    uint16_t length;
+    fwiLogLevel level;
+    fwiLogKind kind;
+};
+
+typedef enum fwiLogArgument : uint8_t {
+    fwiLogArgumentNone /*! "%%", consumes nothing */,
+    fwiLogArgumentInt,
+    fwiLogArgumentLong,
+    fwiLogArgumentLongLong,
+    fwiLogArgumentIntMax,
+    fwiLogArgumentSize,
+    fwiLogArgumentPtrDiff,
+    fwiLogArgumentWideChar,
+    fwiLogArgumentDouble,
+    fwiLogArgumentLongDouble,
+    fwiLogArgumentPointer,
+    fwiLogArgumentString,
+    fwiLogArgumentWideString
+} fwiLogArgument;
+
+/**
+ * @brief One conversion specification inside of a printf format string
+ * @param start_p Points at the '%'
+ * @param length Length of the whole specification
+ * @param stars Number of '*' widths and precisions, each consumes an int
+ * @param argument Type of the argument that is consumed
+ */
+struct fwiLogConversion {
+    const char* start_p;
+    size_t length;
+    uint8_t stars;
+    fwiLogArgument argument;
+};
+
+/**
+ * @brief Finds the next conversion specification inside of a printf format string
+ * @param format_p[in] Where to start searching
+ * @param conversion_p[out] The conversion that was found
+ * @return Pointer behind the conversion or @c nullptr when there are no conversions left
+ * @note Shared between the binary log encoder and the offline decoder.
+ */ // PlatIndepImp
+const char* fwiLogNextConversion(
+    const char* format_p,
+    struct fwiLogConversion* conversion_p
+    );
+
+/**
+ * @brief Appends the arguments of a binary log message to its payload
+ * @param format_p[in] Format the arguments belong to
+ * @param payload_p[in,out] Payload of @c FWI_LOG_MESSAGE_MAX bytes
+ * @param used Bytes of the payload that are already taken
+ * @param args[in] The arguments, consumed in the order of the format's conversions
+ * @return Bytes of the payload that are taken afterwards, arguments that did not fit are cut off
+ */ // PlatIndepImp
+size_t fwiLogEncodeArguments(
+    const char* format_p,
+    uint8_t* payload_p,
+    size_t used,
+    va_list args
+    );
+
+/**
+ * @brief Renders the arguments of a binary log message the way printf would have
+ * @param format_p[in] Format of the message's site
+ * @param payload_p[in] Arguments as @c fwiLogEncodeArguments wrote them
+ * @param length Length of the arguments in bytes
+ * @param out_p[out] The rendered message, always terminated
+ * @param size Size of @c out_p
+ * @note Shared between the offline decoder and the tests.
+ */ // PlatIndepImp
+void fwiLogRenderBinary(
+    const char* format_p,
+    const uint8_t* payload_p,
+    size_t length,
+    char* out_p,
+    size_t size
+    );
+
+/**
+ * @brief Reports what the calling thread handed to its log ring so far
+ * @param pushed_p[out] Bytes of records that were written into the ring
+ * @param dropped_p[out] Messages that did not fit and were not yet reported by the writer
+ */ // PlatIndepImp
+void fwiLogGetThreadCounters(
+    uint64_t* pushed_p,
+    uint64_t* dropped_p
+    );
+
+/**
+ * @brief Records a binary log message, used by @c FWI_LOG when FWI_LOG_BINARY is defined
+ * @param site_p[in] Site of the message, holds the level and format
+ * @param ...[in] Replacement parameters for placeholders of the site's format
+ */ // PlatIndepImp
+void fwiLogBinary(
+    const struct fwiLogSite* site_p,
+    ...
+    );
+
 /**
  * @brief Do not instanciate
  */
 struct fwiState {
-    pthread_mutex_t loggerMutex;
     uint8_t activeModules;
     bool baseIsUp;
 };
 
+/**
+ * @brief Backing state of an @c fwBench
+ */
+struct fwiBench {
+    struct fwBenchConfiguration configuration;
+    uint64_t* samples_p;
+    uint64_t sampleCount;
+    uint64_t sampleCapacity;
+    uint64_t scopeStart;
+    uint32_t warmupLeft;
+};
+
+/**
+ * @brief Backing state of an @c fwArena
+ */
+struct fwiArena {
+    uint8_t* base_p;
+    uint64_t size;
+    uint64_t mappedSize;
+    uint64_t offset;
+};
+
+/**
+ * @brief Backing state of an @c fwPool, free elements link to the next free one
+ */
+struct fwiPool {
+    uint8_t* base_p;
+    uint64_t elementSize;
+    uint64_t elementCount;
+    uint64_t mappedSize;
+    void* free_p;
+};
+
+/**
+ * @brief Backing state of an @c fwSocketStream, the unread bytes lie between readStart and
+ *        readEnd, the unsent ones between writeStart and writeEnd
+ */
+struct fwiSocketStream {
+    fwSocket socket;
+    uint8_t* read_p;
+    uint8_t* write_p;
+    uint32_t readCapacity;
+    uint32_t readStart;
+    uint32_t readEnd;
+    uint32_t readScanned;
+    uint32_t writeCapacity;
+    uint32_t writeStart;
+    uint32_t writeEnd;
+};
+
+#define FWI_TIMER_WHEEL_LEVELS 4
+#define FWI_TIMER_WHEEL_BITS 6
+#define FWI_TIMER_WHEEL_SLOTS (1 << FWI_TIMER_WHEEL_BITS)
+
+struct fwiTimer;
+
+/**
+ * @brief Called by a timer wheel when a timer expired, the timer may be armed again from inside
+ * @param timer_p[in] The timer that expired, it is not armed anymore
+ */
+typedef void (*fwiTimerHandler)(
+    struct fwiTimer* timer_p
+    );
+
+/**
+ * @brief Timeout inside of a timer wheel. Embedded into the state of its owner, so arming never
+ *        allocates and cancelling only unlinks it from its slot.
+ */
+struct fwiTimer {
+    struct fwiTimer* next_p;
+    struct fwiTimer** previous_pp; // nullptr while not armed
+    fwiTimerHandler handler;
+    void* context_p;
+    uint64_t expiry; // absolute tick
+    uint16_t slot; // level times slot count plus slot, UINT16_MAX while it is being fired
+};
+
+/**
+ * @brief Hierarchical timing wheel, every level has 64 slots that each span 64 slots of the level
+ *        below. A timer sits in the lowest level whose range covers it and cascades down as the
+ *        wheel turns, four levels cover 2^24 ticks and later timers wait in the top level.
+ * @note One bit per occupied slot lets the next expiry be found without walking empty slots.
+ */
+struct fwiTimerWheel {
+    struct fwiTimer* slots[FWI_TIMER_WHEEL_LEVELS][FWI_TIMER_WHEEL_SLOTS];
+    uint64_t occupied[FWI_TIMER_WHEEL_LEVELS];
+    uint64_t now; // every tick before it was already processed
+    uint32_t count;
+};
+
+/**
+ * @brief Row kernels of the software renderer, pixels are premultiplied ARGB8888
+ */
+struct fwiRenderKernels {
+    void (*fill)(uint32_t* destination_p, uint32_t count, uint32_t color);
+    void (*copy)(uint32_t* destination_p, const uint32_t* source_p, uint32_t count);
+    void (*blend)(uint32_t* destination_p, const uint32_t* source_p, uint32_t count); // over
+    const char* name_p;
+};
+
+// Sets of up to this many bytes are compared in vector registers, larger ones go through a bitmap
+#define FWI_SCAN_VECTOR_SET 16
+
+/**
+ * @brief Buffer scanning kernels behind @c fwBufferFindAny and @c fwBufferIndexCreate
+ */
+struct fwiScanKernels {
+    // Offset of the first byte that is in the set or size, the set has 1 to FWI_SCAN_VECTOR_SET
+    uint64_t (*findAny)(const uint8_t* data_p, uint64_t size, const uint8_t* set_p,
+                        uint32_t setSize);
+    // Writes base plus one past the offset of every delimiter, offsets_p holds at least size
+    uint64_t (*collect)(const uint8_t* data_p, uint64_t size, uint8_t delimiter, uint64_t base,
+                        uint64_t* offsets_p);
+    const char* name_p;
+};
+
 struct fwiState* fwiGetState(
     void
     );
 
+/**
+ * @brief Picks the widest row kernels the CPU that runs the process supports
+ * @return Kernels that stay valid for the lifetime of the process
+ */ // PlatIndepImp
+const struct fwiRenderKernels* fwiRenderSelectKernels(
+    void
+    );
+
+/**
+ * @brief Plain C row kernels, the reference the vectorized ones have to match bit for bit
+ */ // PlatIndepImp
+const struct fwiRenderKernels* fwiRenderScalarKernels(
+    void
+    );
+
+/**
+ * @brief Picks the widest scanning kernels the CPU that runs the process supports
+ * @return Kernels that stay valid for the lifetime of the process
+ */ // PlatIndepImp
+const struct fwiScanKernels* fwiScanSelectKernels(
+    void
+    );
+
+/**
+ * @brief Plain C scanning kernels, the reference for the vectorized ones
+ */ // PlatIndepImp
+const struct fwiScanKernels* fwiScanScalarKernels(
+    void
+    );
+
+/**
+ * @brief Prepares an empty timer wheel
+ * @param wheel_p[out] Wheel to prepare
+ * @param now[in] First tick that is processed
+ */ // PlatIndepImp
+void fwiTimerWheelInit(
+    struct fwiTimerWheel* wheel_p,
+    uint64_t now
+    );
+
+/**
+ * @brief Arms a timer, re-arming an armed one only moves it
+ * @param wheel_p[in] Wheel that will be holding the timer
+ * @param timer_p[in] Timer with handler and context set
+ * @param expiry[in] Tick at which the timer expires, ticks that were processed already expire on
+ *                   the next one
+ */ // PlatIndepImp
+void fwiTimerWheelArm(
+    struct fwiTimerWheel* wheel_p,
+    struct fwiTimer* timer_p,
+    uint64_t expiry
+    );
+
+/**
+ * @brief Disarms a timer, does nothing if it was not armed
+ */ // PlatIndepImp
+void fwiTimerWheelCancel(
+    struct fwiTimerWheel* wheel_p,
+    struct fwiTimer* timer_p
+    );
+
+/**
+ * @brief Turns the wheel and calls the handlers of every timer that expired on the way
+ * @param wheel_p[in] Wheel to turn
+ * @param until[in] Last tick that is processed
+ * @return Number of timers that expired
+ */ // PlatIndepImp
+uint32_t fwiTimerWheelAdvance(
+    struct fwiTimerWheel* wheel_p,
+    uint64_t until
+    );
+
+/**
+ * @brief Earliest tick at which the wheel has work to do, either firing or cascading timers
+ * @return The tick or UINT64_MAX when no timer is armed
+ */ // PlatIndepImp
+uint64_t fwiTimerWheelNext(
+    const struct fwiTimerWheel* wheel_p
+    );
+
+/**
+ * @brief Maps an anonymous region for an arena or pool
+ * @param size[in] Requested size in bytes
+ * @param numaNode[in] Node to bind the region to or FW_MEMORY_ANY_NODE
+ * @param flags[in] Combination of fwMemoryFlags
+ * @param memory_pp[out] Start of the region
+ * @param mappedSize_p[out] Actual size of the region, at least size
+ * @return fwErrorInvalidParameter when the node does not exist, fwErrorOutOfMemory when the
+ *         region could not be mapped
+ */ // PlatDepImp
+fwError fwiMapMemory(
+    uint64_t size,
+    int16_t numaNode,
+    uint8_t flags,
+    void** memory_pp,
+    uint64_t* mappedSize_p
+    );
+
+// PlatDepImp
+void fwiUnmapMemory(
+    void* memory_p,
+    uint64_t mappedSize
+    );
+
 // PlatIndepImp
 fwError fwiStartNativeModuleBase(
     void
@@ -75,7 +477,7 @@ fwError fwiStartNativeModuleWindow(
 
 // PlatDepImp
 fwError fwiStartNativeModuleNetwork(
-    void
+    uint32_t flags
     );
 
 // PlatDepImp
@@ -88,6 +490,11 @@ fwError fwiStartNativeModuleRenderer(
     void
     );
 
+// PlatDepImp
+fwError fwiStartNativeModuleJob(
+    void
+    );
+
 // PlatIndepImp
 fwError fwiStopNativeModuleBase(
     void
@@ -113,6 +520,11 @@ fwError fwiStopNativeModuleRenderer(
     void
     );
 
+// PlatDepImp
+fwError fwiStopNativeModuleJob(
+    void
+    );
+
 /**
  * @brief printf with added timestamp and log level color
  * @param lll[in] Log level of the message
@@ -123,7 +535,7 @@ void fwiLogA(
     enum fwiLogLevel lll,
     const char* format_p,
     ...
-    );
+    ) __attribute__((format(printf, 2, 3)));
 
 /**
  * @brief printf with added timestamp and log level color
@@ -17,8 +17,215 @@
 #ifndef LINUX_H
 #define LINUX_H
 
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+
 #include "framework.h"
+#include "internal.h"
 
 #define FWI_LOG_ERRNO fwiLogErrno(__func__, __LINE__)
 
+/**
+ * @brief Number of epoll events fetched by one wait of an event loop
+ */
+#define FWI_EVENT_LOOP_BATCH 64
+
+/**
+ * @brief Submission entries of the I/O queues created by the network module
+ */
+#define FWI_IO_QUEUE_DEFAULT_ENTRIES 256
+#define FWI_IO_QUEUE_FILE_ENTRIES 32
+
+/**
+ * @brief Files of at least this size are read in chunks of this size through the I/O queue
+ */
+#define FWI_IO_QUEUE_FILE_CHUNK 1048576 // 1 MiB
+
+struct fwiEventSource;
+struct fwiNativeEventLoop;
+
+/**
+ * @brief Called by an event loop when the file descriptor of a source became ready
+ * @param source_p[in] The source that became ready
+ * @param events[in] Epoll event mask
+ */
+typedef void (*fwiEventHandler)(
+    struct fwiEventSource* source_p,
+    uint32_t events
+    );
+
+/**
+ * @brief Anything that has a file descriptor an event loop can wait on. Embedded into the state
+ *        of its owner, so registering with a loop never allocates.
+ */
+struct fwiEventSource {
+    fwiEventHandler handler;
+    void* context_p;
+    struct fwiNativeEventLoop* loop_p; // nullptr while not registered
+    int32_t fileDescriptor;
+};
+
+struct fwiNativeEventLoop {
+    struct epoll_event* dispatching_p; // batch that is currently being dispatched, if any
+    int32_t dispatchIndex, dispatchCount;
+    uint32_t sourceCount;
+    uint32_t timerCount; // fwTimer objects of the loop, they have to be gone before it is
+    struct fwiEventSource wakeSource; // eventfd used by fwEventLoopStop
+    struct fwiEventSource timerSource; // timerfd, set to the next tick the wheel has work at
+    struct fwiTimerWheel timerWheel; // ticks are milliseconds of CLOCK_MONOTONIC
+    uint64_t timerProgrammed; // tick the timerfd is set to, UINT64_MAX while disarmed
+    int64_t now; // milliseconds at which the current batch of events was received
+    struct fwiEventSource* windowSource_p; // display of the window module, read around every wait
+    int32_t epollFileDescriptor;
+    atomic_bool running;
+};
+
+/**
+ * @brief Do not instanciate, Linux counterpart to @c fwiState
+ */
+struct fwiNativeState {
+    pthread_mutex_t fileIoQueueMutex;
+    fwEventLoop defaultEventLoop;
+    fwIoQueue defaultIoQueue;
+    fwIoQueue fileIoQueue; // used by fwLoadFileToMem, guarded by fileIoQueueMutex
+    const struct fwiRenderKernels* renderKernels_p; // nullptr while the render module is stopped
+    uint32_t renderSurfaceCount;
+    uint32_t audioStreamCount;
+    bool multimediaRunning;
+};
+
+struct fwiNativeState* fwiGetNativeState(
+    void
+    );
+
+struct wl_display;
+struct wl_compositor;
+struct wl_shm;
+struct xdg_wm_base;
+
+/**
+ * @brief Globals of the Wayland display, each one is bound the first time it is asked for
+ * @return The global or @c nullptr if the window module is not running or the compositor does not
+ *         offer it
+ */ // PlatDepImp
+struct wl_display* fwiWindowGetDisplay(
+    void
+    );
+
+// PlatDepImp
+struct wl_compositor* fwiWindowGetCompositor(
+    void
+    );
+
+// PlatDepImp
+struct wl_shm* fwiWindowGetShm(
+    void
+    );
+
+// PlatDepImp
+struct xdg_wm_base* fwiWindowGetWmBase(
+    void
+    );
+
+/**
+ * @brief Lets an event loop dispatch the events of the Wayland display
+ * @param loop_p[in] Event loop that waits on the display from now on
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorModule The window module is not running
+ * @return @c fwErrorInvalidParameter The display already is registered with a loop
+ * @return @c fwErrorEventLoop The display could not be added to the loop
+ */ // PlatDepImp
+fwError fwiWindowAttach(
+    struct fwiNativeEventLoop* loop_p
+    );
+
+/**
+ * @brief Removes the Wayland display from the event loop it is registered with
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorInvalidParameter The display is not registered with a loop
+ */ // PlatDepImp
+fwError fwiWindowDetach(
+    void
+    );
+
+/**
+ * @brief Called by an event loop before it waits, after this only the calling thread reads from
+ *        the display until @c fwiWindowFinishRead . A display in error is detached instead.
+ */ // PlatDepImp
+void fwiWindowPrepareRead(
+    void
+    );
+
+/**
+ * @brief Called by an event loop after it waited, reads the events of the display or gives up the
+ *        read that was prepared
+ * @param readable[in] Whether the wait reported the display as readable
+ */ // PlatDepImp
+void fwiWindowFinishRead(
+    bool readable
+    );
+
+/**
+ * @brief Reserves the table all socket states live in, sized after the descriptor limit
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorOutOfMemory The address space could not be reserved
+ */ // PlatDepImp
+fwError fwiSocketTableCreate(
+    void
+    );
+
+/**
+ * @brief Closes sockets that are still open and releases the socket table
+ */ // PlatDepImp
+void fwiSocketTableDestroy(
+    void
+    );
+
+/**
+ * @brief Starts the workers of the job system, each pinned to its own CPU
+ * @param workers[in] Number of worker threads
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorOutOfMemory The workers or their deques could not be created
+ */ // PlatDepImp
+fwError fwiJobSystemCreate(
+    uint32_t workers
+    );
+
+/**
+ * @brief Runs every job that is still queued, then stops and joins the workers
+ */ // PlatDepImp
+void fwiJobSystemDestroy(
+    void
+    );
+
+/**
+ * @brief Starts watching a source
+ * @param loop_p[in] Event loop that will be watching
+ * @param source_p[in] Source with handler, context and file descriptor filled in
+ * @param events[in] Epoll event mask
+ * @return @c fwErrorSuccess No error occured
+ * @return @c fwErrorEventLoop epoll_ctl failed
+ */ // PlatDepImp
+fwError fwiEventLoopAddSource(
+    struct fwiNativeEventLoop* loop_p,
+    struct fwiEventSource* source_p,
+    uint32_t events
+    );
+
+// PlatDepImp
+fwError fwiEventLoopModifySource(
+    struct fwiEventSource* source_p,
+    uint32_t events
+    );
+
+/**
+ * @brief Stops watching a source, also drops events of it which are still pending in the batch
+ *        that is currently being dispatched
+ */ // PlatDepImp
+fwError fwiEventLoopRemoveSource(
+    struct fwiEventSource* source_p
+    );
+
 #endif //LINUX_H
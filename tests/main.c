@@ -19,8 +19,43 @@
 #include "tests.h"
 
 int main(int argc, char* argv[]) {
+    tstUnitLogger(); // has to run before any module is started
+
     TST(fwStartModule(fwModuleWindow, 0));
 
     TST(fwStopModule(fwModuleWindow));
+
+    tstUnitEventLoop();
+    tstUnitIoQueue();
+    tstUnitFileMapping();
+    tstUnitFileReader();
+    tstUnitSocketBatch();
+    tstUnitSocketStats();
+    tstUnitSocketListen();
+    tstUnitSocketConnectParallel();
+    tstUnitResolver();
+    tstUnitSocketSendFile();
+    tstUnitSocketZeroCopy();
+    tstUnitSocketConfigure();
+    tstUnitSocketStream();
+    tstUnitConnectionPool();
+    tstUnitFiber();
+    tstUnitTimer();
+    tstUnitLocalChannel();
+    tstUnitWindow();
+    tstUnitRender();
+    tstUnitAudio();
+    tstUnitBuffer();
+    tstUnitFileCache();
+    tstUnitModules();
+    tstUnitSocketHandles();
+    tstUnitLogFilter();
+    tstUnitConnectParallelOptions();
+    tstUnitBench();
+    tstUnitJob();
+    tstUnitSystemConfiguration();
+    tstUnitArena();
+    tstUnitSocketBind();
+    tstUnitEventLoopConnect();
     return 0;
 }
@@ -14,7 +14,18 @@
 
 #include "tests.h"
 
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "internal.h"
 
 void tstLogFrameworkFail(const fwError error, const char* location, const int32_t line) {
     printf("Call in %s failed with %d at line %d\n", location, error, line);
@@ -35,11 +46,11 @@ void tstUnitNetworkClient(void) {
                                                                 "Host: www.tonexum.org\n";
 
     TST(fwSocketSend(socket, invalidHttpRequestBecauseNginxWontRespondOtherwise,
-        sizeof(invalidHttpRequestBecauseNginxWontRespondOtherwise)));
+        sizeof(invalidHttpRequestBecauseNginxWontRespondOtherwise), nullptr));
 
     char theResponseTellingMeThatTheHttpRequestIsInvalid[512] = {};
     TST(fwSocketReceive(socket, theResponseTellingMeThatTheHttpRequestIsInvalid,
-        sizeof(theResponseTellingMeThatTheHttpRequestIsInvalid)));
+        sizeof(theResponseTellingMeThatTheHttpRequestIsInvalid), nullptr));
 
     TST(fwSocketClose(socket));
 
@@ -66,3 +77,1849 @@ void tstUnitNetworkServer(void) {
 
     TST(fwStopModule(fwModuleNetwork));
 }
+
+static void tstEventLoopCallback(const fwSocket sfdop, const uint8_t events, void* user_p) {
+    if (events & fwEventRead) {
+        char buffer[16] = {};
+        TST(fwSocketReceive(sfdop, buffer, sizeof(buffer), user_p));
+    }
+}
+
+void tstUnitLogger(void) {
+    if (fwConfigureLogger(nullptr) != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(fwErrorInvalidParameter, __func__, __LINE__);
+    }
+
+    struct fwLoggerConfiguration configuration = {};
+    configuration.flushInterval = 5;
+    TST(fwConfigureLogger(&configuration));
+}
+
+void tstUnitEventLoop(void) {
+    TST(fwStartModule(fwModuleNetwork, fwModuleFlagNetworkEventLoop));
+
+    fwEventLoop loop = 0;
+    TST(fwEventLoopGetDefault(&loop));
+
+    // A datagram socket connected to itself, so the test does not depend on any peer
+    fwSocket socket = 0;
+    TST(fwSocketCreate(&socket, fwSocketAddressFamilyIPv4, fwSocketProtocolDatagram));
+
+    struct fwSocketAddress address = {};
+    address.target_p = "127.0.0.1";
+    address.port_p = "49152";
+    TST(fwSocketBind(socket, &address));
+    TST(fwSocketConnect(socket, &address));
+
+    size_t received = 0;
+    TST(fwEventLoopRegister(loop, socket, fwEventRead, tstEventLoopCallback, &received));
+    TST(fwSocketSend(socket, "ping", 4, nullptr));
+    TST(fwEventLoopPoll(loop, 1000, nullptr));
+    if (received != 4) {
+        tstLogFrameworkFail(fwErrorSocketReceive, __func__, __LINE__);
+    }
+
+    TST(fwSocketClose(socket));
+
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+void tstUnitIoQueue(void) {
+    TST(fwStartModule(fwModuleNetwork, fwModuleFlagNetworkIoUring));
+
+    fwIoQueue queue = 0;
+    TST(fwIoQueueGetDefault(&queue));
+
+    fwSocket socket = 0;
+    TST(fwSocketCreate(&socket, fwSocketAddressFamilyIPv4, fwSocketProtocolDatagram));
+
+    struct fwSocketAddress address = {};
+    address.target_p = "127.0.0.1";
+    address.port_p = "49153";
+    TST(fwSocketBind(socket, &address));
+    TST(fwSocketConnect(socket, &address));
+
+    // Both operations reach the kernel with a single syscall
+    char buffer[16] = {};
+    TST(fwIoQueueSend(queue, socket, "ping", 4, 1));
+    TST(fwIoQueueReceive(queue, socket, buffer, sizeof(buffer), 2));
+    TST(fwIoQueueSubmit(queue, 2));
+
+    fwIoCompletion completions[2] = {};
+    uint32_t reaped = 0;
+    TST(fwIoQueueReap(queue, completions, 2, &reaped));
+    for (uint32_t i = 0; i < reaped; i++) {
+        TST(completions[i].error);
+        if (completions[i].transferred != 4) {
+            tstLogFrameworkFail(fwErrorSocketReceive, __func__, __LINE__);
+        }
+    }
+    if (reaped != 2) {
+        tstLogFrameworkFail(fwErrorIoQueue, __func__, __LINE__);
+    }
+
+    TST(fwSocketClose(socket));
+
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+void tstUnitFileMapping(void) {
+    const char contents[] = "Mapped without a single copy";
+
+    FILE* file = fopen("lpafTestMapping.txt", "wb");
+    fwrite(contents, 1, sizeof(contents), file);
+    fclose(file);
+
+    const void* view = nullptr;
+    uint64_t size = 0;
+    TST(fwMapFile("lpafTestMapping.txt", fwFileMapHintSequential | fwFileMapHintWillNeed, &view,
+        &size));
+    if (size != sizeof(contents) || memcmp(view, contents, sizeof(contents)) != 0) {
+        tstLogFrameworkFail(fwErrorFileMap, __func__, __LINE__);
+    }
+    TST(fwUnmapFile(view, size));
+
+    remove("lpafTestMapping.txt");
+}
+
+void tstUnitFileReader(void) {
+    FILE* file = fopen("lpafTestReader.txt", "wb");
+    for (uint32_t i = 0; i < 10000; i++) {
+        fputc('a' + i % 26, file);
+    }
+    fclose(file);
+
+    fwFileReader reader = 0;
+    TST(fwFileReaderOpen("lpafTestReader.txt", 4096, &reader));
+
+    // Chunks have to arrive in order and without gaps
+    uint64_t total = 0;
+    const void* chunk = nullptr;
+    size_t size = 0;
+    do {
+        TST(fwFileReaderNext(reader, &chunk, &size));
+        for (size_t i = 0; i < size; i++) {
+            if (((const char*)chunk)[i] != (char)('a' + (total + i) % 26)) {
+                tstLogFrameworkFail(fwErrorFileStats, __func__, __LINE__);
+                break;
+            }
+        }
+        total += size;
+    } while (size > 0);
+    if (total != 10000) {
+        tstLogFrameworkFail(fwErrorFileStats, __func__, __LINE__);
+    }
+
+    TST(fwFileReaderClose(reader));
+
+    remove("lpafTestReader.txt");
+}
+
+void tstUnitSocketBatch(void) {
+    TST(fwStartModule(fwModuleNetwork, 0));
+
+    fwSocket socket = 0;
+    TST(fwSocketCreate(&socket, fwSocketAddressFamilyIPv4, fwSocketProtocolDatagram));
+
+    struct fwSocketAddress address = {};
+    address.target_p = "127.0.0.1";
+    address.port_p = "49154";
+    TST(fwSocketBind(socket, &address));
+    TST(fwSocketConnect(socket, &address));
+
+    // Header and payload leave as one datagram
+    char header[] = "HDR";
+    char payload[] = "payload";
+    const fwSocketBuffer parts[2] = {{header, 3}, {payload, 7}};
+    size_t sent = 0;
+    TST(fwSocketSendv(socket, parts, 2, &sent));
+
+    char messages[3][16] = {{'a'}, {'b'}, {'c'}};
+    fwSocketDatagram datagrams[3] = {};
+    for (uint32_t i = 0; i < 3; i++) {
+        datagrams[i].buffer.data_p = messages[i];
+        datagrams[i].buffer.size = 1;
+    }
+    uint32_t count = 0;
+    TST(fwSocketSendBatch(socket, datagrams, 3, &count));
+
+    char received[4][16] = {};
+    fwSocketDatagram incoming[4] = {};
+    for (uint32_t i = 0; i < 4; i++) {
+        incoming[i].buffer.data_p = received[i];
+        incoming[i].buffer.size = sizeof(received[i]);
+    }
+    TST(fwSocketReceiveBatch(socket, incoming, 4, &count));
+    if (count != 4 || incoming[0].transferred != 10 || memcmp(received[0], "HDRpayload", 10) != 0 ||
+        received[3][0] != 'c') {
+        tstLogFrameworkFail(fwErrorSocketReceive, __func__, __LINE__);
+    }
+
+    TST(fwSocketClose(socket));
+
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+void tstUnitSocketStats(void) {
+    TST(fwStartModule(fwModuleNetwork, 0));
+
+    fwSocket socket = 0;
+    TST(fwSocketCreate(&socket, fwSocketAddressFamilyIPv4, fwSocketProtocolDatagram));
+
+    struct fwSocketAddress address = {};
+    address.target_p = "127.0.0.1";
+    address.port_p = "49155";
+    TST(fwSocketBind(socket, &address));
+    TST(fwSocketConnect(socket, &address));
+
+    const char message[] = "statistics";
+    TST(fwSocketSend(socket, message, 10, nullptr));
+    char buffer[64] = {};
+    TST(fwSocketReceive(socket, buffer, sizeof(buffer), nullptr));
+
+    struct fwSocketStats stats = {};
+    TST(fwSocketGetStats(socket, &stats));
+    uint64_t sampled = 0;
+    for (uint32_t i = 0; i < FW_SOCKET_LATENCY_BUCKETS; i++) {
+        sampled += stats.sendLatency[i];
+    }
+    // The very first call of a socket is always timed
+    if (stats.bytesSent != 10 || stats.bytesReceived != 10 || stats.syscalls != 2 ||
+        stats.shortReads != 1 || stats.shortWrites != 0 || sampled != 1) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+
+    TST(fwSocketClose(socket));
+
+    // Closed sockets still count towards the global figures
+    TST(fwSocketGetGlobalStats(&stats));
+    if (stats.bytesSent < 10 || stats.bytesReceived < 10) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    if (fwSocketGetStats(socket, &stats) != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(fwErrorInvalidParameter, __func__, __LINE__);
+    }
+
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+void tstUnitSocketHandles(void) {
+    TST(fwStartModule(fwModuleNetwork, 0));
+
+    fwSocket socket = 0;
+    TST(fwSocketCreate(&socket, fwSocketAddressFamilyIPv4, fwSocketProtocolDatagram));
+    TST(fwSocketClose(socket));
+    fwError error = fwSocketClose(socket);
+    if (error != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+    error = fwSocketSend(socket, "x", 1, nullptr);
+    if (error != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    // The slot is reused by the next socket, the old identifier must not reach it
+    fwSocket reused = 0;
+    TST(fwSocketCreate(&reused, fwSocketAddressFamilyIPv4, fwSocketProtocolDatagram));
+    error = fwSocketClose(socket);
+    if (error != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    // A socket left open when the module stops is closed with it, its identifier stays invalid
+    TST(fwStopModule(fwModuleNetwork));
+    error = fwSocketSend(reused, "x", 1, nullptr);
+    if (error != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+    TST(fwStartModule(fwModuleNetwork, 0));
+    fwSocket fresh = 0;
+    TST(fwSocketCreate(&fresh, fwSocketAddressFamilyIPv4, fwSocketProtocolDatagram));
+    if (fresh == reused || fresh == socket) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    error = fwSocketClose(reused);
+    if (error != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+    TST(fwSocketClose(fresh));
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+// Sites below are compiled as if the build only kept warnings and errors
+#pragma push_macro("FWI_LOG_LEVEL_MAX")
+#undef FWI_LOG_LEVEL_MAX
+#define FWI_LOG_LEVEL_MAX fwiLogLevelWarning
+
+static uint32_t tstLogEvaluated_s = 0;
+
+static uint32_t tstLogEvaluate(void) {
+    return ++tstLogEvaluated_s;
+}
+
+static size_t tstLogEncode(uint8_t* payload_p, const char* format_p, ...) {
+    va_list args;
+    va_start(args);
+    const size_t used = fwiLogEncodeArguments(format_p, payload_p, 0, args);
+    va_end(args);
+    return used;
+}
+
+void tstUnitLogFilter(void) {
+    TST(fwStartModule(fwModuleNetwork, 0));
+
+    // Filtered sites neither evaluate their arguments nor touch the ring the writer drains
+    uint64_t pushed = 0;
+    uint64_t dropped = 0;
+    fwiLogGetThreadCounters(&pushed, &dropped);
+    FWI_LOG_DEBUG("Filtered message %u", tstLogEvaluate());
+    FWI_LOG_INFO("Filtered message %u", tstLogEvaluate());
+    uint64_t pushedAfter = 0;
+    uint64_t droppedAfter = 0;
+    fwiLogGetThreadCounters(&pushedAfter, &droppedAfter);
+    if (tstLogEvaluated_s != 0 || pushedAfter != pushed || droppedAfter > dropped) {
+        tstLogFrameworkFail(fwErrorInvalidParameter, __func__, __LINE__);
+    }
+
+#if defined(BUILD_DEBUG) || defined(BUILD_RELEASE)
+    FWI_LOG_WARNING("Logger test message %u was kept", tstLogEvaluate());
+    fwiLogGetThreadCounters(&pushedAfter, &droppedAfter);
+    if (tstLogEvaluated_s != 1 || pushedAfter <= pushed) {
+        tstLogFrameworkFail(fwErrorInvalidParameter, __func__, __LINE__);
+    }
+#endif // BUILD_DEBUG || BUILD_RELEASE
+
+    // A binary record renders to exactly what printf makes of the same arguments
+    static const char format[] = "%s took %5.2f ms, %-*d of %" PRIu64 " at %p, %c%% %zu";
+    uint8_t payload[FWI_LOG_MESSAGE_MAX];
+    const size_t used = tstLogEncode(payload, format, "Lookup", 1.25, 4, -7, (uint64_t)9,
+                                     (void*)payload, 'x', sizeof(payload));
+    char decoded[FWI_LOG_MESSAGE_MAX];
+    fwiLogRenderBinary(format, payload, used, decoded, sizeof(decoded));
+    char expected[FWI_LOG_MESSAGE_MAX];
+    snprintf(expected, sizeof(expected), format, "Lookup", 1.25, 4, -7, (uint64_t)9,
+             (void*)payload, 'x', sizeof(payload));
+    if (strcmp(decoded, expected) != 0) {
+        printf("Decoded \"%s\" instead of \"%s\"\n", decoded, expected);
+        tstLogFrameworkFail(fwErrorInvalidParameter, __func__, __LINE__);
+    }
+
+    // Payloads that end early are marked instead of being read past their end
+    fwiLogRenderBinary(format, payload, 8, decoded, sizeof(decoded));
+    if (strstr(decoded, "<truncated>") == nullptr) {
+        tstLogFrameworkFail(fwErrorInvalidParameter, __func__, __LINE__);
+    }
+
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+#pragma pop_macro("FWI_LOG_LEVEL_MAX")
+
+void tstUnitBench(void) {
+    const struct fwBenchConfiguration configuration = {
+        .name_p = "Test",
+        .warmup = 2,
+        .repetitions = 4
+    };
+    fwBench bench = 0;
+    TST(fwBenchCreate(&configuration, &bench));
+
+    // The first two are warmup and must not show up in the result
+    const uint64_t samples[] = {1000000, 1000000, 10, 20, 30, 4000};
+    for (uint32_t i = 0; i < 6; i++) {
+        TST(fwBenchRecord(bench, samples[i]));
+    }
+
+    struct fwBenchResult result = {};
+    TST(fwBenchReport(bench, &result));
+    if (result.samples != 4 || result.minimum != 10 || result.maximum != 4000 ||
+        result.median != 20 || result.mean != 1015 || result.histogram[3] != 1) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+
+    TST(fwBenchDestroy(bench));
+}
+
+static void tstJobIncrement(void* user_p) {
+    atomic_fetch_add_explicit((atomic_uint*)user_p, 1, memory_order_relaxed);
+}
+
+static void tstJobCheckFirstStage(void* user_p) {
+    // Runs after all 1000 increments, anything less means the dependency was ignored
+    if (atomic_load((atomic_uint*)user_p) != 1000) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+}
+
+void tstUnitJob(void) {
+    TST(fwStartModule(fwModuleJob, 0));
+
+    uint32_t workers = 0;
+    TST(fwJobGetWorkerCount(&workers));
+    if (workers == 0) {
+        tstLogFrameworkFail(fwErrorModule, __func__, __LINE__);
+    }
+
+    atomic_uint value = 0;
+    static fwJob jobs[1000];
+    for (uint32_t i = 0; i < 1000; i++) {
+        jobs[i].function = tstJobIncrement;
+        jobs[i].user_p = &value;
+    }
+
+    fwJobCounter first = 0;
+    fwJobCounter second = 0;
+    TST(fwJobCounterCreate(&first));
+    TST(fwJobCounterCreate(&second));
+
+    const fwJob check = {.function = tstJobCheckFirstStage, .user_p = &value};
+    TST(fwJobSubmit(jobs, 1000, first));
+    TST(fwJobSubmitAfter(first, &check, 1, second));
+    TST(fwJobWait(second));
+    TST(fwJobWait(first));
+    if (atomic_load(&value) != 1000) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+
+    const fwJob invalid = {};
+    if (fwJobSubmit(&invalid, 1, first) != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(fwErrorInvalidParameter, __func__, __LINE__);
+    }
+
+    TST(fwJobCounterDestroy(second));
+    TST(fwJobCounterDestroy(first));
+
+    TST(fwStopModule(fwModuleJob));
+}
+
+void tstUnitSystemConfiguration(void) {
+    struct fwSystemConfiguration configuration = {};
+    TST(fwGetSystemConfiguration(&configuration));
+
+    if (configuration.cores == 0 || configuration.memory == 0 ||
+        configuration.memoryAvailable > configuration.memory || configuration.sockets == 0 ||
+        configuration.physicalCores > configuration.cores) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    if (configuration.cacheLine == 0 || (configuration.cacheLine & (configuration.cacheLine - 1))) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+
+    // Every online CPU belongs to exactly one node
+    uint32_t nodeCpus = 0;
+    for (uint8_t i = 0; i < configuration.numaNodeCount; i++) {
+        nodeCpus += configuration.numaNodes[i].cpuCount;
+    }
+    if (configuration.numaNodeCount == 0 || nodeCpus != configuration.cores) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+}
+
+void tstUnitArena(void) {
+    const struct fwArenaConfiguration arenaConfiguration = {
+        .size = 1 << 20,
+        .numaNode = FW_MEMORY_ANY_NODE,
+        .flags = fwMemoryFlagTransparentHugePages
+    };
+    fwArena arena = 0;
+    TST(fwArenaCreate(&arenaConfiguration, &arena));
+
+    void* first_p = nullptr;
+    void* second_p = nullptr;
+    TST(fwArenaAllocate(arena, 3, 0, &first_p));
+    fwArenaMarker marker = 0;
+    TST(fwArenaGetMarker(arena, &marker));
+    TST(fwArenaAllocate(arena, 100, 64, &second_p));
+    if ((uintptr_t)second_p % 64 != 0 || (uint8_t*)second_p < (uint8_t*)first_p + 3) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    memset(second_p, 0xAB, 100);
+
+    // Rewinding hands out the same memory again
+    void* again_p = nullptr;
+    TST(fwArenaRewind(arena, marker));
+    TST(fwArenaAllocate(arena, 100, 64, &again_p));
+    if (again_p != second_p) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    if (fwArenaAllocate(arena, 1 << 20, 0, &again_p) != fwErrorOutOfMemory) {
+        tstLogFrameworkFail(fwErrorOutOfMemory, __func__, __LINE__);
+    }
+    TST(fwArenaReset(arena));
+    TST(fwArenaAllocate(arena, 1 << 20, 0, &again_p));
+    TST(fwArenaDestroy(arena));
+
+    const struct fwPoolConfiguration poolConfiguration = {
+        .elementSize = 24,
+        .elementCount = 2,
+        .numaNode = FW_MEMORY_ANY_NODE
+    };
+    fwPool pool = 0;
+    TST(fwPoolCreate(&poolConfiguration, &pool));
+    TST(fwPoolAllocate(pool, &first_p));
+    TST(fwPoolAllocate(pool, &second_p));
+    if (fwPoolAllocate(pool, &again_p) != fwErrorOutOfMemory || second_p != (uint8_t*)first_p + 32) {
+        tstLogFrameworkFail(fwErrorOutOfMemory, __func__, __LINE__);
+    }
+    TST(fwPoolFree(pool, first_p));
+    TST(fwPoolAllocate(pool, &again_p));
+    if (again_p != first_p || fwPoolFree(pool, (uint8_t*)first_p + 8) != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    TST(fwPoolDestroy(pool));
+}
+
+void tstUnitSocketListen(void) {
+    TST(fwStartModule(fwModuleNetwork, 0));
+
+    fwSocket unbound = 0;
+    TST(fwSocketCreate(&unbound, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    if (fwSocketListen(unbound, 16) != fwErrorSocketNotBound) {
+        tstLogFrameworkFail(fwErrorSocketNotBound, __func__, __LINE__);
+    }
+    TST(fwSocketClose(unbound));
+
+    struct fwSocketAddress address = {};
+    address.target_p = "127.0.0.1";
+    address.port_p = "49156";
+    fwSocket shards[2] = {};
+    TST(fwSocketListenSharded(fwSocketAddressFamilyIPv4, &address, 2, 16, shards));
+
+    fwSocket clients[3] = {};
+    for (uint32_t i = 0; i < 3; i++) {
+        TST(fwSocketCreate(&clients[i], fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+        TST(fwSocketConnect(clients[i], &address));
+    }
+
+    // The handshakes completed in the kernel, every connection waits in one of the two queues
+    fwSocket accepted[8] = {};
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < 2; i++) {
+        uint32_t count = 0;
+        const fwError error = fwSocketAcceptBatch(shards[i], &accepted[total], 4, &count);
+        if (error != fwErrorSuccess && error != fwErrorSocketWouldBlock) {
+            tstLogFrameworkFail(error, __func__, __LINE__);
+        }
+        total += count;
+    }
+    if (total != 3) {
+        tstLogFrameworkFail(fwErrorSocketAccept, __func__, __LINE__);
+    }
+
+    // Clients close first, the time-wait state then stays with their ephemeral ports
+    for (uint32_t i = 0; i < 3; i++) {
+        TST(fwSocketClose(clients[i]));
+    }
+    for (uint32_t i = 0; i < total; i++) {
+        TST(fwSocketClose(accepted[i]));
+    }
+    TST(fwSocketClose(shards[0]));
+    TST(fwSocketClose(shards[1]));
+
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+void tstUnitSocketBind(void) {
+    TST(fwStartModule(fwModuleNetwork, 0));
+
+    fwSocket invalid = 0;
+    const struct fwSocketAddress mismatch = {.target_p = "::1", .port_p = "49173"};
+    TST(fwSocketCreate(&invalid, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    if (fwSocketBind(invalid, &mismatch) != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(fwErrorInvalidParameter, __func__, __LINE__);
+    }
+    TST(fwSocketClose(invalid));
+
+    // IPv6 shards bound to the wildcard take connections to the loopback address
+    const struct fwSocketAddress any = {.target_p = FW_SOCKET_ADDRESS_ANY, .port_p = "49173"};
+    const struct fwSocketAddress loopback = {.target_p = "::1", .port_p = "49173"};
+    fwSocket shards[2] = {};
+    TST(fwSocketListenSharded(fwSocketAddressFamilyIPv6, &any, 2, 16, shards));
+
+    fwSocket client = 0;
+    TST(fwSocketCreate(&client, fwSocketAddressFamilyIPv6, fwSocketProtocolStream));
+    TST(fwSocketConnect(client, &loopback));
+
+    fwSocket accepted = 0;
+    char peer[64] = {};
+    fwError error = fwErrorSocketWouldBlock;
+    for (uint32_t i = 0; i < 2 && error == fwErrorSocketWouldBlock; i++) {
+        error = fwSocketAccept(shards[i], &accepted, peer);
+    }
+    TST(error);
+    if (strcmp(peer, "::1") != 0) {
+        tstLogFrameworkFail(fwErrorSocketAccept, __func__, __LINE__);
+    }
+
+    TST(fwSocketClose(client));
+    TST(fwSocketClose(accepted));
+    TST(fwSocketClose(shards[0]));
+    TST(fwSocketClose(shards[1]));
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+void tstUnitSocketConnectParallel(void) {
+    TST(fwStartModule(fwModuleNetwork, 0));
+
+    fwSocket listener = 0;
+    TST(fwSocketCreate(&listener, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    struct fwSocketAddress address = {};
+    address.target_p = "127.0.0.1";
+    address.port_p = "49157";
+    TST(fwSocketBind(listener, &address));
+    TST(fwSocketListen(listener, 4));
+
+    // Created as IPv6, the IPv4 address has to win and take the socket over
+    fwSocket client = 0;
+    TST(fwSocketCreate(&client, fwSocketAddressFamilyIPv6, fwSocketProtocolStream));
+    TST(fwSocketConnectParallel(client, &address, 2000));
+
+    fwSocket accepted = 0;
+    TST(fwSocketAccept(listener, &accepted, nullptr));
+    TST(fwSocketSend(client, "eyeballs", 8, nullptr));
+    char buffer[16] = {};
+    TST(fwSocketReceive(accepted, buffer, sizeof(buffer), nullptr));
+    if (memcmp(buffer, "eyeballs", 8) != 0) {
+        tstLogFrameworkFail(fwErrorSocketReceive, __func__, __LINE__);
+    }
+
+    // The client closes first so that the time-wait state does not block the port for a rerun
+    TST(fwSocketClose(client));
+    TST(fwSocketClose(accepted));
+    TST(fwSocketClose(listener));
+
+    // Nobody listens there, every attempt is refused right away instead of timing out
+    fwSocket refused = 0;
+    TST(fwSocketCreate(&refused, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    address.port_p = "49158";
+    if (fwSocketConnectParallel(refused, &address, 2000) != fwErrorSocketConnection) {
+        tstLogFrameworkFail(fwErrorSocketConnection, __func__, __LINE__);
+    }
+    TST(fwSocketClose(refused));
+
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+void tstUnitResolver(void) {
+    const struct fwResolverConfiguration configuration = {.ttl = 10000, .negativeTtl = 10000};
+    TST(fwResolverConfigure(&configuration));
+
+    const struct fwSocketAddress addresses[] = {
+        {.target_p = "127.0.0.1", .port_p = "49160"},
+        {.target_p = "::1", .port_p = "49160"}
+    };
+    TST(fwResolverWarmup(addresses, 2));
+
+    const struct fwSocketAddress invalid = {.target_p = "lpaf.invalid", .port_p = "80"};
+    if (fwResolverWarmup(&invalid, 1) != fwErrorSocketTargetName) {
+        tstLogFrameworkFail(fwErrorSocketTargetName, __func__, __LINE__);
+    }
+    if (fwResolverPrefetch(addresses, 2) != fwErrorModule) {
+        tstLogFrameworkFail(fwErrorModule, __func__, __LINE__);
+    }
+
+    // Lookups on the job system, ready by the time the connect needs them
+    TST(fwStartModule(fwModuleJob, 0));
+    TST(fwStartModule(fwModuleNetwork, 0));
+    TST(fwResolverPrefetch(addresses, 2));
+
+    fwSocket listener = 0;
+    TST(fwSocketCreate(&listener, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    TST(fwSocketBind(listener, &addresses[0]));
+    TST(fwSocketListen(listener, 4));
+
+    fwSocket client = 0;
+    TST(fwSocketCreate(&client, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    TST(fwSocketConnect(client, &addresses[0]));
+
+    TST(fwSocketClose(client));
+    TST(fwSocketClose(listener));
+    TST(fwStopModule(fwModuleNetwork));
+    TST(fwStopModule(fwModuleJob));
+    TST(fwResolverFlush());
+}
+
+void tstUnitSocketSendFile(void) {
+    FILE* file = fopen("lpafTestSendFile.txt", "wb");
+    for (uint32_t i = 0; i < 4096; i++) {
+        fputc('a' + i % 26, file);
+    }
+    fclose(file);
+
+    TST(fwStartModule(fwModuleNetwork, 0));
+
+    fwSocket listener = 0;
+    TST(fwSocketCreate(&listener, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    struct fwSocketAddress address = {};
+    address.target_p = "127.0.0.1";
+    address.port_p = "49161";
+    TST(fwSocketBind(listener, &address));
+    TST(fwSocketListen(listener, 4));
+
+    fwSocket client = 0;
+    TST(fwSocketCreate(&client, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    TST(fwSocketConnect(client, &address));
+    fwSocket accepted = 0;
+    TST(fwSocketAccept(listener, &accepted, nullptr));
+
+    // 100 bytes from the middle and then everything from offset 4000 to the end
+    uint64_t sent = 0;
+    TST(fwSocketSendFile(accepted, "lpafTestSendFile.txt", 26, 100, &sent));
+    if (sent != 100) {
+        tstLogFrameworkFail(fwErrorSocketSend, __func__, __LINE__);
+    }
+    TST(fwSocketSendFile(accepted, "lpafTestSendFile.txt", 4000, 0, &sent));
+    if (sent != 96) {
+        tstLogFrameworkFail(fwErrorSocketSend, __func__, __LINE__);
+    }
+
+    char buffer[196] = {};
+    size_t received = 0;
+    size_t total = 0;
+    while (total < sizeof(buffer)) {
+        TST(fwSocketReceive(client, buffer + total, sizeof(buffer) - total, &received));
+        total += received;
+    }
+    if (buffer[0] != 'a' || buffer[99] != 'v' || buffer[100] != 'a' + 4000 % 26) {
+        tstLogFrameworkFail(fwErrorSocketReceive, __func__, __LINE__);
+    }
+
+    if (fwSocketSendFile(accepted, "lpafTestMissing.txt", 0, 0, nullptr) !=
+        fwErrorFileUnableToOpen) {
+        tstLogFrameworkFail(fwErrorFileUnableToOpen, __func__, __LINE__);
+    }
+
+    TST(fwSocketClose(client));
+    TST(fwSocketClose(accepted));
+    TST(fwSocketClose(listener));
+    TST(fwStopModule(fwModuleNetwork));
+
+    remove("lpafTestSendFile.txt");
+}
+
+static void tstZeroCopyCallback(const fwSocket sfdop, const uint32_t first, const uint32_t last,
+                                const bool copied, void* user_p) {
+    (void)sfdop;
+    (void)copied; // loopback always copies
+    *(uint32_t*)user_p += last - first + 1;
+}
+
+void tstUnitSocketZeroCopy(void) {
+    TST(fwStartModule(fwModuleNetwork, 0));
+
+    fwSocket listener = 0;
+    TST(fwSocketCreate(&listener, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    struct fwSocketAddress address = {};
+    address.target_p = "127.0.0.1";
+    address.port_p = "49163";
+    TST(fwSocketBind(listener, &address));
+    TST(fwSocketListen(listener, 4));
+
+    fwSocket client = 0;
+    TST(fwSocketCreate(&client, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    TST(fwSocketConnect(client, &address));
+    fwSocket accepted = 0;
+    TST(fwSocketAccept(listener, &accepted, nullptr));
+
+    uint32_t completed = 0;
+    const fwError enabled = fwSocketEnableZeroCopy(accepted, 1024, tstZeroCopyCallback,
+                                                   &completed);
+    if (enabled == fwErrorUnimplemented) {
+        TST(fwSocketClose(client));
+        TST(fwSocketClose(accepted));
+        TST(fwSocketClose(listener));
+        TST(fwStopModule(fwModuleNetwork));
+        return; // kernel older than 4.14
+    }
+    TST(enabled);
+
+    static char payload[65536];
+    memset(payload, 'z', sizeof(payload));
+    uint32_t id = 0;
+    TST(fwSocketSendZeroCopy(accepted, payload, 100, nullptr, &id));
+    if (id != FW_SOCKET_ZEROCOPY_NONE) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    size_t sent = 0;
+    TST(fwSocketSendZeroCopy(accepted, payload, sizeof(payload), &sent, &id));
+    if (id != 0) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+
+    static char received[65536 + 100];
+    size_t total = 0;
+    while (total < 100 + sent) {
+        size_t count = 0;
+        TST(fwSocketReceive(client, received + total, sizeof(received) - total, &count));
+        total += count;
+    }
+
+    // The notification is queued once the receiver consumed the data
+    for (uint32_t i = 0; i < 100000 && completed == 0; i++) {
+        TST(fwSocketReapZeroCopy(accepted, nullptr));
+    }
+    if (completed != 1) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+
+    TST(fwSocketClose(client));
+    TST(fwSocketClose(accepted));
+    TST(fwSocketClose(listener));
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+void tstUnitSocketConfigure(void) {
+    TST(fwStartModule(fwModuleNetwork, 0));
+
+    fwSocket listener = 0;
+    TST(fwSocketCreate(&listener, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    struct fwSocketAddress address = {};
+    address.target_p = "127.0.0.1";
+    address.port_p = "49164";
+    TST(fwSocketBind(listener, &address));
+    struct fwSocketOptions options = {};
+    options.preset = fwSocketPresetThroughput;
+    options.overrides = fwSocketOptionCork;
+    options.cork = false;
+    TST(fwSocketConfigure(listener, &options));
+    TST(fwSocketListen(listener, 4));
+
+    fwSocket client = 0;
+    TST(fwSocketCreate(&client, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    TST(fwSocketConnect(client, &address));
+    fwSocket accepted = 0;
+    TST(fwSocketAccept(listener, &accepted, nullptr));
+
+    // Busy polling above the sysctl limit needs CAP_NET_ADMIN, the preset goes without it
+    options = (struct fwSocketOptions){};
+    options.preset = fwSocketPresetLowLatency;
+    TST(fwSocketConfigure(client, &options));
+    options.overrides = fwSocketOptionBusyPoll;
+    options.busyPoll = 100;
+    fwError error = fwSocketConfigure(client, &options);
+    if (error != fwErrorSuccess && error != fwErrorPermission) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    options = (struct fwSocketOptions){};
+    options.preset = fwSocketPresetThroughput;
+    options.overrides = fwSocketOptionSendBuffer | fwSocketOptionReceiveBuffer;
+    options.sendBuffer = 131072;
+    options.receiveBuffer = 131072;
+    TST(fwSocketConfigure(accepted, &options));
+
+    const char request[] = "ping";
+    size_t count = 0;
+    TST(fwSocketSend(client, request, sizeof(request), &count));
+    char buffer[16] = {};
+    size_t total = 0;
+    while (total < sizeof(request)) {
+        TST(fwSocketReceive(accepted, buffer + total, sizeof(buffer) - total, &count));
+        total += count;
+    }
+    TST(fwSocketSend(accepted, buffer, total, &count));
+    TST(fwSocketFlush(accepted));
+    total = 0;
+    while (total < sizeof(request)) {
+        TST(fwSocketReceive(client, buffer + total, sizeof(buffer) - total, &count));
+        total += count;
+    }
+    if (memcmp(buffer, request, sizeof(request)) != 0) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+
+    options.preset = (fwSocketPreset)3;
+    error = fwSocketConfigure(client, &options);
+    if (error != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+    error = fwSocketConfigure(client, nullptr);
+    if (error != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    TST(fwSocketClose(client));
+    TST(fwSocketClose(accepted));
+    TST(fwSocketClose(listener));
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+void tstUnitSocketStream(void) {
+    TST(fwStartModule(fwModuleNetwork, 0));
+
+    fwSocket listener = 0;
+    TST(fwSocketCreate(&listener, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    struct fwSocketAddress address = {};
+    address.target_p = "127.0.0.1";
+    address.port_p = "49166";
+    TST(fwSocketBind(listener, &address));
+    TST(fwSocketListen(listener, 4));
+
+    fwSocket client = 0;
+    TST(fwSocketCreate(&client, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    TST(fwSocketConnect(client, &address));
+    fwSocket accepted = 0;
+    TST(fwSocketAccept(listener, &accepted, nullptr));
+
+    struct fwSocketStreamConfiguration configuration = {};
+    configuration.socket = client;
+    configuration.writeCapacity = 4096;
+    fwSocketStream writer = 0;
+    TST(fwSocketStreamCreate(&configuration, &writer));
+    configuration.socket = accepted;
+    configuration.readCapacity = 256;
+    fwSocketStream reader = 0;
+    TST(fwSocketStreamCreate(&configuration, &reader));
+
+    // Many small messages leave the client in one write and arrive with a handful of reads
+    for (uint64_t i = 0; i < 100; ++i) {
+        TST(fwSocketStreamWriteFrame(writer, 2, &i, sizeof(i)));
+    }
+    const char request[] = "GET / HTTP/1.1\r\nHost: x\r\n";
+    TST(fwSocketStreamWrite(writer, request, sizeof(request) - 1));
+    static uint8_t large[8192];
+    for (uint32_t i = 0; i < sizeof(large); ++i) {
+        large[i] = (uint8_t)i;
+    }
+    TST(fwSocketStreamWrite(writer, large, sizeof(large)));
+    TST(fwSocketStreamFlush(writer));
+
+    struct fwSocketStats stats = {};
+    TST(fwSocketGetStats(client, &stats));
+    if (stats.syscalls > 2) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+
+    for (uint64_t i = 0; i < 100; ++i) {
+        const void* frame_p = nullptr;
+        size_t length = 0;
+        TST(fwSocketStreamReadFrame(reader, 2, &frame_p, &length));
+        uint64_t value = 0;
+        memcpy(&value, frame_p, sizeof(value));
+        if (length != sizeof(value) || value != i) {
+            tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+        }
+    }
+    TST(fwSocketGetStats(accepted, &stats));
+    if (stats.syscalls > 10) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+
+    const char* lines[] = {"GET / HTTP/1.1", "Host: x"};
+    for (uint32_t i = 0; i < 2; ++i) {
+        const void* frame_p = nullptr;
+        size_t length = 0;
+        TST(fwSocketStreamReadUntil(reader, "\r\n", 2, &frame_p, &length));
+        if (length != strlen(lines[i]) || memcmp(frame_p, lines[i], length) != 0) {
+            tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+        }
+    }
+
+    static uint8_t received[8192];
+    TST(fwSocketStreamReadExact(reader, received, 100));
+    TST(fwSocketStreamReadExact(reader, received + 100, sizeof(received) - 100));
+    if (memcmp(received, large, sizeof(large)) != 0) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+
+    // A frame that can never fit into the read buffer is refused instead of overflowing it
+    TST(fwSocketStreamWriteFrame(writer, 2, large, 1024));
+    TST(fwSocketStreamFlush(writer));
+    const void* frame_p = nullptr;
+    size_t length = 0;
+    fwError error = fwSocketStreamReadFrame(reader, 2, &frame_p, &length);
+    if (error != fwErrorSocketFrame) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+    error = fwSocketStreamWriteFrame(writer, 1, large, 256);
+    if (error != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    TST(fwSocketStreamDestroy(writer));
+    TST(fwSocketClose(client));
+    uint8_t rest[256];
+    size_t count = 0;
+    do {
+        error = fwSocketStreamRead(reader, rest, sizeof(rest), &count);
+    } while (error == fwErrorSuccess);
+    if (error != fwErrorSocketClosed) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+    TST(fwSocketStreamDestroy(reader));
+
+    TST(fwSocketClose(accepted));
+    TST(fwSocketClose(listener));
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+void tstUnitConnectionPool(void) {
+    TST(fwStartModule(fwModuleNetwork, 0));
+
+    fwSocket listener = 0;
+    TST(fwSocketCreate(&listener, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    struct fwSocketAddress address = {};
+    address.target_p = "127.0.0.1";
+    address.port_p = "49168";
+    TST(fwSocketBind(listener, &address));
+    TST(fwSocketListen(listener, 8));
+
+    struct fwConnectionPoolConfiguration configuration = {};
+    configuration.addressFamily = fwSocketAddressFamilyIPv4;
+    configuration.maxIdle = 1;
+    configuration.shards = 2;
+    fwConnectionPool pool = 0;
+    TST(fwConnectionPoolCreate(&configuration, &pool));
+
+    fwSocket first = 0;
+    bool reused = true;
+    TST(fwConnectionPoolAcquire(pool, &address, &first, &reused));
+    if (reused) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    fwSocket accepted = 0;
+    TST(fwSocketAccept(listener, &accepted, nullptr));
+    TST(fwConnectionPoolRelease(pool, first, true));
+
+    // The idle connection comes back instead of a new handshake
+    fwSocket again = 0;
+    TST(fwConnectionPoolAcquire(pool, &address, &again, &reused));
+    if (!reused || again != first) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+
+    // Only one idle connection per target is kept, the second release closes its socket
+    fwSocket second = 0;
+    TST(fwConnectionPoolAcquire(pool, &address, &second, &reused));
+    fwSocket acceptedSecond = 0;
+    TST(fwSocketAccept(listener, &acceptedSecond, nullptr));
+    TST(fwConnectionPoolRelease(pool, again, true));
+    TST(fwConnectionPoolRelease(pool, second, true));
+    struct fwSocketStats stats = {};
+    if (fwSocketGetStats(second, &stats) != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    TST(fwSocketClose(acceptedSecond));
+
+    // A connection with data nobody asked for fails the health check, like one the peer closed
+    TST(fwSocketSend(accepted, "x", 1, nullptr));
+    TST(fwSocketClose(accepted));
+    fwSocket fresh = 0;
+    TST(fwConnectionPoolAcquire(pool, &address, &fresh, &reused));
+    if (reused) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    TST(fwSocketAccept(listener, &accepted, nullptr));
+    TST(fwConnectionPoolRelease(pool, fresh, false));
+    if (fwConnectionPoolRelease(pool, listener, true) != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+
+    uint32_t closed = 0;
+    TST(fwConnectionPoolPrune(pool, &closed));
+    if (closed != 0) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    TST(fwConnectionPoolDestroy(pool));
+
+    TST(fwSocketClose(accepted));
+    TST(fwSocketClose(listener));
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+#define TST_FIBER_CLIENTS 128
+
+static fwJobCounter tstFiberCounter_s = 0;
+static fwSocket tstFiberListener_s = 0;
+static atomic_uint tstFiberEchoed_s = 0;
+
+static void tstFiberHandle(void* user_p) {
+    const fwSocket socket = (uintptr_t)user_p;
+    char buffer[64];
+    size_t count = 0;
+    while (fwFiberSocketReceive(socket, buffer, sizeof(buffer), &count) == fwErrorSuccess &&
+           count != 0) {
+        TST(fwFiberSocketSend(socket, buffer, count, nullptr));
+    }
+    TST(fwSocketClose(socket));
+}
+
+static void tstFiberServe(void* user_p) {
+    (void)user_p;
+    for (uint32_t i = 0; i < TST_FIBER_CLIENTS; ++i) {
+        fwSocket accepted = 0;
+        TST(fwFiberSocketAccept(tstFiberListener_s, &accepted, nullptr));
+        TST(fwFiberSpawn(tstFiberHandle, (void*)(uintptr_t)accepted, tstFiberCounter_s));
+    }
+}
+
+static void tstFiberClient(void* user_p) {
+    fwSocket socket = 0;
+    TST(fwSocketCreate(&socket, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    TST(fwFiberSocketConnect(socket, user_p));
+
+    // Yielding in between lets the fiber continue on whichever worker picks it up next
+    char request[32];
+    const size_t length = snprintf(request, sizeof(request), "ping %p", (void*)&socket);
+    TST(fwFiberSocketSend(socket, request, length, nullptr));
+    TST(fwFiberYield());
+    char response[32];
+    size_t total = 0;
+    while (total < length) {
+        size_t count = 0;
+        TST(fwFiberSocketReceive(socket, response + total, sizeof(response) - total, &count));
+        if (count == 0) {
+            break;
+        }
+        total += count;
+    }
+    if (total == length && memcmp(request, response, length) == 0) {
+        atomic_fetch_add_explicit(&tstFiberEchoed_s, 1, memory_order_relaxed);
+    }
+    TST(fwSocketClose(socket));
+}
+
+void tstUnitFiber(void) {
+    TST(fwStartModule(fwModuleNetwork, 0));
+    TST(fwStartModule(fwModuleJob, 0));
+
+    TST(fwSocketCreate(&tstFiberListener_s, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    static struct fwSocketAddress address = {};
+    address.target_p = "127.0.0.1";
+    address.port_p = "49169";
+    TST(fwSocketBind(tstFiberListener_s, &address));
+    TST(fwSocketListen(tstFiberListener_s, TST_FIBER_CLIENTS));
+
+    // One echo server and a client per connection, all multiplexed over the workers
+    TST(fwJobCounterCreate(&tstFiberCounter_s));
+    TST(fwFiberSpawn(tstFiberServe, nullptr, tstFiberCounter_s));
+    for (uint32_t i = 0; i < TST_FIBER_CLIENTS; ++i) {
+        TST(fwFiberSpawn(tstFiberClient, &address, tstFiberCounter_s));
+    }
+    TST(fwJobWait(tstFiberCounter_s));
+    if (atomic_load(&tstFiberEchoed_s) != TST_FIBER_CLIENTS) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+
+    fwError error = fwFiberYield();
+    if (error != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+    error = fwFiberSpawn(nullptr, nullptr, 0);
+    if (error != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    TST(fwJobCounterDestroy(tstFiberCounter_s));
+    TST(fwSocketClose(tstFiberListener_s));
+    TST(fwStopModule(fwModuleJob));
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+static uint32_t tstTimerOnce_s = 0;
+static uint32_t tstTimerPeriodic_s = 0;
+static uint8_t tstTimerEvents_s = 0;
+
+static void tstTimerCount(const fwTimer timer, void* user_p) {
+    (void)timer;
+    (*(uint32_t*)user_p)++;
+}
+
+static void tstTimerSocketEvent(const fwSocket sfdop, const uint8_t events, void* user_p) {
+    (void)sfdop;
+    (void)user_p;
+    tstTimerEvents_s |= events;
+}
+
+void tstUnitTimer(void) {
+    TST(fwStartModule(fwModuleNetwork, 0));
+
+    fwEventLoop loop = 0;
+    TST(fwEventLoopCreate(&loop));
+
+    // A far timer waits in the top level of the wheel and must neither fire nor block the others
+    fwTimer once = 0, periodic = 0, far = 0;
+    TST(fwTimerCreate(loop, tstTimerCount, &tstTimerOnce_s, &once));
+    TST(fwTimerCreate(loop, tstTimerCount, &tstTimerPeriodic_s, &periodic));
+    TST(fwTimerCreate(loop, tstTimerCount, &tstTimerOnce_s, &far));
+    TST(fwTimerArm(far, 3600000, 0));
+    TST(fwTimerArm(once, 20, 0));
+    TST(fwTimerArm(periodic, 2, 2));
+    for (uint32_t i = 0; i < 1000 && tstTimerOnce_s == 0; i++) {
+        TST(fwEventLoopPoll(loop, 100, nullptr));
+    }
+    if (tstTimerOnce_s != 1 || tstTimerPeriodic_s < 2) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    TST(fwTimerCancel(periodic));
+    TST(fwTimerDestroy(far));
+    const uint32_t periodicFired = tstTimerPeriodic_s;
+    TST(fwEventLoopPoll(loop, 10, nullptr));
+    if (tstTimerPeriodic_s != periodicFired) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    TST(fwTimerDestroy(periodic));
+    TST(fwTimerDestroy(once));
+    fwError error = fwTimerCreate(loop, nullptr, nullptr, &once);
+    if (error != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    fwSocket listener = 0;
+    TST(fwSocketCreate(&listener, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    struct fwSocketAddress address = {};
+    address.target_p = "127.0.0.1";
+    address.port_p = "49170";
+    TST(fwSocketBind(listener, &address));
+    TST(fwSocketListen(listener, 4));
+
+    fwSocket client = 0, accepted = 0;
+    error = fwSocketAcceptTimeout(listener, &accepted, nullptr, 10);
+    if (error != fwErrorSocketTimeout) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    TST(fwSocketCreate(&client, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    TST(fwSocketConnectTimeout(client, &address, 1000));
+    TST(fwSocketAcceptTimeout(listener, &accepted, nullptr, 1000));
+
+    // A blocking receive from a silent peer gives up instead of hanging
+    const struct fwSocketTimeouts timeouts = {.read = 10};
+    TST(fwSocketSetTimeouts(client, &timeouts));
+    char buffer[8];
+    error = fwSocketReceive(client, buffer, sizeof(buffer), nullptr);
+    if (error != fwErrorSocketTimeout) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    // Registered, the same silence is reported by the loop, data pushes the deadline back
+    TST(fwEventLoopRegister(loop, accepted, fwEventRead, tstTimerSocketEvent, nullptr));
+    TST(fwSocketSetTimeouts(accepted, &timeouts));
+    TST(fwSocketSend(client, "x", 1, nullptr));
+    TST(fwEventLoopPoll(loop, 100, nullptr));
+    if (tstTimerEvents_s != fwEventRead) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    TST(fwSocketReceive(accepted, buffer, sizeof(buffer), nullptr));
+    tstTimerEvents_s = 0;
+    for (uint32_t i = 0; i < 100 && tstTimerEvents_s == 0; i++) {
+        TST(fwEventLoopPoll(loop, 100, nullptr));
+    }
+    if (tstTimerEvents_s != fwEventReadTimeout) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+
+    TST(fwSocketClose(client));
+    TST(fwSocketClose(accepted));
+    TST(fwSocketClose(listener));
+    TST(fwEventLoopDestroy(loop));
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+// Offers a plain file the peer could truncate underneath the mapping, it has to be refused
+static void tstOfferUnsealedChannel(const fwSocket listener, const char* path_p) {
+    struct {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t capacity;
+    } offer = {.magic = 0x4C4E48434641504Cull, .version = 1, .capacity = 4096};
+    static const uint8_t zeros_s[4096 + 2 * 4096] = {};
+    FILE* file = fopen("lpafTestUnsealed.bin", "wb");
+    fwrite(zeros_s, 1, sizeof(zeros_s), file);
+    fclose(file);
+
+    const int32_t memory = open("lpafTestUnsealed.bin", O_RDWR | O_CLOEXEC);
+    const int32_t peer = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    strncpy(address.sun_path, path_p, sizeof(address.sun_path) - 1);
+    if (memory == -1 || peer == -1 ||
+        connect(peer, (const struct sockaddr*)&address, sizeof(address)) != 0) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    fwSocket accepted = 0;
+    TST(fwSocketAccept(listener, &accepted, nullptr));
+
+    struct iovec payload = {.iov_base = &offer, .iov_len = sizeof(offer)};
+    union {
+        struct cmsghdr header;
+        uint8_t buffer[CMSG_SPACE(3 * sizeof(int32_t))];
+    } control = {};
+    struct msghdr message = {};
+    message.msg_iov        = &payload;
+    message.msg_iovlen     = 1;
+    message.msg_control    = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+    struct cmsghdr* header_p = CMSG_FIRSTHDR(&message);
+    header_p->cmsg_level = SOL_SOCKET;
+    header_p->cmsg_type  = SCM_RIGHTS;
+    header_p->cmsg_len   = CMSG_LEN(3 * sizeof(int32_t));
+    const int32_t descriptors[] = {memory, memory, memory};
+    memcpy(CMSG_DATA(header_p), descriptors, sizeof(descriptors));
+    if (sendmsg(peer, &message, MSG_NOSIGNAL) != sizeof(offer)) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+
+    fwLocalChannel channel = 0;
+    const fwError error = fwLocalChannelAccept(accepted, nullptr, &channel);
+    if (error != fwErrorSocketReceive) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    TST(fwSocketClose(accepted));
+    close(peer);
+    close(memory);
+}
+
+void tstUnitLocalChannel(void) {
+    TST(fwStartModule(fwModuleNetwork, 0));
+
+    const char* path_p = "/tmp/lpaf-test-channel.sock";
+    remove(path_p);
+    fwSocket listener = 0, client = 0, accepted = 0;
+    TST(fwSocketCreate(&listener, fwSocketAddressFamilyLocal, fwSocketProtocolStream));
+    struct fwSocketAddress address = {};
+    address.target_p = path_p;
+    TST(fwSocketBind(listener, &address));
+    TST(fwSocketListen(listener, 4));
+    TST(fwSocketCreate(&client, fwSocketAddressFamilyLocal, fwSocketProtocolStream));
+    TST(fwSocketConnect(client, &address));
+    TST(fwSocketAccept(listener, &accepted, nullptr));
+
+    // The smallest rings and non blocking sides, so one thread can push more than fits
+    const struct fwLocalChannelConfiguration configuration = {.capacity = 1, .nonBlocking = true};
+    fwLocalChannel connector = 0, acceptor = 0;
+    TST(fwLocalChannelConnect(client, &configuration, &connector));
+    TST(fwLocalChannelAccept(accepted, &configuration, &acceptor));
+
+    static uint8_t data_s[10000], buffer_s[10000];
+    for (uint32_t i = 0; i < sizeof(data_s); i++) {
+        data_s[i] = (uint8_t)(i * 31 + 7);
+    }
+    size_t received = 0;
+    fwError error = fwLocalChannelReceive(acceptor, buffer_s, sizeof(buffer_s), &received);
+    if (error != fwErrorSocketWouldBlock) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    const fwLocalChannel directions[2][2] = {{connector, acceptor}, {acceptor, connector}};
+    for (uint32_t d = 0; d < 2; d++) {
+        size_t sent = 0;
+        received = 0;
+        while (received < sizeof(data_s)) {
+            size_t chunk = 0;
+            if (sent < sizeof(data_s)) {
+                error = fwLocalChannelSend(directions[d][0], data_s + sent, sizeof(data_s) - sent,
+                                           &chunk);
+                if (error != fwErrorSuccess && error != fwErrorSocketWouldBlock) {
+                    tstLogFrameworkFail(error, __func__, __LINE__);
+                    break;
+                }
+                sent += chunk;
+            }
+            TST(fwLocalChannelReceive(directions[d][1], buffer_s + received,
+                                      sizeof(buffer_s) - received, &chunk));
+            received += chunk;
+        }
+        if (memcmp(data_s, buffer_s, sizeof(data_s)) != 0) {
+            tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+        }
+    }
+
+    // What was sent before the close still arrives, after that the channel reads as ended
+    TST(fwLocalChannelSend(connector, "end", 3, nullptr));
+    TST(fwLocalChannelClose(connector));
+    TST(fwLocalChannelReceive(acceptor, buffer_s, sizeof(buffer_s), &received));
+    if (received != 3) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    TST(fwLocalChannelReceive(acceptor, buffer_s, sizeof(buffer_s), &received));
+    if (received != 0) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    error = fwLocalChannelSend(acceptor, "x", 1, nullptr);
+    if (error != fwErrorSocketClosed) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+    TST(fwLocalChannelClose(acceptor));
+
+    // A channel needs a connected local stream socket
+    error = fwLocalChannelConnect(listener, nullptr, &connector);
+    if (error != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    tstOfferUnsealedChannel(listener, path_p);
+
+    TST(fwSocketClose(client));
+    TST(fwSocketClose(accepted));
+    TST(fwSocketClose(listener));
+    remove(path_p);
+    remove("lpafTestUnsealed.bin");
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+static void tstEventLoopWritable(const fwSocket sfdop, const uint8_t events, void* user_p) {
+    (void)sfdop;
+    *(uint8_t*)user_p |= events;
+}
+
+void tstUnitEventLoopConnect(void) {
+    TST(fwStartModule(fwModuleNetwork, 0));
+    fwEventLoop loop = 0;
+    TST(fwEventLoopCreate(&loop));
+
+    fwSocket listener = 0;
+    const struct fwSocketAddress address = {.target_p = "127.0.0.1", .port_p = "49172"};
+    TST(fwSocketCreate(&listener, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    TST(fwSocketBind(listener, &address));
+    TST(fwSocketListen(listener, 4));
+
+    // A non-blocking connect finishes in the background and reports itself as writable
+    fwSocket client = 0;
+    TST(fwSocketCreate(&client, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    TST(fwSocketSetNonBlocking(client, true));
+    fwError error = fwSocketConnect(client, &address);
+    if (error == fwErrorSocketWouldBlock) {
+        uint8_t events = 0;
+        TST(fwEventLoopRegister(loop, client, fwEventWrite, tstEventLoopWritable, &events));
+        for (uint32_t i = 0; i < 100 && !(events & fwEventWrite); i++) {
+            TST(fwEventLoopPoll(loop, 10, nullptr));
+        }
+        error = fwSocketConnect(client, &address);
+        TST(fwEventLoopUnregister(client));
+    }
+    TST(error);
+    fwSocket accepted = 0;
+    TST(fwSocketAccept(listener, &accepted, nullptr));
+
+    // Destroying the loop unregisters its sockets, they stay usable and can be closed afterwards
+    TST(fwEventLoopRegister(loop, accepted, fwEventRead, tstEventLoopCallback, nullptr));
+    fwTimer timer = 0;
+    uint32_t fired = 0;
+    TST(fwTimerCreate(loop, tstTimerCount, &fired, &timer));
+    error = fwEventLoopDestroy(loop);
+    if (error != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+    TST(fwTimerDestroy(timer));
+    TST(fwEventLoopDestroy(loop));
+    TST(fwSocketSend(client, "ping", 4, nullptr));
+    TST(fwSocketClose(accepted));
+
+    TST(fwSocketClose(client));
+    TST(fwSocketClose(listener));
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+void tstUnitWindow(void) {
+    fwEventLoop loop = 0;
+    TST(fwStartModule(fwModuleNetwork, 0));
+    TST(fwEventLoopCreate(&loop));
+
+    fwError error = fwEventLoopRegisterWindow(loop);
+    if (error != fwErrorModule) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    // Headless machines have no compositor to talk to, only the failure can be checked there
+    error = fwStartModule(fwModuleWindow, 0);
+    if (error == fwErrorSuccess) {
+        TST(fwEventLoopRegisterWindow(loop));
+        error = fwEventLoopRegisterWindow(loop);
+        if (error != fwErrorInvalidParameter) {
+            tstLogFrameworkFail(error, __func__, __LINE__);
+        }
+        for (uint32_t i = 0; i < 4; i++) {
+            TST(fwEventLoopPoll(loop, 10, nullptr));
+        }
+        TST(fwEventLoopUnregisterWindow());
+        TST(fwEventLoopRegisterWindow(loop));
+        TST(fwStopModule(fwModuleWindow)); // unregisters implicitly
+        TST(fwEventLoopPoll(loop, 0, nullptr));
+    }
+    else if (error != fwErrorWindowConnect) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    error = fwEventLoopUnregisterWindow();
+    if (error != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+    TST(fwEventLoopDestroy(loop));
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+void tstUnitRender(void) {
+    fwError error = fwStartModule(fwModuleRender, 0);
+    if (error != fwErrorModule) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    // Headless machines have no compositor, the renderer cannot run without one
+    if (fwStartModule(fwModuleWindow, 0) != fwErrorSuccess) {
+        return;
+    }
+    TST(fwStartModule(fwModuleJob, 0));
+    TST(fwStartModule(fwModuleNetwork, 0));
+    fwEventLoop loop = 0;
+    TST(fwEventLoopCreate(&loop));
+    TST(fwEventLoopRegisterWindow(loop));
+    TST(fwStartModule(fwModuleRender, 0));
+
+    fwRenderSurface surface = 0;
+    const struct fwRenderSurfaceConfiguration configuration = {
+        .width = 1024, .height = 768, .title_p = "LPAF render test"
+    };
+    TST(fwRenderSurfaceCreate(&configuration, &surface));
+
+    static uint32_t pixels_s[64 * 64];
+    for (uint32_t i = 0; i < 64 * 64; i++) {
+        pixels_s[i] = (i & 0x7F) << 24 | (i & 0x7F) << 8; // half transparent green, premultiplied
+    }
+    const struct fwRenderImage image = {.pixels_p = pixels_s, .width = 64, .height = 64,
+                                        .stride = 64};
+    for (uint32_t frame = 0; frame < 8; frame++) {
+        // Large enough to be split into bands, partly off screen to be clipped
+        error = fwRenderFill(surface, nullptr, 0xFF202020);
+        if (error == fwErrorRenderBusy) {
+            TST(fwEventLoopPoll(loop, 20, nullptr));
+            continue;
+        }
+        TST(error);
+        const struct fwRenderRect rect = {.x = -16, .y = 700, .width = 200, .height = 200};
+        TST(fwRenderFill(surface, &rect, 0xFF0000FF));
+        TST(fwRenderBlit(surface, (int32_t)frame * 64, 0, &image));
+        TST(fwRenderBlend(surface, 1000, (int32_t)frame * 64, &image));
+        TST(fwRenderPresent(surface));
+        TST(fwEventLoopPoll(loop, 0, nullptr));
+    }
+    error = fwRenderBlit(surface, 0, 0, nullptr);
+    if (error != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    TST(fwRenderSurfaceDestroy(surface));
+    TST(fwStopModule(fwModuleRender));
+    TST(fwEventLoopDestroy(loop));
+    TST(fwStopModule(fwModuleNetwork));
+    TST(fwStopModule(fwModuleWindow));
+    TST(fwStopModule(fwModuleJob));
+}
+
+static _Atomic uint32_t tstAudioPeriods_s = 0;
+
+static void tstAudioSilence(int16_t* samples_p, const uint32_t frames, void* user_p) {
+    (void)user_p;
+    memset(samples_p, 0, frames * 2 * sizeof(int16_t));
+    atomic_fetch_add_explicit(&tstAudioPeriods_s, 1, memory_order_relaxed);
+}
+
+void tstUnitAudio(void) {
+    fwAudioStream stream = 0;
+    struct fwAudioConfiguration configuration = {};
+    fwError error = fwAudioStreamCreate(&configuration, &stream);
+    if (error != fwErrorModule) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    // The event loop only serves as a clock to wait on while the audio thread runs
+    TST(fwStartModule(fwModuleMultimedia, 0));
+    TST(fwStartModule(fwModuleNetwork, 0));
+    fwEventLoop loop = 0;
+    TST(fwEventLoopCreate(&loop));
+
+    // Machines without a sound card have nothing to play on
+    error = fwAudioStreamCreate(&configuration, &stream);
+    if (error == fwErrorSuccess) {
+        struct fwAudioStats stats = {};
+        TST(fwAudioStreamGetStats(stream, &stats));
+        static int16_t samples_s[256 * 2];
+        for (uint32_t i = 0; i < 256; i++) {
+            samples_s[i * 2] = samples_s[i * 2 + 1] = (int16_t)((i & 0x3F) * 256 - 8192);
+        }
+        for (uint32_t i = 0; i < 50; i++) {
+            uint32_t written = 0;
+            TST(fwAudioStreamWrite(stream, samples_s, 256, &written));
+            TST(fwEventLoopPoll(loop, 2, nullptr));
+        }
+        TST(fwAudioStreamGetStats(stream, &stats));
+        if (stats.frames == 0 || stats.periodFrames == 0 || stats.sampleRate == 0) {
+            tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+        }
+        uint32_t read = 0;
+        error = fwAudioStreamRead(stream, samples_s, 256, &read);
+        if (error != fwErrorInvalidParameter) {
+            tstLogFrameworkFail(error, __func__, __LINE__);
+        }
+        TST(fwAudioStreamDestroy(stream));
+
+        configuration.callback = tstAudioSilence;
+        TST(fwAudioStreamCreate(&configuration, &stream));
+        for (uint32_t i = 0; i < 100 && atomic_load(&tstAudioPeriods_s) < 4; i++) {
+            TST(fwEventLoopPoll(loop, 2, nullptr));
+        }
+        if (atomic_load(&tstAudioPeriods_s) < 4) {
+            tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+        }
+        TST(fwAudioStreamDestroy(stream));
+    }
+    else if (error != fwErrorAudioDevice) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    TST(fwEventLoopDestroy(loop));
+    TST(fwStopModule(fwModuleNetwork));
+    TST(fwStopModule(fwModuleMultimedia));
+}
+
+void tstUnitBuffer(void) {
+    const char text[] = "key = value;\n# comment\n\nlast";
+    uint64_t offset = 0;
+    TST(fwBufferFindByte(text, sizeof(text) - 1, '\n', &offset));
+    if (offset != 12) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    TST(fwBufferFindByte(text, sizeof(text) - 1, '@', &offset));
+    if (offset != sizeof(text) - 1) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    const uint8_t set[] = {';', '#', '='};
+    TST(fwBufferFindAny(text, sizeof(text) - 1, set, sizeof(set), &offset));
+    if (offset != 4) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    fwError error = fwBufferFindAny(text, sizeof(text) - 1, set, 0, &offset);
+    if (error != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    // Past the vector limit the set goes through the table, the result has to stay the same
+    uint8_t letters[26];
+    for (uint32_t i = 0; i < sizeof(letters); i++) {
+        letters[i] = (uint8_t)('a' + i);
+    }
+    TST(fwBufferFindAny(text + 5, sizeof(text) - 6, letters, sizeof(letters), &offset));
+    if (offset != 1) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+
+    struct fwBufferIndex index = {};
+    TST(fwBufferIndexCreate(text, sizeof(text) - 1, '\n', fwBufferIndexFlagNone, &index));
+    const uint64_t expected[] = {0, 13, 23, 24, sizeof(text)};
+    if (index.count != 4 || memcmp(index.offsets_p, expected, sizeof(expected)) != 0) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    TST(fwBufferIndexDestroy(&index));
+    TST(fwBufferIndexCreate(text, 0, '\n', fwBufferIndexFlagNone, &index));
+    if (index.count != 0 || index.offsets_p[0] != 0) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    TST(fwBufferIndexDestroy(&index));
+
+    // Lines of random length, large enough to be split across the job workers
+    static uint8_t buffer_s[24 * 1024 * 1024];
+    uint32_t seed = 1;
+    for (uint64_t i = 0; i < sizeof(buffer_s); i++) {
+        seed = seed * 1103515245 + 12345;
+        buffer_s[i] = (seed >> 16) % 61 == 0 ? '\n' : (uint8_t)('a' + (seed >> 16) % 26);
+    }
+    buffer_s[sizeof(buffer_s) - 1] = '\n';
+
+    TST(fwBufferIndexCreate(buffer_s, sizeof(buffer_s), '\n', fwBufferIndexFlagNone, &index));
+    if (index.offsets_p[index.count] != sizeof(buffer_s)) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    for (uint64_t i = 0; i < index.count; i++) {
+        const uint64_t size = index.offsets_p[i + 1] - 1 - index.offsets_p[i];
+        TST(fwBufferFindByte(buffer_s + index.offsets_p[i], size + 1, '\n', &offset));
+        if (offset != size) {
+            tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+            break;
+        }
+    }
+
+    TST(fwStartModule(fwModuleJob, 0));
+    struct fwBufferIndex parallel = {};
+    TST(fwBufferIndexCreate(buffer_s, sizeof(buffer_s), '\n', fwBufferIndexFlagParallel,
+                            &parallel));
+    if (parallel.count != index.count ||
+        memcmp(parallel.offsets_p, index.offsets_p, (index.count + 1) * sizeof(uint64_t)) != 0) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    TST(fwBufferIndexDestroy(&parallel));
+    TST(fwStopModule(fwModuleJob));
+    TST(fwBufferIndexDestroy(&index));
+}
+
+static void tstWriteFile(const char* filename_p, const char* contents_p) {
+    FILE* file = fopen(filename_p, "wb");
+    fwrite(contents_p, 1, strlen(contents_p), file);
+    fclose(file);
+}
+
+void tstUnitFileCache(void) {
+    tstWriteFile("lpafTestCache.txt", "first");
+
+    fwFileCache cache = 0;
+    struct fwFileCacheConfiguration configuration = {};
+    TST(fwFileCacheCreate(&configuration, &cache));
+
+    fwFileCacheEntry first = 0, second = 0;
+    const void* data_p = nullptr;
+    const void* again_p = nullptr;
+    uint64_t size = 0;
+    TST(fwFileCacheAcquire(cache, "lpafTestCache.txt", &first, &data_p, &size));
+    TST(fwFileCacheAcquire(cache, "lpafTestCache.txt", &second, &again_p, &size));
+    if (size != 5 || memcmp(data_p, "first", 5) != 0 || again_p != data_p) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    TST(fwFileCacheRelease(cache, second));
+
+    // A held entry keeps its contents, the next acquire sees the new ones
+    tstWriteFile("lpafTestCache.txt", "second");
+    TST(fwFileCacheAcquire(cache, "lpafTestCache.txt", &second, &again_p, &size));
+    if (size != 6 || memcmp(again_p, "second", 6) != 0 || memcmp(data_p, "first", 5) != 0) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    TST(fwFileCacheRelease(cache, first));
+    TST(fwFileCacheRelease(cache, second));
+
+    struct fwFileCacheStats stats = {};
+    TST(fwFileCacheGetStats(cache, &stats));
+    if (stats.hits != 1 || stats.misses != 2 || stats.invalidations != 1 || stats.entries != 1) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    fwError error = fwFileCacheAcquire(cache, "lpafTestMissing.txt", &first, &data_p, &size);
+    if (error != fwErrorFileUnableToOpen) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+    TST(fwFileCacheDestroy(cache));
+
+    // Only one of the files fits, the one that was used last stays
+    tstWriteFile("lpafTestCacheOther.txt", "other");
+    configuration.budget = 8;
+    configuration.mapThreshold = 1;
+    TST(fwFileCacheCreate(&configuration, &cache));
+    TST(fwFileCacheAcquire(cache, "lpafTestCache.txt", &first, &data_p, &size));
+    TST(fwFileCacheRelease(cache, first));
+    TST(fwFileCacheAcquire(cache, "lpafTestCacheOther.txt", &first, &data_p, &size));
+    if (size != 5 || memcmp(data_p, "other", 5) != 0) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    // A held entry keeps the cache alive
+    error = fwFileCacheDestroy(cache);
+    if (error != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+    TST(fwFileCacheRelease(cache, first));
+    TST(fwFileCacheGetStats(cache, &stats));
+    if (stats.evictions != 1 || stats.entries != 1 || stats.bytes != 5) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    TST(fwFileCacheDestroy(cache));
+
+    remove("lpafTestCache.txt");
+    remove("lpafTestCacheOther.txt");
+}
+
+void tstUnitModules(void) {
+    struct fwModuleStartStats stats = {};
+    fwError error = fwStartModules(0b1000'0000, 0, nullptr, 0, &stats);
+    if (error != fwErrorInvalidParameter) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+
+    const struct fwSocketAddress warmup = {.target_p = "127.0.0.1", .port_p = "49171"};
+    const uint8_t modules = fwModuleNetwork | fwModuleMultimedia | fwModuleJob;
+    TST(fwStartModules(modules, 0, &warmup, 1, &stats));
+    if (stats.total == 0 || stats.modules[2] == 0 || stats.modules[3] == 0 ||
+        stats.modules[4] == 0 || stats.modules[0] != 0 || stats.warmup == 0) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+
+    // Running modules are skipped, by this call as well as by fwStartModule
+    TST(fwStartModules(modules, 0, nullptr, 0, &stats));
+    if (stats.modules[2] != 0 || stats.modules[3] != 0 || stats.modules[4] != 0) {
+        tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+    }
+    TST(fwStartModule(fwModuleJob, 0));
+    uint32_t workers = 0;
+    TST(fwJobGetWorkerCount(&workers));
+
+    TST(fwStopModule(fwModuleJob));
+    error = fwJobGetWorkerCount(&workers);
+    if (error != fwErrorModule) {
+        tstLogFrameworkFail(error, __func__, __LINE__);
+    }
+    TST(fwStopModule(fwModuleJob));
+    TST(fwStopModule(fwModuleMultimedia));
+    TST(fwStopModule(fwModuleNetwork));
+}
+
+void tstUnitConnectParallelOptions(void) {
+    TST(fwStartModule(fwModuleNetwork, 0));
+
+    fwSocket listener = 0;
+    const struct fwSocketAddress address = {.target_p = "127.0.0.1", .port_p = "49174"};
+    TST(fwSocketCreate(&listener, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    TST(fwSocketBind(listener, &address));
+    TST(fwSocketListen(listener, 4));
+
+    // Configured before the race, the descriptor that wins has to carry the options
+    fwSocket client = 0;
+    TST(fwSocketCreate(&client, fwSocketAddressFamilyIPv4, fwSocketProtocolStream));
+    struct fwSocketOptions options = {};
+    options.preset = fwSocketPresetDefault;
+    options.overrides = fwSocketOptionCork;
+    options.cork = true;
+    TST(fwSocketConfigure(client, &options));
+    uint32_t completed = 0;
+    const fwError zeroCopy = fwSocketEnableZeroCopy(client, 1024, tstZeroCopyCallback,
+                                                    &completed);
+    if (zeroCopy != fwErrorSuccess && zeroCopy != fwErrorUnimplemented) {
+        tstLogFrameworkFail(zeroCopy, __func__, __LINE__);
+    }
+    TST(fwSocketConnectParallel(client, &address, 1000));
+    fwSocket accepted = 0;
+    TST(fwSocketAccept(listener, &accepted, nullptr));
+
+    // A corked partial segment stays back until the flush
+    const struct fwSocketTimeouts timeouts = {.read = 50};
+    TST(fwSocketSetTimeouts(accepted, &timeouts));
+    TST(fwSocketSend(client, "ping", 4, nullptr));
+    char buffer[16] = {};
+    size_t count = 0;
+    const fwError held = fwSocketReceive(accepted, buffer, sizeof(buffer), &count);
+    if (held != fwErrorSocketTimeout) {
+        tstLogFrameworkFail(held, __func__, __LINE__);
+    }
+    TST(fwSocketFlush(client));
+    TST(fwSocketReceive(accepted, buffer, sizeof(buffer), &count));
+
+    if (zeroCopy == fwErrorSuccess) {
+        static char payload[65536];
+        memset(payload, 'p', sizeof(payload));
+        uint32_t id = FW_SOCKET_ZEROCOPY_NONE;
+        size_t sent = 0;
+        TST(fwSocketSendZeroCopy(client, payload, sizeof(payload), &sent, &id));
+        TST(fwSocketFlush(client));
+        if (id != 0) {
+            tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+        }
+        static char received[65536];
+        for (size_t total = 0; total < sent; total += count) {
+            TST(fwSocketReceive(accepted, received, sizeof(received), &count));
+        }
+        for (uint32_t i = 0; i < 100000 && completed == 0; i++) {
+            TST(fwSocketReapZeroCopy(client, nullptr));
+        }
+        if (completed != 1) {
+            tstLogFrameworkFail(fwErrorGoodJob, __func__, __LINE__);
+        }
+    }
+
+    TST(fwSocketClose(client));
+    TST(fwSocketClose(accepted));
+    TST(fwSocketClose(listener));
+    TST(fwStopModule(fwModuleNetwork));
+}
@@ -28,6 +28,10 @@ void tstUnitNetworkClient(
     void
     );
 
+void tstUnitSocketBind(
+    void
+    );
+
 void tstUnitNetworkServer(
     void
     );
@@ -36,4 +40,128 @@ void tstUnitWindow(
     void
     );
 
+void tstUnitRender(
+    void
+    );
+
+void tstUnitAudio(
+    void
+    );
+
+void tstUnitBuffer(
+    void
+    );
+
+void tstUnitFileCache(
+    void
+    );
+
+void tstUnitModules(
+    void
+    );
+
+void tstUnitLogger(
+    void
+    );
+
+void tstUnitEventLoop(
+    void
+    );
+
+void tstUnitIoQueue(
+    void
+    );
+
+void tstUnitFileMapping(
+    void
+    );
+
+void tstUnitFileReader(
+    void
+    );
+
+void tstUnitSocketBatch(
+    void
+    );
+
+void tstUnitSocketStats(
+    void
+    );
+
+void tstUnitSocketListen(
+    void
+    );
+
+void tstUnitSocketConnectParallel(
+    void
+    );
+
+void tstUnitSocketHandles(
+    void
+    );
+
+void tstUnitEventLoopConnect(
+    void
+    );
+
+void tstUnitLogFilter(
+    void
+    );
+
+void tstUnitResolver(
+    void
+    );
+
+void tstUnitSocketSendFile(
+    void
+    );
+
+void tstUnitSocketZeroCopy(
+    void
+    );
+
+void tstUnitSocketConfigure(
+    void
+    );
+
+void tstUnitConnectParallelOptions(
+    void
+    );
+
+void tstUnitSocketStream(
+    void
+    );
+
+void tstUnitConnectionPool(
+    void
+    );
+
+void tstUnitFiber(
+    void
+    );
+
+void tstUnitTimer(
+    void
+    );
+
+void tstUnitLocalChannel(
+    void
+    );
+
+void tstUnitBench(
+    void
+    );
+
+void tstUnitJob(
+    void
+    );
+
+void tstUnitSystemConfiguration(
+    void
+    );
+
+void tstUnitArena(
+    void
+    );
+
 #endif //LPAF_TESTS_H
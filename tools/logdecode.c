@@ -0,0 +1,204 @@
+// LPAF - lightweight and performant application framework
+// Copyright (C) 2024 ToneXum (Toni Stein)
+//
+// This program is free software: you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation, either version 3 of
+// the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program. If
+// not, see <https://www.gnu.org/licenses/>.
+
+// Offline decoder for binary logs, renders them the same way the text logger of a release build
+// would have written them. Usage: lpafLogDecode <log file>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "internal.h"
+
+#define TL_LINE_MAX 4096
+
+struct tlSite {
+    const char* format_p;
+    const char* file_p;
+    const char* function_p;
+    uint32_t line;
+    uint8_t level;
+};
+
+struct tlReader {
+    const uint8_t* data_p;
+    size_t size;
+    size_t offset;
+};
+
+static bool tlRead(struct tlReader* reader_p, void* out_p, const size_t size) {
+    if (reader_p->size - reader_p->offset < size) {
+        return false;
+    }
+
+    memcpy(out_p, reader_p->data_p + reader_p->offset, size);
+    reader_p->offset += size;
+    return true;
+}
+
+static const char* tlReadString(struct tlReader* reader_p) {
+    uint16_t length = 0;
+    if (!tlRead(reader_p, &length, sizeof(length)) || reader_p->size - reader_p->offset < length) {
+        return nullptr;
+    }
+
+    char* string_p = malloc(length + 1u);
+    if (string_p == nullptr) {
+        return nullptr;
+    }
+    tlRead(reader_p, string_p, length);
+    string_p[length] = '\0';
+    return string_p;
+}
+
+static void tlFreeSites(struct tlSite* sites_p, const uint32_t count) {
+    for (uint32_t i = 0; sites_p != nullptr && i < count; ++i) {
+        free((void*)sites_p[i].file_p);
+        free((void*)sites_p[i].function_p);
+        free((void*)sites_p[i].format_p);
+    }
+    free(sites_p);
+}
+
+static bool tlReadSites(struct tlReader* reader_p, struct tlSite** sites_pp, uint32_t* count_p) {
+    uint32_t header[2] = {};
+    if (!tlRead(reader_p, header, sizeof(header)) || header[0] != FWI_LOG_BINARY_VERSION) {
+        fprintf(stderr, "Unsupported binary log version\n");
+        return false;
+    }
+
+    // A new table starts the records of the next run that appended to the same file
+    tlFreeSites(*sites_pp, *count_p);
+    *sites_pp = calloc(header[1] != 0 ? header[1] : 1, sizeof(struct tlSite));
+    *count_p = header[1];
+    if (*sites_pp == nullptr) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header[1]; ++i) {
+        struct tlSite* site_p = &(*sites_pp)[i];
+        if (!tlRead(reader_p, &site_p->level, sizeof(site_p->level))
+            || !tlRead(reader_p, &site_p->line, sizeof(site_p->line))
+            || (site_p->file_p = tlReadString(reader_p)) == nullptr
+            || (site_p->function_p = tlReadString(reader_p)) == nullptr
+            || (site_p->format_p = tlReadString(reader_p)) == nullptr) {
+            fprintf(stderr, "The site table is truncated\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void tlPrintRecord(const struct fwiLogRecord* record_p, const struct tlSite* sites_p,
+    const uint32_t siteCount, const uint8_t* payload_p) {
+    static const char* const levels[] = {
+        [fwiLogLevelError]   = "ERROR",
+        [fwiLogLevelWarning] = "WARNING",
+        [fwiLogLevelInfo]    = "INFO",
+        [fwiLogLevelDebug]   = "DEBUG",
+        [fwiLogLevelBench]   = "BENCHMARK"
+    };
+
+    char message[TL_LINE_MAX];
+    if (record_p->kind == fwiLogKindBinary) {
+        struct tlReader payload = { .data_p = payload_p, .size = record_p->length };
+        uint32_t index = 0;
+        if (!tlRead(&payload, &index, sizeof(index)) || index >= siteCount) {
+            snprintf(message, sizeof(message), "<unknown log site>");
+        }
+        else {
+            fwiLogRenderBinary(sites_p[index].format_p, payload_p + payload.offset,
+                payload.size - payload.offset, message, sizeof(message));
+        }
+    }
+    else {
+        snprintf(message, sizeof(message), "%.*s", record_p->length, (const char*)payload_p);
+    }
+
+    if (record_p->kind == fwiLogKindFollowup || record_p->kind == fwiLogKindFollowupLast) {
+        printf("%s - %s\n", record_p->kind == fwiLogKindFollowupLast ? "\\" : "|", message);
+        return;
+    }
+
+    const time_t rawTime = (time_t)record_p->seconds;
+    struct tm time = {};
+    localtime_r(&rawTime, &time);
+    char stamp[32] = {};
+    strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &time);
+
+    const char* level_p = record_p->level <= fwiLogLevelBench ? levels[record_p->level] : "?";
+    printf("[%s.%03"PRId32" %s]: %s\n", stamp, record_p->nanoseconds / 1000000, level_p, message);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <binary log>\n", argv[0]);
+        return 1;
+    }
+
+    FILE* file_p = fopen(argv[1], "rb");
+    if (file_p == nullptr) {
+        fprintf(stderr, "Could not open %s\n", argv[1]);
+        return 1;
+    }
+    fseek(file_p, 0, SEEK_END);
+    const long fileSize = ftell(file_p);
+    fseek(file_p, 0, SEEK_SET);
+
+    uint8_t* data_p = malloc(fileSize > 0 ? (size_t)fileSize : 1u);
+    if (data_p == nullptr || fread(data_p, 1, (size_t)fileSize, file_p) != (size_t)fileSize) {
+        fprintf(stderr, "Could not read %s\n", argv[1]);
+        fclose(file_p);
+        free(data_p);
+        return 1;
+    }
+    fclose(file_p);
+
+    struct tlReader reader = { .data_p = data_p, .size = (size_t)fileSize };
+    struct tlSite* sites_p = nullptr;
+    uint32_t siteCount = 0;
+    int32_t ret = 0;
+    const size_t magicLength = sizeof(FWI_LOG_BINARY_MAGIC) - 1;
+
+    while (reader.offset < reader.size) {
+        // Every run appends its own site table in front of its records
+        if (reader.size - reader.offset >= magicLength
+            && memcmp(reader.data_p + reader.offset, FWI_LOG_BINARY_MAGIC, magicLength) == 0) {
+            reader.offset += magicLength;
+            if (!tlReadSites(&reader, &sites_p, &siteCount)) {
+                ret = 1;
+                break;
+            }
+            continue;
+        }
+
+        struct fwiLogRecord record = {};
+        if (sites_p == nullptr || !tlRead(&reader, &record, sizeof(record))
+            || reader.size - reader.offset < record.length) {
+            fprintf(stderr, "The log is truncated or not a binary log\n");
+            ret = 1;
+            break;
+        }
+
+        tlPrintRecord(&record, sites_p, siteCount, reader.data_p + reader.offset);
+        reader.offset += record.length;
+    }
+
+    tlFreeSites(sites_p, siteCount);
+    free(data_p);
+    return ret;
+}